@@ -0,0 +1,273 @@
+/*
+ * splrts.c -- runtime of SPL programs compiled for x86-64 Linux
+ *
+ * The runtime implements the predefined procedures of table.c for programs translated by genCodeX86.
+ * It needs no C library: it is compiled freestanding, talks to the kernel by system calls and provides
+ * the entry point _start, which calls the procedure main of the program. The messages are the same as
+ * those of the ECO32 runtime, so both targets print the same output.
+ *
+ * The procedures follow the System V calling convention: value parameters arrive as int,
+ * reference parameters as a pointer to the int.
+ *
+ * Build, e.g.:  gcc -c -O2 -ffreestanding -fno-builtin -fno-stack-protector -fno-pie splrts.c
+ * Link, e.g.:   as -o prog.o prog.s && ld -o prog prog.o splrts.o
+ */
+
+#define SYS_READ            0
+#define SYS_WRITE           1
+#define SYS_IOCTL           16
+#define SYS_EXIT            60
+#define SYS_CLOCK_GETTIME   228
+
+#define STDIN               0
+#define STDOUT              1
+#define CLOCK_MONOTONIC     1
+#define TCGETS              0x5401
+
+#define BUFFER_SIZE         4096
+#define TERMIOS_SIZE        60
+
+typedef struct {
+    long seconds;
+    long nanoseconds;
+} TimeSpec;
+
+/* the entry points called from the generated code and from _start */
+void _splBegin(void);
+void _splFinish(void);
+void _indexError(void);
+void printi(int i);
+void printc(int c);
+void readi(int *i);
+void readc(int *c);
+void exit(void);
+void time(int *t);
+void clearAll(int color);
+void setPixel(int x, int y, int color);
+void drawLine(int x1, int y1, int x2, int y2, int color);
+void drawCircle(int x0, int y0, int radius, int color);
+
+/*
+ * The stack is aligned to 16 bytes, as the procedures expect it, and the frame pointer is cleared
+ * to terminate the chain of frames. Registers are not preserved by the generated code, so nothing
+ * is kept in them across the call of main.
+ */
+__asm__(
+        "\t.text\n"
+        "\t.globl\t_start\n"
+        "_start:\n"
+        "\txorl\t%ebp,%ebp\n"
+        "\tandq\t$-16,%rsp\n"
+        "\tcall\t_splBegin\n"
+        "\tcall\tmain\n"
+        "\tcall\t_splFinish\n"
+        "\thlt\n"
+);
+
+static char outputBuffer[BUFFER_SIZE];
+static int outputLength;
+static char inputBuffer[BUFFER_SIZE];
+static int inputLength;
+static int inputPosition;
+static int echoInput;               /* the input is no terminal, which shows it itself */
+static long startSeconds;
+
+static long systemCall(long number, long argument1, long argument2, long argument3) {
+    long result;
+
+    __asm__ volatile("syscall"
+                     : "=a"(result)
+                     : "a"(number), "D"(argument1), "S"(argument2), "d"(argument3)
+                     : "rcx", "r11", "memory");
+    return result;
+}
+
+/*
+ * Output is buffered and flushed when the program ends or waits for input.
+ */
+
+static void flushOutput(void) {
+    long written, n;
+
+    written = 0;
+    while (written < outputLength) {
+        n = systemCall(SYS_WRITE, STDOUT, (long) (outputBuffer + written), outputLength - written);
+        if (n <= 0) break;
+        written += n;
+    }
+    outputLength = 0;
+}
+
+static void putChar(char c) {
+    if (outputLength == BUFFER_SIZE) flushOutput();
+    outputBuffer[outputLength++] = c;
+}
+
+static void putString(const char *s) {
+    while (*s != '\0') putChar(*s++);
+}
+
+static void terminate(int status) {
+    flushOutput();
+    systemCall(SYS_EXIT, status, 0, 0);
+    for (;;);
+}
+
+static int getChar(void) {
+    long n;
+
+    if (inputPosition == inputLength) {
+        flushOutput();
+        n = systemCall(SYS_READ, STDIN, (long) inputBuffer, BUFFER_SIZE);
+        if (n <= 0) return -1;
+        inputLength = (int) n;
+        inputPosition = 0;
+    }
+    return (unsigned char) inputBuffer[inputPosition++];
+}
+
+/*
+ * readi of the ECO32 shows the number while it is typed, readc leaves that to the program. A number
+ * from a file or a pipe is echoed in the same way, so that the output equals that of the ECO32.
+ */
+static int getEchoedChar(void) {
+    int c;
+
+    c = getChar();
+    if (echoInput && c != -1) putChar((char) c);
+    return c;
+}
+
+/*
+ * The ECO32 waits for the next character forever, a host program ends at the end of its input.
+ */
+static void endOfInput(void) {
+    terminate(0);
+}
+
+static long currentSeconds(void) {
+    TimeSpec now;
+
+    systemCall(SYS_CLOCK_GETTIME, CLOCK_MONOTONIC, (long) &now, 0);
+    return now.seconds;
+}
+
+/*
+ * Program start and end
+ */
+
+void _splBegin(void) {
+    char termios[TERMIOS_SIZE];
+
+    echoInput = systemCall(SYS_IOCTL, STDIN, TCGETS, (long) termios) != 0;
+    startSeconds = currentSeconds();
+    putString("SPL/RTS: main() started\n");
+}
+
+void _splFinish(void) {
+    putString("SPL/RTS: main() finished\n");
+    terminate(0);
+}
+
+void _indexError(void) {
+    putString("SPL/RTS: index out of bounds\n");
+    terminate(1);
+}
+
+/*
+ * Predefined procedures
+ */
+
+void printi(int i) {
+    char digits[12];
+    unsigned int value;
+    int n;
+
+    if (i < 0) {
+        putChar('-');
+        value = -(unsigned int) i;
+    } else {
+        value = (unsigned int) i;
+    }
+    n = 0;
+    do {
+        digits[n++] = (char) ('0' + value % 10);
+        value /= 10;
+    } while (value != 0);
+    while (n > 0) putChar(digits[--n]);
+}
+
+void printc(int c) {
+    putChar((char) c);
+}
+
+void readi(int *i) {
+    unsigned int value;
+    int c, isNegative;
+
+    do {
+        c = getEchoedChar();
+    } while (c == ' ' || c == '\t' || c == '\r' || c == '\n');
+    if (c == -1) endOfInput();
+    isNegative = c == '-';
+    if (isNegative) c = getEchoedChar();
+    value = 0;
+    while (c >= '0' && c <= '9') {
+        value = value * 10 + (unsigned int) (c - '0');
+        c = getEchoedChar();
+    }
+    /* the number is entered as a line of its own */
+    while (c != '\n' && c != -1) c = getEchoedChar();
+    *i = (int) (isNegative ? -value : value);
+}
+
+void readc(int *c) {
+    *c = getChar();
+    if (*c == -1) endOfInput();
+}
+
+void exit(void) {
+    terminate(0);
+}
+
+void time(int *t) {
+    *t = (int) (currentSeconds() - startSeconds);
+}
+
+/*
+ * A host has no graphics controller, the ECO32 simulator without one ends the program the same way.
+ */
+
+static void noGraphics(void) {
+    putString("SPL/RTS: graphics controller not installed\n");
+    _splFinish();
+}
+
+void clearAll(int color) {
+    (void) color;
+    noGraphics();
+}
+
+void setPixel(int x, int y, int color) {
+    (void) x;
+    (void) y;
+    (void) color;
+    noGraphics();
+}
+
+void drawLine(int x1, int y1, int x2, int y2, int color) {
+    (void) x1;
+    (void) y1;
+    (void) x2;
+    (void) y2;
+    (void) color;
+    noGraphics();
+}
+
+void drawCircle(int x0, int y0, int radius, int color) {
+    (void) x0;
+    (void) y0;
+    (void) radius;
+    (void) color;
+    noGraphics();
+}
@@ -100,6 +100,7 @@ Statement *newStatement(int line, statement_kind kind) {
 
     node->line = line;
     node->kind = kind;
+    node->profileCounter = -1;
     return node;
 }
 
@@ -130,6 +131,7 @@ Statement *newIfStatement(int line, Expression *condition, Statement *thenPart,
     node->u.ifStatement.condition = condition;
     node->u.ifStatement.thenPart = thenPart;
     node->u.ifStatement.elsePart = elsePart;
+    node->u.ifStatement.lowering = NULL;
     return node;
 }
 
@@ -138,6 +140,8 @@ Statement *newWhileStatement(int line, Expression *condition, Statement *body) {
     Statement *node = newStatement(line, STATEMENT_WHILESTATEMENT);
     node->u.whileStatement.condition = condition;
     node->u.whileStatement.body = body;
+    node->u.whileStatement.pointers = NULL;
+    node->u.whileStatement.isInverted = false;
     return node;
 }
 
@@ -203,6 +207,9 @@ Variable *newArrayAccess(int line, Variable *var, Expression *index) {
     Variable *node = newVariable(line, VARIABLE_ARRAYACCESS);
     node->u.arrayAccess.array = var;
     node->u.arrayAccess.index = index;
+    node->u.arrayAccess.checkIndex = true;
+    node->u.arrayAccess.pointer = NULL;
+    node->u.arrayAccess.pointerOffset = 0;
     return node;
 }
 
@@ -244,6 +251,222 @@ ExpressionList *newExpressionList(Expression *head, ExpressionList *tail) {
     return node;
 }
 
+Variable *copyVariable(Variable *variable) {
+    Variable *copy;
+
+    switch (variable->kind) {
+        case VARIABLE_NAMEDVARIABLE:
+            copy = newNamedVariable(variable->line, variable->u.namedVariable.name);
+            break;
+        case VARIABLE_ARRAYACCESS:
+            copy = newArrayAccess(variable->line,
+                                  copyVariable(variable->u.arrayAccess.array),
+                                  copyExpression(variable->u.arrayAccess.index));
+            copy->u.arrayAccess.checkIndex = variable->u.arrayAccess.checkIndex;
+            break;
+        default:
+            error("unknown variable kind %d in copyVariable", variable->kind);
+            return NULL;
+    }
+    copy->dataType = variable->dataType;
+    return copy;
+}
+
+Expression *copyExpression(Expression *expression) {
+    Expression *copy;
+
+    switch (expression->kind) {
+        case EXPRESSION_BINARYEXPRESSION:
+            copy = newBinaryExpression(expression->line, expression->u.binaryExpression.operator,
+                                       copyExpression(expression->u.binaryExpression.leftOperand),
+                                       copyExpression(expression->u.binaryExpression.rightOperand));
+            break;
+        case EXPRESSION_VARIABLEEXPRESSION:
+            copy = newVariableExpression(expression->line, copyVariable(expression->u.variableExpression.variable));
+            break;
+        case EXPRESSION_INTLITERAL:
+            copy = newIntLiteral(expression->line, expression->u.intLiteral.value);
+            break;
+        default:
+            error("unknown expression kind %d in copyExpression", expression->kind);
+            return NULL;
+    }
+    copy->dataType = expression->dataType;
+    return copy;
+}
+
+static ExpressionList *copyExpressionList(ExpressionList *expressions) {
+    if (expressions->isEmpty) return emptyExpressionList();
+    return newExpressionList(copyExpression(expressions->head), copyExpressionList(expressions->tail));
+}
+
+StatementList *copyStatementList(StatementList *statements) {
+    if (statements->isEmpty) return emptyStatementList();
+    return newStatementList(copyStatement(statements->head), copyStatementList(statements->tail));
+}
+
+Statement *copyStatement(Statement *statement) {
+    Statement *copy;
+
+    switch (statement->kind) {
+        case STATEMENT_EMPTYSTATEMENT:
+            copy = newEmptyStatement(statement->line);
+            break;
+        case STATEMENT_COMPOUNDSTATEMENT:
+            copy = newCompoundStatement(statement->line, copyStatementList(statement->u.compoundStatement.statements));
+            break;
+        case STATEMENT_ASSIGNSTATEMENT:
+            copy = newAssignStatement(statement->line,
+                                      copyVariable(statement->u.assignStatement.target),
+                                      copyExpression(statement->u.assignStatement.value));
+            break;
+        case STATEMENT_IFSTATEMENT:
+            copy = newIfStatement(statement->line,
+                                  copyExpression(statement->u.ifStatement.condition),
+                                  copyStatement(statement->u.ifStatement.thenPart),
+                                  copyStatement(statement->u.ifStatement.elsePart));
+            break;
+        case STATEMENT_WHILESTATEMENT:
+            copy = newWhileStatement(statement->line,
+                                     copyExpression(statement->u.whileStatement.condition),
+                                     copyStatement(statement->u.whileStatement.body));
+            break;
+        case STATEMENT_CALLSTATEMENT:
+            copy = newCallStatement(statement->line, statement->u.callStatement.procedureName,
+                                    copyExpressionList(statement->u.callStatement.argumentList));
+            break;
+        default:
+            error("unknown statement kind %d in copyStatement", statement->kind);
+            return NULL;
+    }
+    /* a copy counts for the statement it was made from */
+    copy->profileCounter = statement->profileCounter;
+    return copy;
+}
+
+bool equalVariables(Variable *left, Variable *right) {
+    if (left->kind != right->kind) return false;
+    switch (left->kind) {
+        case VARIABLE_NAMEDVARIABLE:
+            /* identifiers are interned, so comparing the pointers is sufficient */
+            return left->u.namedVariable.name == right->u.namedVariable.name;
+        case VARIABLE_ARRAYACCESS:
+            return equalVariables(left->u.arrayAccess.array, right->u.arrayAccess.array) &&
+                   equalExpressions(left->u.arrayAccess.index, right->u.arrayAccess.index);
+        default:
+            error("unknown variable kind %d in equalVariables", left->kind);
+            return false;
+    }
+}
+
+bool equalExpressions(Expression *left, Expression *right) {
+    if (left->kind != right->kind) return false;
+    switch (left->kind) {
+        case EXPRESSION_INTLITERAL:
+            return left->u.intLiteral.value == right->u.intLiteral.value;
+        case EXPRESSION_VARIABLEEXPRESSION:
+            return equalVariables(left->u.variableExpression.variable, right->u.variableExpression.variable);
+        case EXPRESSION_BINARYEXPRESSION:
+            return left->u.binaryExpression.operator == right->u.binaryExpression.operator &&
+                   equalExpressions(left->u.binaryExpression.leftOperand, right->u.binaryExpression.leftOperand) &&
+                   equalExpressions(left->u.binaryExpression.rightOperand, right->u.binaryExpression.rightOperand);
+        default:
+            error("unknown expression kind %d in equalExpressions", left->kind);
+            return false;
+    }
+}
+
+bool containsCallInList(StatementList *statements) {
+    for (; !statements->isEmpty; statements = statements->tail) {
+        if (containsCall(statements->head)) return true;
+    }
+    return false;
+}
+
+bool containsCall(Statement *statement) {
+    switch (statement->kind) {
+        case STATEMENT_EMPTYSTATEMENT:
+        case STATEMENT_ASSIGNSTATEMENT:
+            return false;
+        case STATEMENT_COMPOUNDSTATEMENT:
+            return containsCallInList(statement->u.compoundStatement.statements);
+        case STATEMENT_IFSTATEMENT:
+            return containsCall(statement->u.ifStatement.thenPart) || containsCall(statement->u.ifStatement.elsePart);
+        case STATEMENT_WHILESTATEMENT:
+            return containsCall(statement->u.whileStatement.body);
+        case STATEMENT_CALLSTATEMENT:
+            return true;
+        default:
+            error("unknown statement kind %d in containsCall", statement->kind);
+            return true;
+    }
+}
+
+void forEachCallInList(StatementList *statements, void (*function)(Statement *call, void *data), void *data) {
+    for (; !statements->isEmpty; statements = statements->tail) forEachCall(statements->head, function, data);
+}
+
+void forEachCall(Statement *statement, void (*function)(Statement *call, void *data), void *data) {
+    switch (statement->kind) {
+        case STATEMENT_EMPTYSTATEMENT:
+        case STATEMENT_ASSIGNSTATEMENT:
+            break;
+        case STATEMENT_COMPOUNDSTATEMENT:
+            forEachCallInList(statement->u.compoundStatement.statements, function, data);
+            break;
+        case STATEMENT_IFSTATEMENT:
+            forEachCall(statement->u.ifStatement.thenPart, function, data);
+            forEachCall(statement->u.ifStatement.elsePart, function, data);
+            break;
+        case STATEMENT_WHILESTATEMENT:
+            forEachCall(statement->u.whileStatement.body, function, data);
+            break;
+        case STATEMENT_CALLSTATEMENT:
+            function(statement, data);
+            break;
+        default:
+            error("unknown statement kind %d in forEachCall", statement->kind);
+    }
+}
+
+void printVariable(Variable *variable) {
+    switch (variable->kind) {
+        case VARIABLE_NAMEDVARIABLE:
+            printf("%s", variable->u.namedVariable.name->string);
+            break;
+        case VARIABLE_ARRAYACCESS:
+            printVariable(variable->u.arrayAccess.array);
+            printf("[");
+            printExpression(variable->u.arrayAccess.index);
+            printf("]");
+            break;
+        default:
+            error("unknown variable kind %d in printVariable", variable->kind);
+    }
+}
+
+void printExpression(Expression *expression) {
+    static char *operators[] = {"=", "#", "<", "<=", ">", ">=", "+", "-", "*", "/"};
+
+    switch (expression->kind) {
+        case EXPRESSION_INTLITERAL:
+            printf("%d", expression->u.intLiteral.value);
+            break;
+        case EXPRESSION_VARIABLEEXPRESSION:
+            printVariable(expression->u.variableExpression.variable);
+            break;
+        case EXPRESSION_BINARYEXPRESSION:
+            printf("(");
+            printExpression(expression->u.binaryExpression.leftOperand);
+            printf(" %s ", operators[expression->u.binaryExpression.operator]);
+            printExpression(expression->u.binaryExpression.rightOperand);
+            printf(")");
+            break;
+        default:
+            error("unknown expression kind %d in printExpression", expression->kind);
+    }
+}
+
 GlobalDeclarationList *emptyGlobalDeclarationList(void) {
     static GlobalDeclarationList *nil = NULL;
 
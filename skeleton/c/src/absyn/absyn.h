@@ -127,6 +127,8 @@ typedef struct expression {
  * 1. Named variables which represent a simple variable, that is identified by its name.
  *
  * 2. Array accesses that represent an array accessed at a certain index. The accessed array itself may be any variable.
+ * The index of an array access is checked against the size of the array at runtime, unless the optimizer
+ * has proven that it is always in range.
  */
 typedef struct variable {
     int line;
@@ -139,6 +141,9 @@ typedef struct variable {
         struct {
             struct variable *array;
             struct expression *index;
+            bool checkIndex;        /* cleared by the optimizer if the index is known to be in range */
+            struct induction_pointer *pointer;  /* filled in by loop strength reduction and code motion, or NULL */
+            int pointerOffset;      /* filled in by loop strength reduction, added to the pointer in bytes */
         } arrayAccess;
     } u;
 } Variable;
@@ -173,6 +178,7 @@ typedef struct variable {
 typedef struct statement {
     int line;
     statement_kind kind;
+    int profileCounter;       /* first execution counter of an if-, while- or call statement, -1 if it has none */
     union {
         struct {
             int dummy;        /* empty struct not allowed in C */
@@ -188,10 +194,13 @@ typedef struct statement {
             Expression *condition;
             struct statement *thenPart;
             struct statement *elsePart;
+            struct switch_lowering *lowering;    /* set by the switch lowering for the first if of a chain, or NULL */
         } ifStatement;
         struct {
             Expression *condition;
             struct statement *body;
+            struct induction_pointer *pointers;  /* filled in by loop strength reduction and code motion */
+            bool isInverted;                     /* test in front of the loop and after the body, set by loop inversion */
         } whileStatement;
         struct {
             Identifier *procedureName;
@@ -200,6 +209,58 @@ typedef struct statement {
     } u;
 } Statement;
 
+/**
+ * This struct represents the address of an array element, which is kept in a register during a loop.
+ *
+ * It is created by the loop strength reduction for array accesses like a[i] or a[i + 1], where i is
+ * incremented by a constant once per iteration. The address of a[i] is computed in front of the loop and
+ * advanced by the step whenever the increment is executed, instead of multiplying the index in every access.
+ *
+ * The loop-invariant code motion creates pointers with step 0 for addresses like f[i], which do not change
+ * during the loop. Their access keeps its bounds check, so they are computed when the body of the loop
+ * is entered for the first time instead, and they have neither an induction variable nor an increment.
+ */
+typedef struct induction_pointer {
+    Variable *access;                   /* an access a[i] whose address the pointer holds */
+    Identifier *inductionVariable;      /* NULL for an invariant address */
+    int step;                           /* bytes the pointer advances when the increment is executed */
+    int reg;
+    Statement *increment;               /* the statement incrementing the induction variable, or NULL */
+    struct induction_pointer *next;
+} InductionPointer;
+
+/**
+ * The kinds of code a lowered chain of if-statements is emitted as.
+ */
+typedef enum {
+    SWITCH_JUMP_TABLE,
+    SWITCH_DECISION_TREE
+} switch_kind;
+
+/**
+ * This struct represents one case of a lowered chain, the statement executed if the selector has the value.
+ */
+typedef struct {
+    int value;
+    Statement *body;
+} SwitchCase;
+
+/**
+ * This struct represents a chain like "if (x = 1) s1 else if (x = 2) s2 else s3", which compares one variable
+ * with distinct constants.
+ *
+ * It is created by the switch lowering for the first if-statement of the chain. The code generator loads the
+ * selector once and jumps to the body of the matching case through a jump table or a decision tree, instead of
+ * testing the conditions one after another. The if-statements of the chain remain in the tree unchanged.
+ */
+typedef struct switch_lowering {
+    switch_kind kind;
+    Identifier *selector;               /* a named variable of type int */
+    int numCases;
+    SwitchCase *cases;                  /* sorted by value */
+    Statement *defaultPart;             /* executed if no case matches */
+} SwitchLowering;
+
 /**
  * This struct represents type expressions in SPL.
  *
@@ -522,6 +583,87 @@ ExpressionList *emptyExpressionList(void);
  */
 ExpressionList *newExpressionList(Expression *head, ExpressionList *tail);
 
+/**
+ * Creates a deep copy of a statement, e.g. when an optimization duplicates a part of a procedure body.
+ * The semantic types of all expressions and variables and the profile counters are copied as well,
+ * the induction pointers of the loop strength reduction are not.
+ * @param statement The statement to copy.
+ * @return The reference to the root of the newly created tree.
+ */
+Statement *copyStatement(Statement *statement);
+/**
+ * Creates a deep copy of a list of statements.
+ * @param statements The list to copy.
+ * @return The newly created list.
+ */
+StatementList *copyStatementList(StatementList *statements);
+/**
+ * Creates a deep copy of an expression.
+ * @param expression The expression to copy.
+ * @return The reference to the root of the newly created tree.
+ */
+Expression *copyExpression(Expression *expression);
+/**
+ * Creates a deep copy of a variable.
+ * @param variable The variable to copy.
+ * @return The reference to the root of the newly created tree.
+ */
+Variable *copyVariable(Variable *variable);
+
+/**
+ * Compares two expressions structurally.
+ * @param left The first expression.
+ * @param right The second expression.
+ * @return true if both expressions consist of the same operators, literals and variables.
+ */
+bool equalExpressions(Expression *left, Expression *right);
+/**
+ * Compares two variables structurally.
+ * @param left The first variable.
+ * @param right The second variable.
+ * @return true if both variables have the same name and are accessed with equal indices.
+ */
+bool equalVariables(Variable *left, Variable *right);
+
+/**
+ * Checks whether a statement contains a call, e.g. to find the loops and procedures which make no calls.
+ * @param statement The statement to examine.
+ * @return true if the statement or one of its parts is a call statement.
+ */
+bool containsCall(Statement *statement);
+/**
+ * Checks whether a list of statements contains a call.
+ * @param statements The list to examine.
+ * @return true if one of the statements contains a call statement.
+ */
+bool containsCallInList(StatementList *statements);
+/**
+ * Calls a function for every call statement in a statement, e.g. to build the call graph.
+ * @param statement The statement to examine.
+ * @param function The function called with each call statement and the data.
+ * @param data Passed to the function unchanged.
+ */
+void forEachCall(Statement *statement, void (*function)(Statement *call, void *data), void *data);
+/**
+ * Calls a function for every call statement in a list of statements.
+ * @param statements The list to examine.
+ * @param function The function called with each call statement and the data.
+ * @param data Passed to the function unchanged.
+ */
+void forEachCallInList(StatementList *statements, void (*function)(Statement *call, void *data), void *data);
+
+/**
+ * Prints an expression in the syntax of SPL on a single line, e.g. in the reports of the optimizer.
+ * Binary expressions are enclosed in parentheses.
+ * @param expression The expression to print.
+ */
+void printExpression(Expression *expression);
+/**
+ * Prints a variable in the syntax of SPL on a single line, e.g. in the reports of the optimizer.
+ * @param variable The variable to print.
+ */
+void printVariable(Variable *variable);
+
 void showAbsyn(Program *program);
 
 #endif /* _ABSYN_H_ */
@@ -8,13 +8,25 @@
 #include <stdarg.h>
 #include <string.h>
 #include <util/errors.h>
+#include <util/memory.h>
 #include <absyn/absyn.h>
 #include "phases/_01_scanner/scanner.h"
 #include <phases/_04a_tablebuild/tablebuild.h>
 #include <phases/_02_03_parser/parser.h>
 #include "phases/_04b_semant/procedurebodycheck.h"
+#include "phases/_04c_optimize/inline.h"
+#include "phases/_04c_optimize/ipcp.h"
+#include "phases/_04c_optimize/boundscheck.h"
+#include "phases/_04c_optimize/unroll.h"
+#include "phases/_05_varalloc/staticalloc.h"
+#include "phases/_04c_optimize/profile.h"
+#include "phases/_04c_optimize/passes.h"
 #include "phases/_05_varalloc/varalloc.h"
 #include "phases/_06_codegen/codegen.h"
+#include "phases/_06_codegen/peephole.h"
+#include "phases/_06_codegen/instrument.h"
+#include "phases/_06_codegen/constarith.h"
+#include "phases/_06_x86_64/x86codegen.h"
 
 #define VERSION        "1.1"
 
@@ -140,9 +152,70 @@ static void showUsage(FILE *out, const char *myself) {
     fprintf(out, "  --tokens     Phase 1: Scans for tokens and prints them.\n");
     fprintf(out, "  --parse      Phase 2: Parses the stream of tokens to check for syntax errors.\n");
     fprintf(out, "  --absyn      Phase 3: Creates an abstract syntax tree from the input tokens and prints it.\n");
+    fprintf(out, "               Together with -O1 or higher, the tree is printed after it has been optimized.\n");
     fprintf(out, "  --tables     Phase 4a: Builds a symbol table and prints its entries.\n");
     fprintf(out, "  --semant     Phase 4b: Performs the semantic analysis.\n");
     fprintf(out, "  --vars       Phase 5: Allocates memory space for variables and prints the amount of allocated memory.\n");
+    fprintf(out, "  -O<level>    Sets the optimization level (0, 1, 2 or s, default 0). Level 1 enables constant folding,\n");
+    fprintf(out, "               removes unreachable code and stores to variables which are never read,\n");
+    fprintf(out, "               passes the first four arguments of a procedure in registers\n");
+    fprintf(out, "               and rewrites short sequences of emitted instructions into cheaper ones.\n");
+    fprintf(out, "               Level 2 additionally keeps scalar variables in registers and replaces\n");
+    fprintf(out, "               the index multiplication of array accesses in loops by induction pointers.\n");
+    fprintf(out, "               Addresses which do not change during a loop are computed in front of it.\n");
+    fprintf(out, "               Loops with a short condition test it after the body instead of jumping back.\n");
+    fprintf(out, "               Recursive calls at the end of a procedure are turned into a loop.\n");
+    fprintf(out, "               Parameters which receive the same constant at every call are replaced by it,\n");
+    fprintf(out, "               other calls with constant arguments call a copy specialised on them.\n");
+    fprintf(out, "               Values computed more than once, like repeated array elements, are reused.\n");
+    fprintf(out, "               Chains of ifs comparing a variable with constants jump through a table\n");
+    fprintf(out, "               or branch through a binary decision tree.\n");
+    fprintf(out, "               Local variables whose lifetimes do not overlap share a stack slot.\n");
+    fprintf(out, "               Level s adds only the tail call elimination, the register allocation,\n");
+    fprintf(out, "               the sharing of stack slots, the elision of bounds checks and the replacement\n");
+    fprintf(out, "               of constant parameters to level 1, since they do not enlarge the code.\n");
+    fprintf(out, "  --passes=<list>\n");
+    fprintf(out, "               Runs the comma-separated passes in the given order instead of the pipeline\n");
+    fprintf(out, "               of the optimization level. Passes rewriting the tree run before the others.\n");
+    fprintf(out, "               callconv has to precede regalloc, and static has to precede slots.\n");
+    fprintf(out, "               The passes are:\n");
+    showPasses(out);
+    fprintf(out, "  --disable-pass=<list>\n");
+    fprintf(out, "               Removes the comma-separated passes from the pipeline.\n");
+    fprintf(out, "  --pass-stats Prints the wall time and the number of changes of every pass.\n");
+    fprintf(out, "  --bounds-checks=<mode>\n");
+    fprintf(out, "               Selects the array accesses whose index is checked: 'all', 'elide' (omit the checks\n");
+    fprintf(out, "               that can never fail, default with -O2) or 'none'.\n");
+    fprintf(out, "  --inline-threshold=<n>\n");
+    fprintf(out, "               Inlines procedures whose body has at most n nodes (default %d with -O2, else 0).\n",
+            DEFAULT_INLINE_THRESHOLD);
+    fprintf(out, "  --clone-budget=<n>\n");
+    fprintf(out, "               Lets copies of procedures specialised on constant arguments grow the program\n");
+    fprintf(out, "               by at most n percent (default %d with -O2, else 0).\n", DEFAULT_CLONE_BUDGET);
+    fprintf(out, "  --unroll=<n> Unrolls loops with a constant number of iterations up to n times\n");
+    fprintf(out, "               (default %d with -O2, else 0).\n", DEFAULT_UNROLL_FACTOR);
+    fprintf(out, "  --static-locals=<n>\n");
+    fprintf(out, "               Allocates local variables of at least n bytes of procedures which are not\n");
+    fprintf(out, "               recursive in the bss segment (default %d with -O2 or -Os, else 0).\n",
+            DEFAULT_STATIC_THRESHOLD);
+    fprintf(out, "  --mul-cycles=<n>\n");
+    fprintf(out, "  --div-cycles=<n>\n");
+    fprintf(out, "               Assumes that mul or div takes n cycles (default %d, as on the simulator).\n", mulCycles);
+    fprintf(out, "               Multiplications and divisions by constants are replaced by shifts, additions\n");
+    fprintf(out, "               and multiplications of 16 bit halves, where these are cheaper.\n");
+    fprintf(out, "  --profile-generate\n");
+    fprintf(out, "               Counts the executions of branches, loop bodies and calls. The program prints\n");
+    fprintf(out, "               the counters when it ends, the output of its runs can be used as a profile.\n");
+    fprintf(out, "  --profile-use=<file>\n");
+    fprintf(out, "               Uses the counters in the file for inlining, unrolling, register allocation\n");
+    fprintf(out, "               and the order of branches.\n");
+    fprintf(out, "  --target=<machine>\n");
+    fprintf(out, "               Selects the machine the code is generated for: 'eco32' (default) or 'x86_64',\n");
+    fprintf(out, "               which emits assembly for the GNU assembler to be linked with runtime/x86_64.\n");
+    fprintf(out, "               The passes working on ECO32 code are not run for x86_64.\n");
+    fprintf(out, "  --opt-report Prints a report of the optimizations performed.\n");
+    fprintf(out, "  --peephole-stats\n");
+    fprintf(out, "               Prints how often each peephole rule was applied to the emitted instructions.\n");
     fprintf(out, "  --version    Show compiler version.\n");
     fprintf(out, "  --help       Show this help.\n");
 }
@@ -171,6 +244,23 @@ int main(int argc, char *argv[]) {
     bool optionTables;
     bool optionSemant;
     bool optionVars;
+    bool optionReport;
+    bool optionPeepholeStats;
+    bool optionProfileGenerate;
+    bool optionTargetX86;
+    char *profileFileName;
+    int numCounters;
+    optimization_level optimizationLevel;
+    char *passList;
+    char **disabledPasses;
+    int numDisabledPasses;
+    bool optionPassStats;
+    PassOptions passOptions;
+    int boundsChecks;
+    int inlineThreshold;
+    int cloneBudget;
+    int unrollFactor;
+    int staticThreshold;
     int token;
 
     /* analyze command line */
@@ -182,6 +272,21 @@ int main(int argc, char *argv[]) {
     optionTables = false;
     optionSemant = false;
     optionVars = false;
+    optionReport = false;
+    optionPeepholeStats = false;
+    optionProfileGenerate = false;
+    optionTargetX86 = false;
+    profileFileName = NULL;
+    optimizationLevel = OPTIMIZE_NONE;
+    passList = NULL;
+    disabledPasses = allocate(argc * sizeof(char *));
+    numDisabledPasses = 0;
+    optionPassStats = false;
+    boundsChecks = -1;
+    inlineThreshold = -1;
+    cloneBudget = -1;
+    unrollFactor = -1;
+    staticThreshold = -1;
 
     for (i = 1; i < argc; i++) {
         if (strcmp(argv[i], "--tokens") == 0) {
@@ -196,6 +301,65 @@ int main(int argc, char *argv[]) {
             optionSemant = true;
         } else if (strcmp(argv[i], "--vars") == 0) {
             optionVars = true;
+        } else if (strncmp(argv[i], "-O", 2) == 0) {
+            if (strcmp(argv[i] + 2, "0") == 0) optimizationLevel = OPTIMIZE_NONE;
+            else if (strcmp(argv[i] + 2, "1") == 0) optimizationLevel = OPTIMIZE_BASIC;
+            else if (strcmp(argv[i] + 2, "2") == 0) optimizationLevel = OPTIMIZE_SPEED;
+            else if (strcmp(argv[i] + 2, "s") == 0) optimizationLevel = OPTIMIZE_SIZE;
+            else usageError(argv[0], "Unknown optimization level '%s'!", argv[i]);
+        } else if (strncmp(argv[i], "--passes=", 9) == 0) {
+            if (!arePassNames(argv[i] + 9))
+                usageError(argv[0], "Unknown pass in '%s'!", argv[i] + 9);
+            passList = argv[i] + 9;
+        } else if (strncmp(argv[i], "--disable-pass=", 15) == 0) {
+            if (!arePassNames(argv[i] + 15))
+                usageError(argv[0], "Unknown pass in '%s'!", argv[i] + 15);
+            disabledPasses[numDisabledPasses++] = argv[i] + 15;
+        } else if (strcmp(argv[i], "--pass-stats") == 0) {
+            optionPassStats = true;
+        } else if (strncmp(argv[i], "--bounds-checks=", 16) == 0) {
+            if (strcmp(argv[i] + 16, "all") == 0) boundsChecks = BOUNDS_CHECKS_ALL;
+            else if (strcmp(argv[i] + 16, "elide") == 0) boundsChecks = BOUNDS_CHECKS_ELIDE;
+            else if (strcmp(argv[i] + 16, "none") == 0) boundsChecks = BOUNDS_CHECKS_NONE;
+            else usageError(argv[0], "Unknown bounds check mode '%s'!", argv[i] + 16);
+        } else if (strncmp(argv[i], "--inline-threshold=", 19) == 0) {
+            if (argv[i][19] < '0' || argv[i][19] > '9')
+                usageError(argv[0], "Invalid inline threshold '%s'!", argv[i] + 19);
+            inlineThreshold = atoi(argv[i] + 19);
+        } else if (strncmp(argv[i], "--clone-budget=", 15) == 0) {
+            if (argv[i][15] < '0' || argv[i][15] > '9')
+                usageError(argv[0], "Invalid clone budget '%s'!", argv[i] + 15);
+            cloneBudget = atoi(argv[i] + 15);
+        } else if (strncmp(argv[i], "--unroll=", 9) == 0) {
+            if (argv[i][9] < '0' || argv[i][9] > '9')
+                usageError(argv[0], "Invalid unroll factor '%s'!", argv[i] + 9);
+            unrollFactor = atoi(argv[i] + 9);
+        } else if (strncmp(argv[i], "--static-locals=", 16) == 0) {
+            if (argv[i][16] < '0' || argv[i][16] > '9')
+                usageError(argv[0], "Invalid size '%s'!", argv[i] + 16);
+            staticThreshold = atoi(argv[i] + 16);
+        } else if (strncmp(argv[i], "--mul-cycles=", 13) == 0) {
+            if (argv[i][13] < '1' || argv[i][13] > '9')
+                usageError(argv[0], "Invalid number of cycles '%s'!", argv[i] + 13);
+            mulCycles = atoi(argv[i] + 13);
+        } else if (strncmp(argv[i], "--div-cycles=", 13) == 0) {
+            if (argv[i][13] < '1' || argv[i][13] > '9')
+                usageError(argv[0], "Invalid number of cycles '%s'!", argv[i] + 13);
+            divCycles = atoi(argv[i] + 13);
+        } else if (strcmp(argv[i], "--profile-generate") == 0) {
+            optionProfileGenerate = true;
+        } else if (strncmp(argv[i], "--profile-use=", 14) == 0) {
+            if (argv[i][14] == '\0')
+                usageError(argv[0], "No profile given!");
+            profileFileName = argv[i] + 14;
+        } else if (strncmp(argv[i], "--target=", 9) == 0) {
+            if (strcmp(argv[i] + 9, "eco32") == 0) optionTargetX86 = false;
+            else if (strcmp(argv[i] + 9, "x86_64") == 0) optionTargetX86 = true;
+            else usageError(argv[0], "Unknown target '%s'!", argv[i] + 9);
+        } else if (strcmp(argv[i], "--opt-report") == 0) {
+            optionReport = true;
+        } else if (strcmp(argv[i], "--peephole-stats") == 0) {
+            optionPeepholeStats = true;
         } else if (strcmp(argv[i], "--version") == 0) {
             version(argv[0]);
             exit(0);
@@ -215,6 +379,21 @@ int main(int argc, char *argv[]) {
 
     if (inFileName == NULL)
         usageError(argv[0], "No input file");
+    if (optionTargetX86 && optionProfileGenerate)
+        usageError(argv[0], "The instrumentation for a profile is only available for the ECO32!");
+    /* a pass named in --passes runs with its default setting */
+    if (boundsChecks < 0)
+        boundsChecks = optimizationLevel == OPTIMIZE_SPEED || optimizationLevel == OPTIMIZE_SIZE || passList != NULL ?
+                       BOUNDS_CHECKS_ELIDE : BOUNDS_CHECKS_ALL;
+    if (inlineThreshold < 0)
+        inlineThreshold = optimizationLevel == OPTIMIZE_SPEED || passList != NULL ? DEFAULT_INLINE_THRESHOLD : 0;
+    if (cloneBudget < 0)
+        cloneBudget = optimizationLevel == OPTIMIZE_SPEED || passList != NULL ? DEFAULT_CLONE_BUDGET : 0;
+    if (unrollFactor < 0)
+        unrollFactor = optimizationLevel == OPTIMIZE_SPEED || passList != NULL ? DEFAULT_UNROLL_FACTOR : 0;
+    if (staticThreshold < 0)
+        staticThreshold = optimizationLevel == OPTIMIZE_SPEED || optimizationLevel == OPTIMIZE_SIZE || passList != NULL ?
+                          DEFAULT_STATIC_THRESHOLD : 0;
     // Only display usage if compiler is expected to run the code-generation phase
     if (outFileName == NULL &&
         !(optionTokens || optionParse || optionAbsyn || optionTables || optionVars || optionSemant))
@@ -243,7 +422,7 @@ int main(int argc, char *argv[]) {
         exit(0);
     }
 
-    if (optionAbsyn) {
+    if (optionAbsyn && optimizationLevel == OPTIMIZE_NONE && passList == NULL) {
         showAbsyn(program);
         exit(0);
     }
@@ -257,6 +436,37 @@ int main(int argc, char *argv[]) {
         exit(0);
     }
 
+    /* the counters are numbered before any optimization, so both builds number the same statements */
+    if (optionProfileGenerate || profileFileName != NULL) {
+        numCounters = numberProfileCounters(program);
+        if (profileFileName != NULL) readProfile(program, profileFileName);
+        if (optionProfileGenerate) numProfileCounters = numCounters;
+    }
+
+    passOptions.program = program;
+    passOptions.globalTable = globalTable;
+    passOptions.showReport = optionReport;
+    passOptions.boundsChecks = boundsChecks;
+    passOptions.inlineThreshold = inlineThreshold;
+    passOptions.cloneBudget = cloneBudget;
+    passOptions.unrollFactor = unrollFactor;
+    passOptions.staticThreshold = staticThreshold;
+    if (passList == NULL) {
+        selectDefaultPasses(optimizationLevel, &passOptions);
+    } else if (!selectPasses(passList)) {
+        usageError(argv[0], "Pass listed twice or out of order in '%s'!", passList);
+    }
+    for (i = 0; i < numDisabledPasses; i++) disablePasses(disabledPasses[i]);
+    if (optionTargetX86) disablePasses(X86_64_UNSUPPORTED_PASSES);
+
+    runPasses(&passOptions, PASS_STAGE_TREE);
+    if (optionAbsyn) {
+        showAbsyn(program);
+        if (optionPassStats) showPassStats();
+        exit(0);
+    }
+
+    runPasses(&passOptions, PASS_STAGE_MACHINE);
     allocVars(program, globalTable, optionVars);
     if (optionVars) exit(0);
 
@@ -264,7 +474,11 @@ int main(int argc, char *argv[]) {
     if (outFile == NULL) {
         error("Unable to open output file '%s'", outFileName);
     }
-    genCode(program, globalTable, outFile);
+    runPasses(&passOptions, PASS_STAGE_CODE);
+    if (optionTargetX86) genCodeX86(program, globalTable, outFile);
+    else genCode(program, globalTable, outFile);
     fclose(outFile);
+    if (optionPeepholeStats) showPeepholeStats();
+    if (optionPassStats) showPassStats();
     return 0;
 }
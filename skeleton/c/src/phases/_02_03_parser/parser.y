@@ -18,7 +18,7 @@ void yyerror(Program**, char *);
 
 %}
 
-%expect 0 //TODO Change?
+%expect 0
 %parse-param {Program** program}
 
 %union {
@@ -52,12 +52,171 @@ void yyerror(Program**, char *);
 %token	<stringVal>	IDENT
 %token	<intVal>	INTLIT
 
+%type	<globalDeclarationList>	program globalDeclarationList
+%type	<globalDeclaration>	globalDeclaration typeDeclaration procedureDeclaration
+%type	<typeExpression>	typeExpression
+%type	<parameterList>		parameterList nonEmptyParameterList
+%type	<parameterDeclaration>	parameterDeclaration
+%type	<variableList>		variableList
+%type	<variableDeclaration>	variableDeclaration
+%type	<statementList>		statementList
+%type	<statement>		statement
+%type	<expressionList>	argumentList nonEmptyArgumentList
+%type	<expression>		expression additiveExpression multiplicativeExpression
+%type	<expression>		unaryExpression primaryExpression
+%type	<variable>		variable
+
+%nonassoc		LOWER_THAN_ELSE
+%nonassoc		ELSE
+
 %start			program
 
 
 %%
 
-program			: INTLIT; //TODO (assignment 2 and 3): Just a dummy, needs to be replaced by the actual spl grammar.
+program			: globalDeclarationList
+			  { *program = $1; }
+			;
+
+globalDeclarationList	: /* empty */
+			  { $$ = emptyGlobalDeclarationList(); }
+			| globalDeclaration globalDeclarationList
+			  { $$ = newGlobalDeclarationList($1, $2); }
+			;
+
+globalDeclaration	: typeDeclaration
+			  { $$ = $1; }
+			| procedureDeclaration
+			  { $$ = $1; }
+			;
+
+typeDeclaration		: TYPE IDENT EQ typeExpression SEMIC
+			  { $$ = newTypeDeclaration($1.line, newIdentifier($2.val), $4); }
+			;
+
+typeExpression		: IDENT
+			  { $$ = newNamedTypeExpression($1.line, newIdentifier($1.val)); }
+			| ARRAY LBRACK INTLIT RBRACK OF typeExpression
+			  { $$ = newArrayTypeExpression($1.line, $6, $3.val); }
+			;
+
+procedureDeclaration	: PROC IDENT LPAREN parameterList RPAREN LCURL variableList statementList RCURL
+			  { $$ = newProcedureDeclaration($1.line, newIdentifier($2.val), $4, $7, $8); }
+			;
+
+parameterList		: /* empty */
+			  { $$ = emptyParameterList(); }
+			| nonEmptyParameterList
+			  { $$ = $1; }
+			;
+
+nonEmptyParameterList	: parameterDeclaration
+			  { $$ = newParameterList($1, emptyParameterList()); }
+			| parameterDeclaration COMMA nonEmptyParameterList
+			  { $$ = newParameterList($1, $3); }
+			;
+
+parameterDeclaration	: IDENT COLON typeExpression
+			  { $$ = newParameterDeclaration($1.line, newIdentifier($1.val), $3, false); }
+			| REF IDENT COLON typeExpression
+			  { $$ = newParameterDeclaration($2.line, newIdentifier($2.val), $4, true); }
+			;
+
+variableList		: /* empty */
+			  { $$ = emptyVariableList(); }
+			| variableDeclaration variableList
+			  { $$ = newVariableList($1, $2); }
+			;
+
+variableDeclaration	: VAR IDENT COLON typeExpression SEMIC
+			  { $$ = newVariableDeclaration($1.line, newIdentifier($2.val), $4); }
+			;
+
+statementList		: /* empty */
+			  { $$ = emptyStatementList(); }
+			| statement statementList
+			  { $$ = newStatementList($1, $2); }
+			;
+
+statement		: SEMIC
+			  { $$ = newEmptyStatement($1.line); }
+			| LCURL statementList RCURL
+			  { $$ = newCompoundStatement($1.line, $2); }
+			| variable ASGN expression SEMIC
+			  { $$ = newAssignStatement($2.line, $1, $3); }
+			| IF LPAREN expression RPAREN statement %prec LOWER_THAN_ELSE
+			  { $$ = newIfStatement($1.line, $3, $5, newEmptyStatement($1.line)); }
+			| IF LPAREN expression RPAREN statement ELSE statement
+			  { $$ = newIfStatement($1.line, $3, $5, $7); }
+			| WHILE LPAREN expression RPAREN statement
+			  { $$ = newWhileStatement($1.line, $3, $5); }
+			| IDENT LPAREN argumentList RPAREN SEMIC
+			  { $$ = newCallStatement($1.line, newIdentifier($1.val), $3); }
+			;
+
+argumentList		: /* empty */
+			  { $$ = emptyExpressionList(); }
+			| nonEmptyArgumentList
+			  { $$ = $1; }
+			;
+
+nonEmptyArgumentList	: expression
+			  { $$ = newExpressionList($1, emptyExpressionList()); }
+			| expression COMMA nonEmptyArgumentList
+			  { $$ = newExpressionList($1, $3); }
+			;
+
+expression		: additiveExpression
+			  { $$ = $1; }
+			| expression EQ additiveExpression
+			  { $$ = newBinaryExpression($2.line, ABSYN_OP_EQU, $1, $3); }
+			| expression NE additiveExpression
+			  { $$ = newBinaryExpression($2.line, ABSYN_OP_NEQ, $1, $3); }
+			| expression LT additiveExpression
+			  { $$ = newBinaryExpression($2.line, ABSYN_OP_LST, $1, $3); }
+			| expression LE additiveExpression
+			  { $$ = newBinaryExpression($2.line, ABSYN_OP_LSE, $1, $3); }
+			| expression GT additiveExpression
+			  { $$ = newBinaryExpression($2.line, ABSYN_OP_GRT, $1, $3); }
+			| expression GE additiveExpression
+			  { $$ = newBinaryExpression($2.line, ABSYN_OP_GRE, $1, $3); }
+			;
+
+additiveExpression	: multiplicativeExpression
+			  { $$ = $1; }
+			| additiveExpression PLUS multiplicativeExpression
+			  { $$ = newBinaryExpression($2.line, ABSYN_OP_ADD, $1, $3); }
+			| additiveExpression MINUS multiplicativeExpression
+			  { $$ = newBinaryExpression($2.line, ABSYN_OP_SUB, $1, $3); }
+			;
+
+multiplicativeExpression	: unaryExpression
+			  { $$ = $1; }
+			| multiplicativeExpression STAR unaryExpression
+			  { $$ = newBinaryExpression($2.line, ABSYN_OP_MUL, $1, $3); }
+			| multiplicativeExpression SLASH unaryExpression
+			  { $$ = newBinaryExpression($2.line, ABSYN_OP_DIV, $1, $3); }
+			;
+
+unaryExpression		: primaryExpression
+			  { $$ = $1; }
+			| MINUS unaryExpression
+			  { $$ = newBinaryExpression($1.line, ABSYN_OP_SUB, newIntLiteral($1.line, 0), $2); }
+			;
+
+primaryExpression	: INTLIT
+			  { $$ = newIntLiteral($1.line, $1.val); }
+			| variable
+			  { $$ = newVariableExpression($1->line, $1); }
+			| LPAREN expression RPAREN
+			  { $$ = $2; }
+			;
+
+variable		: IDENT
+			  { $$ = newNamedVariable($1.line, newIdentifier($1.val)); }
+			| variable LBRACK expression RBRACK
+			  { $$ = newArrayAccess($1->line, $1, $3); }
+			;
 
 %%
 
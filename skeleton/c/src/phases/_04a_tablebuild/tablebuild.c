@@ -13,10 +13,118 @@
 #define BOOL_BYTE_SIZE   4    /* size of a bool in bytes */
 #define INT_BYTE_SIZE    4    /* size of an int in bytes */
 
+static Type *typeOf(TypeExpression *typeExpression, SymbolTable *table);
+static ParamTypes *enterParameters(ParameterList *parameters, SymbolTable *localTable);
+static void enterTypeDeclaration(GlobalDeclaration *typeDec, SymbolTable *globalTable);
+static void enterProcedureDeclaration(GlobalDeclaration *procDec, SymbolTable *globalTable, bool showSymbolTables);
+static void checkMain(SymbolTable *globalTable);
+
+/**
+ * Computes the semantic type of a type expression and stores it in the expression.
+ */
+static Type *typeOf(TypeExpression *typeExpression, SymbolTable *table) {
+    Entry *entry;
+
+    switch (typeExpression->kind) {
+        case TYPEEXPRESSION_NAMEDTYPEEXPRESSION:
+            entry = lookup(table, typeExpression->u.namedTypeExpression.name);
+            if (entry == NULL) undefinedType(typeExpression->line, typeExpression->u.namedTypeExpression.name);
+            if (entry->kind != ENTRY_KIND_TYPE) notAType(typeExpression->line, typeExpression->u.namedTypeExpression.name);
+            typeExpression->dataType = entry->u.typeEntry.type;
+            break;
+        case TYPEEXPRESSION_ARRAYTYPEEXPRESSION:
+            typeExpression->dataType = newArrayType(typeExpression->u.arrayTypeExpression.arraySize,
+                                                    typeOf(typeExpression->u.arrayTypeExpression.baseType, table));
+            break;
+        default:
+            error("unknown type expression kind %d in typeOf", typeExpression->kind);
+    }
+    return typeExpression->dataType;
+}
+
+static void enterTypeDeclaration(GlobalDeclaration *typeDec, SymbolTable *globalTable) {
+    Type *type;
+
+    type = typeOf(typeDec->u.typeDeclaration.typeExpression, globalTable);
+    if (enter(globalTable, newTypeEntry(typeDec->name, type)) == NULL) redeclarationAsType(typeDec->line, typeDec->name);
+}
+
+/**
+ * Enters the parameters of a procedure into its local table and returns their types.
+ * The types are looked up in the local table, so a parameter hides a type of the same name.
+ */
+static ParamTypes *enterParameters(ParameterList *parameters, SymbolTable *localTable) {
+    ParameterDeclaration *parDec;
+    ParamTypes *paramTypes;
+    Type *type;
+
+    if (parameters->isEmpty) return emptyParamTypes();
+    parDec = parameters->head;
+    type = typeOf(parDec->typeExpression, localTable);
+    if (type->kind == TYPE_KIND_ARRAY && !parDec->isReference) mustBeAReferenceParameter(parDec->line, parDec->name);
+    if (enter(localTable, newVarEntry(parDec->name, type, parDec->isReference)) == NULL) {
+        redeclarationAsParameter(parDec->line, parDec->name);
+    }
+    paramTypes = newParamTypes(type, parDec->isReference, NULL);
+    paramTypes->next = enterParameters(parameters->tail, localTable);
+    return paramTypes;
+}
+
+/**
+ * Enters a procedure and its local variables. The parameters are checked before the procedure itself is entered.
+ */
+static void enterProcedureDeclaration(GlobalDeclaration *procDec, SymbolTable *globalTable, bool showSymbolTables) {
+    VariableDeclarationList *variables;
+    VariableDeclaration *varDec;
+    SymbolTable *localTable;
+    ParamTypes *paramTypes;
+
+    localTable = newTable(globalTable);
+    paramTypes = enterParameters(procDec->u.procedureDeclaration.parameters, localTable);
+    if (enter(globalTable, newProcEntry(procDec->name, paramTypes, localTable)) == NULL) {
+        redeclarationAsProcedure(procDec->line, procDec->name);
+    }
+    for (variables = procDec->u.procedureDeclaration.variables; !variables->isEmpty; variables = variables->tail) {
+        varDec = variables->head;
+        if (enter(localTable, newVarEntry(varDec->name, typeOf(varDec->typeExpression, localTable), false)) == NULL) {
+            redeclarationAsVariable(varDec->line, varDec->name);
+        }
+    }
+    if (showSymbolTables) {
+        printf("symbol table at end of procedure '%s':\n", procDec->name->string);
+        showTable(localTable);
+    }
+}
+
+static void checkMain(SymbolTable *globalTable) {
+    Entry *mainEntry;
+
+    mainEntry = lookup(globalTable, newIdentifier("main"));
+    if (mainEntry == NULL) mainIsMissing();
+    if (mainEntry->kind != ENTRY_KIND_PROC) mainIsNotAProcedure();
+    if (!mainEntry->u.procEntry.paramTypes->isEmpty) mainMustNotHaveParameters();
+}
+
 SymbolTable *buildSymbolTable(Program *program, bool showSymbolTables) {
+    SymbolTable *globalTable;
+    GlobalDeclarationList *declarations;
+
     intType = newPrimitiveType("int", INT_BYTE_SIZE);
     boolType = newPrimitiveType("boolean", BOOL_BYTE_SIZE);
 
-    //TODO (assignment 4a): Initialize a symbol table with all predefined symbols and fill it with user-defined symbols
-    notImplemented();
+    globalTable = initializeGlobalTable();
+    for (declarations = program; !declarations->isEmpty; declarations = declarations->tail) {
+        switch (declarations->head->kind) {
+            case DECLARATION_TYPEDECLARATION:
+                enterTypeDeclaration(declarations->head, globalTable);
+                break;
+            case DECLARATION_PROCEDUREDECLARATION:
+                enterProcedureDeclaration(declarations->head, globalTable, showSymbolTables);
+                break;
+            default:
+                error("unknown declaration kind %d in buildSymbolTable", declarations->head->kind);
+        }
+    }
+    checkMain(globalTable);
+    return globalTable;
 }
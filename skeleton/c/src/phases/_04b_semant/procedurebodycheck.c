@@ -8,8 +8,164 @@
 #include <types/types.h>
 #include <table/table.h>
 
+static Type *checkVariable(Variable *variable, SymbolTable *table);
+static Type *checkExpression(Expression *expression, SymbolTable *table);
+static void checkCall(Statement *callStatement, SymbolTable *table);
+static void checkStatement(Statement *statement, SymbolTable *table);
+static void checkStatementList(StatementList *statements, SymbolTable *table);
+
+/**
+ * Computes the semantic type of a variable and stores it in the variable.
+ */
+static Type *checkVariable(Variable *variable, SymbolTable *table) {
+    Entry *entry;
+    Type *arrayType;
+
+    switch (variable->kind) {
+        case VARIABLE_NAMEDVARIABLE:
+            entry = lookup(table, variable->u.namedVariable.name);
+            if (entry == NULL) undefinedVariable(variable->line, variable->u.namedVariable.name);
+            if (entry->kind != ENTRY_KIND_VAR) notAVariable(variable->line, variable->u.namedVariable.name);
+            variable->dataType = entry->u.varEntry.type;
+            break;
+        case VARIABLE_ARRAYACCESS:
+            arrayType = checkVariable(variable->u.arrayAccess.array, table);
+            if (arrayType->kind != TYPE_KIND_ARRAY) indexingNonArray(variable->line);
+            if (checkExpression(variable->u.arrayAccess.index, table) != intType) indexingWithNonInteger(variable->line);
+            variable->dataType = arrayType->u.arrayType.baseType;
+            break;
+        default:
+            error("unknown variable kind %d in checkVariable", variable->kind);
+    }
+    return variable->dataType;
+}
+
+/**
+ * Computes the semantic type of an expression and stores it in the expression.
+ * Comparisons are of type boolean, arithmetic operations of type int.
+ */
+static Type *checkExpression(Expression *expression, SymbolTable *table) {
+    Type *leftType, *rightType;
+
+    switch (expression->kind) {
+        case EXPRESSION_BINARYEXPRESSION:
+            leftType = checkExpression(expression->u.binaryExpression.leftOperand, table);
+            rightType = checkExpression(expression->u.binaryExpression.rightOperand, table);
+            if (leftType != rightType) operatorDifferentTypes(expression->line);
+            switch (expression->u.binaryExpression.operator) {
+                case ABSYN_OP_EQU:
+                case ABSYN_OP_NEQ:
+                case ABSYN_OP_LST:
+                case ABSYN_OP_LSE:
+                case ABSYN_OP_GRT:
+                case ABSYN_OP_GRE:
+                    if (leftType != intType) comparisonNonInteger(expression->line);
+                    expression->dataType = boolType;
+                    break;
+                case ABSYN_OP_ADD:
+                case ABSYN_OP_SUB:
+                case ABSYN_OP_MUL:
+                case ABSYN_OP_DIV:
+                    if (leftType != intType) arithmeticOperatorNonInteger(expression->line);
+                    expression->dataType = intType;
+                    break;
+                default:
+                    error("unknown operator %d in checkExpression", expression->u.binaryExpression.operator);
+            }
+            break;
+        case EXPRESSION_INTLITERAL:
+            expression->dataType = intType;
+            break;
+        case EXPRESSION_VARIABLEEXPRESSION:
+            expression->dataType = checkVariable(expression->u.variableExpression.variable, table);
+            break;
+        default:
+            error("unknown expression kind %d in checkExpression", expression->kind);
+    }
+    return expression->dataType;
+}
+
+/**
+ * Checks the arguments of a call one after another against the parameters of the called procedure.
+ * An argument passed to a reference parameter must be a variable.
+ */
+static void checkCall(Statement *callStatement, SymbolTable *table) {
+    Identifier *name;
+    Entry *entry;
+    ParamTypes *paramTypes;
+    ExpressionList *arguments;
+    int argumentIndex;
+
+    name = callStatement->u.callStatement.procedureName;
+    entry = lookup(table, name);
+    if (entry == NULL) undefinedProcedure(callStatement->line, name);
+    if (entry->kind != ENTRY_KIND_PROC) callOfNonProcedure(callStatement->line, name);
+    paramTypes = entry->u.procEntry.paramTypes;
+    arguments = callStatement->u.callStatement.argumentList;
+    for (argumentIndex = 1; !arguments->isEmpty; argumentIndex++) {
+        if (paramTypes->isEmpty) tooManyArguments(callStatement->line, name);
+        if (checkExpression(arguments->head, table) != paramTypes->type) {
+            argumentTypeMismatch(callStatement->line, name, argumentIndex);
+        }
+        if (paramTypes->isRef && arguments->head->kind != EXPRESSION_VARIABLEEXPRESSION) {
+            argumentMustBeAVariable(callStatement->line, name, argumentIndex);
+        }
+        arguments = arguments->tail;
+        paramTypes = paramTypes->next;
+    }
+    if (!paramTypes->isEmpty) tooFewArguments(callStatement->line, name);
+}
+
+static void checkStatement(Statement *statement, SymbolTable *table) {
+    Type *targetType;
+
+    switch (statement->kind) {
+        case STATEMENT_EMPTYSTATEMENT:
+            break;
+        case STATEMENT_COMPOUNDSTATEMENT:
+            checkStatementList(statement->u.compoundStatement.statements, table);
+            break;
+        case STATEMENT_ASSIGNSTATEMENT:
+            targetType = checkVariable(statement->u.assignStatement.target, table);
+            if (checkExpression(statement->u.assignStatement.value, table) != targetType) {
+                assignmentHasDifferentTypes(statement->line);
+            }
+            if (targetType != intType) assignmentRequiresIntegers(statement->line);
+            break;
+        case STATEMENT_IFSTATEMENT:
+            if (checkExpression(statement->u.ifStatement.condition, table) != boolType) {
+                ifConditionMustBeBoolean(statement->line);
+            }
+            checkStatement(statement->u.ifStatement.thenPart, table);
+            checkStatement(statement->u.ifStatement.elsePart, table);
+            break;
+        case STATEMENT_WHILESTATEMENT:
+            if (checkExpression(statement->u.whileStatement.condition, table) != boolType) {
+                whileConditionMustBeBoolean(statement->line);
+            }
+            checkStatement(statement->u.whileStatement.body, table);
+            break;
+        case STATEMENT_CALLSTATEMENT:
+            checkCall(statement, table);
+            break;
+        default:
+            error("unknown statement kind %d in checkStatement", statement->kind);
+    }
+}
+
+static void checkStatementList(StatementList *statements, SymbolTable *table) {
+    for (; !statements->isEmpty; statements = statements->tail) checkStatement(statements->head, table);
+}
+
 void check(Program *program, SymbolTable *globalTable) {
-    //TODO (assignment 4b): Check all procedure bodies for semantic errors
+    GlobalDeclarationList *declarations;
+    GlobalDeclaration *declaration;
+    Entry *procEntry;
 
-    notImplemented();
+    for (declarations = program; !declarations->isEmpty; declarations = declarations->tail) {
+        declaration = declarations->head;
+        if (declaration->kind != DECLARATION_PROCEDUREDECLARATION) continue;
+        procEntry = lookup(globalTable, declaration->name);
+        checkStatementList(declaration->u.procedureDeclaration.body, procEntry->u.procEntry.localTable);
+    }
 }
@@ -0,0 +1,815 @@
+/*
+ * boundscheck.c -- elimination of array bounds checks
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <limits.h>
+#include <util/errors.h>
+#include <util/memory.h>
+#include <absyn/absyn.h>
+#include <table/table.h>
+#include <types/types.h>
+#include "boundscheck.h"
+
+#define WIDENING_DELAY      3     /* iterations at a loop head before the bounds are widened */
+#define NARROWING_STEPS     2
+#define MAX_VERSIONED_SIZE  64    /* the maximal number of nodes of a loop that may be duplicated */
+
+/**
+ * The possible values of a variable or an expression.
+ * The bounds are stored with more than 32 bits, so the results of operations can be checked for overflow.
+ */
+typedef struct {
+    long long low;
+    long long high;
+} Range;
+
+/**
+ * The ranges of all tracked variables at a certain point of a procedure body.
+ */
+typedef struct {
+    bool reachable;
+    Range *ranges;
+} State;
+
+static SymbolTable *procedures;
+static SymbolTable *localTable;
+static Entry **tracked;
+static int numTracked;
+
+/* while recording, the checkIndex flags are set, otherwise the body of a loop is only analyzed */
+static bool recording;
+static int numAccesses;
+static int numEliminated;
+static int numVersioned;
+static int numCopiedAccesses;           /* accesses in the copies of versioned loops */
+static int numCopiedEliminated;
+static int smallestCheckedSize;
+
+static Range fullRange(void) {
+    Range range;
+
+    range.low = INT_MIN;
+    range.high = INT_MAX;
+    return range;
+}
+
+static Range newRange(long long low, long long high) {
+    Range range;
+
+    /* a value that does not fit into 32 bits has wrapped around */
+    if (low < INT_MIN || high > INT_MAX) return fullRange();
+    range.low = low;
+    range.high = high;
+    return range;
+}
+
+static long long min(long long a, long long b) {
+    return a < b ? a : b;
+}
+
+static long long max(long long a, long long b) {
+    return a > b ? a : b;
+}
+
+/*
+ * States
+ */
+
+static State *newState(bool reachable) {
+    State *state = allocate(sizeof(State));
+    int i;
+
+    state->reachable = reachable;
+    state->ranges = allocate((numTracked + 1) * sizeof(Range));
+    for (i = 0; i < numTracked; i++) {
+        state->ranges[i] = fullRange();
+    }
+    return state;
+}
+
+static State *copyState(State *state) {
+    State *copy = newState(state->reachable);
+
+    memcpy(copy->ranges, state->ranges, numTracked * sizeof(Range));
+    return copy;
+}
+
+static void releaseState(State *state) {
+    release(state->ranges);
+    release(state);
+}
+
+static void joinState(State *target, State *source) {
+    int i;
+
+    if (!source->reachable) return;
+    if (!target->reachable) {
+        memcpy(target->ranges, source->ranges, numTracked * sizeof(Range));
+        target->reachable = true;
+        return;
+    }
+    for (i = 0; i < numTracked; i++) {
+        target->ranges[i].low = min(target->ranges[i].low, source->ranges[i].low);
+        target->ranges[i].high = max(target->ranges[i].high, source->ranges[i].high);
+    }
+}
+
+/**
+ * Enlarges the state at a loop head, so that every bound which is still growing jumps to its extreme value.
+ * This guarantees that the iteration at the loop head terminates.
+ */
+static void widenState(State *head, State *next) {
+    int i;
+
+    if (!next->reachable) return;
+    if (!head->reachable) {
+        joinState(head, next);
+        return;
+    }
+    for (i = 0; i < numTracked; i++) {
+        if (next->ranges[i].low < head->ranges[i].low) head->ranges[i].low = INT_MIN;
+        if (next->ranges[i].high > head->ranges[i].high) head->ranges[i].high = INT_MAX;
+    }
+}
+
+static bool includedState(State *inner, State *outer) {
+    int i;
+
+    if (!inner->reachable) return true;
+    if (!outer->reachable) return false;
+    for (i = 0; i < numTracked; i++) {
+        if (inner->ranges[i].low < outer->ranges[i].low || inner->ranges[i].high > outer->ranges[i].high) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/*
+ * Ranges of expressions
+ */
+
+static int findTracked(Variable *variable) {
+    Entry *entry;
+    int i;
+
+    if (variable->kind != VARIABLE_NAMEDVARIABLE) return -1;
+    entry = lookup(localTable, variable->u.namedVariable.name);
+    for (i = 0; i < numTracked; i++) {
+        if (tracked[i] == entry) return i;
+    }
+    return -1;
+}
+
+static Range rangeOfExpression(Expression *expression, State *state);
+
+static Range rangeOfBinaryExpression(Expression *expression, State *state) {
+    Range left = rangeOfExpression(expression->u.binaryExpression.leftOperand, state);
+    Range right = rangeOfExpression(expression->u.binaryExpression.rightOperand, state);
+    long long a, b, c, d;
+
+    switch (expression->u.binaryExpression.operator) {
+        case ABSYN_OP_ADD:
+            return newRange(left.low + right.low, left.high + right.high);
+        case ABSYN_OP_SUB:
+            return newRange(left.low - right.high, left.high - right.low);
+        case ABSYN_OP_MUL:
+            a = left.low * right.low;
+            b = left.low * right.high;
+            c = left.high * right.low;
+            d = left.high * right.high;
+            return newRange(min(min(a, b), min(c, d)), max(max(a, b), max(c, d)));
+        case ABSYN_OP_DIV:
+            /* the quotient is monotonic in both operands, as long as the divisor does not change its sign */
+            if (right.low <= 0 && right.high >= 0) return fullRange();
+            a = left.low / right.low;
+            b = left.low / right.high;
+            c = left.high / right.low;
+            d = left.high / right.high;
+            return newRange(min(min(a, b), min(c, d)), max(max(a, b), max(c, d)));
+        default:
+            /* comparisons only occur as conditions */
+            return fullRange();
+    }
+}
+
+static Range rangeOfExpression(Expression *expression, State *state) {
+    int i;
+
+    switch (expression->kind) {
+        case EXPRESSION_INTLITERAL:
+            return newRange(expression->u.intLiteral.value, expression->u.intLiteral.value);
+        case EXPRESSION_VARIABLEEXPRESSION:
+            i = findTracked(expression->u.variableExpression.variable);
+            return i >= 0 ? state->ranges[i] : fullRange();
+        case EXPRESSION_BINARYEXPRESSION:
+            return rangeOfBinaryExpression(expression, state);
+        default:
+            error("unknown expression kind %d in rangeOfExpression", expression->kind);
+            return fullRange();
+    }
+}
+
+/*
+ * Conditions
+ */
+
+static binary_operator negate(binary_operator operator) {
+    switch (operator) {
+        case ABSYN_OP_EQU:
+            return ABSYN_OP_NEQ;
+        case ABSYN_OP_NEQ:
+            return ABSYN_OP_EQU;
+        case ABSYN_OP_LST:
+            return ABSYN_OP_GRE;
+        case ABSYN_OP_LSE:
+            return ABSYN_OP_GRT;
+        case ABSYN_OP_GRT:
+            return ABSYN_OP_LSE;
+        case ABSYN_OP_GRE:
+            return ABSYN_OP_LST;
+        default:
+            error("unknown comparison %d in negate", operator);
+            return operator;
+    }
+}
+
+/**
+ * Returns the operator for the comparison with swapped operands, e.g. a < b is the same as b > a.
+ */
+static binary_operator mirror(binary_operator operator) {
+    switch (operator) {
+        case ABSYN_OP_LST:
+            return ABSYN_OP_GRT;
+        case ABSYN_OP_LSE:
+            return ABSYN_OP_GRE;
+        case ABSYN_OP_GRT:
+            return ABSYN_OP_LST;
+        case ABSYN_OP_GRE:
+            return ABSYN_OP_LSE;
+        default:
+            return operator;
+    }
+}
+
+/**
+ * Narrows the range of a tracked variable, which is known to compare with a value in the given range.
+ */
+static void narrow(State *state, int i, binary_operator operator, Range other) {
+    Range *range = &state->ranges[i];
+
+    switch (operator) {
+        case ABSYN_OP_LST:
+            range->high = min(range->high, other.high - 1);
+            break;
+        case ABSYN_OP_LSE:
+            range->high = min(range->high, other.high);
+            break;
+        case ABSYN_OP_GRT:
+            range->low = max(range->low, other.low + 1);
+            break;
+        case ABSYN_OP_GRE:
+            range->low = max(range->low, other.low);
+            break;
+        case ABSYN_OP_EQU:
+            range->low = max(range->low, other.low);
+            range->high = min(range->high, other.high);
+            break;
+        case ABSYN_OP_NEQ:
+            if (other.low != other.high) break;
+            if (range->low == other.low) range->low++;
+            if (range->high == other.high) range->high--;
+            break;
+        default:
+            error("unknown comparison %d in narrow", operator);
+    }
+    if (range->low > range->high) state->reachable = false;
+}
+
+/**
+ * Narrows the state to the values, for which the condition has the given outcome.
+ */
+static void refine(State *state, Expression *condition, bool outcome) {
+    binary_operator operator;
+    Expression *left, *right;
+    int i;
+
+    if (!state->reachable || condition->kind != EXPRESSION_BINARYEXPRESSION) return;
+    operator = condition->u.binaryExpression.operator;
+    if (!outcome) operator = negate(operator);
+    left = condition->u.binaryExpression.leftOperand;
+    right = condition->u.binaryExpression.rightOperand;
+
+    if (left->kind == EXPRESSION_VARIABLEEXPRESSION) {
+        i = findTracked(left->u.variableExpression.variable);
+        if (i >= 0) narrow(state, i, operator, rangeOfExpression(right, state));
+    }
+    if (state->reachable && right->kind == EXPRESSION_VARIABLEEXPRESSION) {
+        i = findTracked(right->u.variableExpression.variable);
+        if (i >= 0) narrow(state, i, mirror(operator), rangeOfExpression(left, state));
+    }
+}
+
+/*
+ * Recording the array accesses
+ */
+
+static void visitExpression(Expression *expression, State *state);
+
+static void visitVariable(Variable *variable, State *state) {
+    Range index;
+    int size;
+
+    switch (variable->kind) {
+        case VARIABLE_NAMEDVARIABLE:
+            break;
+        case VARIABLE_ARRAYACCESS:
+            visitVariable(variable->u.arrayAccess.array, state);
+            visitExpression(variable->u.arrayAccess.index, state);
+            if (!recording) break;
+            index = rangeOfExpression(variable->u.arrayAccess.index, state);
+            size = variable->u.arrayAccess.array->dataType->u.arrayType.size;
+            numAccesses++;
+            /* code that is never reached needs no check either */
+            if (!state->reachable || (index.low >= 0 && index.high < size)) {
+                variable->u.arrayAccess.checkIndex = false;
+                numEliminated++;
+            } else {
+                variable->u.arrayAccess.checkIndex = true;
+                if (smallestCheckedSize < 0 || size < smallestCheckedSize) smallestCheckedSize = size;
+            }
+            break;
+        default:
+            error("unknown variable kind %d in visitVariable", variable->kind);
+    }
+}
+
+static void visitExpression(Expression *expression, State *state) {
+    switch (expression->kind) {
+        case EXPRESSION_INTLITERAL:
+            break;
+        case EXPRESSION_VARIABLEEXPRESSION:
+            visitVariable(expression->u.variableExpression.variable, state);
+            break;
+        case EXPRESSION_BINARYEXPRESSION:
+            visitExpression(expression->u.binaryExpression.leftOperand, state);
+            visitExpression(expression->u.binaryExpression.rightOperand, state);
+            break;
+        default:
+            error("unknown expression kind %d in visitExpression", expression->kind);
+    }
+}
+
+/*
+ * Analysis of statements
+ */
+
+static State *analyzeStatement(Statement *statement, State *in);
+
+static State *analyzeList(StatementList *statements, State *in) {
+    State *state, *next;
+
+    state = copyState(in);
+    while (!statements->isEmpty) {
+        next = analyzeStatement(statements->head, state);
+        releaseState(state);
+        state = next;
+        statements = statements->tail;
+    }
+    return state;
+}
+
+/**
+ * Computes the state after one execution of the loop body, joined with the state at loop entry.
+ */
+static State *iterateLoop(Statement *loop, State *in, State *head) {
+    State *bodyIn, *next;
+
+    bodyIn = copyState(head);
+    refine(bodyIn, loop->u.whileStatement.condition, true);
+    next = analyzeStatement(loop->u.whileStatement.body, bodyIn);
+    releaseState(bodyIn);
+    joinState(next, in);
+    return next;
+}
+
+/**
+ * Computes an invariant for the tracked variables at the head of a loop, without recording the accesses.
+ */
+static State *loopInvariant(Statement *loop, State *in) {
+    State *head, *next;
+    bool savedRecording;
+    int iteration;
+
+    savedRecording = recording;
+    recording = false;
+    head = copyState(in);
+    for (iteration = 0; ; iteration++) {
+        next = iterateLoop(loop, in, head);
+        if (includedState(next, head)) {
+            releaseState(next);
+            break;
+        }
+        if (iteration < WIDENING_DELAY) joinState(head, next);
+        else widenState(head, next);
+        releaseState(next);
+    }
+    /* the widening may have lost the bounds given by the loop condition, which are recovered here */
+    for (iteration = 0; iteration < NARROWING_STEPS; iteration++) {
+        next = iterateLoop(loop, in, head);
+        releaseState(head);
+        head = next;
+    }
+    recording = savedRecording;
+    return head;
+}
+
+static State *analyzeLoop(Statement *loop, State *in) {
+    State *head, *bodyIn, *bodyOut;
+
+    head = loopInvariant(loop, in);
+    visitExpression(loop->u.whileStatement.condition, head);
+    if (recording) {
+        bodyIn = copyState(head);
+        refine(bodyIn, loop->u.whileStatement.condition, true);
+        bodyOut = analyzeStatement(loop->u.whileStatement.body, bodyIn);
+        releaseState(bodyIn);
+        releaseState(bodyOut);
+    }
+    refine(head, loop->u.whileStatement.condition, false);
+    return head;
+}
+
+static int countNodes(Statement *statement);
+
+static int countNodesOfList(StatementList *statements) {
+    int nodes = 0;
+
+    while (!statements->isEmpty) {
+        nodes += countNodes(statements->head);
+        statements = statements->tail;
+    }
+    return nodes;
+}
+
+static int countNodes(Statement *statement) {
+    switch (statement->kind) {
+        case STATEMENT_COMPOUNDSTATEMENT:
+            return countNodesOfList(statement->u.compoundStatement.statements);
+        case STATEMENT_IFSTATEMENT:
+            return 1 + countNodes(statement->u.ifStatement.thenPart) + countNodes(statement->u.ifStatement.elsePart);
+        case STATEMENT_WHILESTATEMENT:
+            return 1 + countNodes(statement->u.whileStatement.body);
+        default:
+            return 1;
+    }
+}
+
+/**
+ * Builds the condition, which is tested once before a loop "while (i < n)" or "while (i <= n)",
+ * to decide whether the copy of the loop without bounds checks may run.
+ * @return The condition, or NULL if the loop does not have this form.
+ */
+static Expression *entryCondition(Statement *loop, int size) {
+    Expression *condition = loop->u.whileStatement.condition;
+    Expression *bound, *limit, *test;
+    binary_operator operator;
+
+    if (condition->kind != EXPRESSION_BINARYEXPRESSION) return NULL;
+    operator = condition->u.binaryExpression.operator;
+    if (operator != ABSYN_OP_LST && operator != ABSYN_OP_LSE) return NULL;
+    bound = condition->u.binaryExpression.rightOperand;
+    if (bound->kind != EXPRESSION_VARIABLEEXPRESSION || findTracked(bound->u.variableExpression.variable) < 0) {
+        return NULL;
+    }
+
+    /* i < n stays below size if n <= size, i <= n if n < size */
+    limit = newIntLiteral(condition->line, size);
+    limit->dataType = intType;
+    test = newBinaryExpression(condition->line, operator == ABSYN_OP_LST ? ABSYN_OP_LSE : ABSYN_OP_LST,
+                               copyExpression(bound), limit);
+    test->dataType = boolType;
+    return test;
+}
+
+/**
+ * Tries to hoist the remaining bounds checks of a loop, which has just been recorded, in front of the loop.
+ * The loop statement is replaced by "if (n <= size) copy else loop", where the copy is recorded
+ * with the knowledge gained from the test.
+ */
+static void versionLoop(Statement *loop, State *in, int eliminatedInLoop, int smallestSize) {
+    Expression *test;
+    Statement *copy, *original;
+    State *copyIn, *copyOut;
+    int savedAccesses, savedEliminated, savedCopiedAccesses, savedCopiedEliminated, savedSmallest;
+
+    if (smallestSize < 0 || countNodes(loop) > MAX_VERSIONED_SIZE) return;
+    test = entryCondition(loop, smallestSize);
+    if (test == NULL) return;
+
+    savedAccesses = numAccesses;
+    savedEliminated = numEliminated;
+    savedCopiedAccesses = numCopiedAccesses;
+    savedCopiedEliminated = numCopiedEliminated;
+    savedSmallest = smallestCheckedSize;
+    copy = copyStatement(loop);
+    copyIn = copyState(in);
+    refine(copyIn, test, true);
+    copyOut = analyzeLoop(copy, copyIn);
+    releaseState(copyIn);
+    releaseState(copyOut);
+
+    if (numEliminated - savedEliminated <= eliminatedInLoop) {
+        /* the test does not help, so the copy is dropped */
+        numAccesses = savedAccesses;
+        numEliminated = savedEliminated;
+        numCopiedAccesses = savedCopiedAccesses;
+        numCopiedEliminated = savedCopiedEliminated;
+        smallestCheckedSize = savedSmallest;
+        return;
+    }
+    /* the accesses of the copy are not in the source, so they are counted apart */
+    numCopiedAccesses += numAccesses - savedAccesses;
+    numCopiedEliminated += numEliminated - savedEliminated;
+    numAccesses = savedAccesses;
+    numEliminated = savedEliminated;
+    smallestCheckedSize = savedSmallest;
+    original = newWhileStatement(loop->line, loop->u.whileStatement.condition, loop->u.whileStatement.body);
+    loop->kind = STATEMENT_IFSTATEMENT;
+    loop->u.ifStatement.condition = test;
+    loop->u.ifStatement.thenPart = copy;
+    loop->u.ifStatement.elsePart = original;
+    numVersioned++;
+}
+
+static State *analyzeStatement(Statement *statement, State *in) {
+    State *out, *thenIn, *elseIn, *elseOut;
+    ExpressionList *arguments;
+    int i, eliminatedBefore, savedSmallest, smallestSize;
+
+    switch (statement->kind) {
+        case STATEMENT_EMPTYSTATEMENT:
+            return copyState(in);
+        case STATEMENT_COMPOUNDSTATEMENT:
+            return analyzeList(statement->u.compoundStatement.statements, in);
+        case STATEMENT_ASSIGNSTATEMENT:
+            visitVariable(statement->u.assignStatement.target, in);
+            visitExpression(statement->u.assignStatement.value, in);
+            out = copyState(in);
+            i = findTracked(statement->u.assignStatement.target);
+            if (i >= 0) out->ranges[i] = rangeOfExpression(statement->u.assignStatement.value, in);
+            return out;
+        case STATEMENT_IFSTATEMENT:
+            visitExpression(statement->u.ifStatement.condition, in);
+            thenIn = copyState(in);
+            refine(thenIn, statement->u.ifStatement.condition, true);
+            elseIn = copyState(in);
+            refine(elseIn, statement->u.ifStatement.condition, false);
+            out = analyzeStatement(statement->u.ifStatement.thenPart, thenIn);
+            releaseState(thenIn);
+            elseOut = analyzeStatement(statement->u.ifStatement.elsePart, elseIn);
+            releaseState(elseIn);
+            joinState(out, elseOut);
+            releaseState(elseOut);
+            return out;
+        case STATEMENT_WHILESTATEMENT:
+            if (!recording) return analyzeLoop(statement, in);
+            eliminatedBefore = numEliminated;
+            savedSmallest = smallestCheckedSize;
+            smallestCheckedSize = -1;
+            out = analyzeLoop(statement, in);
+            smallestSize = smallestCheckedSize;
+            if (savedSmallest >= 0 && (smallestCheckedSize < 0 || savedSmallest < smallestCheckedSize)) {
+                smallestCheckedSize = savedSmallest;
+            }
+            /* the state after the loop covers the executions of both versions */
+            versionLoop(statement, in, numEliminated - eliminatedBefore, smallestSize);
+            return out;
+        case STATEMENT_CALLSTATEMENT:
+            /* tracked variables are never passed by reference, so the call cannot change them */
+            arguments = statement->u.callStatement.argumentList;
+            while (!arguments->isEmpty) {
+                visitExpression(arguments->head, in);
+                arguments = arguments->tail;
+            }
+            return copyState(in);
+        default:
+            error("unknown statement kind %d in analyzeStatement", statement->kind);
+            return NULL;
+    }
+}
+
+/*
+ * Selection of the tracked variables
+ */
+
+static void untrack(Variable *variable) {
+    int i = findTracked(variable);
+
+    if (i < 0) return;
+    tracked[i] = tracked[--numTracked];
+}
+
+static void untrackReferenceArguments(Statement *statement);
+
+static void untrackReferenceArgumentsOfList(StatementList *statements) {
+    while (!statements->isEmpty) {
+        untrackReferenceArguments(statements->head);
+        statements = statements->tail;
+    }
+}
+
+static void untrackReferenceArguments(Statement *statement) {
+    Entry *procEntry;
+    ParamTypes *paramTypes;
+    ExpressionList *arguments;
+
+    switch (statement->kind) {
+        case STATEMENT_COMPOUNDSTATEMENT:
+            untrackReferenceArgumentsOfList(statement->u.compoundStatement.statements);
+            break;
+        case STATEMENT_IFSTATEMENT:
+            untrackReferenceArguments(statement->u.ifStatement.thenPart);
+            untrackReferenceArguments(statement->u.ifStatement.elsePart);
+            break;
+        case STATEMENT_WHILESTATEMENT:
+            untrackReferenceArguments(statement->u.whileStatement.body);
+            break;
+        case STATEMENT_CALLSTATEMENT:
+            procEntry = lookup(procedures, statement->u.callStatement.procedureName);
+            paramTypes = procEntry->u.procEntry.paramTypes;
+            arguments = statement->u.callStatement.argumentList;
+            while (!arguments->isEmpty && !paramTypes->isEmpty) {
+                if (paramTypes->isRef && arguments->head->kind == EXPRESSION_VARIABLEEXPRESSION) {
+                    untrack(arguments->head->u.variableExpression.variable);
+                }
+                arguments = arguments->tail;
+                paramTypes = paramTypes->next;
+            }
+            break;
+        default:
+            break;
+    }
+}
+
+static void track(Identifier *name) {
+    Entry *entry = lookup(localTable, name);
+
+    if (entry->kind != ENTRY_KIND_VAR || entry->u.varEntry.isRef || entry->u.varEntry.type != intType) return;
+    tracked[numTracked++] = entry;
+}
+
+/*
+ * Removing all checks
+ */
+
+static void omitChecksOfExpression(Expression *expression);
+
+static void omitChecksOfVariable(Variable *variable) {
+    if (variable->kind != VARIABLE_ARRAYACCESS) return;
+    omitChecksOfVariable(variable->u.arrayAccess.array);
+    omitChecksOfExpression(variable->u.arrayAccess.index);
+    variable->u.arrayAccess.checkIndex = false;
+    numAccesses++;
+    numEliminated++;
+}
+
+static void omitChecksOfExpression(Expression *expression) {
+    switch (expression->kind) {
+        case EXPRESSION_INTLITERAL:
+            break;
+        case EXPRESSION_VARIABLEEXPRESSION:
+            omitChecksOfVariable(expression->u.variableExpression.variable);
+            break;
+        case EXPRESSION_BINARYEXPRESSION:
+            omitChecksOfExpression(expression->u.binaryExpression.leftOperand);
+            omitChecksOfExpression(expression->u.binaryExpression.rightOperand);
+            break;
+        default:
+            error("unknown expression kind %d in omitChecksOfExpression", expression->kind);
+    }
+}
+
+static void omitChecks(Statement *statement);
+
+static void omitChecksOfList(StatementList *statements) {
+    while (!statements->isEmpty) {
+        omitChecks(statements->head);
+        statements = statements->tail;
+    }
+}
+
+static void omitChecks(Statement *statement) {
+    ExpressionList *arguments;
+
+    switch (statement->kind) {
+        case STATEMENT_EMPTYSTATEMENT:
+            break;
+        case STATEMENT_COMPOUNDSTATEMENT:
+            omitChecksOfList(statement->u.compoundStatement.statements);
+            break;
+        case STATEMENT_ASSIGNSTATEMENT:
+            omitChecksOfVariable(statement->u.assignStatement.target);
+            omitChecksOfExpression(statement->u.assignStatement.value);
+            break;
+        case STATEMENT_IFSTATEMENT:
+            omitChecksOfExpression(statement->u.ifStatement.condition);
+            omitChecks(statement->u.ifStatement.thenPart);
+            omitChecks(statement->u.ifStatement.elsePart);
+            break;
+        case STATEMENT_WHILESTATEMENT:
+            omitChecksOfExpression(statement->u.whileStatement.condition);
+            omitChecks(statement->u.whileStatement.body);
+            break;
+        case STATEMENT_CALLSTATEMENT:
+            arguments = statement->u.callStatement.argumentList;
+            while (!arguments->isEmpty) {
+                omitChecksOfExpression(arguments->head);
+                arguments = arguments->tail;
+            }
+            break;
+        default:
+            error("unknown statement kind %d in omitChecks", statement->kind);
+    }
+}
+
+static void elideProcedureChecks(GlobalDeclaration *procDec) {
+    Entry *procEntry;
+    ParameterList *parameters;
+    VariableDeclarationList *variables;
+    State *in, *out;
+    int count;
+
+    procEntry = lookup(procedures, procDec->name);
+    localTable = procEntry->u.procEntry.localTable;
+
+    count = 0;
+    for (parameters = procDec->u.procedureDeclaration.parameters; !parameters->isEmpty; parameters = parameters->tail) {
+        count++;
+    }
+    for (variables = procDec->u.procedureDeclaration.variables; !variables->isEmpty; variables = variables->tail) {
+        count++;
+    }
+    tracked = allocate((count + 1) * sizeof(Entry *));
+    numTracked = 0;
+    for (parameters = procDec->u.procedureDeclaration.parameters; !parameters->isEmpty; parameters = parameters->tail) {
+        track(parameters->head->name);
+    }
+    for (variables = procDec->u.procedureDeclaration.variables; !variables->isEmpty; variables = variables->tail) {
+        track(variables->head->name);
+    }
+    untrackReferenceArgumentsOfList(procDec->u.procedureDeclaration.body);
+
+    /* parameters and uninitialized local variables may hold any value at procedure entry */
+    recording = true;
+    smallestCheckedSize = -1;
+    in = newState(true);
+    out = analyzeList(procDec->u.procedureDeclaration.body, in);
+    releaseState(in);
+    releaseState(out);
+    release(tracked);
+}
+
+int elideBoundsChecks(Program *program, SymbolTable *globalTable, bounds_check_mode mode, bool showReport) {
+    GlobalDeclarationList *declarationList;
+    GlobalDeclaration *declaration;
+    int total;
+
+    procedures = globalTable;
+    total = 0;
+    for (declarationList = program; !declarationList->isEmpty; declarationList = declarationList->tail) {
+        declaration = declarationList->head;
+        if (declaration->kind != DECLARATION_PROCEDUREDECLARATION) continue;
+
+        numAccesses = 0;
+        numEliminated = 0;
+        numVersioned = 0;
+        numCopiedAccesses = 0;
+        numCopiedEliminated = 0;
+        switch (mode) {
+            case BOUNDS_CHECKS_ALL:
+                break;
+            case BOUNDS_CHECKS_ELIDE:
+                elideProcedureChecks(declaration);
+                break;
+            case BOUNDS_CHECKS_NONE:
+                omitChecksOfList(declaration->u.procedureDeclaration.body);
+                break;
+            default:
+                error("unknown bounds check mode %d in elideBoundsChecks", mode);
+        }
+        total += numEliminated + numCopiedEliminated;
+
+        if (showReport) {
+            printf("\nBounds checks for procedure '%s'\n", declaration->name->string);
+            printf("eliminated = %d of %d\n", numEliminated, numAccesses);
+            if (numVersioned > 0) {
+                printf("loops with checks hoisted to the loop entry = %d\n", numVersioned);
+                printf("eliminated in their copies = %d of %d\n", numCopiedEliminated, numCopiedAccesses);
+            }
+        }
+    }
+    return total;
+}
@@ -0,0 +1,45 @@
+/*
+ * boundscheck.h -- elimination of array bounds checks
+ */
+
+
+#ifndef _BOUNDSCHECK_H_
+#define _BOUNDSCHECK_H_
+
+#include <absyn/absyn.h>
+#include <table/table.h>
+
+/**
+ * Used to select which array accesses keep their bounds check.
+ */
+typedef enum {
+    BOUNDS_CHECKS_ALL,      /* every index is checked */
+    BOUNDS_CHECKS_ELIDE,    /* checks that can never fail are omitted */
+    BOUNDS_CHECKS_NONE      /* no index is checked at all */
+} bounds_check_mode;
+
+/**
+ * This function clears the checkIndex flag of array accesses whose bounds check can be omitted.
+ *
+ * In the mode BOUNDS_CHECKS_ELIDE a range analysis computes an interval for every scalar variable of type int,
+ * that is never passed as an argument for a reference parameter, at every point of a procedure body.
+ * Loop conditions narrow the intervals of induction variables, so an access like a[i] inside of
+ * "i := 0; while (i < 10) ..." is known to be in range for an array of size 10 or more.
+ *
+ * If the bound of a loop like "while (i < n)" is a variable, whose value is only known at loop entry,
+ * the loop is duplicated: the copy without checks runs if a single test of n before the loop
+ * proves every access to be in range, otherwise the original loop runs with all its checks.
+ * This way an index error still occurs at the same point of the execution as without optimization.
+ * The report counts the accesses of these copies apart from the accesses of the source program.
+ *
+ * The pass has to run after the semantic analysis.
+ *
+ * @param program The program whose array accesses are examined.
+ * @param globalTable The symbol table for the current program.
+ * @param mode Selects which checks are kept.
+ * @param showReport Whether the number of eliminated checks should be printed for every procedure.
+ * @return The number of array accesses without a bounds check.
+ */
+int elideBoundsChecks(Program *program, SymbolTable *globalTable, bounds_check_mode mode, bool showReport);
+
+#endif /* _BOUNDSCHECK_H_ */
@@ -0,0 +1,93 @@
+/*
+ * callgraph.c -- call graph of the procedures declared in a program
+ */
+
+#include <string.h>
+#include <util/errors.h>
+#include <util/memory.h>
+#include <absyn/absyn.h>
+#include <table/table.h>
+#include "callgraph.h"
+
+static CallGraph *graph;
+
+CallGraphNode *findCallGraphNode(CallGraph *callGraph, Identifier *name) {
+    int i;
+
+    for (i = 0; i < callGraph->numNodes; i++) {
+        if (callGraph->nodes[i].declaration->name == name) return &callGraph->nodes[i];
+    }
+    return NULL;
+}
+
+static void addCallee(CallGraphNode *caller, CallGraphNode *callee) {
+    int i;
+
+    callee->numCallSites++;
+    for (i = 0; i < caller->numCallees; i++) {
+        if (caller->callees[i] == callee) return;
+    }
+    caller->callees[caller->numCallees++] = callee;
+}
+
+static void collectCall(Statement *call, void *data) {
+    CallGraphNode *callee;
+
+    callee = findCallGraphNode(graph, call->u.callStatement.procedureName);
+    if (callee != NULL) addCallee(data, callee);
+}
+
+static void markReachable(CallGraphNode *node, bool *reachable) {
+    int i;
+
+    for (i = 0; i < node->numCallees; i++) {
+        if (reachable[node->callees[i] - graph->nodes]) continue;
+        reachable[node->callees[i] - graph->nodes] = true;
+        markReachable(node->callees[i], reachable);
+    }
+}
+
+CallGraph *buildCallGraph(Program *program, SymbolTable *globalTable) {
+    GlobalDeclarationList *declarationList;
+    CallGraphNode *node;
+    bool *reachable;
+    int i;
+
+    graph = allocate(sizeof(CallGraph));
+    graph->numNodes = 0;
+    for (declarationList = program; !declarationList->isEmpty; declarationList = declarationList->tail) {
+        if (declarationList->head->kind == DECLARATION_PROCEDUREDECLARATION) graph->numNodes++;
+    }
+    graph->nodes = allocate((graph->numNodes + 1) * sizeof(CallGraphNode));
+    i = 0;
+    for (declarationList = program; !declarationList->isEmpty; declarationList = declarationList->tail) {
+        if (declarationList->head->kind != DECLARATION_PROCEDUREDECLARATION) continue;
+        node = &graph->nodes[i++];
+        node->declaration = declarationList->head;
+        node->entry = lookup(globalTable, node->declaration->name);
+        node->numCallees = 0;
+        node->callees = allocate((graph->numNodes + 1) * sizeof(CallGraphNode *));
+        node->numCallSites = 0;
+        node->isRecursive = false;
+    }
+    for (i = 0; i < graph->numNodes; i++) {
+        forEachCallInList(graph->nodes[i].declaration->u.procedureDeclaration.body, collectCall, &graph->nodes[i]);
+    }
+
+    reachable = allocate((graph->numNodes + 1) * sizeof(bool));
+    for (i = 0; i < graph->numNodes; i++) {
+        memset(reachable, 0, graph->numNodes * sizeof(bool));
+        markReachable(&graph->nodes[i], reachable);
+        graph->nodes[i].isRecursive = reachable[i];
+    }
+    release(reachable);
+    return graph;
+}
+
+void releaseCallGraph(CallGraph *callGraph) {
+    int i;
+
+    for (i = 0; i < callGraph->numNodes; i++) release(callGraph->nodes[i].callees);
+    release(callGraph->nodes);
+    release(callGraph);
+}
@@ -0,0 +1,55 @@
+/*
+ * callgraph.h -- call graph of the procedures declared in a program
+ */
+
+
+#ifndef _CALLGRAPH_H_
+#define _CALLGRAPH_H_
+
+#include <stdbool.h>
+#include <absyn/absyn.h>
+#include <table/table.h>
+
+/**
+ * A procedure declared in the program, with the procedures it calls.
+ * The predefined procedures are no nodes, since they never call back into the program.
+ */
+typedef struct callgraphnode {
+    GlobalDeclaration *declaration;
+    Entry *entry;
+    int numCallees;
+    struct callgraphnode **callees;     /* every procedure called by this one, only once */
+    int numCallSites;                   /* the calls of this procedure in the whole program */
+    bool isRecursive;                   /* the procedure may call itself, directly or indirectly */
+} CallGraphNode;
+
+/**
+ * The call graph of a program, with one node for every procedure declaration.
+ */
+typedef struct {
+    int numNodes;
+    CallGraphNode *nodes;               /* in the order of the declarations */
+} CallGraph;
+
+/**
+ * Builds the call graph of a program and finds the recursive procedures.
+ * A procedure is recursive if it can reach itself along the edges of the graph.
+ * @param program The program whose calls are collected.
+ * @param globalTable The symbol table for the current program.
+ * @return The call graph, which has to be released by releaseCallGraph.
+ */
+CallGraph *buildCallGraph(Program *program, SymbolTable *globalTable);
+
+/**
+ * @param graph The call graph.
+ * @param name The name of a procedure.
+ * @return The node of the procedure, or NULL if it is a predefined one.
+ */
+CallGraphNode *findCallGraphNode(CallGraph *graph, Identifier *name);
+
+/**
+ * Releases the memory of a call graph.
+ */
+void releaseCallGraph(CallGraph *graph);
+
+#endif /* _CALLGRAPH_H_ */
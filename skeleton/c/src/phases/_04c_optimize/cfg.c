@@ -0,0 +1,332 @@
+/*
+ * cfg.c -- control flow graph, dominator tree and loop nesting forest
+ */
+
+#include <string.h>
+#include <util/errors.h>
+#include <util/memory.h>
+#include <absyn/absyn.h>
+#include "cfg.h"
+
+/*
+ * Growing arrays
+ */
+
+static void *grow(void *array, int length, int elementSize) {
+    void *larger;
+
+    /* the capacity is doubled whenever the length reaches a power of two */
+    if (length == 0) return allocate(elementSize);
+    if ((length & (length - 1)) != 0) return array;
+    larger = allocate(2 * length * elementSize);
+    memcpy(larger, array, length * elementSize);
+    release(array);
+    return larger;
+}
+
+/*
+ * Construction
+ */
+
+typedef struct {
+    int numBlocks;
+    Block **blocks;     /* in the order of creation */
+} Builder;
+
+static Block *newBlock(Builder *builder) {
+    Block *block;
+
+    block = allocate(sizeof(Block));
+    block->number = -1;
+    block->numStatements = 0;
+    block->statements = NULL;
+    block->numSuccessors = 0;
+    block->numPredecessors = 0;
+    block->predecessors = NULL;
+    block->immediateDominator = NULL;
+    block->loop = NULL;
+    builder->blocks = grow(builder->blocks, builder->numBlocks, sizeof(Block *));
+    builder->blocks[builder->numBlocks++] = block;
+    return block;
+}
+
+static void appendStatement(Block *block, Statement *statement) {
+    block->statements = grow(block->statements, block->numStatements, sizeof(Statement *));
+    block->statements[block->numStatements++] = statement;
+}
+
+static void addEdge(Block *from, Block *to) {
+    if (from->numSuccessors == 2) error("block with more than two successors");
+    from->successors[from->numSuccessors++] = to;
+    to->predecessors = grow(to->predecessors, to->numPredecessors, sizeof(Block *));
+    to->predecessors[to->numPredecessors++] = from;
+}
+
+static Block *buildStatement(Builder *builder, Block *current, Statement *statement);
+
+static Block *buildStatementList(Builder *builder, Block *current, StatementList *statements) {
+    while (!statements->isEmpty) {
+        current = buildStatement(builder, current, statements->head);
+        statements = statements->tail;
+    }
+    return current;
+}
+
+/**
+ * Adds a statement to the graph.
+ * @return The block in which the execution continues after the statement.
+ */
+static Block *buildStatement(Builder *builder, Block *current, Statement *statement) {
+    Block *thenBlock, *elseBlock, *join, *header, *body, *after;
+
+    switch (statement->kind) {
+        case STATEMENT_EMPTYSTATEMENT:
+        case STATEMENT_ASSIGNSTATEMENT:
+        case STATEMENT_CALLSTATEMENT:
+            appendStatement(current, statement);
+            return current;
+        case STATEMENT_COMPOUNDSTATEMENT:
+            return buildStatementList(builder, current, statement->u.compoundStatement.statements);
+        case STATEMENT_IFSTATEMENT:
+            appendStatement(current, statement);
+            thenBlock = newBlock(builder);
+            elseBlock = newBlock(builder);
+            addEdge(current, thenBlock);
+            addEdge(current, elseBlock);
+            thenBlock = buildStatement(builder, thenBlock, statement->u.ifStatement.thenPart);
+            elseBlock = buildStatement(builder, elseBlock, statement->u.ifStatement.elsePart);
+            join = newBlock(builder);
+            addEdge(thenBlock, join);
+            addEdge(elseBlock, join);
+            return join;
+        case STATEMENT_WHILESTATEMENT:
+            header = newBlock(builder);
+            addEdge(current, header);
+            appendStatement(header, statement);
+            body = newBlock(builder);
+            addEdge(header, body);
+            body = buildStatement(builder, body, statement->u.whileStatement.body);
+            addEdge(body, header);
+            after = newBlock(builder);
+            addEdge(header, after);
+            return after;
+        default:
+            error("unknown statement kind %d in buildStatement", statement->kind);
+            return current;
+    }
+}
+
+/*
+ * Reverse postorder
+ */
+
+static void numberPostorder(Block *block, Block **postorder, int *count) {
+    int i;
+
+    block->number = 0;      /* visited */
+    for (i = 0; i < block->numSuccessors; i++) {
+        if (block->successors[i]->number < 0) numberPostorder(block->successors[i], postorder, count);
+    }
+    postorder[(*count)++] = block;
+}
+
+static void orderBlocks(ControlFlowGraph *graph, Builder *builder) {
+    Block **postorder;
+    int i, count;
+
+    postorder = allocate(builder->numBlocks * sizeof(Block *));
+    count = 0;
+    numberPostorder(graph->entry, postorder, &count);
+    /* every block of a structured body is reachable */
+    if (count != builder->numBlocks) error("unreachable block in control flow graph");
+    graph->numBlocks = count;
+    graph->blocks = allocate(count * sizeof(Block *));
+    for (i = 0; i < count; i++) {
+        graph->blocks[i] = postorder[count - 1 - i];
+        graph->blocks[i]->number = i;
+    }
+    release(postorder);
+}
+
+/*
+ * Dominators
+ */
+
+static Block *intersect(Block *first, Block *second) {
+    while (first != second) {
+        while (first->number > second->number) first = first->immediateDominator;
+        while (second->number > first->number) second = second->immediateDominator;
+    }
+    return first;
+}
+
+static void computeDominators(ControlFlowGraph *graph) {
+    Block *block, *dominator;
+    bool changed;
+    int i, j;
+
+    graph->entry->immediateDominator = graph->entry;
+    do {
+        changed = false;
+        for (i = 1; i < graph->numBlocks; i++) {
+            block = graph->blocks[i];
+            dominator = NULL;
+            for (j = 0; j < block->numPredecessors; j++) {
+                if (block->predecessors[j]->immediateDominator == NULL) continue;
+                dominator = dominator == NULL ? block->predecessors[j] : intersect(block->predecessors[j], dominator);
+            }
+            if (block->immediateDominator != dominator) {
+                block->immediateDominator = dominator;
+                changed = true;
+            }
+        }
+    } while (changed);
+    graph->entry->immediateDominator = NULL;
+}
+
+bool dominates(Block *dominator, Block *block) {
+    while (block != NULL) {
+        if (block == dominator) return true;
+        block = block->immediateDominator;
+    }
+    return false;
+}
+
+/*
+ * Loops
+ */
+
+static int markLoopBlocks(Loop *loop, Block *block, bool *inLoop) {
+    int i, count;
+
+    if (inLoop[block->number]) return 0;
+    inLoop[block->number] = true;
+    block->loop = loop;
+    count = 1;
+    if (block == loop->header) return count;
+    for (i = 0; i < block->numPredecessors; i++) {
+        count += markLoopBlocks(loop, block->predecessors[i], inLoop);
+    }
+    return count;
+}
+
+static Loop *newLoop(Block *header, Block *latch) {
+    Loop *loop;
+
+    loop = allocate(sizeof(Loop));
+    loop->statement = header->statements[header->numStatements - 1];
+    if (loop->statement->kind != STATEMENT_WHILESTATEMENT) error("loop header without while-statement");
+    loop->header = header;
+    loop->latch = latch;
+    loop->parent = header->loop;
+    loop->depth = loop->parent == NULL ? 1 : loop->parent->depth + 1;
+    loop->children = NULL;
+    return loop;
+}
+
+/**
+ * Finds the loops from the back edges, i.e. edges to a block dominating their source.
+ * The headers are visited in reverse postorder, so an enclosing loop is always found before the loops
+ * nested in it, and the loop field of a block ends up holding the innermost loop.
+ */
+static void findLoops(ControlFlowGraph *graph) {
+    Loop *loop, **last;
+    Block *header;
+    bool *inLoop;
+    int i, j;
+
+    inLoop = allocate(graph->numBlocks * sizeof(bool));
+    for (i = 0; i < graph->numBlocks; i++) {
+        header = graph->blocks[i];
+        for (j = 0; j < header->numPredecessors; j++) {
+            if (!dominates(header, header->predecessors[j])) continue;
+            loop = newLoop(header, header->predecessors[j]);
+            memset(inLoop, 0, graph->numBlocks * sizeof(bool));
+            loop->numBlocks = markLoopBlocks(loop, loop->latch, inLoop);
+
+            /* keep the siblings in the order of the program */
+            last = loop->parent == NULL ? &graph->loops : &loop->parent->children;
+            while (*last != NULL) last = &(*last)->next;
+            loop->next = NULL;
+            *last = loop;
+        }
+    }
+    release(inLoop);
+}
+
+bool loopContains(Loop *loop, Block *block) {
+    Loop *enclosing;
+
+    for (enclosing = block->loop; enclosing != NULL; enclosing = enclosing->parent) {
+        if (enclosing == loop) return true;
+    }
+    return false;
+}
+
+/*
+ * Interface
+ */
+
+ControlFlowGraph *buildControlFlowGraph(StatementList *body) {
+    ControlFlowGraph *graph;
+    Builder builder;
+    Block *last;
+
+    builder.numBlocks = 0;
+    builder.blocks = NULL;
+    graph = allocate(sizeof(ControlFlowGraph));
+    graph->entry = newBlock(&builder);
+    last = buildStatementList(&builder, graph->entry, body);
+    graph->exit = newBlock(&builder);
+    addEdge(last, graph->exit);
+    graph->loops = NULL;
+
+    orderBlocks(graph, &builder);
+    release(builder.blocks);
+    computeDominators(graph);
+    findLoops(graph);
+    return graph;
+}
+
+static void freeLoops(Loop *loop) {
+    Loop *next;
+
+    while (loop != NULL) {
+        next = loop->next;
+        freeLoops(loop->children);
+        release(loop);
+        loop = next;
+    }
+}
+
+void freeControlFlowGraph(ControlFlowGraph *graph) {
+    int i;
+
+    freeLoops(graph->loops);
+    for (i = 0; i < graph->numBlocks; i++) {
+        if (graph->blocks[i]->statements != NULL) release(graph->blocks[i]->statements);
+        if (graph->blocks[i]->predecessors != NULL) release(graph->blocks[i]->predecessors);
+        release(graph->blocks[i]);
+    }
+    release(graph->blocks);
+    release(graph);
+}
+
+Block *blockOfStatement(ControlFlowGraph *graph, Statement *statement) {
+    int i, j;
+
+    for (i = 0; i < graph->numBlocks; i++) {
+        for (j = 0; j < graph->blocks[i]->numStatements; j++) {
+            if (graph->blocks[i]->statements[j] == statement) return graph->blocks[i];
+        }
+    }
+    return NULL;
+}
+
+Loop *loopOfStatement(ControlFlowGraph *graph, Statement *statement) {
+    Block *header;
+
+    header = blockOfStatement(graph, statement);
+    if (header == NULL || header->loop == NULL || header->loop->header != header) return NULL;
+    return header->loop;
+}
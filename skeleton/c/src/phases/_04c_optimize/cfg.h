@@ -0,0 +1,105 @@
+/*
+ * cfg.h -- control flow graph, dominator tree and loop nesting forest
+ */
+
+
+#ifndef _CFG_H_
+#define _CFG_H_
+
+#include <absyn/absyn.h>
+
+/**
+ * This struct represents a basic block of a procedure body.
+ *
+ * A block holds a sequence of statements, which are executed one after another. Only assignments,
+ * calls and empty statements are held completely. An if- or while-statement may only be the last statement
+ * of a block and stands for the evaluation of its condition there, its parts belong to other blocks.
+ */
+typedef struct block {
+    int number;                         /* position in reverse postorder, the entry block has number 0 */
+    int numStatements;
+    Statement **statements;
+    int numSuccessors;
+    struct block *successors[2];        /* for a condition the successor if it is true comes first */
+    int numPredecessors;
+    struct block **predecessors;
+    struct block *immediateDominator;   /* NULL for the entry block */
+    struct loop *loop;                  /* the innermost loop containing the block, NULL if there is none */
+} Block;
+
+/**
+ * This struct represents a natural loop, i.e. the blocks on a path from the header back to itself,
+ * which are all dominated by the header.
+ *
+ * The loops of a procedure form a forest: the parent of a loop is the innermost loop containing its header.
+ * Since SPL has no jumps, every loop is a while-statement with one latch at the end of its body.
+ */
+typedef struct loop {
+    Statement *statement;               /* the while-statement */
+    Block *header;                      /* the block evaluating the condition */
+    Block *latch;                       /* the block jumping back to the header */
+    int depth;                          /* 1 for outermost loops */
+    int numBlocks;
+    struct loop *parent;
+    struct loop *children;
+    struct loop *next;                  /* the next sibling in the forest */
+} Loop;
+
+/**
+ * This struct represents the control flow graph of a procedure body.
+ */
+typedef struct {
+    int numBlocks;
+    Block **blocks;                     /* in reverse postorder */
+    Block *entry;
+    Block *exit;
+    Loop *loops;                        /* the outermost loops */
+} ControlFlowGraph;
+
+/**
+ * Builds the control flow graph of a procedure body and computes its dominator tree with the iterative
+ * algorithm of Cooper, Harvey and Kennedy and its loop nesting forest from the back edges.
+ * @param body The statements of the procedure body.
+ * @return The reference to a newly created graph.
+ */
+ControlFlowGraph *buildControlFlowGraph(StatementList *body);
+
+/**
+ * Releases a control flow graph including its blocks and loops. The statements are not touched.
+ * @param graph The graph to release.
+ */
+void freeControlFlowGraph(ControlFlowGraph *graph);
+
+/**
+ * Finds the block holding a statement, or the evaluation of its condition for an if- or while-statement.
+ * @param graph The graph to search.
+ * @param statement The statement to look for.
+ * @return The block, or NULL if the statement is not part of the graph.
+ */
+Block *blockOfStatement(ControlFlowGraph *graph, Statement *statement);
+
+/**
+ * Finds the loop of a while-statement.
+ * @param graph The graph to search.
+ * @param statement The while-statement.
+ * @return The loop, or NULL if the statement is not part of the graph.
+ */
+Loop *loopOfStatement(ControlFlowGraph *graph, Statement *statement);
+
+/**
+ * Checks whether every path from the entry to a block passes a dominator.
+ * @param dominator The block which may dominate the other one.
+ * @param block The dominated block.
+ * @return true if dominator dominates block, which includes the case that both are the same.
+ */
+bool dominates(Block *dominator, Block *block);
+
+/**
+ * Checks whether a block is part of a loop or one of the loops nested in it.
+ * @param loop The loop.
+ * @param block The block.
+ * @return true if the block belongs to the loop.
+ */
+bool loopContains(Loop *loop, Block *block);
+
+#endif /* _CFG_H_ */
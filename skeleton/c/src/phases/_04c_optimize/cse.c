@@ -0,0 +1,550 @@
+/*
+ * cse.c -- elimination of common subexpressions
+ */
+
+#include <stdio.h>
+#include <util/errors.h>
+#include <util/memory.h>
+#include <absyn/absyn.h>
+#include <table/table.h>
+#include <types/types.h>
+#include "locals.h"
+#include "cse.h"
+
+/**
+ * A value that has been computed and may be reused.
+ */
+typedef struct available {
+    Expression *pattern;        /* copy of the expression as written, compared with later ones */
+    Expression *occurrence;     /* the first computation, NULL if the value is held by an assigned variable */
+    Statement *statement;       /* the statement containing the first computation */
+    Variable *holder;           /* the variable holding the value, NULL as long as it is not reused */
+    int uses;
+    struct available *next;
+} Available;
+
+/**
+ * The values available at a point of the procedure body. Every branch works on its own copy.
+ */
+typedef struct valueTable {
+    Available *available;
+    struct valueTable *next;
+} ValueTable;
+
+/**
+ * The assignment of a first computation to a new variable, inserted when the procedure is done.
+ */
+typedef struct insertion {
+    Statement *statement;
+    Statement *assignment;
+    Variable *temporary;
+    bool inserted;
+    struct insertion *next;
+} Insertion;
+
+static GlobalDeclaration *procedure;
+static SymbolTable *procedures;
+static SymbolTable *localTable;
+static Available *allAvailable;
+static Available **lastAvailable;
+static Insertion *insertions;
+static int numTemporaries;
+static int numEliminated;
+
+/*
+ * Aliasing
+ */
+
+static bool readsAliasInExpression(Expression *expression, Variable *target);
+
+static bool readsAliasInVariable(Variable *variable, Variable *target) {
+    if (mayAlias(localTable, target, variable)) return true;
+    while (variable->kind == VARIABLE_ARRAYACCESS) {
+        if (readsAliasInExpression(variable->u.arrayAccess.index, target)) return true;
+        variable = variable->u.arrayAccess.array;
+    }
+    return false;
+}
+
+static bool readsAliasInExpression(Expression *expression, Variable *target) {
+    switch (expression->kind) {
+        case EXPRESSION_INTLITERAL:
+            return false;
+        case EXPRESSION_VARIABLEEXPRESSION:
+            return readsAliasInVariable(expression->u.variableExpression.variable, target);
+        case EXPRESSION_BINARYEXPRESSION:
+            return readsAliasInExpression(expression->u.binaryExpression.leftOperand, target) ||
+                   readsAliasInExpression(expression->u.binaryExpression.rightOperand, target);
+        default:
+            error("unknown expression kind %d in readsAliasInExpression", expression->kind);
+            return false;
+    }
+}
+
+/*
+ * Available values
+ */
+
+static ValueTable *copyTable(ValueTable *table) {
+    ValueTable *copy, **last;
+
+    copy = NULL;
+    for (last = &copy; table != NULL; table = table->next, last = &(*last)->next) {
+        *last = allocate(sizeof(ValueTable));
+        (*last)->available = table->available;
+        (*last)->next = NULL;
+    }
+    return copy;
+}
+
+static void freeTable(ValueTable *table) {
+    ValueTable *next;
+
+    for (; table != NULL; table = next) {
+        next = table->next;
+        release(table);
+    }
+}
+
+static Available *findAvailable(ValueTable *table, Expression *expression) {
+    for (; table != NULL; table = table->next) {
+        if (equalExpressions(table->available->pattern, expression)) return table->available;
+    }
+    return NULL;
+}
+
+static Available *newAvailable(ValueTable **table, Expression *pattern, Expression *occurrence,
+                               Statement *statement, Variable *holder) {
+    Available *available;
+    ValueTable *cell;
+
+    available = allocate(sizeof(Available));
+    available->pattern = pattern;
+    available->occurrence = occurrence;
+    available->statement = statement;
+    available->holder = holder;
+    available->uses = 0;
+    available->next = NULL;
+    *lastAvailable = available;
+    lastAvailable = &available->next;
+
+    cell = allocate(sizeof(ValueTable));
+    cell->available = available;
+    cell->next = *table;
+    *table = cell;
+    return available;
+}
+
+/**
+ * Removes the values an assignment to target may change, and those held by a variable it may change.
+ */
+static void killAssigned(ValueTable **table, Variable *target) {
+    ValueTable **cell, *killed;
+    Available *available;
+
+    cell = table;
+    while (*cell != NULL) {
+        available = (*cell)->available;
+        if (readsAliasInExpression(available->pattern, target) ||
+            (available->holder != NULL && mayAlias(localTable, target, available->holder))) {
+            killed = *cell;
+            *cell = killed->next;
+            release(killed);
+        } else {
+            cell = &(*cell)->next;
+        }
+    }
+}
+
+static void killInStatement(ValueTable **table, Statement *statement);
+
+static void killInList(ValueTable **table, StatementList *statements) {
+    for (; !statements->isEmpty; statements = statements->tail) killInStatement(table, statements->head);
+}
+
+static void killInCall(ValueTable **table, Statement *call) {
+    ParamTypes *paramTypes;
+    ExpressionList *arguments;
+
+    paramTypes = lookup(procedures, call->u.callStatement.procedureName)->u.procEntry.paramTypes;
+    arguments = call->u.callStatement.argumentList;
+    for (; !arguments->isEmpty && !paramTypes->isEmpty; arguments = arguments->tail, paramTypes = paramTypes->next) {
+        if (paramTypes->isRef) killAssigned(table, arguments->head->u.variableExpression.variable);
+    }
+}
+
+/**
+ * Removes the values any assignment or call within a statement may change.
+ */
+static void killInStatement(ValueTable **table, Statement *statement) {
+    switch (statement->kind) {
+        case STATEMENT_EMPTYSTATEMENT:
+            break;
+        case STATEMENT_COMPOUNDSTATEMENT:
+            killInList(table, statement->u.compoundStatement.statements);
+            break;
+        case STATEMENT_ASSIGNSTATEMENT:
+            killAssigned(table, statement->u.assignStatement.target);
+            break;
+        case STATEMENT_IFSTATEMENT:
+            killInStatement(table, statement->u.ifStatement.thenPart);
+            killInStatement(table, statement->u.ifStatement.elsePart);
+            break;
+        case STATEMENT_WHILESTATEMENT:
+            killInStatement(table, statement->u.whileStatement.body);
+            break;
+        case STATEMENT_CALLSTATEMENT:
+            killInCall(table, statement);
+            break;
+        default:
+            error("unknown statement kind %d in killInStatement", statement->kind);
+    }
+}
+
+/*
+ * Reuse
+ */
+
+static bool isSimple(Expression *expression) {
+    return expression->kind == EXPRESSION_INTLITERAL ||
+           (expression->kind == EXPRESSION_VARIABLEEXPRESSION &&
+            expression->u.variableExpression.variable->kind == VARIABLE_NAMEDVARIABLE);
+}
+
+/**
+ * Checks whether keeping the value of an expression in a register is cheaper than computing it again.
+ * An addition of two variables costs as much as copying the result.
+ */
+static bool isWorthReusing(Expression *expression) {
+    if (expression->dataType != intType) return false;
+    switch (expression->kind) {
+        case EXPRESSION_INTLITERAL:
+            return false;
+        case EXPRESSION_VARIABLEEXPRESSION:
+            return expression->u.variableExpression.variable->kind == VARIABLE_ARRAYACCESS;
+        case EXPRESSION_BINARYEXPRESSION:
+            if (expression->u.binaryExpression.operator == ABSYN_OP_MUL ||
+                expression->u.binaryExpression.operator == ABSYN_OP_DIV) return true;
+            return !isSimple(expression->u.binaryExpression.leftOperand) ||
+                   !isSimple(expression->u.binaryExpression.rightOperand);
+        default:
+            error("unknown expression kind %d in isWorthReusing", expression->kind);
+            return false;
+    }
+}
+
+static Variable *newTemporary(int line) {
+    TypeExpression *typeExpression;
+    char buffer[120];
+
+    /* a dot can never appear in an identifier of the source program */
+    snprintf(buffer, sizeof(buffer), "%.90s.cse.%d", procedure->name->string, ++numTemporaries);
+    typeExpression = newNamedTypeExpression(line, newIdentifier("int"));
+    typeExpression->dataType = intType;
+    return newLocalVariable(procedure, localTable, newIdentifier(buffer), typeExpression, intType, line);
+}
+
+static void replaceByVariable(Expression *expression, Variable *variable) {
+    int line;
+
+    line = expression->line;
+    *expression = *newVariableExpression(line, copyVariable(variable));
+    expression->dataType = intType;
+}
+
+/**
+ * Replaces an expression by the variable holding an available value. The first computation is moved
+ * into a new variable when the value is reused for the first time; the moved expression stays the same
+ * object, so values found within it can still be replaced later.
+ */
+static void reuse(Available *available, Expression *expression) {
+    Insertion *insertion, **last;
+    Expression *value;
+
+    if (available->holder == NULL) {
+        available->holder = newTemporary(available->statement->line);
+        value = allocate(sizeof(Expression));
+        *value = *available->occurrence;
+        replaceByVariable(available->occurrence, available->holder);
+
+        insertion = allocate(sizeof(Insertion));
+        insertion->statement = available->statement;
+        insertion->temporary = available->holder;
+        insertion->assignment = newAssignStatement(available->statement->line, copyVariable(available->holder), value);
+        insertion->inserted = false;
+        insertion->next = NULL;
+        for (last = &insertions; *last != NULL; last = &(*last)->next);
+        *last = insertion;
+    }
+    replaceByVariable(expression, available->holder);
+    available->uses++;
+    numEliminated++;
+}
+
+static void numberVariable(Variable *variable, ValueTable **table, Statement *statement);
+
+/**
+ * Replaces the available values within an expression and adds the values it computes.
+ * @param statement The statement evaluating the expression, NULL if its values must not be added.
+ */
+static void numberExpression(Expression *expression, ValueTable **table, Statement *statement) {
+    Available *available;
+    Expression *pattern;
+
+    pattern = NULL;
+    if (isWorthReusing(expression)) {
+        available = findAvailable(*table, expression);
+        if (available != NULL) {
+            reuse(available, expression);
+            return;
+        }
+        if (statement != NULL) pattern = copyExpression(expression);
+    }
+    switch (expression->kind) {
+        case EXPRESSION_INTLITERAL:
+            break;
+        case EXPRESSION_VARIABLEEXPRESSION:
+            numberVariable(expression->u.variableExpression.variable, table, statement);
+            break;
+        case EXPRESSION_BINARYEXPRESSION:
+            numberExpression(expression->u.binaryExpression.leftOperand, table, statement);
+            numberExpression(expression->u.binaryExpression.rightOperand, table, statement);
+            break;
+        default:
+            error("unknown expression kind %d in numberExpression", expression->kind);
+    }
+    if (pattern != NULL) newAvailable(table, pattern, expression, statement, NULL);
+}
+
+static void numberVariable(Variable *variable, ValueTable **table, Statement *statement) {
+    switch (variable->kind) {
+        case VARIABLE_NAMEDVARIABLE:
+            break;
+        case VARIABLE_ARRAYACCESS:
+            numberVariable(variable->u.arrayAccess.array, table, statement);
+            numberExpression(variable->u.arrayAccess.index, table, statement);
+            break;
+        default:
+            error("unknown variable kind %d in numberVariable", variable->kind);
+    }
+}
+
+static void numberStatement(Statement *statement, ValueTable **table);
+
+static void numberList(StatementList *statements, ValueTable **table) {
+    for (; !statements->isEmpty; statements = statements->tail) numberStatement(statements->head, table);
+}
+
+static void numberAssignment(Statement *statement, ValueTable **table) {
+    Variable *target;
+    Expression *value, *pattern;
+
+    target = statement->u.assignStatement.target;
+    value = statement->u.assignStatement.value;
+    pattern = isWorthReusing(value) ? copyExpression(value) : NULL;
+    numberVariable(target, table, statement);
+    numberExpression(value, table, statement);
+    killAssigned(table, target);
+
+    /* after "x := e" the value of e is held by x, as long as neither changes */
+    if (pattern != NULL && target->kind == VARIABLE_NAMEDVARIABLE && target->dataType == intType &&
+        !rootEntry(localTable, target)->u.varEntry.isRef && !readsAliasInExpression(pattern, target)) {
+        newAvailable(table, pattern, NULL, statement, copyVariable(target));
+    }
+}
+
+static void numberCall(Statement *statement, ValueTable **table) {
+    ParamTypes *paramTypes;
+    ExpressionList *arguments;
+
+    paramTypes = lookup(procedures, statement->u.callStatement.procedureName)->u.procEntry.paramTypes;
+    arguments = statement->u.callStatement.argumentList;
+    for (; !arguments->isEmpty && !paramTypes->isEmpty; arguments = arguments->tail, paramTypes = paramTypes->next) {
+        /* a variable passed by reference is no value, but its indices are */
+        if (paramTypes->isRef) {
+            numberVariable(arguments->head->u.variableExpression.variable, table, statement);
+        } else {
+            numberExpression(arguments->head, table, statement);
+        }
+    }
+    killInCall(table, statement);
+}
+
+static void numberStatement(Statement *statement, ValueTable **table) {
+    ValueTable *branch;
+
+    switch (statement->kind) {
+        case STATEMENT_EMPTYSTATEMENT:
+            break;
+        case STATEMENT_COMPOUNDSTATEMENT:
+            numberList(statement->u.compoundStatement.statements, table);
+            break;
+        case STATEMENT_ASSIGNSTATEMENT:
+            numberAssignment(statement, table);
+            break;
+        case STATEMENT_IFSTATEMENT:
+            /* the condition dominates both branches and the statement following the if-statement */
+            numberExpression(statement->u.ifStatement.condition, table, statement);
+            branch = copyTable(*table);
+            numberStatement(statement->u.ifStatement.thenPart, &branch);
+            freeTable(branch);
+            branch = copyTable(*table);
+            numberStatement(statement->u.ifStatement.elsePart, &branch);
+            freeTable(branch);
+            killInStatement(table, statement);
+            break;
+        case STATEMENT_WHILESTATEMENT:
+            /* a value is available in the loop if no iteration changes it */
+            killInStatement(table, statement);
+            numberExpression(statement->u.whileStatement.condition, table, NULL);
+            branch = copyTable(*table);
+            numberStatement(statement->u.whileStatement.body, &branch);
+            freeTable(branch);
+            break;
+        case STATEMENT_CALLSTATEMENT:
+            numberCall(statement, table);
+            break;
+        default:
+            error("unknown statement kind %d in numberStatement", statement->kind);
+    }
+}
+
+/*
+ * Insertion of the new variables
+ */
+
+static bool readsName(Expression *expression, Identifier *name);
+
+static bool readsNameInVariable(Variable *variable, Identifier *name) {
+    switch (variable->kind) {
+        case VARIABLE_NAMEDVARIABLE:
+            return variable->u.namedVariable.name == name;
+        case VARIABLE_ARRAYACCESS:
+            return readsNameInVariable(variable->u.arrayAccess.array, name) ||
+                   readsName(variable->u.arrayAccess.index, name);
+        default:
+            error("unknown variable kind %d in readsNameInVariable", variable->kind);
+            return false;
+    }
+}
+
+static bool readsName(Expression *expression, Identifier *name) {
+    switch (expression->kind) {
+        case EXPRESSION_INTLITERAL:
+            return false;
+        case EXPRESSION_VARIABLEEXPRESSION:
+            return readsNameInVariable(expression->u.variableExpression.variable, name);
+        case EXPRESSION_BINARYEXPRESSION:
+            return readsName(expression->u.binaryExpression.leftOperand, name) ||
+                   readsName(expression->u.binaryExpression.rightOperand, name);
+        default:
+            error("unknown expression kind %d in readsName", expression->kind);
+            return false;
+    }
+}
+
+/**
+ * Checks whether the assignment of an insertion reads a variable assigned by another one for the same
+ * statement, which is not inserted yet.
+ */
+static bool dependsOnPending(Insertion *insertion) {
+    Insertion *other;
+
+    for (other = insertions; other != NULL; other = other->next) {
+        if (other != insertion && other->statement == insertion->statement && !other->inserted &&
+            readsName(insertion->assignment->u.assignStatement.value, other->temporary->u.namedVariable.name)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * Puts the assignments of the new variables in front of their statement, wrapping both into a compound
+ * statement. A value found within a reused value is assigned first.
+ */
+static void insertAssignments(void) {
+    Insertion *insertion, *next;
+    StatementList *assignments, **last;
+    Statement *original;
+    bool progress;
+
+    for (insertion = insertions; insertion != NULL; insertion = insertion->next) {
+        if (insertion->inserted) continue;
+        assignments = emptyStatementList();
+        last = &assignments;
+        do {
+            progress = false;
+            for (next = insertion; next != NULL; next = next->next) {
+                if (next->statement != insertion->statement || next->inserted || dependsOnPending(next)) continue;
+                *last = newStatementList(next->assignment, emptyStatementList());
+                last = &(*last)->tail;
+                next->inserted = true;
+                progress = true;
+            }
+        } while (progress);
+
+        original = allocate(sizeof(Statement));
+        *original = *insertion->statement;
+        *last = newStatementList(original, emptyStatementList());
+        *insertion->statement = *newCompoundStatement(original->line, assignments);
+    }
+    while (insertions != NULL) {
+        insertion = insertions;
+        insertions = insertion->next;
+        release(insertion);
+    }
+}
+
+/*
+ * Report
+ */
+
+static void showReused(void) {
+    Available *available;
+    int eliminated;
+
+    eliminated = 0;
+    for (available = allAvailable; available != NULL; available = available->next) {
+        if (available->uses == 0) continue;
+        printf("expression in line %d: ", available->statement->line);
+        printExpression(available->pattern);
+        printf(" held by '%s', reused %d time%s\n", available->holder->u.namedVariable.name->string,
+               available->uses, available->uses == 1 ? "" : "s");
+        eliminated += available->uses;
+    }
+    printf("expressions eliminated = %d\n", eliminated);
+}
+
+int eliminateCommonSubexpressions(Program *program, SymbolTable *globalTable, bool showReport) {
+    GlobalDeclarationList *declarationList;
+    Available *available;
+    ValueTable *table;
+
+    numEliminated = 0;
+    procedures = globalTable;
+    for (declarationList = program; !declarationList->isEmpty; declarationList = declarationList->tail) {
+        procedure = declarationList->head;
+        if (procedure->kind != DECLARATION_PROCEDUREDECLARATION) continue;
+
+        localTable = lookup(globalTable, procedure->name)->u.procEntry.localTable;
+        allAvailable = NULL;
+        lastAvailable = &allAvailable;
+        insertions = NULL;
+        numTemporaries = 0;
+        table = NULL;
+        numberList(procedure->u.procedureDeclaration.body, &table);
+        freeTable(table);
+        insertAssignments();
+        if (showReport) {
+            printf("\nCommon subexpression elimination for procedure '%s'\n", procedure->name->string);
+            showReused();
+        }
+        while (allAvailable != NULL) {
+            available = allAvailable;
+            allAvailable = available->next;
+            release(available);
+        }
+    }
+    return numEliminated;
+}
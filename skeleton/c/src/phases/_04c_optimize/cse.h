@@ -0,0 +1,38 @@
+/*
+ * cse.h -- elimination of common subexpressions
+ */
+
+
+#ifndef _CSE_H_
+#define _CSE_H_
+
+#include <absyn/absyn.h>
+#include <table/table.h>
+
+/**
+ * This function replaces repeated computations of the same value by a variable holding it.
+ *
+ * The expressions worth to be reused are loads of array elements and arithmetic expressions containing
+ * an array access, a multiplication or a division, or more than one operator. Two expressions have the same
+ * value if they are structurally equal and no variable they read may have been changed between them.
+ * A value stays available along the dominator tree of the structured body: within a sequence of statements,
+ * from the condition of an if-statement into both branches and behind the if-statement, and into a loop
+ * if the loop changes none of its variables. Values computed inside a branch or a loop are not available
+ * behind it.
+ *
+ * An assignment changes the assigned variable and, if it assigns through a reference parameter, everything
+ * reachable through any reference parameter. A call changes the variables passed to reference parameters
+ * in the same way. An assignment "x := e" to a scalar variable makes the value of e available in x.
+ * Otherwise the first computation of a reused value is moved into a new variable in front of its statement.
+ * The new variables get names which are no valid identifiers in SPL.
+ *
+ * The pass has to run after the semantic analysis and before the register allocation.
+ *
+ * @param program The program whose expressions are examined.
+ * @param globalTable The symbol table for the current program.
+ * @param showReport Whether the reused expressions should be printed for every procedure.
+ * @return The number of eliminated expressions.
+ */
+int eliminateCommonSubexpressions(Program *program, SymbolTable *globalTable, bool showReport);
+
+#endif /* _CSE_H_ */
@@ -0,0 +1,396 @@
+/*
+ * dce.c -- elimination of dead code
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <util/errors.h>
+#include <util/memory.h>
+#include <absyn/absyn.h>
+#include <table/table.h>
+#include <types/types.h>
+#include "estimate.h"
+#include "fold.h"
+#include "dce.h"
+
+#define INSTRUCTION_SIZE 4      /* every ECO32 instruction is one word */
+
+static SymbolTable *localTable;
+static Identifier **nonReturning;   /* procedures which never return to their caller */
+static int numNonReturning;
+static Identifier **candidates;     /* the scalar variables whose stores may be removed */
+static int numCandidates;
+static int numRemoved;
+static int numBytes;
+static bool reportRemoved;
+
+static int countStatements(Statement *statement) {
+    StatementList *statements;
+    int count;
+
+    switch (statement->kind) {
+        case STATEMENT_EMPTYSTATEMENT:
+            return 0;
+        case STATEMENT_COMPOUNDSTATEMENT:
+            count = 0;
+            for (statements = statement->u.compoundStatement.statements; !statements->isEmpty;
+                 statements = statements->tail) {
+                count += countStatements(statements->head);
+            }
+            return count;
+        case STATEMENT_IFSTATEMENT:
+            return countStatements(statement->u.ifStatement.thenPart) +
+                   countStatements(statement->u.ifStatement.elsePart) + 1;
+        case STATEMENT_WHILESTATEMENT:
+            return countStatements(statement->u.whileStatement.body) + 1;
+        default:
+            return 1;
+    }
+}
+
+/**
+ * Accounts for a removed statement.
+ * @param instructions The number of instructions no longer emitted.
+ */
+static void recordRemoval(Statement *statement, int statements, int instructions, char *reason) {
+    if (statements == 0) return;
+    numRemoved += statements;
+    numBytes += instructions * INSTRUCTION_SIZE;
+    if (reportRemoved) {
+        printf("line %d: %s, statements removed = %d, bytes saved = %d\n",
+               statement->line, reason, statements, instructions * INSTRUCTION_SIZE);
+    }
+}
+
+/*
+ * Unreachable code
+ */
+
+static bool isNonReturning(Identifier *name) {
+    int i;
+
+    for (i = 0; i < numNonReturning; i++) {
+        if (nonReturning[i] == name) return true;
+    }
+    return false;
+}
+
+static bool neverCompletes(Statement *statement);
+
+static bool neverCompletesList(StatementList *statements) {
+    for (; !statements->isEmpty; statements = statements->tail) {
+        if (neverCompletes(statements->head)) return true;
+    }
+    return false;
+}
+
+static bool neverCompletes(Statement *statement) {
+    int value;
+
+    switch (statement->kind) {
+        case STATEMENT_COMPOUNDSTATEMENT:
+            return neverCompletesList(statement->u.compoundStatement.statements);
+        case STATEMENT_IFSTATEMENT:
+            return neverCompletes(statement->u.ifStatement.thenPart) && neverCompletes(statement->u.ifStatement.elsePart);
+        case STATEMENT_WHILESTATEMENT:
+            /* SPL has no statement leaving a loop early */
+            return evaluateCondition(statement->u.whileStatement.condition, &value) && value;
+        case STATEMENT_CALLSTATEMENT:
+            return isNonReturning(statement->u.callStatement.procedureName);
+        default:
+            return false;
+    }
+}
+
+/**
+ * Collects exit() and the procedures whose body never completes, until no further procedure is found.
+ */
+static void findNonReturning(Program *program) {
+    GlobalDeclarationList *declarationList;
+    GlobalDeclaration *declaration;
+    bool changed;
+    int numProcedures;
+
+    numProcedures = 1;
+    for (declarationList = program; !declarationList->isEmpty; declarationList = declarationList->tail) numProcedures++;
+    nonReturning = allocate(numProcedures * sizeof(Identifier *));
+    nonReturning[0] = newIdentifier("exit");
+    numNonReturning = 1;
+    do {
+        changed = false;
+        for (declarationList = program; !declarationList->isEmpty; declarationList = declarationList->tail) {
+            declaration = declarationList->head;
+            if (declaration->kind != DECLARATION_PROCEDUREDECLARATION || isNonReturning(declaration->name)) continue;
+            if (neverCompletesList(declaration->u.procedureDeclaration.body)) {
+                nonReturning[numNonReturning++] = declaration->name;
+                changed = true;
+            }
+        }
+    } while (changed);
+}
+
+static void removeUnreachable(Statement *statement);
+
+static void removeUnreachableInList(StatementList *statements) {
+    StatementList *rest;
+
+    for (; !statements->isEmpty; statements = statements->tail) {
+        removeUnreachable(statements->head);
+        if (neverCompletes(statements->head)) {
+            for (rest = statements->tail; !rest->isEmpty; rest = rest->tail) {
+                recordRemoval(rest->head, countStatements(rest->head), statementInstructions(rest->head),
+                              "unreachable statement");
+            }
+            statements->tail = emptyStatementList();
+        }
+    }
+}
+
+static void removeUnreachable(Statement *statement) {
+    Statement *taken, *notTaken;
+    int value;
+
+    switch (statement->kind) {
+        case STATEMENT_COMPOUNDSTATEMENT:
+            removeUnreachableInList(statement->u.compoundStatement.statements);
+            break;
+        case STATEMENT_IFSTATEMENT:
+            if (evaluateCondition(statement->u.ifStatement.condition, &value)) {
+                taken = value ? statement->u.ifStatement.thenPart : statement->u.ifStatement.elsePart;
+                notTaken = value ? statement->u.ifStatement.elsePart : statement->u.ifStatement.thenPart;
+                recordRemoval(statement, countStatements(notTaken) + 1,
+                              statementInstructions(statement) - statementInstructions(taken),
+                              "branch never taken");
+                *statement = *taken;
+                removeUnreachable(statement);
+                break;
+            }
+            removeUnreachable(statement->u.ifStatement.thenPart);
+            removeUnreachable(statement->u.ifStatement.elsePart);
+            break;
+        case STATEMENT_WHILESTATEMENT:
+            if (evaluateCondition(statement->u.whileStatement.condition, &value) && !value) {
+                recordRemoval(statement, countStatements(statement), statementInstructions(statement),
+                              "loop never executed");
+                statement->kind = STATEMENT_EMPTYSTATEMENT;
+                break;
+            }
+            removeUnreachable(statement->u.whileStatement.body);
+            break;
+        default:
+            break;
+    }
+}
+
+/*
+ * Dead stores
+ */
+
+static int candidateIndex(Variable *variable) {
+    int i;
+
+    if (variable->kind != VARIABLE_NAMEDVARIABLE) return -1;
+    for (i = 0; i < numCandidates; i++) {
+        if (candidates[i] == variable->u.namedVariable.name) return i;
+    }
+    return -1;
+}
+
+static void findCandidates(GlobalDeclaration *procedure) {
+    ParameterList *parameters;
+    VariableDeclarationList *variables;
+    Entry *entry;
+    int numDeclarations;
+
+    numDeclarations = 0;
+    for (parameters = procedure->u.procedureDeclaration.parameters; !parameters->isEmpty; parameters = parameters->tail) {
+        numDeclarations++;
+    }
+    for (variables = procedure->u.procedureDeclaration.variables; !variables->isEmpty; variables = variables->tail) {
+        numDeclarations++;
+    }
+    candidates = allocate((numDeclarations + 1) * sizeof(Identifier *));
+    numCandidates = 0;
+    for (parameters = procedure->u.procedureDeclaration.parameters; !parameters->isEmpty; parameters = parameters->tail) {
+        entry = lookup(localTable, parameters->head->name);
+        if (!entry->u.varEntry.isRef && entry->u.varEntry.type == intType) {
+            candidates[numCandidates++] = parameters->head->name;
+        }
+    }
+    for (variables = procedure->u.procedureDeclaration.variables; !variables->isEmpty; variables = variables->tail) {
+        entry = lookup(localTable, variables->head->name);
+        if (entry->u.varEntry.type == intType) candidates[numCandidates++] = variables->head->name;
+    }
+}
+
+static void addUsesOfExpression(Expression *expression, bool *live);
+
+static void addUsesOfVariable(Variable *variable, bool *live) {
+    int index;
+
+    switch (variable->kind) {
+        case VARIABLE_NAMEDVARIABLE:
+            index = candidateIndex(variable);
+            if (index >= 0) live[index] = true;
+            break;
+        case VARIABLE_ARRAYACCESS:
+            addUsesOfVariable(variable->u.arrayAccess.array, live);
+            addUsesOfExpression(variable->u.arrayAccess.index, live);
+            break;
+        default:
+            error("unknown variable kind %d in addUsesOfVariable", variable->kind);
+    }
+}
+
+static void addUsesOfExpression(Expression *expression, bool *live) {
+    switch (expression->kind) {
+        case EXPRESSION_INTLITERAL:
+            break;
+        case EXPRESSION_VARIABLEEXPRESSION:
+            addUsesOfVariable(expression->u.variableExpression.variable, live);
+            break;
+        case EXPRESSION_BINARYEXPRESSION:
+            addUsesOfExpression(expression->u.binaryExpression.leftOperand, live);
+            addUsesOfExpression(expression->u.binaryExpression.rightOperand, live);
+            break;
+        default:
+            error("unknown expression kind %d in addUsesOfExpression", expression->kind);
+    }
+}
+
+static bool *copySet(bool *set) {
+    bool *copy;
+
+    copy = allocate((numCandidates + 1) * sizeof(bool));
+    memcpy(copy, set, numCandidates * sizeof(bool));
+    return copy;
+}
+
+static void liveInStatement(Statement *statement, bool *live, bool remove);
+
+static void liveInList(StatementList *statements, bool *live, bool remove) {
+    if (statements->isEmpty) return;
+    liveInList(statements->tail, live, remove);
+    liveInStatement(statements->head, live, remove);
+}
+
+static void liveInAssignment(Statement *statement, bool *live, bool remove) {
+    Variable *target;
+    char reason[120];
+    int index;
+
+    target = statement->u.assignStatement.target;
+    index = candidateIndex(target);
+    if (index >= 0) {
+        if (!live[index] && isTrapFree(statement->u.assignStatement.value)) {
+            if (remove) {
+                snprintf(reason, sizeof(reason), "dead store to '%.90s'", target->u.namedVariable.name->string);
+                recordRemoval(statement, 1, statementInstructions(statement), reason);
+                statement->kind = STATEMENT_EMPTYSTATEMENT;
+            }
+            return;
+        }
+        live[index] = false;
+    } else {
+        addUsesOfVariable(target, live);
+    }
+    addUsesOfExpression(statement->u.assignStatement.value, live);
+}
+
+/**
+ * Turns the set of variables live behind a statement into the set live in front of it.
+ * @param remove Whether dead stores are removed, which is only done once the sets of enclosing loops are final.
+ */
+static void liveInStatement(Statement *statement, bool *live, bool remove) {
+    ExpressionList *arguments;
+    bool *other, *entry, changed;
+    int i;
+
+    switch (statement->kind) {
+        case STATEMENT_EMPTYSTATEMENT:
+            break;
+        case STATEMENT_COMPOUNDSTATEMENT:
+            liveInList(statement->u.compoundStatement.statements, live, remove);
+            break;
+        case STATEMENT_ASSIGNSTATEMENT:
+            liveInAssignment(statement, live, remove);
+            break;
+        case STATEMENT_IFSTATEMENT:
+            other = copySet(live);
+            liveInStatement(statement->u.ifStatement.thenPart, live, remove);
+            liveInStatement(statement->u.ifStatement.elsePart, other, remove);
+            for (i = 0; i < numCandidates; i++) live[i] |= other[i];
+            release(other);
+            addUsesOfExpression(statement->u.ifStatement.condition, live);
+            break;
+        case STATEMENT_WHILESTATEMENT:
+            /* the set in front of the condition is also the set behind the body */
+            addUsesOfExpression(statement->u.whileStatement.condition, live);
+            entry = copySet(live);
+            changed = true;
+            while (changed) {
+                other = copySet(entry);
+                liveInStatement(statement->u.whileStatement.body, other, false);
+                changed = false;
+                for (i = 0; i < numCandidates; i++) {
+                    if (other[i] && !entry[i]) {
+                        entry[i] = true;
+                        changed = true;
+                    }
+                }
+                release(other);
+            }
+            if (remove) {
+                other = copySet(entry);
+                liveInStatement(statement->u.whileStatement.body, other, true);
+                release(other);
+            }
+            memcpy(live, entry, numCandidates * sizeof(bool));
+            release(entry);
+            break;
+        case STATEMENT_CALLSTATEMENT:
+            /* a variable passed by reference may be read by the called procedure */
+            for (arguments = statement->u.callStatement.argumentList; !arguments->isEmpty; arguments = arguments->tail) {
+                addUsesOfExpression(arguments->head, live);
+            }
+            break;
+        default:
+            error("unknown statement kind %d in liveInStatement", statement->kind);
+    }
+}
+
+int eliminateDeadCode(Program *program, SymbolTable *globalTable, bool showReport) {
+    GlobalDeclarationList *declarationList;
+    GlobalDeclaration *declaration;
+    int removedBefore, bytesBefore, i;
+    bool *live;
+
+    numRemoved = 0;
+    numBytes = 0;
+    reportRemoved = showReport;
+    findNonReturning(program);
+    for (declarationList = program; !declarationList->isEmpty; declarationList = declarationList->tail) {
+        declaration = declarationList->head;
+        if (declaration->kind != DECLARATION_PROCEDUREDECLARATION) continue;
+
+        localTable = lookup(globalTable, declaration->name)->u.procEntry.localTable;
+        if (showReport) printf("\nDead code elimination for procedure '%s'\n", declaration->name->string);
+        removedBefore = numRemoved;
+        bytesBefore = numBytes;
+        removeUnreachableInList(declaration->u.procedureDeclaration.body);
+
+        /* nothing is live when the procedure returns */
+        findCandidates(declaration);
+        live = allocate((numCandidates + 1) * sizeof(bool));
+        for (i = 0; i < numCandidates; i++) live[i] = false;
+        liveInList(declaration->u.procedureDeclaration.body, live, true);
+        release(live);
+        release(candidates);
+
+        if (showReport) {
+            printf("statements removed = %d, bytes saved = %d\n", numRemoved - removedBefore, numBytes - bytesBefore);
+        }
+    }
+    release(nonReturning);
+    return numRemoved;
+}
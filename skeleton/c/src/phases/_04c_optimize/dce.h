@@ -0,0 +1,35 @@
+/*
+ * dce.h -- elimination of dead code
+ */
+
+
+#ifndef _DCE_H_
+#define _DCE_H_
+
+#include <absyn/absyn.h>
+#include <table/table.h>
+
+/**
+ * This function removes statements which are never executed or whose effect is never observed.
+ *
+ * An if-statement whose condition compares two constants is replaced by the branch that is taken,
+ * a while-statement whose condition is constantly false is removed. Statements following a statement
+ * that never completes are unreachable and removed as well. A statement never completes if it calls
+ * exit(), calls a procedure which never returns, or is a loop whose condition is constantly true.
+ *
+ * An assignment to a scalar local variable or value parameter is a dead store if no later read can see
+ * the assigned value, i.e. the variable is not live behind it. A read only counts if it belongs to a store
+ * which is kept itself, so a variable which is merely updated from its own value is removed completely.
+ * Passing a variable by reference counts as a read. Stores whose value might cause a runtime error,
+ * like a division by a variable or a checked array access, are kept.
+ *
+ * The pass has to run after the semantic analysis.
+ *
+ * @param program The program whose dead code is removed.
+ * @param globalTable The symbol table for the current program.
+ * @param showReport Whether every removed statement should be printed with the estimated code size saved.
+ * @return The number of removed statements.
+ */
+int eliminateDeadCode(Program *program, SymbolTable *globalTable, bool showReport);
+
+#endif /* _DCE_H_ */
@@ -0,0 +1,147 @@
+/*
+ * estimate.c -- size and code estimates of statements
+ */
+
+#include <util/errors.h>
+#include <absyn/absyn.h>
+#include "estimate.h"
+
+static int variableInstructions(Variable *variable);
+
+int expressionInstructions(Expression *expression) {
+    switch (expression->kind) {
+        case EXPRESSION_INTLITERAL:
+            return 1;
+        case EXPRESSION_VARIABLEEXPRESSION:
+            return variableInstructions(expression->u.variableExpression.variable) + 1;
+        case EXPRESSION_BINARYEXPRESSION:
+            return expressionInstructions(expression->u.binaryExpression.leftOperand) +
+                   expressionInstructions(expression->u.binaryExpression.rightOperand) + 1;
+        default:
+            error("unknown expression kind %d in expressionInstructions", expression->kind);
+            return 0;
+    }
+}
+
+/**
+ * Estimates the instructions computing the address of a variable, including the bounds check.
+ */
+static int variableInstructions(Variable *variable) {
+    switch (variable->kind) {
+        case VARIABLE_NAMEDVARIABLE:
+            return 1;
+        case VARIABLE_ARRAYACCESS:
+            return variableInstructions(variable->u.arrayAccess.array) +
+                   expressionInstructions(variable->u.arrayAccess.index) +
+                   (variable->u.arrayAccess.checkIndex ? 3 : 0) + 2;
+        default:
+            error("unknown variable kind %d in variableInstructions", variable->kind);
+            return 0;
+    }
+}
+
+int listInstructions(StatementList *statements) {
+    int instructions = 0;
+
+    for (; !statements->isEmpty; statements = statements->tail) instructions += statementInstructions(statements->head);
+    return instructions;
+}
+
+int statementInstructions(Statement *statement) {
+    ExpressionList *arguments;
+    int instructions;
+
+    switch (statement->kind) {
+        case STATEMENT_EMPTYSTATEMENT:
+            return 0;
+        case STATEMENT_COMPOUNDSTATEMENT:
+            return listInstructions(statement->u.compoundStatement.statements);
+        case STATEMENT_ASSIGNSTATEMENT:
+            return variableInstructions(statement->u.assignStatement.target) +
+                   expressionInstructions(statement->u.assignStatement.value) + 1;
+        case STATEMENT_IFSTATEMENT:
+            return expressionInstructions(statement->u.ifStatement.condition) +
+                   statementInstructions(statement->u.ifStatement.thenPart) +
+                   statementInstructions(statement->u.ifStatement.elsePart) + 1;
+        case STATEMENT_WHILESTATEMENT:
+            return expressionInstructions(statement->u.whileStatement.condition) +
+                   statementInstructions(statement->u.whileStatement.body) + 2;
+        case STATEMENT_CALLSTATEMENT:
+            /* every argument is stored into the outgoing area */
+            instructions = 1;
+            for (arguments = statement->u.callStatement.argumentList; !arguments->isEmpty; arguments = arguments->tail) {
+                instructions += expressionInstructions(arguments->head) + 1;
+            }
+            return instructions;
+        default:
+            error("unknown statement kind %d in statementInstructions", statement->kind);
+            return 0;
+    }
+}
+
+static int expressionSize(Expression *expression);
+
+static int variableSize(Variable *variable) {
+    switch (variable->kind) {
+        case VARIABLE_NAMEDVARIABLE:
+            return 1;
+        case VARIABLE_ARRAYACCESS:
+            return 1 + variableSize(variable->u.arrayAccess.array) + expressionSize(variable->u.arrayAccess.index);
+        default:
+            error("unknown variable kind %d in variableSize", variable->kind);
+            return 0;
+    }
+}
+
+static int expressionSize(Expression *expression) {
+    switch (expression->kind) {
+        case EXPRESSION_INTLITERAL:
+            return 1;
+        case EXPRESSION_VARIABLEEXPRESSION:
+            return 1 + variableSize(expression->u.variableExpression.variable);
+        case EXPRESSION_BINARYEXPRESSION:
+            return 1 + expressionSize(expression->u.binaryExpression.leftOperand) +
+                   expressionSize(expression->u.binaryExpression.rightOperand);
+        default:
+            error("unknown expression kind %d in expressionSize", expression->kind);
+            return 0;
+    }
+}
+
+int statementListSize(StatementList *statements) {
+    int size = 0;
+
+    for (; !statements->isEmpty; statements = statements->tail) size += statementSize(statements->head);
+    return size;
+}
+
+int statementSize(Statement *statement) {
+    ExpressionList *arguments;
+    int size;
+
+    switch (statement->kind) {
+        case STATEMENT_EMPTYSTATEMENT:
+            return 1;
+        case STATEMENT_COMPOUNDSTATEMENT:
+            return 1 + statementListSize(statement->u.compoundStatement.statements);
+        case STATEMENT_ASSIGNSTATEMENT:
+            return 1 + variableSize(statement->u.assignStatement.target) +
+                   expressionSize(statement->u.assignStatement.value);
+        case STATEMENT_IFSTATEMENT:
+            return 1 + expressionSize(statement->u.ifStatement.condition) +
+                   statementSize(statement->u.ifStatement.thenPart) +
+                   statementSize(statement->u.ifStatement.elsePart);
+        case STATEMENT_WHILESTATEMENT:
+            return 1 + expressionSize(statement->u.whileStatement.condition) +
+                   statementSize(statement->u.whileStatement.body);
+        case STATEMENT_CALLSTATEMENT:
+            size = 1;
+            for (arguments = statement->u.callStatement.argumentList; !arguments->isEmpty; arguments = arguments->tail) {
+                size += expressionSize(arguments->head);
+            }
+            return size;
+        default:
+            error("unknown statement kind %d in statementSize", statement->kind);
+            return 0;
+    }
+}
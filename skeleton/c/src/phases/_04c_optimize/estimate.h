@@ -0,0 +1,51 @@
+/*
+ * estimate.h -- size and code estimates of statements
+ */
+
+
+#ifndef _ESTIMATE_H_
+#define _ESTIMATE_H_
+
+#include <absyn/absyn.h>
+
+/**
+ * Estimates the number of instructions emitted for an expression, counting one instruction for every
+ * literal, variable and operator. Array accesses add the address computation and their bounds check.
+ * The optimizations weigh the code they remove or duplicate with this estimate.
+ * @param expression The expression to estimate.
+ * @return The estimated number of instructions.
+ */
+int expressionInstructions(Expression *expression);
+
+/**
+ * Estimates the number of instructions emitted for a statement, including the branches of if- and
+ * while-statements and the stores of the arguments of a call.
+ * @param statement The statement to estimate.
+ * @return The estimated number of instructions.
+ */
+int statementInstructions(Statement *statement);
+
+/**
+ * Estimates the number of instructions emitted for a list of statements.
+ * @param statements The list to estimate.
+ * @return The sum of the estimates of the statements.
+ */
+int listInstructions(StatementList *statements);
+
+/**
+ * Counts the nodes of the abstract syntax of a statement: the statement itself, its parts, and every
+ * variable, literal and operator in its expressions. Inlining, interprocedural constant propagation and
+ * unrolling limit the code they duplicate with this size.
+ * @param statement The statement to measure.
+ * @return The number of nodes.
+ */
+int statementSize(Statement *statement);
+
+/**
+ * Counts the nodes of the abstract syntax of a list of statements.
+ * @param statements The list to measure.
+ * @return The sum of the sizes of the statements.
+ */
+int statementListSize(StatementList *statements);
+
+#endif /* _ESTIMATE_H_ */
@@ -0,0 +1,306 @@
+/*
+ * fold.c -- constant folding and algebraic simplification
+ */
+
+#include <limits.h>
+#include <util/errors.h>
+#include <absyn/absyn.h>
+#include <types/types.h>
+#include "fold.h"
+
+static int changes;
+
+static void foldVariable(Variable *variable);
+static void foldExpression(Expression *expression);
+static void foldStatement(Statement *statement);
+
+/**
+ * Converts the result of an unsigned computation back to a signed 32 bit value.
+ * Computing in unsigned arithmetic gives the same wraparound behavior as the ECO32 add, sub and mul instructions.
+ */
+static int wrap(unsigned value) {
+    return (int) value;
+}
+
+static bool isComparison(binary_operator operator) {
+    switch (operator) {
+        case ABSYN_OP_EQU:
+        case ABSYN_OP_NEQ:
+        case ABSYN_OP_LST:
+        case ABSYN_OP_LSE:
+        case ABSYN_OP_GRT:
+        case ABSYN_OP_GRE:
+            return true;
+        default:
+            return false;
+    }
+}
+
+/**
+ * Evaluates a binary operator for two constant operands.
+ * @return false if the result must not be computed at compile time, because the operation traps at runtime.
+ */
+static bool evaluate(binary_operator operator, int left, int right, int *result) {
+    switch (operator) {
+        case ABSYN_OP_EQU:
+            *result = left == right;
+            return true;
+        case ABSYN_OP_NEQ:
+            *result = left != right;
+            return true;
+        case ABSYN_OP_LST:
+            *result = left < right;
+            return true;
+        case ABSYN_OP_LSE:
+            *result = left <= right;
+            return true;
+        case ABSYN_OP_GRT:
+            *result = left > right;
+            return true;
+        case ABSYN_OP_GRE:
+            *result = left >= right;
+            return true;
+        case ABSYN_OP_ADD:
+            *result = wrap((unsigned) left + (unsigned) right);
+            return true;
+        case ABSYN_OP_SUB:
+            *result = wrap((unsigned) left - (unsigned) right);
+            return true;
+        case ABSYN_OP_MUL:
+            *result = wrap((unsigned) left * (unsigned) right);
+            return true;
+        case ABSYN_OP_DIV:
+            /* division by zero and the overflowing INT_MIN / -1 are left to the processor */
+            if (right == 0 || (left == INT_MIN && right == -1)) return false;
+            *result = left / right;
+            return true;
+        default:
+            error("unknown operator %d in evaluate", operator);
+            return false;
+    }
+}
+
+static bool isLiteral(Expression *expression, int value) {
+    return expression->kind == EXPRESSION_INTLITERAL && expression->u.intLiteral.value == value;
+}
+
+bool isTrapFree(Expression *expression) {
+    Variable *variable;
+    Expression *divisor;
+
+    switch (expression->kind) {
+        case EXPRESSION_INTLITERAL:
+            return true;
+        case EXPRESSION_VARIABLEEXPRESSION:
+            for (variable = expression->u.variableExpression.variable; variable->kind == VARIABLE_ARRAYACCESS;
+                 variable = variable->u.arrayAccess.array) {
+                if (variable->u.arrayAccess.checkIndex || !isTrapFree(variable->u.arrayAccess.index)) return false;
+            }
+            return true;
+        case EXPRESSION_BINARYEXPRESSION:
+            divisor = expression->u.binaryExpression.rightOperand;
+            /* a constant divisor other than 0 and -1 never traps, INT_MIN / -1 overflows */
+            if (expression->u.binaryExpression.operator == ABSYN_OP_DIV &&
+                (divisor->kind != EXPRESSION_INTLITERAL || divisor->u.intLiteral.value == 0 ||
+                 divisor->u.intLiteral.value == -1)) {
+                return false;
+            }
+            return isTrapFree(expression->u.binaryExpression.leftOperand) && isTrapFree(divisor);
+        default:
+            error("unknown expression kind %d in isTrapFree", expression->kind);
+            return false;
+    }
+}
+
+static void replaceByLiteral(Expression *expression, int value) {
+    expression->kind = EXPRESSION_INTLITERAL;
+    expression->u.intLiteral.value = value;
+    expression->dataType = intType;
+    changes++;
+}
+
+static void replaceByOperand(Expression *expression, Expression *operand) {
+    *expression = *operand;
+    changes++;
+}
+
+/**
+ * Combines the constants of nested additions and subtractions, e.g. (x + 1) - 3 becomes x + -2.
+ * Since the arithmetic wraps around, this is valid for all values of x.
+ */
+static void reassociate(Expression *expression) {
+    binary_operator operator = expression->u.binaryExpression.operator;
+    Expression *left = expression->u.binaryExpression.leftOperand;
+    Expression *right = expression->u.binaryExpression.rightOperand;
+    unsigned inner, outer;
+
+    if (operator != ABSYN_OP_ADD && operator != ABSYN_OP_SUB) return;
+    if (right->kind != EXPRESSION_INTLITERAL || left->kind != EXPRESSION_BINARYEXPRESSION) return;
+    if (left->u.binaryExpression.operator != ABSYN_OP_ADD && left->u.binaryExpression.operator != ABSYN_OP_SUB) return;
+    if (left->u.binaryExpression.rightOperand->kind != EXPRESSION_INTLITERAL) return;
+
+    inner = (unsigned) left->u.binaryExpression.rightOperand->u.intLiteral.value;
+    if (left->u.binaryExpression.operator == ABSYN_OP_SUB) inner = -inner;
+    outer = (unsigned) right->u.intLiteral.value;
+    if (operator == ABSYN_OP_SUB) outer = -outer;
+
+    expression->u.binaryExpression.operator = ABSYN_OP_ADD;
+    expression->u.binaryExpression.leftOperand = left->u.binaryExpression.leftOperand;
+    right->u.intLiteral.value = wrap(inner + outer);
+    changes++;
+}
+
+static void foldBinaryExpression(Expression *expression) {
+    binary_operator operator = expression->u.binaryExpression.operator;
+    Expression *left = expression->u.binaryExpression.leftOperand;
+    Expression *right = expression->u.binaryExpression.rightOperand;
+    int value;
+
+    /* comparisons only occur as conditions, they are folded together with their statement */
+    if (isComparison(operator)) return;
+
+    if (left->kind == EXPRESSION_INTLITERAL && right->kind == EXPRESSION_INTLITERAL) {
+        if (evaluate(operator, left->u.intLiteral.value, right->u.intLiteral.value, &value)) {
+            replaceByLiteral(expression, value);
+        }
+        return;
+    }
+
+    reassociate(expression);
+    operator = expression->u.binaryExpression.operator;
+    left = expression->u.binaryExpression.leftOperand;
+
+    switch (operator) {
+        case ABSYN_OP_ADD:
+            if (isLiteral(right, 0)) replaceByOperand(expression, left);
+            else if (isLiteral(left, 0)) replaceByOperand(expression, right);
+            break;
+        case ABSYN_OP_SUB:
+            if (isLiteral(right, 0)) replaceByOperand(expression, left);
+            else if (isTrapFree(left) && equalExpressions(left, right)) replaceByLiteral(expression, 0);
+            break;
+        case ABSYN_OP_MUL:
+            if (isLiteral(right, 1)) replaceByOperand(expression, left);
+            else if (isLiteral(left, 1)) replaceByOperand(expression, right);
+            else if (isLiteral(right, 0) && isTrapFree(left)) replaceByLiteral(expression, 0);
+            else if (isLiteral(left, 0) && isTrapFree(right)) replaceByLiteral(expression, 0);
+            break;
+        case ABSYN_OP_DIV:
+            if (isLiteral(right, 1)) replaceByOperand(expression, left);
+            break;
+        default:
+            break;
+    }
+}
+
+static void foldExpression(Expression *expression) {
+    switch (expression->kind) {
+        case EXPRESSION_INTLITERAL:
+            break;
+        case EXPRESSION_VARIABLEEXPRESSION:
+            foldVariable(expression->u.variableExpression.variable);
+            break;
+        case EXPRESSION_BINARYEXPRESSION:
+            foldExpression(expression->u.binaryExpression.leftOperand);
+            foldExpression(expression->u.binaryExpression.rightOperand);
+            foldBinaryExpression(expression);
+            break;
+        default:
+            error("unknown expression kind %d in foldExpression", expression->kind);
+    }
+}
+
+static void foldVariable(Variable *variable) {
+    switch (variable->kind) {
+        case VARIABLE_NAMEDVARIABLE:
+            break;
+        case VARIABLE_ARRAYACCESS:
+            foldVariable(variable->u.arrayAccess.array);
+            foldExpression(variable->u.arrayAccess.index);
+            break;
+        default:
+            error("unknown variable kind %d in foldVariable", variable->kind);
+    }
+}
+
+bool evaluateCondition(Expression *condition, int *result) {
+    Expression *left, *right;
+
+    if (condition->kind != EXPRESSION_BINARYEXPRESSION) return false;
+    left = condition->u.binaryExpression.leftOperand;
+    right = condition->u.binaryExpression.rightOperand;
+
+    if (left->kind == EXPRESSION_INTLITERAL && right->kind == EXPRESSION_INTLITERAL) {
+        return evaluate(condition->u.binaryExpression.operator,
+                        left->u.intLiteral.value, right->u.intLiteral.value, result);
+    }
+    if (isTrapFree(left) && equalExpressions(left, right)) {
+        /* x compared with itself behaves like two equal constants */
+        return evaluate(condition->u.binaryExpression.operator, 0, 0, result);
+    }
+    return false;
+}
+
+static void foldStatementList(StatementList *statements) {
+    while (!statements->isEmpty) {
+        foldStatement(statements->head);
+        statements = statements->tail;
+    }
+}
+
+static void foldStatement(Statement *statement) {
+    ExpressionList *arguments;
+    int value;
+
+    switch (statement->kind) {
+        case STATEMENT_EMPTYSTATEMENT:
+            break;
+        case STATEMENT_COMPOUNDSTATEMENT:
+            foldStatementList(statement->u.compoundStatement.statements);
+            break;
+        case STATEMENT_ASSIGNSTATEMENT:
+            foldVariable(statement->u.assignStatement.target);
+            foldExpression(statement->u.assignStatement.value);
+            break;
+        case STATEMENT_IFSTATEMENT:
+            foldExpression(statement->u.ifStatement.condition);
+            foldStatement(statement->u.ifStatement.thenPart);
+            foldStatement(statement->u.ifStatement.elsePart);
+            if (evaluateCondition(statement->u.ifStatement.condition, &value)) {
+                *statement = value ? *statement->u.ifStatement.thenPart : *statement->u.ifStatement.elsePart;
+                changes++;
+            }
+            break;
+        case STATEMENT_WHILESTATEMENT:
+            foldExpression(statement->u.whileStatement.condition);
+            foldStatement(statement->u.whileStatement.body);
+            if (evaluateCondition(statement->u.whileStatement.condition, &value) && !value) {
+                statement->kind = STATEMENT_EMPTYSTATEMENT;
+                changes++;
+            }
+            break;
+        case STATEMENT_CALLSTATEMENT:
+            arguments = statement->u.callStatement.argumentList;
+            while (!arguments->isEmpty) {
+                foldExpression(arguments->head);
+                arguments = arguments->tail;
+            }
+            break;
+        default:
+            error("unknown statement kind %d in foldStatement", statement->kind);
+    }
+}
+
+int foldConstants(Program *program) {
+    GlobalDeclarationList *declarationList;
+
+    changes = 0;
+    declarationList = program;
+    while (!declarationList->isEmpty) {
+        if (declarationList->head->kind == DECLARATION_PROCEDUREDECLARATION) {
+            foldStatementList(declarationList->head->u.procedureDeclaration.body);
+        }
+        declarationList = declarationList->tail;
+    }
+    return changes;
+}
@@ -0,0 +1,44 @@
+/*
+ * fold.h -- constant folding and algebraic simplification
+ */
+
+
+#ifndef _FOLD_H_
+#define _FOLD_H_
+
+#include <absyn/absyn.h>
+
+/**
+ * This function folds constant subexpressions of the program and applies simple algebraic identities.
+ *
+ * The pass has to run after the semantic analysis, since it relies on the dataType fields of the expressions.
+ * Arithmetic is performed with the 32 bit wraparound semantics of the ECO32 processor.
+ * Divisions by zero are never folded, so the error still happens at runtime.
+ * Conditions of if- and while-statements comparing two constants are evaluated at compile time
+ * and the statement is replaced by the branch that is actually taken.
+ *
+ * @param program The program to be simplified. It is modified in place.
+ * @return The number of expressions and statements that have been simplified.
+ */
+int foldConstants(Program *program);
+
+/**
+ * Checks whether an expression can be evaluated without a runtime error, so dropping it is unobservable.
+ * Only such expressions may be removed by an identity like x * 0 or by the elimination of a dead store,
+ * because dropping them must not hide an index error or a division by zero. An array access is trap-free
+ * once its bounds check has been elided, a division only if its divisor is a constant other than 0 and -1.
+ * @param expression The expression to examine.
+ * @return true if the expression never traps.
+ */
+bool isTrapFree(Expression *expression);
+
+/**
+ * Tries to evaluate a condition at compile time: a comparison of two constants, or of a trap-free
+ * expression with itself.
+ * @param condition The condition of an if- or while-statement.
+ * @param result Set to the value of the condition, 0 or 1, if it is known.
+ * @return true if the value of the condition is known.
+ */
+bool evaluateCondition(Expression *condition, int *result);
+
+#endif /* _FOLD_H_ */
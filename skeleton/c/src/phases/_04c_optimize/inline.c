@@ -0,0 +1,508 @@
+/*
+ * inline.c -- inlining of procedure calls
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <util/errors.h>
+#include <util/memory.h>
+#include <absyn/absyn.h>
+#include <table/table.h>
+#include <types/types.h>
+#include "estimate.h"
+#include "inline.h"
+#include "profile.h"
+#include "locals.h"
+
+#define CALL_OVERHEAD 10    /* jal, frame setup and teardown, saving and restoring fp and the return address */
+
+/**
+ * The procedures of the program together with the information needed to decide about inlining.
+ */
+typedef struct {
+    GlobalDeclaration *declaration;
+    Entry *entry;
+    int size;
+    int budget;         /* the size the procedure may grow to */
+    bool isLeaf;
+    bool isRecursive;
+    bool isProcessed;
+} Procedure;
+
+/**
+ * The replacement of a parameter or local variable of the inlined procedure.
+ * Exactly one of variable and expression is set.
+ */
+typedef struct {
+    Identifier *name;
+    Variable *variable;
+    Expression *expression;
+} Substitution;
+
+static SymbolTable *procedures;
+static Procedure *procedureList;
+static int numProcedures;
+static int inlineThreshold;
+static bool reportCalls;
+static int numInlined;
+static int numNewVariables;
+
+/*
+ * Properties of procedures
+ */
+
+static Procedure *findProcedure(Identifier *name) {
+    int i;
+
+    for (i = 0; i < numProcedures; i++) {
+        if (procedureList[i].declaration->name == name) return &procedureList[i];
+    }
+    return NULL;
+}
+
+static void markCaller(Statement *call, void *data) {
+    (void) call;
+    ((Procedure *) data)->isLeaf = false;
+}
+
+static void markReachable(Statement *call, void *data) {
+    Procedure *callee;
+    bool *reachable = data;
+
+    callee = findProcedure(call->u.callStatement.procedureName);
+    if (callee == NULL || reachable[callee - procedureList]) return;
+    reachable[callee - procedureList] = true;
+    forEachCallInList(callee->declaration->u.procedureDeclaration.body, markReachable, data);
+}
+
+/**
+ * Collects the procedures of the program and finds the recursive ones in the call graph.
+ */
+static void collectProcedures(Program *program) {
+    GlobalDeclarationList *declarationList;
+    Procedure *procedure;
+    bool *reachable;
+    int i;
+
+    numProcedures = 0;
+    for (declarationList = program; !declarationList->isEmpty; declarationList = declarationList->tail) {
+        if (declarationList->head->kind == DECLARATION_PROCEDUREDECLARATION) numProcedures++;
+    }
+    procedureList = allocate(numProcedures * sizeof(Procedure));
+    i = 0;
+    for (declarationList = program; !declarationList->isEmpty; declarationList = declarationList->tail) {
+        if (declarationList->head->kind != DECLARATION_PROCEDUREDECLARATION) continue;
+        procedure = &procedureList[i++];
+        procedure->declaration = declarationList->head;
+        procedure->entry = lookup(procedures, procedure->declaration->name);
+        procedure->size = statementListSize(procedure->declaration->u.procedureDeclaration.body);
+        procedure->budget = 2 * procedure->size + inlineThreshold;
+        procedure->isLeaf = true;
+        procedure->isProcessed = false;
+        forEachCallInList(procedure->declaration->u.procedureDeclaration.body, markCaller, procedure);
+    }
+
+    reachable = allocate(numProcedures * sizeof(bool));
+    for (i = 0; i < numProcedures; i++) {
+        procedure = &procedureList[i];
+        memset(reachable, 0, numProcedures * sizeof(bool));
+        forEachCallInList(procedure->declaration->u.procedureDeclaration.body, markReachable, reachable);
+        procedure->isRecursive = reachable[i];
+    }
+    release(reachable);
+}
+
+/*
+ * Arguments
+ */
+
+/**
+ * Checks whether the address of a variable is known at the call, i.e. its indices are constant and in range.
+ */
+static bool hasFixedAddress(Variable *variable) {
+    Expression *index;
+
+    switch (variable->kind) {
+        case VARIABLE_NAMEDVARIABLE:
+            return true;
+        case VARIABLE_ARRAYACCESS:
+            index = variable->u.arrayAccess.index;
+            return index->kind == EXPRESSION_INTLITERAL && index->u.intLiteral.value >= 0 &&
+                   index->u.intLiteral.value < variable->u.arrayAccess.array->dataType->u.arrayType.size &&
+                   hasFixedAddress(variable->u.arrayAccess.array);
+        default:
+            error("unknown variable kind %d in hasFixedAddress", variable->kind);
+            return false;
+    }
+}
+
+/**
+ * Checks whether a parameter is assigned or passed by reference in the body of its procedure.
+ */
+static bool isChanged(Statement *statement, Identifier *parameter);
+
+static bool isChangedInList(StatementList *statements, Identifier *parameter) {
+    while (!statements->isEmpty) {
+        if (isChanged(statements->head, parameter)) return true;
+        statements = statements->tail;
+    }
+    return false;
+}
+
+static bool isChanged(Statement *statement, Identifier *parameter) {
+    Variable *target;
+    ParamTypes *paramTypes;
+    ExpressionList *arguments;
+    Expression *argument;
+
+    switch (statement->kind) {
+        case STATEMENT_COMPOUNDSTATEMENT:
+            return isChangedInList(statement->u.compoundStatement.statements, parameter);
+        case STATEMENT_ASSIGNSTATEMENT:
+            target = statement->u.assignStatement.target;
+            return target->kind == VARIABLE_NAMEDVARIABLE && target->u.namedVariable.name == parameter;
+        case STATEMENT_IFSTATEMENT:
+            return isChanged(statement->u.ifStatement.thenPart, parameter) ||
+                   isChanged(statement->u.ifStatement.elsePart, parameter);
+        case STATEMENT_WHILESTATEMENT:
+            return isChanged(statement->u.whileStatement.body, parameter);
+        case STATEMENT_CALLSTATEMENT:
+            paramTypes = lookup(procedures, statement->u.callStatement.procedureName)->u.procEntry.paramTypes;
+            arguments = statement->u.callStatement.argumentList;
+            for (; !arguments->isEmpty && !paramTypes->isEmpty; arguments = arguments->tail, paramTypes = paramTypes->next) {
+                argument = arguments->head;
+                if (paramTypes->isRef && argument->kind == EXPRESSION_VARIABLEEXPRESSION &&
+                    argument->u.variableExpression.variable->kind == VARIABLE_NAMEDVARIABLE &&
+                    argument->u.variableExpression.variable->u.namedVariable.name == parameter) {
+                    return true;
+                }
+            }
+            return false;
+        default:
+            return false;
+    }
+}
+
+/**
+ * Checks whether a variable of the caller is passed to a reference parameter of the call,
+ * so the called procedure might change it.
+ */
+static bool isPassedByReference(Statement *call, Entry *entry, SymbolTable *callerTable) {
+    ParamTypes *paramTypes;
+    ExpressionList *arguments;
+
+    paramTypes = lookup(procedures, call->u.callStatement.procedureName)->u.procEntry.paramTypes;
+    arguments = call->u.callStatement.argumentList;
+    for (; !arguments->isEmpty && !paramTypes->isEmpty; arguments = arguments->tail, paramTypes = paramTypes->next) {
+        if (paramTypes->isRef && rootEntry(callerTable, arguments->head->u.variableExpression.variable) == entry) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/*
+ * Substitution
+ */
+
+static Identifier *newVariableName(Identifier *procedure, Identifier *name) {
+    char buffer[200];
+
+    /* a dot can never appear in an identifier of the source program */
+    snprintf(buffer, sizeof(buffer), "%.90s.%.90s.%d", procedure->string, name->string, ++numNewVariables);
+    return newIdentifier(buffer);
+}
+
+static Substitution *findSubstitution(Substitution *substitutions, int count, Identifier *name) {
+    int i;
+
+    for (i = 0; i < count; i++) {
+        if (substitutions[i].name == name) return &substitutions[i];
+    }
+    error("undefined variable '%s' in inlined procedure", name->string);
+    return NULL;
+}
+
+static void substituteExpression(Expression *expression, Substitution *substitutions, int count);
+
+static void substituteVariable(Variable *variable, Substitution *substitutions, int count) {
+    Substitution *substitution;
+    int line;
+
+    switch (variable->kind) {
+        case VARIABLE_NAMEDVARIABLE:
+            substitution = findSubstitution(substitutions, count, variable->u.namedVariable.name);
+            if (substitution->variable == NULL) error("parameter replaced by an expression in a variable");
+            line = variable->line;
+            *variable = *copyVariable(substitution->variable);
+            variable->line = line;
+            break;
+        case VARIABLE_ARRAYACCESS:
+            substituteVariable(variable->u.arrayAccess.array, substitutions, count);
+            substituteExpression(variable->u.arrayAccess.index, substitutions, count);
+            break;
+        default:
+            error("unknown variable kind %d in substituteVariable", variable->kind);
+    }
+}
+
+static void substituteExpression(Expression *expression, Substitution *substitutions, int count) {
+    Substitution *substitution;
+    Variable *variable;
+    int line;
+
+    switch (expression->kind) {
+        case EXPRESSION_INTLITERAL:
+            break;
+        case EXPRESSION_VARIABLEEXPRESSION:
+            variable = expression->u.variableExpression.variable;
+            if (variable->kind == VARIABLE_NAMEDVARIABLE) {
+                substitution = findSubstitution(substitutions, count, variable->u.namedVariable.name);
+                if (substitution->expression != NULL) {
+                    line = expression->line;
+                    *expression = *copyExpression(substitution->expression);
+                    expression->line = line;
+                    break;
+                }
+            }
+            substituteVariable(variable, substitutions, count);
+            break;
+        case EXPRESSION_BINARYEXPRESSION:
+            substituteExpression(expression->u.binaryExpression.leftOperand, substitutions, count);
+            substituteExpression(expression->u.binaryExpression.rightOperand, substitutions, count);
+            break;
+        default:
+            error("unknown expression kind %d in substituteExpression", expression->kind);
+    }
+}
+
+static void substituteStatement(Statement *statement, Substitution *substitutions, int count);
+
+static void substituteStatementList(StatementList *statements, Substitution *substitutions, int count) {
+    while (!statements->isEmpty) {
+        substituteStatement(statements->head, substitutions, count);
+        statements = statements->tail;
+    }
+}
+
+static void substituteStatement(Statement *statement, Substitution *substitutions, int count) {
+    ExpressionList *arguments;
+
+    switch (statement->kind) {
+        case STATEMENT_EMPTYSTATEMENT:
+            break;
+        case STATEMENT_COMPOUNDSTATEMENT:
+            substituteStatementList(statement->u.compoundStatement.statements, substitutions, count);
+            break;
+        case STATEMENT_ASSIGNSTATEMENT:
+            substituteVariable(statement->u.assignStatement.target, substitutions, count);
+            substituteExpression(statement->u.assignStatement.value, substitutions, count);
+            break;
+        case STATEMENT_IFSTATEMENT:
+            substituteExpression(statement->u.ifStatement.condition, substitutions, count);
+            substituteStatement(statement->u.ifStatement.thenPart, substitutions, count);
+            substituteStatement(statement->u.ifStatement.elsePart, substitutions, count);
+            break;
+        case STATEMENT_WHILESTATEMENT:
+            substituteExpression(statement->u.whileStatement.condition, substitutions, count);
+            substituteStatement(statement->u.whileStatement.body, substitutions, count);
+            break;
+        case STATEMENT_CALLSTATEMENT:
+            for (arguments = statement->u.callStatement.argumentList; !arguments->isEmpty; arguments = arguments->tail) {
+                substituteExpression(arguments->head, substitutions, count);
+            }
+            break;
+        default:
+            error("unknown statement kind %d in substituteStatement", statement->kind);
+    }
+}
+
+/*
+ * Inlining
+ */
+
+static int countParameters(ParameterList *parameters) {
+    int count = 0;
+
+    for (; !parameters->isEmpty; parameters = parameters->tail) count++;
+    return count;
+}
+
+static int countVariables(VariableDeclarationList *variables) {
+    int count = 0;
+
+    for (; !variables->isEmpty; variables = variables->tail) count++;
+    return count;
+}
+
+/**
+ * Checks whether a call may be inlined.
+ * @return NULL if it may, otherwise the reason why not.
+ */
+static char *rejectCall(Procedure *caller, Procedure *callee, Statement *call) {
+    ParameterList *parameters;
+    ExpressionList *arguments;
+    int limit;
+
+    if (callee->isRecursive) return "recursive";
+    if (isColdProfileCounter(call, 0)) return "never executed in the profile";
+    limit = callee->isLeaf ? inlineThreshold : inlineThreshold / 2;
+    if (isHotProfileCounter(call, 0)) limit *= 2;
+    if (callee->size > limit) return "too large";
+    if (caller->size + callee->size > caller->budget) return "size budget of the caller exhausted";
+    parameters = callee->declaration->u.procedureDeclaration.parameters;
+    arguments = call->u.callStatement.argumentList;
+    for (; !parameters->isEmpty; parameters = parameters->tail, arguments = arguments->tail) {
+        if (parameters->head->isReference &&
+            !hasFixedAddress(arguments->head->u.variableExpression.variable)) {
+            return "reference argument with a variable index";
+        }
+    }
+    return NULL;
+}
+
+/**
+ * Replaces a call by a copy of the body of the called procedure.
+ * @return The number of arguments, which are not copied into a new variable.
+ */
+static int inlineCall(Procedure *caller, Procedure *callee, Statement *call) {
+    SymbolTable *callerTable, *calleeTable;
+    Substitution *substitutions;
+    ParameterList *parameters;
+    VariableDeclarationList *variables;
+    ExpressionList *arguments;
+    StatementList *initializations, **lastInitialization, *body;
+    Statement *initialization;
+    Expression *argument;
+    Variable *variable;
+    Entry *entry;
+    int count, passedDirectly;
+
+    callerTable = caller->entry->u.procEntry.localTable;
+    calleeTable = callee->entry->u.procEntry.localTable;
+    parameters = callee->declaration->u.procedureDeclaration.parameters;
+    variables = callee->declaration->u.procedureDeclaration.variables;
+    substitutions = allocate((countParameters(parameters) + countVariables(variables)) * sizeof(Substitution));
+    count = 0;
+    passedDirectly = 0;
+    initializations = emptyStatementList();
+    lastInitialization = &initializations;
+
+    for (arguments = call->u.callStatement.argumentList; !parameters->isEmpty;
+         parameters = parameters->tail, arguments = arguments->tail) {
+        argument = arguments->head;
+        substitutions[count].name = parameters->head->name;
+        substitutions[count].variable = NULL;
+        substitutions[count].expression = NULL;
+        if (parameters->head->isReference) {
+            substitutions[count].variable = argument->u.variableExpression.variable;
+            passedDirectly++;
+        } else if (!isChangedInList(callee->declaration->u.procedureDeclaration.body, parameters->head->name) &&
+                   argument->kind == EXPRESSION_INTLITERAL) {
+            substitutions[count].expression = argument;
+            passedDirectly++;
+        } else if (!isChangedInList(callee->declaration->u.procedureDeclaration.body, parameters->head->name) &&
+                   argument->kind == EXPRESSION_VARIABLEEXPRESSION &&
+                   argument->u.variableExpression.variable->kind == VARIABLE_NAMEDVARIABLE &&
+                   !(entry = rootEntry(callerTable, argument->u.variableExpression.variable))->u.varEntry.isRef &&
+                   !isPassedByReference(call, entry, callerTable)) {
+            substitutions[count].variable = argument->u.variableExpression.variable;
+            passedDirectly++;
+        } else {
+            entry = lookup(calleeTable, parameters->head->name);
+            variable = newLocalVariable(caller->declaration, callerTable,
+                                        newVariableName(callee->declaration->name, parameters->head->name),
+                                        parameters->head->typeExpression, entry->u.varEntry.type, call->line);
+            substitutions[count].variable = variable;
+            initialization = newAssignStatement(call->line, copyVariable(variable), copyExpression(argument));
+            *lastInitialization = newStatementList(initialization, emptyStatementList());
+            lastInitialization = &(*lastInitialization)->tail;
+        }
+        count++;
+    }
+    for (; !variables->isEmpty; variables = variables->tail) {
+        entry = lookup(calleeTable, variables->head->name);
+        substitutions[count].name = variables->head->name;
+        substitutions[count].variable = newLocalVariable(caller->declaration, callerTable,
+                                                         newVariableName(callee->declaration->name, variables->head->name),
+                                                         variables->head->typeExpression, entry->u.varEntry.type, call->line);
+        substitutions[count].expression = NULL;
+        count++;
+    }
+
+    body = copyStatementList(callee->declaration->u.procedureDeclaration.body);
+    substituteStatementList(body, substitutions, count);
+    *lastInitialization = body;
+    *call = *newCompoundStatement(call->line, initializations);
+    release(substitutions);
+    return passedDirectly;
+}
+
+static void inlineCallsInProcedure(Procedure *caller);
+
+static void processCallee(Statement *call, void *data) {
+    Procedure *callee;
+
+    (void) data;
+    callee = findProcedure(call->u.callStatement.procedureName);
+    if (callee != NULL) inlineCallsInProcedure(callee);
+}
+
+static void inlineCallSite(Statement *call, void *data) {
+    Procedure *caller = data, *callee;
+    Identifier *name;
+    char *reason;
+    int line, size, saved;
+
+    name = call->u.callStatement.procedureName;
+    callee = findProcedure(name);
+    /* predefined procedures have no body */
+    if (callee == NULL) return;
+    line = call->line;
+    reason = rejectCall(caller, callee, call);
+    if (reason != NULL) {
+        if (reportCalls) printf("call of '%s' in line %d: not inlined, %s\n", name->string, line, reason);
+        return;
+    }
+    size = callee->size;
+    saved = CALL_OVERHEAD + inlineCall(caller, callee, call);
+    caller->size += size;
+    numInlined++;
+    if (reportCalls) {
+        printf("call of '%s' in line %d: inlined, size = %d, estimated instructions saved per call = %d\n",
+               name->string, line, size, saved);
+    }
+}
+
+/**
+ * Inlines the calls of a procedure, after its callees have been processed.
+ */
+static void inlineCallsInProcedure(Procedure *caller) {
+    StatementList *body;
+
+    if (caller->isProcessed) return;
+    caller->isProcessed = true;
+    body = caller->declaration->u.procedureDeclaration.body;
+    forEachCallInList(body, processCallee, NULL);
+
+    if (reportCalls) printf("\nInlining for procedure '%s'\n", caller->declaration->name->string);
+    forEachCallInList(body, inlineCallSite, caller);
+    caller->isLeaf = true;
+    forEachCallInList(body, markCaller, caller);
+    if (reportCalls) printf("size = %d\n", caller->size);
+}
+
+int inlineCalls(Program *program, SymbolTable *globalTable, int threshold, bool showReport) {
+    int i;
+
+    procedures = globalTable;
+    inlineThreshold = threshold;
+    reportCalls = showReport;
+    numInlined = 0;
+    if (threshold <= 0) return 0;
+
+    collectProcedures(program);
+    for (i = 0; i < numProcedures; i++) inlineCallsInProcedure(&procedureList[i]);
+    release(procedureList);
+    return numInlined;
+}
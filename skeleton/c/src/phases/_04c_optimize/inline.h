@@ -0,0 +1,45 @@
+/*
+ * inline.h -- inlining of procedure calls
+ */
+
+
+#ifndef _INLINE_H_
+#define _INLINE_H_
+
+#include <absyn/absyn.h>
+#include <table/table.h>
+
+#define DEFAULT_INLINE_THRESHOLD 100    /* used with -O2, in nodes of the abstract syntax tree */
+
+/**
+ * This function replaces calls of small procedures by a copy of their body.
+ *
+ * The size of a procedure is the number of statements, expressions and variables in its body.
+ * A procedure is inlined if its size is at most the threshold, or half of it if the procedure calls
+ * other procedures itself, since the calls it contains are not saved. With a profile, calls which have never
+ * been executed are kept and the limit is doubled for hot calls. Recursive procedures, i.e. procedures
+ * that may call themselves directly or indirectly, and the predefined procedures are never inlined.
+ * Every procedure may only grow to twice its original size plus the threshold.
+ * The procedures are processed from the leaves of the call graph upwards, so a procedure is inlined
+ * with the calls it contains already inlined.
+ *
+ * In the copy of the body, the local variables of the called procedure become new local variables of
+ * the caller. A value parameter becomes a new local variable as well, which is assigned the argument in front
+ * of the body, unless the parameter is never changed and the argument is a literal or a variable which
+ * the called procedure cannot change; then the argument is used directly. A reference parameter is
+ * replaced by the variable passed to it. Since its address has to stay the same during the call,
+ * only a named variable or an array element with constant indices is accepted, otherwise the call is kept.
+ * The new variables get names which are no valid identifiers in SPL, so they never collide with the
+ * caller's variables.
+ *
+ * The pass has to run after the semantic analysis.
+ *
+ * @param program The program whose calls are inlined.
+ * @param globalTable The symbol table for the current program.
+ * @param threshold The largest size of an inlined procedure, 0 disables inlining.
+ * @param showReport Whether every call site should be printed with the decision taken.
+ * @return The number of inlined calls.
+ */
+int inlineCalls(Program *program, SymbolTable *globalTable, int threshold, bool showReport);
+
+#endif /* _INLINE_H_ */
@@ -0,0 +1,111 @@
+/*
+ * invert.c -- loop inversion
+ */
+
+#include <stdio.h>
+#include <util/errors.h>
+#include <absyn/absyn.h>
+#include <table/table.h>
+#include "invert.h"
+
+static SymbolTable *localTable;
+static int numInverted;
+static bool reportLoops;
+
+static int addressSize(Variable *variable);
+
+/**
+ * Estimates the number of instructions evaluating an expression, or the branch of a condition.
+ */
+static int expressionSize(Expression *expression) {
+    Variable *variable;
+    Entry *entry;
+
+    switch (expression->kind) {
+        case EXPRESSION_INTLITERAL:
+            return 1;
+        case EXPRESSION_VARIABLEEXPRESSION:
+            variable = expression->u.variableExpression.variable;
+            if (variable->kind == VARIABLE_NAMEDVARIABLE) {
+                entry = lookup(localTable, variable->u.namedVariable.name);
+                if (entry->u.varEntry.reg != 0) return 1;
+            }
+            return addressSize(variable) + 1;
+        case EXPRESSION_BINARYEXPRESSION:
+            return expressionSize(expression->u.binaryExpression.leftOperand) +
+                   expressionSize(expression->u.binaryExpression.rightOperand) + 1;
+        default:
+            error("unknown expression kind %d in expressionSize", expression->kind);
+            return 0;
+    }
+}
+
+static int addressSize(Variable *variable) {
+    Entry *entry;
+
+    switch (variable->kind) {
+        case VARIABLE_NAMEDVARIABLE:
+            entry = lookup(localTable, variable->u.namedVariable.name);
+            return entry->u.varEntry.isRef ? 2 : 1;
+        case VARIABLE_ARRAYACCESS:
+            /* a reduced access only adds its offset to the pointer register */
+            if (variable->u.arrayAccess.pointer != NULL) return 1;
+            return addressSize(variable->u.arrayAccess.array) + expressionSize(variable->u.arrayAccess.index) +
+                   (variable->u.arrayAccess.checkIndex ? 3 : 0) + 2;
+        default:
+            error("unknown variable kind %d in addressSize", variable->kind);
+            return 0;
+    }
+}
+
+static void invertStatement(Statement *statement);
+
+static void invertStatementList(StatementList *statements) {
+    for (; !statements->isEmpty; statements = statements->tail) invertStatement(statements->head);
+}
+
+static void invertStatement(Statement *statement) {
+    int size;
+
+    switch (statement->kind) {
+        case STATEMENT_COMPOUNDSTATEMENT:
+            invertStatementList(statement->u.compoundStatement.statements);
+            break;
+        case STATEMENT_IFSTATEMENT:
+            invertStatement(statement->u.ifStatement.thenPart);
+            invertStatement(statement->u.ifStatement.elsePart);
+            break;
+        case STATEMENT_WHILESTATEMENT:
+            invertStatement(statement->u.whileStatement.body);
+            size = expressionSize(statement->u.whileStatement.condition);
+            if (size > MAX_INVERTED_CONDITION) {
+                if (reportLoops) printf("loop in line %d: not inverted, condition = %d instructions\n",
+                                        statement->line, size);
+                break;
+            }
+            statement->u.whileStatement.isInverted = true;
+            numInverted++;
+            if (reportLoops) printf("loop in line %d: inverted, condition = %d instructions, jumps saved per iteration = 1\n",
+                                    statement->line, size);
+            break;
+        default:
+            break;
+    }
+}
+
+int invertLoops(Program *program, SymbolTable *globalTable, bool showReport) {
+    GlobalDeclarationList *declarationList;
+    GlobalDeclaration *declaration;
+
+    numInverted = 0;
+    reportLoops = showReport;
+    for (declarationList = program; !declarationList->isEmpty; declarationList = declarationList->tail) {
+        declaration = declarationList->head;
+        if (declaration->kind != DECLARATION_PROCEDUREDECLARATION) continue;
+
+        localTable = lookup(globalTable, declaration->name)->u.procEntry.localTable;
+        if (showReport) printf("\nLoop inversion for procedure '%s'\n", declaration->name->string);
+        invertStatementList(declaration->u.procedureDeclaration.body);
+    }
+    return numInverted;
+}
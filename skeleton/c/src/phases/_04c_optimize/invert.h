@@ -0,0 +1,35 @@
+/*
+ * invert.h -- loop inversion
+ */
+
+
+#ifndef _INVERT_H_
+#define _INVERT_H_
+
+#include <absyn/absyn.h>
+#include <table/table.h>
+
+#define MAX_INVERTED_CONDITION 12   /* instructions of a condition which may be duplicated */
+
+/**
+ * This function marks while-loops to be emitted as a do-while-loop guarded by a copy of the condition.
+ *
+ * A loop is normally emitted with its test at the top and an unconditional jump back to the test after the
+ * body, so every iteration executes a jump and a branch. An inverted loop tests the condition in front of
+ * the loop, skipping it if the condition is false, and again after the body, branching back to the start
+ * of the body if it is true. Every iteration then executes a single conditional branch. The pointers of the
+ * loop strength reduction and the code motion are set up between the first test and the body, as before.
+ *
+ * Since the code of the condition is emitted twice, only loops whose condition is estimated to need
+ * at most MAX_INVERTED_CONDITION instructions are inverted. The code generator has to honor the isInverted
+ * field of the while-statement. The pass has to run after the register allocation and the loop strength
+ * reduction, whose results change the size of the condition.
+ *
+ * @param program The program whose loops are inverted.
+ * @param globalTable The symbol table for the current program.
+ * @param showReport Whether the decision for every loop should be printed.
+ * @return The number of inverted loops.
+ */
+int invertLoops(Program *program, SymbolTable *globalTable, bool showReport);
+
+#endif /* _INVERT_H_ */
@@ -0,0 +1,628 @@
+/*
+ * ipcp.c -- interprocedural constant propagation and procedure cloning
+ */
+
+#include <stdio.h>
+#include <util/errors.h>
+#include <util/memory.h>
+#include <absyn/absyn.h>
+#include <table/table.h>
+#include <types/types.h>
+#include "callgraph.h"
+#include "fold.h"
+#include "profile.h"
+#include "estimate.h"
+#include "ipcp.h"
+
+/**
+ * The value of a parameter over all calls, in the lattice unknown > constant > varying.
+ */
+typedef enum {
+    VALUE_UNKNOWN,      /* no call has been seen yet */
+    VALUE_CONSTANT,
+    VALUE_VARYING
+} value_kind;
+
+typedef struct {
+    value_kind kind;
+    int value;
+} Value;
+
+/**
+ * A procedure of the program or a copy made by this pass.
+ */
+typedef struct procedure {
+    GlobalDeclaration *declaration;
+    Entry *entry;
+    CallGraphNode *node;                /* the node of the original procedure */
+    struct procedure *original;         /* the procedure this one is a copy of, NULL for an original */
+    int numParameters;                  /* of the original */
+    ParameterDeclaration **parameters;
+    bool *isConsidered;                 /* a value parameter of type int which the body never changes */
+    Value *values;
+    bool *isSpecialised;                /* for a copy, the parameters of the original replaced by a constant */
+    int *constants;
+    int size;
+    int numCopies;
+    GlobalDeclarationList *lastDeclaration;     /* the copies are declared behind it */
+    struct procedure *next;
+} Procedure;
+
+/**
+ * A parameter together with the constant it is replaced by.
+ */
+typedef struct {
+    Identifier *name;
+    int value;
+} Replacement;
+
+static SymbolTable *procedures;
+static CallGraph *callGraph;
+static Procedure *procedureList;
+static Procedure *lastProcedure;
+static Procedure *reportedCaller;
+static bool reportCalls;
+static bool isValueChanged;
+static int sizeBudget;
+static int numChanges;
+
+/*
+ * Walking the bodies
+ */
+
+static Procedure *findProcedure(Identifier *name) {
+    Procedure *procedure;
+
+    for (procedure = procedureList; procedure != NULL; procedure = procedure->next) {
+        if (procedure->declaration->name == name) return procedure;
+    }
+    return NULL;
+}
+
+/**
+ * Replaces the uses of parameters by their constants, or only counts them if replace is false.
+ * @return The number of uses.
+ */
+static int replaceInExpression(Expression *expression, Replacement *replacements, int count, bool replace);
+
+static int replaceInVariable(Variable *variable, Replacement *replacements, int count, bool replace) {
+    switch (variable->kind) {
+        case VARIABLE_NAMEDVARIABLE:
+            return 0;
+        case VARIABLE_ARRAYACCESS:
+            return replaceInVariable(variable->u.arrayAccess.array, replacements, count, replace) +
+                   replaceInExpression(variable->u.arrayAccess.index, replacements, count, replace);
+        default:
+            error("unknown variable kind %d in replaceInVariable", variable->kind);
+            return 0;
+    }
+}
+
+static int replaceInExpression(Expression *expression, Replacement *replacements, int count, bool replace) {
+    Variable *variable;
+    Expression *literal;
+    int i;
+
+    switch (expression->kind) {
+        case EXPRESSION_INTLITERAL:
+            return 0;
+        case EXPRESSION_VARIABLEEXPRESSION:
+            variable = expression->u.variableExpression.variable;
+            if (variable->kind != VARIABLE_NAMEDVARIABLE) return replaceInVariable(variable, replacements, count, replace);
+            for (i = 0; i < count; i++) {
+                if (variable->u.namedVariable.name != replacements[i].name) continue;
+                if (replace) {
+                    literal = newIntLiteral(expression->line, replacements[i].value);
+                    literal->dataType = intType;
+                    *expression = *literal;
+                }
+                return 1;
+            }
+            return 0;
+        case EXPRESSION_BINARYEXPRESSION:
+            return replaceInExpression(expression->u.binaryExpression.leftOperand, replacements, count, replace) +
+                   replaceInExpression(expression->u.binaryExpression.rightOperand, replacements, count, replace);
+        default:
+            error("unknown expression kind %d in replaceInExpression", expression->kind);
+            return 0;
+    }
+}
+
+static int replaceInStatement(Statement *statement, Replacement *replacements, int count, bool replace);
+
+static int replaceInList(StatementList *statements, Replacement *replacements, int count, bool replace) {
+    int uses = 0;
+
+    for (; !statements->isEmpty; statements = statements->tail) {
+        uses += replaceInStatement(statements->head, replacements, count, replace);
+    }
+    return uses;
+}
+
+static int replaceInStatement(Statement *statement, Replacement *replacements, int count, bool replace) {
+    ExpressionList *arguments;
+    int uses;
+
+    switch (statement->kind) {
+        case STATEMENT_EMPTYSTATEMENT:
+            return 0;
+        case STATEMENT_COMPOUNDSTATEMENT:
+            return replaceInList(statement->u.compoundStatement.statements, replacements, count, replace);
+        case STATEMENT_ASSIGNSTATEMENT:
+            /* the target is never one of the parameters, since they are not changed */
+            return replaceInVariable(statement->u.assignStatement.target, replacements, count, replace) +
+                   replaceInExpression(statement->u.assignStatement.value, replacements, count, replace);
+        case STATEMENT_IFSTATEMENT:
+            return replaceInExpression(statement->u.ifStatement.condition, replacements, count, replace) +
+                   replaceInStatement(statement->u.ifStatement.thenPart, replacements, count, replace) +
+                   replaceInStatement(statement->u.ifStatement.elsePart, replacements, count, replace);
+        case STATEMENT_WHILESTATEMENT:
+            return replaceInExpression(statement->u.whileStatement.condition, replacements, count, replace) +
+                   replaceInStatement(statement->u.whileStatement.body, replacements, count, replace);
+        case STATEMENT_CALLSTATEMENT:
+            uses = 0;
+            for (arguments = statement->u.callStatement.argumentList; !arguments->isEmpty; arguments = arguments->tail) {
+                uses += replaceInExpression(arguments->head, replacements, count, replace);
+            }
+            return uses;
+        default:
+            error("unknown statement kind %d in replaceInStatement", statement->kind);
+            return 0;
+    }
+}
+
+/*
+ * Properties of procedures
+ */
+
+/**
+ * Checks whether a parameter is assigned or passed by reference in a statement.
+ */
+static bool isChanged(Statement *statement, Identifier *parameter);
+
+static bool isChangedInList(StatementList *statements, Identifier *parameter) {
+    for (; !statements->isEmpty; statements = statements->tail) {
+        if (isChanged(statements->head, parameter)) return true;
+    }
+    return false;
+}
+
+static bool isChanged(Statement *statement, Identifier *parameter) {
+    Variable *target;
+    ParamTypes *paramTypes;
+    ExpressionList *arguments;
+    Expression *argument;
+
+    switch (statement->kind) {
+        case STATEMENT_COMPOUNDSTATEMENT:
+            return isChangedInList(statement->u.compoundStatement.statements, parameter);
+        case STATEMENT_ASSIGNSTATEMENT:
+            target = statement->u.assignStatement.target;
+            return target->kind == VARIABLE_NAMEDVARIABLE && target->u.namedVariable.name == parameter;
+        case STATEMENT_IFSTATEMENT:
+            return isChanged(statement->u.ifStatement.thenPart, parameter) ||
+                   isChanged(statement->u.ifStatement.elsePart, parameter);
+        case STATEMENT_WHILESTATEMENT:
+            return isChanged(statement->u.whileStatement.body, parameter);
+        case STATEMENT_CALLSTATEMENT:
+            paramTypes = lookup(procedures, statement->u.callStatement.procedureName)->u.procEntry.paramTypes;
+            arguments = statement->u.callStatement.argumentList;
+            for (; !arguments->isEmpty && !paramTypes->isEmpty; arguments = arguments->tail, paramTypes = paramTypes->next) {
+                argument = arguments->head;
+                if (paramTypes->isRef && argument->kind == EXPRESSION_VARIABLEEXPRESSION &&
+                    argument->u.variableExpression.variable->kind == VARIABLE_NAMEDVARIABLE &&
+                    argument->u.variableExpression.variable->u.namedVariable.name == parameter) {
+                    return true;
+                }
+            }
+            return false;
+        default:
+            return false;
+    }
+}
+
+static void appendProcedure(Procedure *procedure) {
+    procedure->next = NULL;
+    if (lastProcedure == NULL) procedureList = procedure;
+    else lastProcedure->next = procedure;
+    lastProcedure = procedure;
+}
+
+/**
+ * Collects the procedures of the program with their parameters.
+ * @return The size of the program.
+ */
+static int collectProcedures(Program *program) {
+    GlobalDeclarationList *declarationList;
+    ParameterList *parameters;
+    Procedure *procedure;
+    Entry *entry;
+    int programSize, i;
+
+    procedureList = NULL;
+    lastProcedure = NULL;
+    programSize = 0;
+    for (declarationList = program; !declarationList->isEmpty; declarationList = declarationList->tail) {
+        if (declarationList->head->kind != DECLARATION_PROCEDUREDECLARATION) continue;
+        procedure = allocate(sizeof(Procedure));
+        procedure->declaration = declarationList->head;
+        procedure->entry = lookup(procedures, procedure->declaration->name);
+        procedure->node = findCallGraphNode(callGraph, procedure->declaration->name);
+        procedure->original = NULL;
+        procedure->numParameters = 0;
+        for (parameters = procedure->declaration->u.procedureDeclaration.parameters; !parameters->isEmpty;
+             parameters = parameters->tail) {
+            procedure->numParameters++;
+        }
+        procedure->parameters = allocate((procedure->numParameters + 1) * sizeof(ParameterDeclaration *));
+        procedure->isConsidered = allocate((procedure->numParameters + 1) * sizeof(bool));
+        procedure->values = allocate((procedure->numParameters + 1) * sizeof(Value));
+        parameters = procedure->declaration->u.procedureDeclaration.parameters;
+        for (i = 0; i < procedure->numParameters; i++, parameters = parameters->tail) {
+            procedure->parameters[i] = parameters->head;
+            entry = lookup(procedure->entry->u.procEntry.localTable, parameters->head->name);
+            procedure->isConsidered[i] = !parameters->head->isReference && entry->u.varEntry.type == intType &&
+                                         !isChangedInList(procedure->declaration->u.procedureDeclaration.body,
+                                                          parameters->head->name);
+            procedure->values[i].kind = VALUE_UNKNOWN;
+            procedure->values[i].value = 0;
+        }
+        procedure->isSpecialised = NULL;
+        procedure->constants = NULL;
+        procedure->size = statementListSize(procedure->declaration->u.procedureDeclaration.body);
+        procedure->numCopies = 0;
+        procedure->lastDeclaration = declarationList;
+        appendProcedure(procedure);
+        programSize += procedure->size;
+    }
+    return programSize;
+}
+
+static void releaseProcedures(void) {
+    Procedure *procedure, *next;
+
+    for (procedure = procedureList; procedure != NULL; procedure = next) {
+        next = procedure->next;
+        if (procedure->original == NULL) {
+            release(procedure->parameters);
+            release(procedure->isConsidered);
+            release(procedure->values);
+        } else {
+            release(procedure->isSpecialised);
+            release(procedure->constants);
+        }
+        release(procedure);
+    }
+}
+
+/*
+ * Propagation
+ */
+
+/**
+ * Computes the value of an argument in its caller.
+ */
+static Value argumentValue(Procedure *caller, Expression *argument) {
+    Value value;
+    Variable *variable;
+    int i;
+
+    value.kind = VALUE_VARYING;
+    value.value = 0;
+    if (argument->kind == EXPRESSION_INTLITERAL) {
+        value.kind = VALUE_CONSTANT;
+        value.value = argument->u.intLiteral.value;
+    } else if (argument->kind == EXPRESSION_VARIABLEEXPRESSION) {
+        variable = argument->u.variableExpression.variable;
+        if (variable->kind != VARIABLE_NAMEDVARIABLE) return value;
+        for (i = 0; i < caller->numParameters; i++) {
+            if (caller->parameters[i]->name == variable->u.namedVariable.name && caller->isConsidered[i]) {
+                return caller->values[i];
+            }
+        }
+    }
+    return value;
+}
+
+/**
+ * Combines the value of a parameter with the value of another argument.
+ * @return true if the value of the parameter changed.
+ */
+static bool meet(Value *parameter, Value argument) {
+    if (argument.kind == VALUE_UNKNOWN || parameter->kind == VALUE_VARYING) return false;
+    if (parameter->kind == VALUE_UNKNOWN) {
+        *parameter = argument;
+        return true;
+    }
+    if (argument.kind == VALUE_CONSTANT && argument.value == parameter->value) return false;
+    parameter->kind = VALUE_VARYING;
+    return true;
+}
+
+static void meetArguments(Statement *call, void *data) {
+    Procedure *caller = data, *callee;
+    ExpressionList *arguments;
+    int i;
+
+    callee = findProcedure(call->u.callStatement.procedureName);
+    if (callee == NULL) return;
+    arguments = call->u.callStatement.argumentList;
+    for (i = 0; i < callee->numParameters; i++, arguments = arguments->tail) {
+        if (!callee->isConsidered[i]) continue;
+        if (meet(&callee->values[i], argumentValue(caller, arguments->head))) isValueChanged = true;
+    }
+}
+
+/**
+ * Replaces the parameters which have the same value at every call.
+ */
+static void replaceConstantParameters(void) {
+    Procedure *procedure;
+    Replacement replacement;
+    int i, uses;
+
+    /* every value only decreases in the lattice, so this terminates */
+    do {
+        isValueChanged = false;
+        for (procedure = procedureList; procedure != NULL; procedure = procedure->next) {
+            forEachCallInList(procedure->declaration->u.procedureDeclaration.body, meetArguments, procedure);
+        }
+    } while (isValueChanged);
+
+    for (procedure = procedureList; procedure != NULL; procedure = procedure->next) {
+        for (i = 0; i < procedure->numParameters; i++) {
+            if (!procedure->isConsidered[i] || procedure->values[i].kind != VALUE_CONSTANT) continue;
+            replacement.name = procedure->parameters[i]->name;
+            replacement.value = procedure->values[i].value;
+            uses = replaceInList(procedure->declaration->u.procedureDeclaration.body, &replacement, 1, true);
+            if (uses == 0) continue;
+            numChanges++;
+            if (reportCalls) {
+                printf("parameter '%s' of '%s' is %d at all %d calls, %d uses replaced\n",
+                       replacement.name->string, procedure->declaration->name->string, replacement.value,
+                       procedure->node->numCallSites, uses);
+            }
+        }
+    }
+}
+
+/*
+ * Cloning
+ */
+
+static void reportCall(Procedure *caller, Statement *call, const char *format, const char *argument) {
+    if (!reportCalls) return;
+    if (reportedCaller != caller) {
+        printf("\nSpecialisation for procedure '%s'\n", caller->declaration->name->string);
+        reportedCaller = caller;
+    }
+    printf("call of '%s' in line %d: ", call->u.callStatement.procedureName->string, call->line);
+    printf(format, argument);
+    printf("\n");
+}
+
+static Procedure *findCopy(Procedure *original, bool *isSpecialised, int *constants) {
+    Procedure *copy;
+    int i;
+
+    for (copy = procedureList; copy != NULL; copy = copy->next) {
+        if (copy->original != original) continue;
+        for (i = 0; i < original->numParameters; i++) {
+            if (copy->isSpecialised[i] != isSpecialised[i]) break;
+            if (isSpecialised[i] && copy->constants[i] != constants[i]) break;
+        }
+        if (i == original->numParameters) return copy;
+    }
+    return NULL;
+}
+
+static int collectReplacements(Procedure *original, bool *isSpecialised, int *constants, Replacement *replacements) {
+    int count = 0, i;
+
+    for (i = 0; i < original->numParameters; i++) {
+        if (!isSpecialised[i]) continue;
+        replacements[count].name = original->parameters[i]->name;
+        replacements[count].value = constants[i];
+        count++;
+    }
+    return count;
+}
+
+/**
+ * Checks whether a copy of a procedure may be made for a call.
+ * @return NULL if it may, otherwise the reason why not.
+ */
+static char *rejectCopy(Procedure *caller, Procedure *callee, Statement *call, bool *isSpecialised, int *constants) {
+    Replacement *replacements;
+    int count, uses;
+
+    if (caller->original != NULL && callee->node->isRecursive) return "recursive procedure called from a copy";
+    if (isColdProfileCounter(call, 0)) return "never executed in the profile";
+    if (callee->size > sizeBudget) return "code growth budget exhausted";
+    replacements = allocate((callee->numParameters + 1) * sizeof(Replacement));
+    count = collectReplacements(callee, isSpecialised, constants, replacements);
+    uses = replaceInList(callee->declaration->u.procedureDeclaration.body, replacements, count, false);
+    release(replacements);
+    if (uses == 0) return "constant parameters unused";
+    return NULL;
+}
+
+static Identifier *newCopyName(Procedure *original) {
+    char buffer[200];
+    Identifier *name;
+
+    /* the name is a valid identifier, so it may already be declared */
+    do {
+        snprintf(buffer, sizeof(buffer), "%.180s__c%d", original->declaration->name->string, ++original->numCopies);
+        name = newIdentifier(buffer);
+    } while (lookup(procedures, name) != NULL);
+    return name;
+}
+
+static ParameterList *copyParameters(ParameterList *parameters, bool *isSpecialised, SymbolTable *originalTable,
+                                     SymbolTable *localTable) {
+    ParameterList *tail;
+    Entry *entry;
+
+    if (parameters->isEmpty) return emptyParameterList();
+    tail = copyParameters(parameters->tail, isSpecialised + 1, originalTable, localTable);
+    if (*isSpecialised) return tail;
+    entry = lookup(originalTable, parameters->head->name);
+    enter(localTable, newVarEntry(parameters->head->name, entry->u.varEntry.type, entry->u.varEntry.isRef));
+    return newParameterList(parameters->head, tail);
+}
+
+static ParamTypes *copyParamTypes(ParamTypes *paramTypes, bool *isSpecialised) {
+    ParamTypes *tail;
+
+    if (paramTypes->isEmpty) return emptyParamTypes();
+    tail = copyParamTypes(paramTypes->next, isSpecialised + 1);
+    if (*isSpecialised) return tail;
+    return newParamTypes(paramTypes->type, paramTypes->isRef, tail);
+}
+
+static VariableDeclarationList *copyVariables(VariableDeclarationList *variables, SymbolTable *originalTable,
+                                              SymbolTable *localTable) {
+    Entry *entry;
+
+    if (variables->isEmpty) return emptyVariableList();
+    entry = lookup(originalTable, variables->head->name);
+    enter(localTable, newVarEntry(variables->head->name, entry->u.varEntry.type, false));
+    return newVariableList(variables->head, copyVariables(variables->tail, originalTable, localTable));
+}
+
+/**
+ * Declares a copy of a procedure with the specialised parameters replaced by their constants.
+ * The copy takes over the arrays describing the specialisation.
+ */
+static Procedure *newCopy(Procedure *original, bool *isSpecialised, int *constants) {
+    GlobalDeclaration *declaration;
+    SymbolTable *originalTable, *localTable;
+    Replacement *replacements;
+    Procedure *copy;
+    Identifier *name;
+    ParameterList *parameters;
+    VariableDeclarationList *variables;
+    StatementList *body;
+    int count;
+
+    name = newCopyName(original);
+    originalTable = original->entry->u.procEntry.localTable;
+    localTable = newTable(procedures);
+    parameters = copyParameters(original->declaration->u.procedureDeclaration.parameters, isSpecialised,
+                                originalTable, localTable);
+    variables = copyVariables(original->declaration->u.procedureDeclaration.variables, originalTable, localTable);
+    body = copyStatementList(original->declaration->u.procedureDeclaration.body);
+    replacements = allocate((original->numParameters + 1) * sizeof(Replacement));
+    count = collectReplacements(original, isSpecialised, constants, replacements);
+    replaceInList(body, replacements, count, true);
+    release(replacements);
+
+    declaration = newProcedureDeclaration(original->declaration->line, name, parameters, variables, body);
+    original->lastDeclaration->tail = newGlobalDeclarationList(declaration, original->lastDeclaration->tail);
+    original->lastDeclaration = original->lastDeclaration->tail;
+
+    copy = allocate(sizeof(Procedure));
+    copy->declaration = declaration;
+    copy->entry = enter(procedures, newProcEntry(name, copyParamTypes(original->entry->u.procEntry.paramTypes,
+                                                                       isSpecialised), localTable));
+    copy->node = original->node;
+    copy->original = original;
+    copy->numParameters = 0;
+    copy->parameters = NULL;
+    copy->isConsidered = NULL;
+    copy->values = NULL;
+    copy->isSpecialised = isSpecialised;
+    copy->constants = constants;
+    copy->size = statementListSize(body);
+    copy->numCopies = 0;
+    copy->lastDeclaration = NULL;
+    appendProcedure(copy);
+    sizeBudget -= copy->size;
+    return copy;
+}
+
+static ExpressionList *dropArguments(ExpressionList *arguments, bool *isSpecialised) {
+    ExpressionList *tail;
+
+    if (arguments->isEmpty) return arguments;
+    tail = dropArguments(arguments->tail, isSpecialised + 1);
+    if (*isSpecialised) return tail;
+    return newExpressionList(arguments->head, tail);
+}
+
+static void specialiseCall(Statement *call, void *data) {
+    Procedure *caller = data, *callee, *copy;
+    ExpressionList *arguments;
+    bool *isSpecialised, hasConstant;
+    int *constants, i;
+    char *reason;
+
+    callee = findProcedure(call->u.callStatement.procedureName);
+    /* predefined procedures have no body, the calls of copies have no constant arguments left */
+    if (callee == NULL || callee->original != NULL) return;
+    isSpecialised = allocate((callee->numParameters + 1) * sizeof(bool));
+    constants = allocate((callee->numParameters + 1) * sizeof(int));
+    hasConstant = false;
+    arguments = call->u.callStatement.argumentList;
+    for (i = 0; i < callee->numParameters; i++, arguments = arguments->tail) {
+        isSpecialised[i] = callee->isConsidered[i] && arguments->head->kind == EXPRESSION_INTLITERAL;
+        constants[i] = isSpecialised[i] ? arguments->head->u.intLiteral.value : 0;
+        if (isSpecialised[i]) hasConstant = true;
+    }
+    if (!hasConstant) {
+        release(isSpecialised);
+        release(constants);
+        return;
+    }
+
+    copy = findCopy(callee, isSpecialised, constants);
+    if (copy != NULL) {
+        release(isSpecialised);
+        release(constants);
+        reportCall(caller, call, "calls '%s'", copy->declaration->name->string);
+    } else {
+        reason = rejectCopy(caller, callee, call, isSpecialised, constants);
+        if (reason != NULL) {
+            reportCall(caller, call, "not specialised, %s", reason);
+            release(isSpecialised);
+            release(constants);
+            return;
+        }
+        copy = newCopy(callee, isSpecialised, constants);
+        reportCall(caller, call, "specialised as '%s'", copy->declaration->name->string);
+    }
+    call->u.callStatement.procedureName = copy->declaration->name;
+    call->u.callStatement.argumentList = dropArguments(call->u.callStatement.argumentList, copy->isSpecialised);
+    numChanges++;
+}
+
+int propagateConstants(Program *program, SymbolTable *globalTable, int cloneBudget, bool showReport) {
+    Procedure *procedure;
+    int programSize;
+
+    procedures = globalTable;
+    reportCalls = showReport;
+    reportedCaller = NULL;
+    numChanges = 0;
+
+    callGraph = buildCallGraph(program, globalTable);
+    programSize = collectProcedures(program);
+    if (reportCalls) printf("\nConstant parameters\n");
+    replaceConstantParameters();
+    /* arguments computed from the replaced parameters become literals */
+    if (numChanges > 0) foldConstants(program);
+
+    sizeBudget = programSize * cloneBudget / 100;
+    if (cloneBudget > 0) {
+        /* the copies are appended to the list, so their calls are specialised as well */
+        for (procedure = procedureList; procedure != NULL; procedure = procedure->next) {
+            forEachCallInList(procedure->declaration->u.procedureDeclaration.body, specialiseCall, procedure);
+        }
+    }
+    if (reportCalls) printf("%d parameters and calls specialised\n", numChanges);
+
+    releaseProcedures();
+    releaseCallGraph(callGraph);
+    return numChanges;
+}
@@ -0,0 +1,47 @@
+/*
+ * ipcp.h -- interprocedural constant propagation and procedure cloning
+ */
+
+
+#ifndef _IPCP_H_
+#define _IPCP_H_
+
+#include <stdbool.h>
+#include <absyn/absyn.h>
+#include <table/table.h>
+
+#define DEFAULT_CLONE_BUDGET 25     /* used with -O2, in percent of the size of the program */
+
+/**
+ * This function propagates constant arguments of value parameters into the called procedures.
+ *
+ * Only value parameters of type int which the body of their procedure never changes, i.e. never assigns
+ * or passes by reference, are considered. First, the value of every such parameter is computed over all
+ * calls in the program, along the edges of the call graph: an argument is constant if it is a literal or
+ * a considered parameter of the caller which is constant itself. This is iterated until nothing changes,
+ * starting with no value for every parameter, so a recursive call passing the parameter on keeps it
+ * constant. If all calls agree on the value, the uses of the parameter are replaced by it, while the
+ * parameter itself stays. The program is folded afterwards, so expressions of such parameters become
+ * literal arguments of the calls they are passed to.
+ *
+ * Then every call passing literals to considered parameters is redirected to a copy of the called
+ * procedure specialised on these values, e.g. "ackermann__c1", which omits the parameters and uses the
+ * values in their place. The copies are shared by all calls passing the same values and are declared
+ * behind the original procedure. A copy is only made if the body uses one of the parameters and, with a
+ * profile, the call has been executed, and only as long as the sizes of all copies together, counted
+ * as in inline.h, stay within the budget. The bodies of the copies are processed as well, but a call in
+ * a copy only makes a new copy of a procedure which is not recursive, so the specialisation of a recursive
+ * procedure cannot go on forever. Calls of the predefined procedures are never changed.
+ *
+ * The pass has to run after the semantic analysis, and the program should be folded after it.
+ *
+ * @param program The program whose calls are analysed. It is modified in place.
+ * @param globalTable The symbol table for the current program, which receives the copies.
+ * @param cloneBudget The growth of the program allowed for the copies, in percent of its size,
+ *                    0 only replaces the parameters which are constant at every call.
+ * @param showReport Whether the constant parameters and every specialised call should be printed.
+ * @return The number of replaced parameters and redirected calls.
+ */
+int propagateConstants(Program *program, SymbolTable *globalTable, int cloneBudget, bool showReport);
+
+#endif /* _IPCP_H_ */
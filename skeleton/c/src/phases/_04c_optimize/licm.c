@@ -0,0 +1,413 @@
+/*
+ * licm.c -- loop-invariant code motion for array addresses
+ */
+
+#include <stdio.h>
+#include <util/errors.h>
+#include <util/memory.h>
+#include <absyn/absyn.h>
+#include <table/table.h>
+#include <types/types.h>
+#include "phases/_05_varalloc/regalloc.h"
+#include "loopreduce.h"
+#include "cfg.h"
+#include "locals.h"
+#include "licm.h"
+
+/**
+ * The addresses hoisted out of a loop, kept for the report.
+ */
+typedef struct hoisted {
+    Loop *loop;
+    InductionPointer *pointer;
+    int accesses;
+    int instructions;       /* instructions no longer executed in every iteration */
+    struct hoisted *next;
+} Hoisted;
+
+static SymbolTable *localTable;
+static ControlFlowGraph *graph;
+static Hoisted *hoistedAddresses;
+static int numHoisted;
+
+/*
+ * Invariance
+ */
+
+static bool mayBeAssigned(Statement *statement, Variable *variable);
+
+static bool mayBeAssignedInList(StatementList *statements, Variable *variable) {
+    while (!statements->isEmpty) {
+        if (mayBeAssigned(statements->head, variable)) return true;
+        statements = statements->tail;
+    }
+    return false;
+}
+
+static bool mayBeAssigned(Statement *statement, Variable *variable) {
+    switch (statement->kind) {
+        case STATEMENT_COMPOUNDSTATEMENT:
+            return mayBeAssignedInList(statement->u.compoundStatement.statements, variable);
+        case STATEMENT_ASSIGNSTATEMENT:
+            return mayAlias(localTable, statement->u.assignStatement.target, variable);
+        case STATEMENT_IFSTATEMENT:
+            return mayBeAssigned(statement->u.ifStatement.thenPart, variable) ||
+                   mayBeAssigned(statement->u.ifStatement.elsePart, variable);
+        case STATEMENT_WHILESTATEMENT:
+            return mayBeAssigned(statement->u.whileStatement.body, variable);
+        default:
+            return false;
+    }
+}
+
+static bool isInvariantAddress(Variable *variable, Statement *loop);
+
+static bool isInvariantValue(Expression *expression, Statement *loop) {
+    Variable *variable;
+
+    switch (expression->kind) {
+        case EXPRESSION_INTLITERAL:
+            return true;
+        case EXPRESSION_VARIABLEEXPRESSION:
+            variable = expression->u.variableExpression.variable;
+            return isInvariantAddress(variable, loop) && !mayBeAssigned(loop, variable);
+        case EXPRESSION_BINARYEXPRESSION:
+            return isInvariantValue(expression->u.binaryExpression.leftOperand, loop) &&
+                   isInvariantValue(expression->u.binaryExpression.rightOperand, loop);
+        default:
+            error("unknown expression kind %d in isInvariantValue", expression->kind);
+            return false;
+    }
+}
+
+static bool isInvariantAddress(Variable *variable, Statement *loop) {
+    switch (variable->kind) {
+        case VARIABLE_NAMEDVARIABLE:
+            /* the address of a variable, or the one held by a reference parameter, never changes */
+            return true;
+        case VARIABLE_ARRAYACCESS:
+            return isInvariantAddress(variable->u.arrayAccess.array, loop) &&
+                   isInvariantValue(variable->u.arrayAccess.index, loop);
+        default:
+            error("unknown variable kind %d in isInvariantAddress", variable->kind);
+            return false;
+    }
+}
+
+/*
+ * Costs
+ */
+
+static int addressCost(Variable *variable);
+
+/**
+ * Estimates the number of instructions evaluating an expression onto the expression stack.
+ */
+static int valueCost(Expression *expression) {
+    Variable *variable;
+    Entry *entry;
+
+    switch (expression->kind) {
+        case EXPRESSION_INTLITERAL:
+            return 1;
+        case EXPRESSION_VARIABLEEXPRESSION:
+            variable = expression->u.variableExpression.variable;
+            if (variable->kind == VARIABLE_NAMEDVARIABLE) {
+                entry = rootEntry(localTable, variable);
+                if (entry->u.varEntry.reg != 0) return 1;
+            }
+            return addressCost(variable) + 1;
+        case EXPRESSION_BINARYEXPRESSION:
+            return valueCost(expression->u.binaryExpression.leftOperand) +
+                   valueCost(expression->u.binaryExpression.rightOperand) + 1;
+        default:
+            error("unknown expression kind %d in valueCost", expression->kind);
+            return 0;
+    }
+}
+
+/**
+ * Estimates the number of instructions computing the address of a variable onto the expression stack.
+ * The bounds check compares the index with the size loaded into a register, the offset of a constant
+ * index without a check is added to the address of the array.
+ */
+static int addressCost(Variable *variable) {
+    Variable *array;
+    Expression *index;
+
+    switch (variable->kind) {
+        case VARIABLE_NAMEDVARIABLE:
+            return 1;
+        case VARIABLE_ARRAYACCESS:
+            array = variable->u.arrayAccess.array;
+            index = variable->u.arrayAccess.index;
+            if (index->kind == EXPRESSION_INTLITERAL && !variable->u.arrayAccess.checkIndex) {
+                if (array->kind == VARIABLE_NAMEDVARIABLE && !rootEntry(localTable, array)->u.varEntry.isRef) return 1;
+                return addressCost(array) + 1;
+            }
+            return addressCost(array) + valueCost(index) + (variable->u.arrayAccess.checkIndex ? 2 : 0) + 2;
+        default:
+            error("unknown variable kind %d in addressCost", variable->kind);
+            return 0;
+    }
+}
+
+/*
+ * Pointer registers
+ */
+
+static unsigned registersOfLoop(Loop *loop) {
+    InductionPointer *pointer;
+    unsigned registers = 0;
+
+    for (pointer = loop->statement->u.whileStatement.pointers; pointer != NULL; pointer = pointer->next) {
+        registers |= 1u << pointer->reg;
+    }
+    return registers;
+}
+
+static unsigned registersOfNestedLoops(Loop *loop) {
+    Loop *child;
+    unsigned registers;
+
+    registers = registersOfLoop(loop);
+    for (child = loop->children; child != NULL; child = child->next) registers |= registersOfNestedLoops(child);
+    return registers;
+}
+
+/**
+ * Finds a pointer register which is neither used in the loop, nor in a loop enclosing it.
+ * @return The register, or -1 if all pointer registers are in use.
+ */
+static int freeRegister(Loop *loop) {
+    Loop *enclosing;
+    unsigned used;
+    int reg;
+
+    used = registersOfNestedLoops(loop);
+    for (enclosing = loop->parent; enclosing != NULL; enclosing = enclosing->parent) used |= registersOfLoop(enclosing);
+    for (reg = FIRST_POINTER_REGISTER; reg <= LAST_POINTER_REGISTER; reg++) {
+        if ((used & (1u << reg)) == 0) return reg;
+    }
+    return -1;
+}
+
+/*
+ * Hoisting
+ */
+
+/**
+ * Finds the outermost loop out of which the address of an access can be moved.
+ * Every loop on the way must execute the access in each iteration and must not change the address.
+ * The condition of a loop is evaluated before its body is entered, so it is only moved out of enclosing loops.
+ */
+static Loop *targetLoop(Variable *access, Block *block) {
+    Loop *loop, *target;
+
+    target = NULL;
+    for (loop = block->loop; loop != NULL; loop = loop->parent) {
+        if (block == loop->header) continue;
+        if (!dominates(block, loop->latch)) break;
+        if (containsCall(loop->statement->u.whileStatement.body)) break;
+        if (!isInvariantAddress(access, loop->statement)) break;
+        target = loop;
+    }
+    return target;
+}
+
+/**
+ * Keeps a bounds check in the hoisted address, if any of the accesses sharing it needs the check.
+ */
+static void mergeChecks(Variable *hoisted, Variable *access) {
+    while (hoisted->kind == VARIABLE_ARRAYACCESS) {
+        hoisted->u.arrayAccess.checkIndex |= access->u.arrayAccess.checkIndex;
+        hoisted = hoisted->u.arrayAccess.array;
+        access = access->u.arrayAccess.array;
+    }
+}
+
+static Hoisted *findHoisted(Loop *loop, Variable *access) {
+    Hoisted *hoisted;
+
+    for (hoisted = hoistedAddresses; hoisted != NULL; hoisted = hoisted->next) {
+        if (hoisted->loop == loop && equalVariables(hoisted->pointer->access, access)) return hoisted;
+    }
+    return NULL;
+}
+
+static Hoisted *newHoisted(Loop *loop, Variable *access, int reg) {
+    InductionPointer *pointer;
+    Hoisted *hoisted, **last;
+
+    pointer = allocate(sizeof(InductionPointer));
+    pointer->access = copyVariable(access);
+    pointer->inductionVariable = NULL;
+    pointer->step = 0;
+    pointer->reg = reg;
+    pointer->increment = NULL;
+    pointer->next = loop->statement->u.whileStatement.pointers;
+    loop->statement->u.whileStatement.pointers = pointer;
+
+    hoisted = allocate(sizeof(Hoisted));
+    hoisted->loop = loop;
+    hoisted->pointer = pointer;
+    hoisted->accesses = 0;
+    hoisted->instructions = 0;
+    hoisted->next = NULL;
+    for (last = &hoistedAddresses; *last != NULL; last = &(*last)->next);
+    *last = hoisted;
+    return hoisted;
+}
+
+/**
+ * Takes the address of an access from a pointer computed in front of a loop, if it is invariant.
+ * @return true if the access has been replaced.
+ */
+static bool hoistAccess(Variable *access, Block *block) {
+    Hoisted *hoisted;
+    Loop *loop;
+    int reg;
+
+    loop = targetLoop(access, block);
+    if (loop == NULL) return false;
+    /* copying the address from the pointer register is one instruction */
+    if (addressCost(access) <= 1) return false;
+
+    hoisted = findHoisted(loop, access);
+    if (hoisted == NULL) {
+        reg = freeRegister(loop);
+        if (reg < 0) return false;
+        hoisted = newHoisted(loop, access, reg);
+    } else {
+        mergeChecks(hoisted->pointer->access, access);
+    }
+    access->u.arrayAccess.pointer = hoisted->pointer;
+    access->u.arrayAccess.pointerOffset = 0;
+    hoisted->accesses++;
+    hoisted->instructions += addressCost(access) - 1;
+    numHoisted++;
+    return true;
+}
+
+static void hoistExpression(Expression *expression, Block *block);
+
+static void hoistVariable(Variable *variable, Block *block) {
+    if (variable->kind != VARIABLE_ARRAYACCESS) return;
+    /* the array and the index of a reduced access are not evaluated in the loop */
+    if (variable->u.arrayAccess.pointer != NULL) return;
+    if (hoistAccess(variable, block)) return;
+    hoistVariable(variable->u.arrayAccess.array, block);
+    hoistExpression(variable->u.arrayAccess.index, block);
+}
+
+static void hoistExpression(Expression *expression, Block *block) {
+    switch (expression->kind) {
+        case EXPRESSION_INTLITERAL:
+            break;
+        case EXPRESSION_VARIABLEEXPRESSION:
+            hoistVariable(expression->u.variableExpression.variable, block);
+            break;
+        case EXPRESSION_BINARYEXPRESSION:
+            hoistExpression(expression->u.binaryExpression.leftOperand, block);
+            hoistExpression(expression->u.binaryExpression.rightOperand, block);
+            break;
+        default:
+            error("unknown expression kind %d in hoistExpression", expression->kind);
+    }
+}
+
+static void hoistStatement(Statement *statement);
+
+static void hoistStatementList(StatementList *statements) {
+    while (!statements->isEmpty) {
+        hoistStatement(statements->head);
+        statements = statements->tail;
+    }
+}
+
+static void hoistStatement(Statement *statement) {
+    Block *block;
+
+    block = blockOfStatement(graph, statement);
+    switch (statement->kind) {
+        case STATEMENT_EMPTYSTATEMENT:
+            break;
+        case STATEMENT_COMPOUNDSTATEMENT:
+            hoistStatementList(statement->u.compoundStatement.statements);
+            break;
+        case STATEMENT_ASSIGNSTATEMENT:
+            if (block->loop == NULL) break;
+            hoistVariable(statement->u.assignStatement.target, block);
+            hoistExpression(statement->u.assignStatement.value, block);
+            break;
+        case STATEMENT_IFSTATEMENT:
+            if (block->loop != NULL) hoistExpression(statement->u.ifStatement.condition, block);
+            hoistStatement(statement->u.ifStatement.thenPart);
+            hoistStatement(statement->u.ifStatement.elsePart);
+            break;
+        case STATEMENT_WHILESTATEMENT:
+            hoistExpression(statement->u.whileStatement.condition, block);
+            hoistStatement(statement->u.whileStatement.body);
+            break;
+        case STATEMENT_CALLSTATEMENT:
+            /* every loop around a call is skipped */
+            break;
+        default:
+            error("unknown statement kind %d in hoistStatement", statement->kind);
+    }
+}
+
+/*
+ * Report
+ */
+
+static void showLoops(Loop *loop) {
+    Hoisted *hoisted;
+    int instructions;
+
+    for (; loop != NULL; loop = loop->next) {
+        instructions = 0;
+        for (hoisted = hoistedAddresses; hoisted != NULL; hoisted = hoisted->next) {
+            if (hoisted->loop != loop) continue;
+            printf("loop in line %d: $%d = &", loop->statement->line, hoisted->pointer->reg);
+            printVariable(hoisted->pointer->access);
+            printf(", accesses = %d\n", hoisted->accesses);
+            instructions += hoisted->instructions;
+        }
+        printf("loop in line %d: instructions hoisted = %d\n", loop->statement->line, instructions);
+        showLoops(loop->children);
+    }
+}
+
+int hoistInvariants(Program *program, SymbolTable *globalTable, bool showReport) {
+    GlobalDeclarationList *declarationList;
+    GlobalDeclaration *declaration;
+    Entry *procEntry;
+    Hoisted *hoisted;
+
+    numHoisted = 0;
+    for (declarationList = program; !declarationList->isEmpty; declarationList = declarationList->tail) {
+        declaration = declarationList->head;
+        if (declaration->kind != DECLARATION_PROCEDUREDECLARATION) continue;
+
+        procEntry = lookup(globalTable, declaration->name);
+        localTable = procEntry->u.procEntry.localTable;
+        graph = buildControlFlowGraph(declaration->u.procedureDeclaration.body);
+        hoistedAddresses = NULL;
+        hoistStatementList(declaration->u.procedureDeclaration.body);
+        if (showReport) {
+            printf("\nLoop-invariant code motion for procedure '%s'\n", declaration->name->string);
+            showLoops(graph->loops);
+        }
+        while (hoistedAddresses != NULL) {
+            hoisted = hoistedAddresses;
+            hoistedAddresses = hoisted->next;
+            release(hoisted);
+        }
+        freeControlFlowGraph(graph);
+    }
+    if (numHoisted > 0 && lastExpressionRegister >= FIRST_POINTER_REGISTER) {
+        lastExpressionRegister = FIRST_POINTER_REGISTER - 1;
+    }
+    return numHoisted;
+}
@@ -0,0 +1,43 @@
+/*
+ * licm.h -- loop-invariant code motion for array addresses
+ */
+
+
+#ifndef _LICM_H_
+#define _LICM_H_
+
+#include <absyn/absyn.h>
+#include <table/table.h>
+
+/**
+ * This function moves the computation of array element addresses, which do not change during a loop,
+ * in front of the loop.
+ *
+ * The address of an access like f[i] inside of the loop "while (j < 20) ..." consists of the address of f,
+ * which has to be loaded if f is a reference parameter, the bounds check of i and the multiplication of i.
+ * If i is not changed by the loop, the address is computed once and kept in a pointer register instead.
+ * An index is invariant if every variable read by it is neither assigned in the loop nor possibly
+ * aliased by an assignment: reads through a reference parameter count as changed, if the loop assigns
+ * anything through a reference parameter. Loops containing a call are skipped, the called procedure may
+ * change any variable passed to it by reference and does not preserve the pointer registers.
+ *
+ * The places of the accesses are found with the control flow graph of the procedure. An address is only
+ * moved out of a loop, if its access dominates the end of the loop body, i.e. it is evaluated in every
+ * iteration. Since the bounds check moves with it, the address is computed when the body is entered
+ * for the first time, so a loop which is not executed at all never reports an index error.
+ * The address is moved out of as many enclosing loops as possible, and the largest invariant part
+ * of an access is taken, e.g. f[i] of f[i][j]. Accesses already reduced by the loop strength reduction
+ * are left untouched.
+ *
+ * The addresses are recorded as induction pointers with step 0 in the pointers field of the while-statement
+ * and in the pointer field of the array accesses, using the pointer registers left by enclosing and nested loops.
+ * The pass has to run after the semantic analysis, the register allocation and the loop strength reduction.
+ *
+ * @param program The program whose loops are optimized.
+ * @param globalTable The symbol table for the current program.
+ * @param showReport Whether the hoisted addresses of every loop should be printed.
+ * @return The number of array accesses whose address is taken from a hoisted pointer.
+ */
+int hoistInvariants(Program *program, SymbolTable *globalTable, bool showReport);
+
+#endif /* _LICM_H_ */
@@ -0,0 +1,39 @@
+/*
+ * locals.c -- local variables of the procedures transformed by the optimizations
+ */
+
+#include <stdio.h>
+#include <util/errors.h>
+#include <absyn/absyn.h>
+#include <table/table.h>
+#include <types/types.h>
+#include "locals.h"
+
+Entry *rootEntry(SymbolTable *localTable, Variable *variable) {
+    while (variable->kind == VARIABLE_ARRAYACCESS) variable = variable->u.arrayAccess.array;
+    return lookup(localTable, variable->u.namedVariable.name);
+}
+
+bool mayAlias(SymbolTable *localTable, Variable *target, Variable *variable) {
+    Entry *targetEntry, *variableEntry;
+
+    targetEntry = rootEntry(localTable, target);
+    variableEntry = rootEntry(localTable, variable);
+    return targetEntry == variableEntry || (targetEntry->u.varEntry.isRef && variableEntry->u.varEntry.isRef);
+}
+
+Variable *newLocalVariable(GlobalDeclaration *procedure, SymbolTable *localTable, Identifier *name,
+                           TypeExpression *typeExpression, Type *type, int line) {
+    VariableDeclarationList **last;
+    Variable *variable;
+
+    if (enter(localTable, newVarEntry(name, type, false)) == NULL) {
+        error("variable '%s' already exists in newLocalVariable", name->string);
+    }
+    for (last = &procedure->u.procedureDeclaration.variables; !(*last)->isEmpty; last = &(*last)->tail);
+    *last = newVariableList(newVariableDeclaration(line, name, typeExpression), emptyVariableList());
+
+    variable = newNamedVariable(line, name);
+    variable->dataType = type;
+    return variable;
+}
@@ -0,0 +1,47 @@
+/*
+ * locals.h -- local variables of the procedures transformed by the optimizations
+ */
+
+
+#ifndef _LOCALS_H_
+#define _LOCALS_H_
+
+#include <stdbool.h>
+#include <absyn/absyn.h>
+#include <table/table.h>
+#include <types/types.h>
+
+/**
+ * Finds the entry of the variable an access refers to, i.e. of the array for an array access.
+ * @param localTable The symbol table of the procedure containing the access.
+ * @param variable A named variable or an array access.
+ * @return The entry of the named variable at the root of the access.
+ */
+Entry *rootEntry(SymbolTable *localTable, Variable *variable);
+
+/**
+ * Checks whether an assignment to target may change the value of variable.
+ * A reference parameter can only point to a variable of a calling procedure, so it may be an alias
+ * of another reference parameter, but never of a local variable or value parameter.
+ * @param localTable The symbol table of the procedure containing both variables.
+ * @param target The target of the assignment.
+ * @param variable The variable whose value is read.
+ * @return true if both variables may share their storage.
+ */
+bool mayAlias(SymbolTable *localTable, Variable *target, Variable *variable);
+
+/**
+ * Adds a new local variable to a procedure, both to its declarations and to its symbol table.
+ * The name should contain a dot, which can never appear in an identifier of the source program.
+ * @param procedure The declaration of the procedure.
+ * @param localTable The symbol table of the procedure.
+ * @param name The name of the new variable, which must not be declared in the procedure yet.
+ * @param typeExpression The type expression of the declaration.
+ * @param type The semantic type of the variable.
+ * @param line The line number of the new declaration.
+ * @return A variable referring to it.
+ */
+Variable *newLocalVariable(GlobalDeclaration *procedure, SymbolTable *localTable, Identifier *name,
+                           TypeExpression *typeExpression, Type *type, int line);
+
+#endif /* _LOCALS_H_ */
@@ -0,0 +1,486 @@
+/*
+ * loopreduce.c -- strength reduction of array accesses in loops
+ */
+
+#include <stdio.h>
+#include <util/errors.h>
+#include <util/memory.h>
+#include <absyn/absyn.h>
+#include <table/table.h>
+#include <types/types.h>
+#include "phases/_05_varalloc/regalloc.h"
+#include "loopreduce.h"
+
+static SymbolTable *procedures;
+static SymbolTable *localTable;
+static StatementList *procedureBody;
+static int numReduced;
+static bool reportLoops;
+
+/*
+ * Properties of variables
+ */
+
+static Entry *scalarEntry(Variable *variable) {
+    Entry *entry;
+
+    if (variable->kind != VARIABLE_NAMEDVARIABLE) return NULL;
+    entry = lookup(localTable, variable->u.namedVariable.name);
+    if (entry->kind != ENTRY_KIND_VAR || entry->u.varEntry.isRef || entry->u.varEntry.type != intType) return NULL;
+    return entry;
+}
+
+static bool isNamed(Expression *expression, Entry *entry) {
+    return expression->kind == EXPRESSION_VARIABLEEXPRESSION &&
+           scalarEntry(expression->u.variableExpression.variable) == entry;
+}
+
+static bool passedByReference(Statement *statement, Entry *entry);
+
+static bool passedByReferenceInList(StatementList *statements, Entry *entry) {
+    while (!statements->isEmpty) {
+        if (passedByReference(statements->head, entry)) return true;
+        statements = statements->tail;
+    }
+    return false;
+}
+
+static bool passedByReference(Statement *statement, Entry *entry) {
+    Entry *procEntry;
+    ParamTypes *paramTypes;
+    ExpressionList *arguments;
+
+    switch (statement->kind) {
+        case STATEMENT_COMPOUNDSTATEMENT:
+            return passedByReferenceInList(statement->u.compoundStatement.statements, entry);
+        case STATEMENT_IFSTATEMENT:
+            return passedByReference(statement->u.ifStatement.thenPart, entry) ||
+                   passedByReference(statement->u.ifStatement.elsePart, entry);
+        case STATEMENT_WHILESTATEMENT:
+            return passedByReference(statement->u.whileStatement.body, entry);
+        case STATEMENT_CALLSTATEMENT:
+            procEntry = lookup(procedures, statement->u.callStatement.procedureName);
+            paramTypes = procEntry->u.procEntry.paramTypes;
+            arguments = statement->u.callStatement.argumentList;
+            while (!arguments->isEmpty && !paramTypes->isEmpty) {
+                if (paramTypes->isRef && isNamed(arguments->head, entry)) return true;
+                arguments = arguments->tail;
+                paramTypes = paramTypes->next;
+            }
+            return false;
+        default:
+            return false;
+    }
+}
+
+static int countAssignments(Statement *statement, Entry *entry);
+
+static int countAssignmentsInList(StatementList *statements, Entry *entry) {
+    int count = 0;
+
+    while (!statements->isEmpty) {
+        count += countAssignments(statements->head, entry);
+        statements = statements->tail;
+    }
+    return count;
+}
+
+static int countAssignments(Statement *statement, Entry *entry) {
+    switch (statement->kind) {
+        case STATEMENT_COMPOUNDSTATEMENT:
+            return countAssignmentsInList(statement->u.compoundStatement.statements, entry);
+        case STATEMENT_ASSIGNSTATEMENT:
+            return scalarEntry(statement->u.assignStatement.target) == entry ? 1 : 0;
+        case STATEMENT_IFSTATEMENT:
+            return countAssignments(statement->u.ifStatement.thenPart, entry) +
+                   countAssignments(statement->u.ifStatement.elsePart, entry);
+        case STATEMENT_WHILESTATEMENT:
+            return countAssignments(statement->u.whileStatement.body, entry);
+        default:
+            return 0;
+    }
+}
+
+/**
+ * Checks whether an index expression has the same value during the whole loop and can be
+ * evaluated in front of it without any risk, i.e. it contains neither a division nor an array access.
+ */
+static bool isInvariantExpression(Expression *expression, Statement *loop) {
+    Entry *entry;
+
+    switch (expression->kind) {
+        case EXPRESSION_INTLITERAL:
+            return true;
+        case EXPRESSION_VARIABLEEXPRESSION:
+            entry = scalarEntry(expression->u.variableExpression.variable);
+            return entry != NULL && countAssignments(loop, entry) == 0 && !passedByReferenceInList(procedureBody, entry);
+        case EXPRESSION_BINARYEXPRESSION:
+            return expression->u.binaryExpression.operator != ABSYN_OP_DIV &&
+                   isInvariantExpression(expression->u.binaryExpression.leftOperand, loop) &&
+                   isInvariantExpression(expression->u.binaryExpression.rightOperand, loop);
+        default:
+            error("unknown expression kind %d in isInvariantExpression", expression->kind);
+            return false;
+    }
+}
+
+static bool isInvariantArray(Variable *array, Statement *loop) {
+    switch (array->kind) {
+        case VARIABLE_NAMEDVARIABLE:
+            /* the address of an array variable, or of the array a reference parameter points to, never changes */
+            return true;
+        case VARIABLE_ARRAYACCESS:
+            return isInvariantArray(array->u.arrayAccess.array, loop) &&
+                   isInvariantExpression(array->u.arrayAccess.index, loop);
+        default:
+            error("unknown variable kind %d in isInvariantArray", array->kind);
+            return false;
+    }
+}
+
+/**
+ * Recognizes an index of the form i, i + k or i - k.
+ * @return true if the index has this form, the constant k is stored in offset.
+ */
+static bool isInductionIndex(Expression *index, Entry *inductionVariable, int *offset) {
+    Expression *constant;
+
+    if (isNamed(index, inductionVariable)) {
+        *offset = 0;
+        return true;
+    }
+    if (index->kind != EXPRESSION_BINARYEXPRESSION) return false;
+    constant = index->u.binaryExpression.rightOperand;
+    if (!isNamed(index->u.binaryExpression.leftOperand, inductionVariable)) return false;
+    if (constant->kind != EXPRESSION_INTLITERAL) return false;
+    switch (index->u.binaryExpression.operator) {
+        case ABSYN_OP_ADD:
+            *offset = constant->u.intLiteral.value;
+            return true;
+        case ABSYN_OP_SUB:
+            *offset = -constant->u.intLiteral.value;
+            return true;
+        default:
+            return false;
+    }
+}
+
+/**
+ * Recognizes the increment "i := i + c" or "i := i - c" of an induction variable.
+ * @return The entry of the induction variable, or NULL if the statement is no increment.
+ */
+static Entry *incrementedVariable(Statement *statement, int *increment) {
+    Expression *value, *constant;
+    Entry *entry;
+
+    if (statement->kind != STATEMENT_ASSIGNSTATEMENT) return NULL;
+    entry = scalarEntry(statement->u.assignStatement.target);
+    value = statement->u.assignStatement.value;
+    if (entry == NULL || value->kind != EXPRESSION_BINARYEXPRESSION) return NULL;
+    if (!isNamed(value->u.binaryExpression.leftOperand, entry)) return NULL;
+    constant = value->u.binaryExpression.rightOperand;
+    if (constant->kind != EXPRESSION_INTLITERAL || constant->u.intLiteral.value == 0) return NULL;
+    switch (value->u.binaryExpression.operator) {
+        case ABSYN_OP_ADD:
+            *increment = constant->u.intLiteral.value;
+            return entry;
+        case ABSYN_OP_SUB:
+            *increment = -constant->u.intLiteral.value;
+            return entry;
+        default:
+            return NULL;
+    }
+}
+
+/*
+ * Reduction of a single loop
+ */
+
+typedef struct {
+    Statement *loop;
+    Statement *incrementStatement;
+    Entry *inductionVariable;
+    int increment;      /* the constant added to the induction variable */
+    int nextRegister;
+} Reduction;
+
+static InductionPointer *findPointer(Statement *loop, Variable *array, Entry *inductionVariable) {
+    InductionPointer *pointer;
+
+    for (pointer = loop->u.whileStatement.pointers; pointer != NULL; pointer = pointer->next) {
+        if (lookup(localTable, pointer->inductionVariable) == inductionVariable &&
+            equalVariables(pointer->access->u.arrayAccess.array, array)) {
+            return pointer;
+        }
+    }
+    return NULL;
+}
+
+static InductionPointer *newPointer(Reduction *reduction, Variable *access) {
+    InductionPointer *pointer;
+    Variable *index;
+    Expression *indexExpression;
+
+    pointer = allocate(sizeof(InductionPointer));
+    index = newNamedVariable(access->line, reduction->inductionVariable->name);
+    index->dataType = intType;
+    indexExpression = newVariableExpression(access->line, index);
+    indexExpression->dataType = intType;
+    pointer->access = newArrayAccess(access->line, copyVariable(access->u.arrayAccess.array), indexExpression);
+    pointer->access->dataType = access->dataType;
+    /* the pointer is only computed, the element it points to is never accessed in front of the loop */
+    pointer->access->u.arrayAccess.checkIndex = false;
+    pointer->inductionVariable = reduction->inductionVariable->name;
+    pointer->step = reduction->increment * access->dataType->byteSize;
+    pointer->reg = reduction->nextRegister++;
+    pointer->increment = reduction->incrementStatement;
+    pointer->next = reduction->loop->u.whileStatement.pointers;
+    reduction->loop->u.whileStatement.pointers = pointer;
+    return pointer;
+}
+
+static void reduceExpression(Reduction *reduction, Expression *expression);
+
+static void reduceVariable(Reduction *reduction, Variable *variable) {
+    InductionPointer *pointer;
+    int offset;
+
+    if (variable->kind != VARIABLE_ARRAYACCESS) return;
+    reduceVariable(reduction, variable->u.arrayAccess.array);
+    reduceExpression(reduction, variable->u.arrayAccess.index);
+
+    /* a pointer has no index to check, so only the accesses proven to stay within bounds are reduced */
+    if (variable->u.arrayAccess.pointer != NULL || variable->u.arrayAccess.checkIndex) return;
+    if (!isInductionIndex(variable->u.arrayAccess.index, reduction->inductionVariable, &offset)) return;
+    if (!isInvariantArray(variable->u.arrayAccess.array, reduction->loop)) return;
+
+    pointer = findPointer(reduction->loop, variable->u.arrayAccess.array, reduction->inductionVariable);
+    if (pointer == NULL) {
+        if (reduction->nextRegister > LAST_POINTER_REGISTER) return;
+        pointer = newPointer(reduction, variable);
+    }
+    variable->u.arrayAccess.pointer = pointer;
+    variable->u.arrayAccess.pointerOffset = offset * variable->dataType->byteSize;
+    numReduced++;
+}
+
+static void reduceExpression(Reduction *reduction, Expression *expression) {
+    switch (expression->kind) {
+        case EXPRESSION_INTLITERAL:
+            break;
+        case EXPRESSION_VARIABLEEXPRESSION:
+            reduceVariable(reduction, expression->u.variableExpression.variable);
+            break;
+        case EXPRESSION_BINARYEXPRESSION:
+            reduceExpression(reduction, expression->u.binaryExpression.leftOperand);
+            reduceExpression(reduction, expression->u.binaryExpression.rightOperand);
+            break;
+        default:
+            error("unknown expression kind %d in reduceExpression", expression->kind);
+    }
+}
+
+static void reduceAccesses(Reduction *reduction, Statement *statement);
+
+static void reduceAccessesOfList(Reduction *reduction, StatementList *statements) {
+    while (!statements->isEmpty) {
+        reduceAccesses(reduction, statements->head);
+        statements = statements->tail;
+    }
+}
+
+static void reduceAccesses(Reduction *reduction, Statement *statement) {
+    ExpressionList *arguments;
+
+    switch (statement->kind) {
+        case STATEMENT_EMPTYSTATEMENT:
+            break;
+        case STATEMENT_COMPOUNDSTATEMENT:
+            reduceAccessesOfList(reduction, statement->u.compoundStatement.statements);
+            break;
+        case STATEMENT_ASSIGNSTATEMENT:
+            reduceVariable(reduction, statement->u.assignStatement.target);
+            reduceExpression(reduction, statement->u.assignStatement.value);
+            break;
+        case STATEMENT_IFSTATEMENT:
+            reduceExpression(reduction, statement->u.ifStatement.condition);
+            reduceAccesses(reduction, statement->u.ifStatement.thenPart);
+            reduceAccesses(reduction, statement->u.ifStatement.elsePart);
+            break;
+        case STATEMENT_WHILESTATEMENT:
+            reduceExpression(reduction, statement->u.whileStatement.condition);
+            reduceAccesses(reduction, statement->u.whileStatement.body);
+            break;
+        case STATEMENT_CALLSTATEMENT:
+            arguments = statement->u.callStatement.argumentList;
+            while (!arguments->isEmpty) {
+                reduceExpression(reduction, arguments->head);
+                arguments = arguments->tail;
+            }
+            break;
+        default:
+            error("unknown statement kind %d in reduceAccesses", statement->kind);
+    }
+}
+
+/*
+ * Report
+ */
+
+static int countUsers(Statement *loop, InductionPointer *pointer);
+
+static int countUsersOfVariable(Variable *variable, InductionPointer *pointer);
+
+static int countUsersOfExpression(Expression *expression, InductionPointer *pointer) {
+    switch (expression->kind) {
+        case EXPRESSION_VARIABLEEXPRESSION:
+            return countUsersOfVariable(expression->u.variableExpression.variable, pointer);
+        case EXPRESSION_BINARYEXPRESSION:
+            return countUsersOfExpression(expression->u.binaryExpression.leftOperand, pointer) +
+                   countUsersOfExpression(expression->u.binaryExpression.rightOperand, pointer);
+        default:
+            return 0;
+    }
+}
+
+static int countUsersOfVariable(Variable *variable, InductionPointer *pointer) {
+    if (variable->kind != VARIABLE_ARRAYACCESS) return 0;
+    return (variable->u.arrayAccess.pointer == pointer ? 1 : 0) +
+           countUsersOfVariable(variable->u.arrayAccess.array, pointer) +
+           countUsersOfExpression(variable->u.arrayAccess.index, pointer);
+}
+
+static int countUsersOfList(StatementList *statements, InductionPointer *pointer) {
+    int users = 0;
+
+    while (!statements->isEmpty) {
+        users += countUsers(statements->head, pointer);
+        statements = statements->tail;
+    }
+    return users;
+}
+
+static int countUsers(Statement *statement, InductionPointer *pointer) {
+    ExpressionList *arguments;
+    int users;
+
+    switch (statement->kind) {
+        case STATEMENT_COMPOUNDSTATEMENT:
+            return countUsersOfList(statement->u.compoundStatement.statements, pointer);
+        case STATEMENT_ASSIGNSTATEMENT:
+            return countUsersOfVariable(statement->u.assignStatement.target, pointer) +
+                   countUsersOfExpression(statement->u.assignStatement.value, pointer);
+        case STATEMENT_IFSTATEMENT:
+            return countUsersOfExpression(statement->u.ifStatement.condition, pointer) +
+                   countUsers(statement->u.ifStatement.thenPart, pointer) +
+                   countUsers(statement->u.ifStatement.elsePart, pointer);
+        case STATEMENT_WHILESTATEMENT:
+            return countUsersOfExpression(statement->u.whileStatement.condition, pointer) +
+                   countUsers(statement->u.whileStatement.body, pointer);
+        case STATEMENT_CALLSTATEMENT:
+            users = 0;
+            for (arguments = statement->u.callStatement.argumentList; !arguments->isEmpty; arguments = arguments->tail) {
+                users += countUsersOfExpression(arguments->head, pointer);
+            }
+            return users;
+        default:
+            return 0;
+    }
+}
+
+static void showLoop(Statement *loop) {
+    InductionPointer *pointer;
+
+    for (pointer = loop->u.whileStatement.pointers; pointer != NULL; pointer = pointer->next) {
+        printf("loop in line %d: $%d = &", loop->line, pointer->reg);
+        printVariable(pointer->access);
+        printf(", step %d, accesses = %d\n", pointer->step, countUsers(loop, pointer));
+    }
+}
+
+/*
+ * Traversal of the loops
+ */
+
+static void reduceStatement(Statement *statement, int firstFreeRegister);
+
+static void reduceStatementList(StatementList *statements, int firstFreeRegister) {
+    while (!statements->isEmpty) {
+        reduceStatement(statements->head, firstFreeRegister);
+        statements = statements->tail;
+    }
+}
+
+static void reduceLoop(Statement *loop, int firstFreeRegister) {
+    Reduction reduction;
+    StatementList *statements;
+    Statement *body;
+
+    reduction.loop = loop;
+    reduction.nextRegister = firstFreeRegister;
+    body = loop->u.whileStatement.body;
+    if (body->kind == STATEMENT_COMPOUNDSTATEMENT) {
+        statements = body->u.compoundStatement.statements;
+    } else {
+        statements = newStatementList(body, emptyStatementList());
+    }
+
+    /* the pointer registers are not preserved by a call */
+    if (containsCall(body)) statements = emptyStatementList();
+
+    /* only increments on the top level of the body are executed exactly once per iteration */
+    for (; !statements->isEmpty; statements = statements->tail) {
+        reduction.inductionVariable = incrementedVariable(statements->head, &reduction.increment);
+        if (reduction.inductionVariable == NULL) continue;
+        if (countAssignments(body, reduction.inductionVariable) != 1) continue;
+        if (passedByReferenceInList(procedureBody, reduction.inductionVariable)) continue;
+        reduction.incrementStatement = statements->head;
+        reduceExpression(&reduction, loop->u.whileStatement.condition);
+        reduceAccesses(&reduction, body);
+    }
+    if (reportLoops) showLoop(loop);
+    if (loop->u.whileStatement.pointers != NULL && lastExpressionRegister >= FIRST_POINTER_REGISTER) {
+        lastExpressionRegister = FIRST_POINTER_REGISTER - 1;
+    }
+
+    /* the pointers of this loop stay alive in nested loops */
+    reduceStatement(body, reduction.nextRegister);
+}
+
+static void reduceStatement(Statement *statement, int firstFreeRegister) {
+    switch (statement->kind) {
+        case STATEMENT_COMPOUNDSTATEMENT:
+            reduceStatementList(statement->u.compoundStatement.statements, firstFreeRegister);
+            break;
+        case STATEMENT_IFSTATEMENT:
+            reduceStatement(statement->u.ifStatement.thenPart, firstFreeRegister);
+            reduceStatement(statement->u.ifStatement.elsePart, firstFreeRegister);
+            break;
+        case STATEMENT_WHILESTATEMENT:
+            reduceLoop(statement, firstFreeRegister);
+            break;
+        default:
+            break;
+    }
+}
+
+int reduceLoops(Program *program, SymbolTable *globalTable, bool showReport) {
+    GlobalDeclarationList *declarationList;
+    GlobalDeclaration *declaration;
+    Entry *procEntry;
+
+    procedures = globalTable;
+    reportLoops = showReport;
+    numReduced = 0;
+    for (declarationList = program; !declarationList->isEmpty; declarationList = declarationList->tail) {
+        declaration = declarationList->head;
+        if (declaration->kind != DECLARATION_PROCEDUREDECLARATION) continue;
+
+        procEntry = lookup(procedures, declaration->name);
+        localTable = procEntry->u.procEntry.localTable;
+        procedureBody = declaration->u.procedureDeclaration.body;
+        if (showReport) printf("\nLoop strength reduction for procedure '%s'\n", declaration->name->string);
+        reduceStatementList(procedureBody, FIRST_POINTER_REGISTER);
+    }
+    return numReduced;
+}
@@ -0,0 +1,42 @@
+/*
+ * loopreduce.h -- strength reduction of array accesses in loops
+ */
+
+
+#ifndef _LOOPREDUCE_H_
+#define _LOOPREDUCE_H_
+
+#include <absyn/absyn.h>
+#include <table/table.h>
+
+#define FIRST_POINTER_REGISTER  12    /* induction pointers are held at the top of the expression stack */
+#define LAST_POINTER_REGISTER   15
+
+/**
+ * This function replaces the multiplication of the index in array accesses inside of loops by induction pointers.
+ *
+ * An induction variable is an int variable which is incremented by a constant exactly once per iteration,
+ * by an assignment "i := i + c" or "i := i - c" on the top level of the loop body. It must not be
+ * passed as an argument for a reference parameter anywhere in the procedure.
+ * Every access a[i + k] without a bounds check, whose array a is the same during the whole loop, then gets
+ * an induction pointer holding the address of a[i], which is computed in front of the loop and advanced by
+ * c times the element size at the increment. The access itself only adds the constant offset k times the element size.
+ * Accesses of the same array share one pointer. Since the pointers of enclosing loops stay alive,
+ * every loop only uses the pointer registers its enclosing loops have left. Loops containing a call
+ * are not reduced, because the pointer registers are not preserved by the called procedure.
+ *
+ * The pointers are recorded in the pointers field of the while-statement and the pointer and pointerOffset
+ * fields of the array accesses. The expression stack is shortened to end below FIRST_POINTER_REGISTER,
+ * if any pointer has been created.
+ * Since an access through a pointer is never checked, only the accesses whose check boundscheck has proven
+ * unnecessary are reduced. The pass has to run after the semantic analysis, the elision of bounds checks and
+ * the register allocation.
+ *
+ * @param program The program whose loops are reduced.
+ * @param globalTable The symbol table for the current program.
+ * @param showReport Whether the pointers of every loop should be printed.
+ * @return The number of array accesses whose address is taken from an induction pointer.
+ */
+int reduceLoops(Program *program, SymbolTable *globalTable, bool showReport);
+
+#endif /* _LOOPREDUCE_H_ */
@@ -0,0 +1,355 @@
+/*
+ * passes.c -- the pass manager running the optimizations
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <util/errors.h>
+#include <absyn/absyn.h>
+#include <table/table.h>
+#include <phases/_05_varalloc/regalloc.h>
+#include <phases/_05_varalloc/callconv.h>
+#include <phases/_05_varalloc/slotshare.h>
+#include <phases/_05_varalloc/staticalloc.h>
+#include <phases/_06_codegen/peephole.h>
+#include "fold.h"
+#include "inline.h"
+#include "ipcp.h"
+#include "tailcall.h"
+#include "boundscheck.h"
+#include "cse.h"
+#include "dce.h"
+#include "unroll.h"
+#include "loopreduce.h"
+#include "licm.h"
+#include "invert.h"
+#include "profile.h"
+#include "switchlower.h"
+#include "passes.h"
+
+#define LEVEL(level) (1u << (level))
+#define ALL_LEVELS (LEVEL(OPTIMIZE_NONE) | LEVEL(OPTIMIZE_BASIC) | LEVEL(OPTIMIZE_SPEED) | LEVEL(OPTIMIZE_SIZE))
+
+/**
+ * An optimization known to the pass manager.
+ */
+typedef struct {
+    const char *name;
+    const char *description;
+    pass_stage stage;
+    unsigned levels;                            /* the levels whose default pipeline contains the pass */
+    bool (*isEnabled)(PassOptions *options);    /* NULL if the pass has no setting disabling it */
+    int (*run)(PassOptions *options);           /* returns the number of changes */
+    int (*countChanges)(void);                  /* for PASS_STAGE_CODE, counts the changes afterwards */
+    int runs;
+    double seconds;
+    int changes;
+} Pass;
+
+/*
+ * Passes
+ */
+
+static int runTailCalls(PassOptions *options) {
+    return eliminateTailCalls(options->program, options->globalTable, options->showReport);
+}
+
+static int runConstantPropagation(PassOptions *options) {
+    int changes;
+
+    changes = propagateConstants(options->program, options->globalTable, options->cloneBudget, options->showReport);
+    /* the constants replacing the parameters are worth folding */
+    if (changes > 0) foldConstants(options->program);
+    return changes;
+}
+
+static bool isInliningEnabled(PassOptions *options) {
+    return options->inlineThreshold > 0;
+}
+
+static int runInlining(PassOptions *options) {
+    return inlineCalls(options->program, options->globalTable, options->inlineThreshold, options->showReport);
+}
+
+static int runFolding(PassOptions *options) {
+    return foldConstants(options->program);
+}
+
+static bool isUnrollingEnabled(PassOptions *options) {
+    return options->unrollFactor > 1;
+}
+
+static int runUnrolling(PassOptions *options) {
+    int unrolled;
+
+    unrolled = unrollLoops(options->program, options->globalTable, options->unrollFactor, options->showReport);
+    /* the copies of the bodies use constant indices, which are worth folding */
+    if (unrolled > 0) foldConstants(options->program);
+    return unrolled;
+}
+
+static int runDeadCode(PassOptions *options) {
+    return eliminateDeadCode(options->program, options->globalTable, options->showReport);
+}
+
+static bool isBoundsCheckingEnabled(PassOptions *options) {
+    return options->boundsChecks != BOUNDS_CHECKS_ALL;
+}
+
+static int runBoundsChecks(PassOptions *options) {
+    return elideBoundsChecks(options->program, options->globalTable, options->boundsChecks, options->showReport);
+}
+
+static int runCommonSubexpressions(PassOptions *options) {
+    return eliminateCommonSubexpressions(options->program, options->globalTable, options->showReport);
+}
+
+static int runCallingConvention(PassOptions *options) {
+    int assigned;
+
+    assigned = assignArgumentRegisters(options->program, options->globalTable);
+    /* without the register allocation, this decides which parameters stay in their registers */
+    keepArgumentsInRegisters(options->program, options->globalTable);
+    return assigned;
+}
+
+static int runRegisters(PassOptions *options) {
+    return allocRegisters(options->program, options->globalTable);
+}
+
+static int runLoopReduction(PassOptions *options) {
+    return reduceLoops(options->program, options->globalTable, options->showReport);
+}
+
+static int runInvariants(PassOptions *options) {
+    return hoistInvariants(options->program, options->globalTable, options->showReport);
+}
+
+static int runInversion(PassOptions *options) {
+    return invertLoops(options->program, options->globalTable, options->showReport);
+}
+
+static bool isLayoutEnabled(PassOptions *options) {
+    (void) options;
+    return profileLoaded;
+}
+
+static int runLayout(PassOptions *options) {
+    return layoutBranches(options->program, options->showReport);
+}
+
+static int runSwitchLowering(PassOptions *options) {
+    return lowerSwitches(options->program, options->globalTable, options->showReport);
+}
+
+static bool isStaticAllocationEnabled(PassOptions *options) {
+    return options->staticThreshold > 0;
+}
+
+static int runStaticAllocation(PassOptions *options) {
+    return allocStaticVariables(options->program, options->globalTable, options->staticThreshold,
+                                options->showReport);
+}
+
+static int runSlotSharing(PassOptions *options) {
+    return shareStackSlots(options->program, options->globalTable, options->showReport);
+}
+
+static int runPeephole(PassOptions *options) {
+    (void) options;
+    peepholeEnabled = true;
+    return 0;
+}
+
+#define BASIC_LEVELS (LEVEL(OPTIMIZE_BASIC) | LEVEL(OPTIMIZE_SPEED) | LEVEL(OPTIMIZE_SIZE))
+#define SPEED_LEVELS LEVEL(OPTIMIZE_SPEED)
+#define COMPACT_LEVELS (LEVEL(OPTIMIZE_SPEED) | LEVEL(OPTIMIZE_SIZE))
+
+/* the order of the default pipelines */
+static Pass passes[] = {
+        {"tailcall", "turn recursive calls at the end of a procedure into a loop",
+         PASS_STAGE_TREE, COMPACT_LEVELS, NULL, runTailCalls, NULL, 0, 0.0, 0},
+        {"ipcp", "propagate constant arguments into procedures and specialise copies on them",
+         PASS_STAGE_TREE, COMPACT_LEVELS, NULL, runConstantPropagation, NULL, 0, 0.0, 0},
+        {"inline", "replace calls of small procedures by their body",
+         PASS_STAGE_TREE, ALL_LEVELS, isInliningEnabled, runInlining, NULL, 0, 0.0, 0},
+        {"fold", "compute constant expressions at compile time",
+         PASS_STAGE_TREE, BASIC_LEVELS, NULL, runFolding, NULL, 0, 0.0, 0},
+        {"unroll", "unroll loops with a constant number of iterations",
+         PASS_STAGE_TREE, ALL_LEVELS, isUnrollingEnabled, runUnrolling, NULL, 0, 0.0, 0},
+        {"dce", "remove unreachable code and stores which are never read",
+         PASS_STAGE_TREE, BASIC_LEVELS, NULL, runDeadCode, NULL, 0, 0.0, 0},
+        {"boundscheck", "omit the bounds checks which can never fail",
+         PASS_STAGE_TREE, ALL_LEVELS, isBoundsCheckingEnabled, runBoundsChecks, NULL, 0, 0.0, 0},
+        {"cse", "reuse values computed more than once",
+         PASS_STAGE_TREE, SPEED_LEVELS, NULL, runCommonSubexpressions, NULL, 0, 0.0, 0},
+        {"callconv", "pass the first arguments of a procedure in registers",
+         PASS_STAGE_MACHINE, BASIC_LEVELS, NULL, runCallingConvention, NULL, 0, 0.0, 0},
+        {"regalloc", "keep scalar variables in registers",
+         PASS_STAGE_MACHINE, COMPACT_LEVELS, NULL, runRegisters, NULL, 0, 0.0, 0},
+        {"loopreduce", "replace index multiplications in loops by induction pointers",
+         PASS_STAGE_MACHINE, SPEED_LEVELS, NULL, runLoopReduction, NULL, 0, 0.0, 0},
+        {"licm", "compute addresses which do not change during a loop in front of it",
+         PASS_STAGE_MACHINE, SPEED_LEVELS, NULL, runInvariants, NULL, 0, 0.0, 0},
+        {"invert", "test short loop conditions after the body",
+         PASS_STAGE_MACHINE, SPEED_LEVELS, NULL, runInversion, NULL, 0, 0.0, 0},
+        {"layout", "put the more frequent branch of an if-statement where it needs no jump",
+         PASS_STAGE_MACHINE, ALL_LEVELS, isLayoutEnabled, runLayout, NULL, 0, 0.0, 0},
+        {"switch", "turn chains of ifs comparing a variable with constants into a jump table or decision tree",
+         PASS_STAGE_MACHINE, SPEED_LEVELS, NULL, runSwitchLowering, NULL, 0, 0.0, 0},
+        {"static", "allocate large variables of procedures which are not recursive in the bss segment",
+         PASS_STAGE_MACHINE, ALL_LEVELS, isStaticAllocationEnabled, runStaticAllocation, NULL, 0, 0.0, 0},
+        {"slots", "let local variables with disjoint lifetimes share a stack slot",
+         PASS_STAGE_MACHINE, COMPACT_LEVELS, NULL, runSlotSharing, NULL, 0, 0.0, 0},
+        {"peephole", "rewrite short sequences of emitted instructions",
+         PASS_STAGE_CODE, BASIC_LEVELS, NULL, runPeephole, countPeepholeRemovals, 0, 0.0, 0},
+};
+
+#define NUM_PASSES ((int) (sizeof(passes) / sizeof(passes[0])))
+
+static Pass *pipeline[NUM_PASSES];
+static int pipelineLength = 0;
+
+/*
+ * Selection
+ */
+
+static Pass *findPass(const char *name, int length) {
+    int i;
+
+    for (i = 0; i < NUM_PASSES; i++) {
+        if (strncmp(passes[i].name, name, length) == 0 && passes[i].name[length] == '\0') return &passes[i];
+    }
+    return NULL;
+}
+
+/**
+ * Splits a comma-separated list of names and looks them up.
+ * @return The number of passes found, or -1 if a name is unknown or the list has more than NUM_PASSES entries.
+ */
+static int parseNames(const char *names, Pass **found) {
+    const char *end;
+    Pass *pass;
+    int count;
+
+    count = 0;
+    for (;;) {
+        end = strchr(names, ',');
+        if (end == NULL) end = names + strlen(names);
+        pass = findPass(names, (int) (end - names));
+        if (pass == NULL || count == NUM_PASSES) return -1;
+        found[count++] = pass;
+        if (*end == '\0') return count;
+        names = end + 1;
+    }
+}
+
+void selectDefaultPasses(optimization_level level, PassOptions *options) {
+    int i;
+
+    pipelineLength = 0;
+    for (i = 0; i < NUM_PASSES; i++) {
+        if ((passes[i].levels & LEVEL(level)) == 0) continue;
+        if (passes[i].isEnabled != NULL && !passes[i].isEnabled(options)) continue;
+        pipeline[pipelineLength++] = &passes[i];
+    }
+}
+
+bool selectPasses(const char *names) {
+    Pass *found[NUM_PASSES];
+    int count, i, j;
+
+    count = parseNames(names, found);
+    if (count < 0) return false;
+    for (i = 0; i < count; i++) {
+        for (j = 0; j < i; j++) {
+            if (found[i] == found[j]) return false;
+            /* the register allocation has to know which parameters arrive in registers */
+            if (strcmp(found[i]->name, "callconv") == 0 && strcmp(found[j]->name, "regalloc") == 0) return false;
+            /* a variable allocated statically cannot give back the stack slot another one shares */
+            if (strcmp(found[i]->name, "static") == 0 && strcmp(found[j]->name, "slots") == 0) return false;
+        }
+    }
+    for (i = 0; i < count; i++) pipeline[i] = found[i];
+    pipelineLength = count;
+    return true;
+}
+
+bool disablePasses(const char *names) {
+    Pass *found[NUM_PASSES];
+    int count, i, j, k;
+
+    count = parseNames(names, found);
+    if (count < 0) return false;
+    for (i = 0; i < count; i++) {
+        for (j = 0, k = 0; j < pipelineLength; j++) {
+            if (pipeline[j] != found[i]) pipeline[k++] = pipeline[j];
+        }
+        pipelineLength = k;
+    }
+    return true;
+}
+
+bool arePassNames(const char *names) {
+    Pass *found[NUM_PASSES];
+
+    return parseNames(names, found) >= 0;
+}
+
+int countSelectedPasses(void) {
+    return pipelineLength;
+}
+
+/*
+ * Running
+ */
+
+static double now(void) {
+    struct timespec time;
+
+    timespec_get(&time, TIME_UTC);
+    return (double) time.tv_sec + (double) time.tv_nsec / 1e9;
+}
+
+void runPasses(PassOptions *options, pass_stage stage) {
+    Pass *pass;
+    double start;
+    int i;
+
+    for (i = 0; i < pipelineLength; i++) {
+        pass = pipeline[i];
+        if (pass->stage != stage) continue;
+        start = now();
+        pass->changes += pass->run(options);
+        pass->seconds += now() - start;
+        pass->runs++;
+    }
+}
+
+void showPassStats(void) {
+    double seconds;
+    int i, changes;
+
+    printf("\nPass statistics\n");
+    printf("%-12s %5s %12s %10s\n", "pass", "runs", "time [ms]", "changes");
+    seconds = 0.0;
+    changes = 0;
+    for (i = 0; i < NUM_PASSES; i++) {
+        if (passes[i].runs == 0) continue;
+        if (passes[i].countChanges != NULL) passes[i].changes = passes[i].countChanges();
+        printf("%-12s %5d %12.3f %10d\n", passes[i].name, passes[i].runs, passes[i].seconds * 1000.0,
+               passes[i].changes);
+        seconds += passes[i].seconds;
+        changes += passes[i].changes;
+    }
+    printf("%-12s %5s %12.3f %10d\n", "total", "", seconds * 1000.0, changes);
+}
+
+void showPasses(FILE *out) {
+    int i;
+
+    for (i = 0; i < NUM_PASSES; i++) {
+        fprintf(out, "               %-12s %s\n", passes[i].name, passes[i].description);
+    }
+}
@@ -0,0 +1,110 @@
+/*
+ * passes.h -- the pass manager running the optimizations
+ */
+
+
+#ifndef _PASSES_H_
+#define _PASSES_H_
+
+#include <stdio.h>
+#include <stdbool.h>
+#include <absyn/absyn.h>
+#include <table/table.h>
+#include "boundscheck.h"
+
+/**
+ * The optimization levels, selecting the default pipeline.
+ */
+typedef enum {
+    OPTIMIZE_NONE,          /* -O0 */
+    OPTIMIZE_BASIC,         /* -O1 */
+    OPTIMIZE_SPEED,         /* -O2 */
+    OPTIMIZE_SIZE           /* -Os */
+} optimization_level;
+
+/**
+ * The stages of the compiler in which passes run. Within a stage, the passes run in the order of the pipeline.
+ */
+typedef enum {
+    PASS_STAGE_TREE,        /* transforms the abstract syntax tree, before it is printed with --absyn */
+    PASS_STAGE_MACHINE,     /* registers, loop setup and layout, before the variables are allocated */
+    PASS_STAGE_CODE         /* works on the emitted instructions during the code generation */
+} pass_stage;
+
+/**
+ * The program and the settings the passes are run with.
+ */
+typedef struct {
+    Program *program;
+    SymbolTable *globalTable;
+    bool showReport;
+    bounds_check_mode boundsChecks;
+    int inlineThreshold;
+    int cloneBudget;
+    int unrollFactor;
+    int staticThreshold;
+} PassOptions;
+
+/**
+ * Selects the default pipeline of an optimization level.
+ *
+ * -O1 folds constants, removes dead code, passes the first arguments in registers and enables the peephole
+ * optimizer. -O2 adds every other pass.
+ * -Os adds only the passes which do not duplicate code to -O1: tail call elimination, the propagation of
+ * constant parameters, the elision of bounds checks, the register allocation, the static allocation of large
+ * variables and the sharing of stack slots; without a budget, the propagation makes no copies of procedures.
+ * Inlining, unrolling, the static allocation and the elision of bounds checks are part of every pipeline,
+ * as long as their threshold, factor or mode enables them, and the branch layout as long as a profile
+ * has been read.
+ *
+ * @param level The optimization level.
+ * @param options The settings of the passes.
+ */
+void selectDefaultPasses(optimization_level level, PassOptions *options);
+
+/**
+ * Selects the passes given as a comma-separated list of names, in the given order.
+ * @param names The list, like "fold,dce,licm".
+ * @return false if a name is unknown or listed twice, if callconv follows regalloc or if static follows slots,
+ *         the pipeline is unchanged then.
+ */
+bool selectPasses(const char *names);
+
+/**
+ * Removes passes from the pipeline, e.g. to find the pass responsible for a miscompilation.
+ * @param names A comma-separated list of names.
+ * @return false if a name is unknown.
+ */
+bool disablePasses(const char *names);
+
+/**
+ * Checks whether a comma-separated list of names only contains known passes.
+ */
+bool arePassNames(const char *names);
+
+/**
+ * @return The number of passes in the pipeline.
+ */
+int countSelectedPasses(void);
+
+/**
+ * Runs the passes of a stage in the order of the pipeline, measuring their wall time and their changes.
+ * The passes of PASS_STAGE_CODE are only enabled, they run while the code is generated.
+ * @param options The program and the settings of the passes.
+ * @param stage The stage whose passes are run.
+ */
+void runPasses(PassOptions *options, pass_stage stage);
+
+/**
+ * Prints the wall time and the number of changes of every pass that has run.
+ * The changes are counted by the passes themselves, e.g. folded expressions or inlined calls.
+ */
+void showPassStats(void);
+
+/**
+ * Prints the names and descriptions of all passes, in the order of the default pipelines.
+ * @param out The file to print to.
+ */
+void showPasses(FILE *out);
+
+#endif /* _PASSES_H_ */
@@ -0,0 +1,309 @@
+/*
+ * profile.c -- execution profiles for profile-guided optimization
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <util/errors.h>
+#include <util/memory.h>
+#include <absyn/absyn.h>
+#include "profile.h"
+
+#define PROFILE_LINE_LENGTH 256
+
+/**
+ * The number of calls of a procedure, summed up from its call edges.
+ */
+typedef struct {
+    Identifier *name;
+    long long calls;
+} ProcedureCount;
+
+bool profileLoaded = false;
+
+static int numCounters;
+static long long *counters;
+static long long highestCounter;
+static ProcedureCount *procedureCounts;
+static int numProcedures;
+static int numExchanged;
+static bool reportBranches;
+
+/*
+ * Numbering
+ */
+
+static void numberStatement(Statement *statement);
+
+static void numberStatementList(StatementList *statements) {
+    for (; !statements->isEmpty; statements = statements->tail) numberStatement(statements->head);
+}
+
+static void numberStatement(Statement *statement) {
+    switch (statement->kind) {
+        case STATEMENT_EMPTYSTATEMENT:
+        case STATEMENT_ASSIGNSTATEMENT:
+            break;
+        case STATEMENT_COMPOUNDSTATEMENT:
+            numberStatementList(statement->u.compoundStatement.statements);
+            break;
+        case STATEMENT_IFSTATEMENT:
+            statement->profileCounter = numCounters;
+            numCounters += 2;
+            numberStatement(statement->u.ifStatement.thenPart);
+            numberStatement(statement->u.ifStatement.elsePart);
+            break;
+        case STATEMENT_WHILESTATEMENT:
+            statement->profileCounter = numCounters++;
+            numberStatement(statement->u.whileStatement.body);
+            break;
+        case STATEMENT_CALLSTATEMENT:
+            statement->profileCounter = numCounters++;
+            break;
+        default:
+            error("unknown statement kind %d in numberStatement", statement->kind);
+    }
+}
+
+int numberProfileCounters(Program *program) {
+    GlobalDeclarationList *declarationList;
+
+    numCounters = 0;
+    for (declarationList = program; !declarationList->isEmpty; declarationList = declarationList->tail) {
+        if (declarationList->head->kind != DECLARATION_PROCEDUREDECLARATION) continue;
+        numberStatementList(declarationList->head->u.procedureDeclaration.body);
+    }
+    return numCounters;
+}
+
+/*
+ * Reading
+ */
+
+static ProcedureCount *findProcedureCount(Identifier *name) {
+    int i;
+
+    for (i = 0; i < numProcedures; i++) {
+        if (procedureCounts[i].name == name) return &procedureCounts[i];
+    }
+    return NULL;
+}
+
+static void countCalls(Statement *statement);
+
+static void countCallsInList(StatementList *statements) {
+    for (; !statements->isEmpty; statements = statements->tail) countCalls(statements->head);
+}
+
+static void countCalls(Statement *statement) {
+    ProcedureCount *callee;
+
+    switch (statement->kind) {
+        case STATEMENT_COMPOUNDSTATEMENT:
+            countCallsInList(statement->u.compoundStatement.statements);
+            break;
+        case STATEMENT_IFSTATEMENT:
+            countCalls(statement->u.ifStatement.thenPart);
+            countCalls(statement->u.ifStatement.elsePart);
+            break;
+        case STATEMENT_WHILESTATEMENT:
+            countCalls(statement->u.whileStatement.body);
+            break;
+        case STATEMENT_CALLSTATEMENT:
+            /* predefined procedures are not declared in the program */
+            callee = findProcedureCount(statement->u.callStatement.procedureName);
+            if (callee != NULL) callee->calls += counters[statement->profileCounter];
+            break;
+        default:
+            break;
+    }
+}
+
+/**
+ * Sums up the calls of every procedure from the counters of the call statements.
+ */
+static void countProcedureCalls(Program *program) {
+    GlobalDeclarationList *declarationList;
+    ProcedureCount *mainCount;
+
+    numProcedures = 0;
+    for (declarationList = program; !declarationList->isEmpty; declarationList = declarationList->tail) {
+        if (declarationList->head->kind == DECLARATION_PROCEDUREDECLARATION) numProcedures++;
+    }
+    procedureCounts = allocate((numProcedures + 1) * sizeof(ProcedureCount));
+    numProcedures = 0;
+    for (declarationList = program; !declarationList->isEmpty; declarationList = declarationList->tail) {
+        if (declarationList->head->kind != DECLARATION_PROCEDUREDECLARATION) continue;
+        procedureCounts[numProcedures].name = declarationList->head->name;
+        procedureCounts[numProcedures].calls = 0;
+        numProcedures++;
+    }
+    for (declarationList = program; !declarationList->isEmpty; declarationList = declarationList->tail) {
+        if (declarationList->head->kind != DECLARATION_PROCEDUREDECLARATION) continue;
+        countCallsInList(declarationList->head->u.procedureDeclaration.body);
+    }
+    mainCount = findProcedureCount(newIdentifier("main"));
+    if (mainCount != NULL) mainCount->calls += 1;
+}
+
+void readProfile(Program *program, const char *fileName) {
+    char line[PROFILE_LINE_LENGTH];
+    FILE *file;
+    int i, count, numRuns;
+    long long value;
+
+    /* a program without counters is not instrumented and prints no profile */
+    if (numCounters == 0) return;
+    counters = allocate((numCounters + 1) * sizeof(long long));
+    for (i = 0; i < numCounters; i++) counters[i] = 0;
+
+    file = fopen(fileName, "r");
+    if (file == NULL) error("cannot open profile '%s'", fileName);
+    numRuns = 0;
+    while (fgets(line, PROFILE_LINE_LENGTH, file) != NULL) {
+        if (strncmp(line, "#profile ", 9) != 0) continue;
+        if (sscanf(line + 9, "%d", &count) != 1 || count != numCounters) {
+            error("profile '%s' does not belong to this program", fileName);
+        }
+        for (i = 0; i < numCounters; i++) {
+            if (fscanf(file, "%lld", &value) != 1) error("profile '%s' is incomplete", fileName);
+            counters[i] += value < 0 ? value + 0x100000000LL : value;
+        }
+        numRuns++;
+    }
+    fclose(file);
+    if (numRuns == 0) error("no profile found in '%s'", fileName);
+
+    highestCounter = 0;
+    for (i = 0; i < numCounters; i++) {
+        if (counters[i] > highestCounter) highestCounter = counters[i];
+    }
+    countProcedureCalls(program);
+    profileLoaded = true;
+}
+
+/*
+ * Queries
+ */
+
+long long profileCount(Statement *statement, int offset) {
+    if (!profileLoaded || statement->profileCounter < 0) return -1;
+    return counters[statement->profileCounter + offset];
+}
+
+long long procedureProfileCount(Identifier *name) {
+    ProcedureCount *procedure;
+
+    if (!profileLoaded) return -1;
+    procedure = findProcedureCount(name);
+    return procedure == NULL ? -1 : procedure->calls;
+}
+
+bool isColdProfileCounter(Statement *statement, int offset) {
+    return profileCount(statement, offset) == 0;
+}
+
+bool isHotProfileCounter(Statement *statement, int offset) {
+    long long count;
+
+    count = profileCount(statement, offset);
+    return count > 0 && count >= highestCounter / PROFILE_HOT_FRACTION;
+}
+
+int profileFrequency(Statement *statement, int offset, long long calls, int estimate) {
+    long long count, frequency;
+
+    count = profileCount(statement, offset);
+    if (count < 0) return estimate;
+    if (count == 0) return 0;
+    /* only possible if the profile was edited, every call is counted before the body is executed */
+    if (calls <= 0) return estimate;
+    frequency = (count + calls - 1) / calls;
+    return frequency > MAX_PROFILE_FREQUENCY ? MAX_PROFILE_FREQUENCY : (int) frequency;
+}
+
+/*
+ * Branch layout
+ */
+
+static binary_operator negatedComparison(binary_operator operator) {
+    switch (operator) {
+        case ABSYN_OP_EQU:
+            return ABSYN_OP_NEQ;
+        case ABSYN_OP_NEQ:
+            return ABSYN_OP_EQU;
+        case ABSYN_OP_LST:
+            return ABSYN_OP_GRE;
+        case ABSYN_OP_LSE:
+            return ABSYN_OP_GRT;
+        case ABSYN_OP_GRT:
+            return ABSYN_OP_LSE;
+        case ABSYN_OP_GRE:
+            return ABSYN_OP_LST;
+        default:
+            error("operator %d in negatedComparison is no comparison", operator);
+            return operator;
+    }
+}
+
+static void layoutStatement(Statement *statement);
+
+static void layoutStatementList(StatementList *statements) {
+    for (; !statements->isEmpty; statements = statements->tail) layoutStatement(statements->head);
+}
+
+static void exchangeBranches(Statement *statement) {
+    Expression *condition;
+    Statement *thenPart;
+    long long thenCount, elseCount;
+
+    thenCount = profileCount(statement, PROFILE_THEN);
+    elseCount = profileCount(statement, PROFILE_ELSE);
+    if (thenCount <= elseCount || statement->u.ifStatement.elsePart->kind == STATEMENT_EMPTYSTATEMENT) return;
+    condition = statement->u.ifStatement.condition;
+    condition->u.binaryExpression.operator = negatedComparison(condition->u.binaryExpression.operator);
+    thenPart = statement->u.ifStatement.thenPart;
+    statement->u.ifStatement.thenPart = statement->u.ifStatement.elsePart;
+    statement->u.ifStatement.elsePart = thenPart;
+    statement->profileCounter = -1;
+    numExchanged++;
+    if (reportBranches) {
+        printf("if in line %d: branches exchanged, then-part executed %lld times, else-part %lld times\n",
+               statement->line, thenCount, elseCount);
+    }
+}
+
+static void layoutStatement(Statement *statement) {
+    switch (statement->kind) {
+        case STATEMENT_COMPOUNDSTATEMENT:
+            layoutStatementList(statement->u.compoundStatement.statements);
+            break;
+        case STATEMENT_IFSTATEMENT:
+            layoutStatement(statement->u.ifStatement.thenPart);
+            layoutStatement(statement->u.ifStatement.elsePart);
+            exchangeBranches(statement);
+            break;
+        case STATEMENT_WHILESTATEMENT:
+            layoutStatement(statement->u.whileStatement.body);
+            break;
+        default:
+            break;
+    }
+}
+
+int layoutBranches(Program *program, bool showReport) {
+    GlobalDeclarationList *declarationList;
+    GlobalDeclaration *declaration;
+
+    numExchanged = 0;
+    if (!profileLoaded) return 0;
+    reportBranches = showReport;
+    for (declarationList = program; !declarationList->isEmpty; declarationList = declarationList->tail) {
+        declaration = declarationList->head;
+        if (declaration->kind != DECLARATION_PROCEDUREDECLARATION) continue;
+
+        if (showReport) printf("\nBranch layout for procedure '%s'\n", declaration->name->string);
+        layoutStatementList(declaration->u.procedureDeclaration.body);
+    }
+    return numExchanged;
+}
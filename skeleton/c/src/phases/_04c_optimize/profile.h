@@ -0,0 +1,106 @@
+/*
+ * profile.h -- execution profiles for profile-guided optimization
+ */
+
+
+#ifndef _PROFILE_H_
+#define _PROFILE_H_
+
+#include <stdbool.h>
+#include <absyn/absyn.h>
+
+#define PROFILE_THEN 0                  /* offset of the counter of the then-part of an if-statement */
+#define PROFILE_ELSE 1                  /* offset of the counter of the else-part */
+#define PROFILE_HOT_FRACTION 100        /* a counter is hot if it reaches 1/100 of the highest counter */
+#define MAX_PROFILE_FREQUENCY 1000000   /* limit for executions per call, keeps weights within an int */
+
+/**
+ * Whether a profile has been read by readProfile.
+ */
+extern bool profileLoaded;
+
+/**
+ * This function numbers the execution counters of a program, in the order the statements appear in the source.
+ *
+ * An if-statement gets two counters, for the executions of its then-part and its else-part, a while-statement
+ * one for the executions of its body and a call statement one for the executions of the call, i.e. for its
+ * edge of the call graph. The executions of all other statements follow from these, the calls of a procedure
+ * are the sum of its call edges, plus one for main. The first counter of a statement is stored in its
+ * profileCounter field, which is also carried over to the copies made by later optimizations.
+ *
+ * An instrumented build and a build using the profile have to number the same source, so the pass has to run
+ * directly after the semantic analysis, before any optimization changes the procedure bodies.
+ *
+ * @param program The program whose counters are numbered.
+ * @return The number of counters.
+ */
+int numberProfileCounters(Program *program);
+
+/**
+ * Reads the counters written by a program built with --profile-generate.
+ *
+ * The file is the output of one or more runs of the program. Every run prints a line "#profile n", followed
+ * by the n counters on a line each, when main returns or exit is called. The other output of the program
+ * is skipped, and the counters of all runs found in the file are added. A counter of 2^31 or more is printed
+ * as a negative number by printi, so it is read back as an unsigned word.
+ * The counters have to be numbered by numberProfileCounters before.
+ *
+ * @param program The program the profile belongs to.
+ * @param fileName The name of the file holding the output.
+ */
+void readProfile(Program *program, const char *fileName);
+
+/**
+ * Looks up the executions of a statement in the profile.
+ * @param statement An if-, while- or call statement.
+ * @param offset PROFILE_THEN or PROFILE_ELSE for an if-statement, otherwise 0.
+ * @return The number of executions, or -1 if there is no profile or the statement has no counter.
+ */
+long long profileCount(Statement *statement, int offset);
+
+/**
+ * Computes how often a procedure has been called in the profile.
+ * @param name The name of the procedure.
+ * @return The number of calls, or -1 if there is no profile.
+ */
+long long procedureProfileCount(Identifier *name);
+
+/**
+ * Checks whether a counter has never been incremented in the profile.
+ * @return false if there is no profile or the statement has no counter.
+ */
+bool isColdProfileCounter(Statement *statement, int offset);
+
+/**
+ * Checks whether a counter reaches at least 1/PROFILE_HOT_FRACTION of the highest counter of the profile.
+ * @return false if there is no profile or the statement has no counter.
+ */
+bool isHotProfileCounter(Statement *statement, int offset);
+
+/**
+ * Computes how often a part of a procedure is executed per call of the procedure, rounded up, so a part which
+ * is executed at all counts at least once.
+ * @param statement An if-, while- or call statement.
+ * @param offset PROFILE_THEN or PROFILE_ELSE for an if-statement, otherwise 0.
+ * @param calls The number of calls of the procedure, as returned by procedureProfileCount.
+ * @param estimate The frequency to use if there is no profile or the statement has no counter.
+ * @return The executions per call, at most MAX_PROFILE_FREQUENCY.
+ */
+int profileFrequency(Statement *statement, int offset, long long calls, int estimate);
+
+/**
+ * This function arranges the branches of if-statements according to the profile.
+ *
+ * An if-statement with an else-part is emitted as the condition branching to the else-part, the then-part
+ * and a jump over the else-part, so the then-part executes one instruction more. If the then-part has been
+ * executed more often than the else-part, the condition is negated and the parts are exchanged, so the more
+ * frequent part is emitted without the jump. The counters of an exchanged statement are dropped, since they
+ * no longer fit its parts, so the pass has to run after all other passes using the profile.
+ *
+ * @param program The program whose branches are arranged.
+ * @param showReport Whether every exchanged if-statement should be printed with its counters.
+ * @return The number of exchanged if-statements.
+ */
+int layoutBranches(Program *program, bool showReport);
+
+#endif /* _PROFILE_H_ */
@@ -0,0 +1,242 @@
+/*
+ * switchlower.c -- lowering of if-chains to jump tables and decision trees
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <util/errors.h>
+#include <util/memory.h>
+#include <absyn/absyn.h>
+#include <table/table.h>
+#include <types/types.h>
+#include <phases/_06_codegen/instrument.h>
+#include "switchlower.h"
+
+static SymbolTable *localTable;
+static int numLowered;
+static bool reportSwitches;
+
+/*
+ * Recognition
+ */
+
+/**
+ * Checks whether a condition compares a variable of type int with a literal, in either order.
+ * @param condition The condition of an if-statement.
+ * @param selector Receives the name of the variable.
+ * @param value Receives the value of the literal.
+ * @return ABSYN_OP_EQU or ABSYN_OP_NEQ if the condition is such a comparison, otherwise -1.
+ */
+static int matchCaseCondition(Expression *condition, Identifier **selector, int *value) {
+    Expression *variable, *literal;
+    binary_operator operator;
+    Entry *entry;
+
+    if (condition->kind != EXPRESSION_BINARYEXPRESSION) return -1;
+    operator = condition->u.binaryExpression.operator;
+    if (operator != ABSYN_OP_EQU && operator != ABSYN_OP_NEQ) return -1;
+    variable = condition->u.binaryExpression.leftOperand;
+    literal = condition->u.binaryExpression.rightOperand;
+    if (variable->kind == EXPRESSION_INTLITERAL) {
+        literal = variable;
+        variable = condition->u.binaryExpression.rightOperand;
+    }
+    if (literal->kind != EXPRESSION_INTLITERAL || variable->kind != EXPRESSION_VARIABLEEXPRESSION) return -1;
+    if (variable->u.variableExpression.variable->kind != VARIABLE_NAMEDVARIABLE) return -1;
+    *selector = variable->u.variableExpression.variable->u.namedVariable.name;
+    entry = lookup(localTable, *selector);
+    if (entry == NULL || entry->kind != ENTRY_KIND_VAR || entry->u.varEntry.type != intType) return -1;
+    *value = literal->u.intLiteral.value;
+    return (int) operator;
+}
+
+/**
+ * Skips compound statements holding a single statement, which a chain written with braces has around
+ * its next if-statement.
+ */
+static Statement *unwrapStatement(Statement *statement) {
+    StatementList *statements;
+
+    while (statement->kind == STATEMENT_COMPOUNDSTATEMENT) {
+        statements = statement->u.compoundStatement.statements;
+        if (statements->isEmpty || !statements->tail->isEmpty) break;
+        statement = statements->head;
+    }
+    return statement;
+}
+
+static bool hasCase(SwitchCase *cases, int numCases, int value) {
+    int i;
+
+    for (i = 0; i < numCases; i++) {
+        if (cases[i].value == value) return true;
+    }
+    return false;
+}
+
+static int compareCases(const void *left, const void *right) {
+    int leftValue = ((const SwitchCase *) left)->value;
+    int rightValue = ((const SwitchCase *) right)->value;
+
+    return leftValue < rightValue ? -1 : leftValue > rightValue ? 1 : 0;
+}
+
+/**
+ * Counts the if-statements of the chain starting at an if-statement.
+ * @return The number of cases, 0 if the statement does not start a chain.
+ */
+static int countChain(Statement *statement) {
+    Identifier *first, *selector;
+    int count, value;
+
+    if (matchCaseCondition(statement->u.ifStatement.condition, &first, &value) < 0) return 0;
+    count = 0;
+    for (;;) {
+        switch (matchCaseCondition(statement->u.ifStatement.condition, &selector, &value)) {
+            case ABSYN_OP_EQU:
+                statement = statement->u.ifStatement.elsePart;
+                break;
+            case ABSYN_OP_NEQ:
+                statement = statement->u.ifStatement.thenPart;
+                break;
+            default:
+                return count;
+        }
+        if (selector != first) return count;
+        count++;
+        statement = unwrapStatement(statement);
+        if (statement->kind != STATEMENT_IFSTATEMENT) return count;
+    }
+}
+
+/**
+ * Collects the cases of the chain starting at an if-statement, up to the first repeated value.
+ */
+static SwitchLowering *collectChain(Statement *statement, int maxCases) {
+    SwitchLowering *lowering;
+    Identifier *selector;
+    Statement *body, *rest;
+    int value;
+
+    lowering = allocate(sizeof(SwitchLowering));
+    lowering->cases = allocate(maxCases * sizeof(SwitchCase));
+    lowering->numCases = 0;
+    lowering->defaultPart = statement;
+    while (lowering->numCases < maxCases) {
+        if (matchCaseCondition(statement->u.ifStatement.condition, &selector, &value) == ABSYN_OP_EQU) {
+            body = statement->u.ifStatement.thenPart;
+            rest = statement->u.ifStatement.elsePart;
+        } else {
+            body = statement->u.ifStatement.elsePart;
+            rest = statement->u.ifStatement.thenPart;
+        }
+        /* a repeated value can never match, the if-statement with it is left to the default part */
+        if (hasCase(lowering->cases, lowering->numCases, value)) break;
+        lowering->selector = selector;
+        lowering->cases[lowering->numCases].value = value;
+        lowering->cases[lowering->numCases].body = body;
+        lowering->numCases++;
+        lowering->defaultPart = rest;
+        statement = unwrapStatement(rest);
+    }
+    qsort(lowering->cases, lowering->numCases, sizeof(SwitchCase), compareCases);
+    return lowering;
+}
+
+/**
+ * Chooses between a jump table and a decision tree.
+ */
+static switch_kind chooseKind(SwitchLowering *lowering) {
+    long long range;
+
+    range = (long long) lowering->cases[lowering->numCases - 1].value - lowering->cases[0].value + 1;
+    if (range > MAX_JUMP_TABLE_SIZE) return SWITCH_DECISION_TREE;
+    if (lowering->numCases * 100 < range * MIN_JUMP_TABLE_DENSITY) return SWITCH_DECISION_TREE;
+    return SWITCH_JUMP_TABLE;
+}
+
+/*
+ * Lowering
+ */
+
+static void lowerStatement(Statement *statement);
+
+static void lowerStatementList(StatementList *statements) {
+    for (; !statements->isEmpty; statements = statements->tail) lowerStatement(statements->head);
+}
+
+static void lowerChain(Statement *statement, int maxCases) {
+    SwitchLowering *lowering;
+    int i, low, high;
+
+    lowering = collectChain(statement, maxCases);
+    if (lowering->numCases < MIN_SWITCH_CASES) {
+        release(lowering->cases);
+        release(lowering);
+        lowerStatement(statement->u.ifStatement.thenPart);
+        lowerStatement(statement->u.ifStatement.elsePart);
+        return;
+    }
+    lowering->kind = chooseKind(lowering);
+    statement->u.ifStatement.lowering = lowering;
+    numLowered++;
+    if (reportSwitches) {
+        low = lowering->cases[0].value;
+        high = lowering->cases[lowering->numCases - 1].value;
+        if (lowering->kind == SWITCH_JUMP_TABLE) {
+            printf("if in line %d: %d cases of '%s' from %d to %d, jump table with %d entries\n",
+                   statement->line, lowering->numCases, lowering->selector->string, low, high, high - low + 1);
+        } else {
+            printf("if in line %d: %d cases of '%s' from %d to %d, decision tree\n",
+                   statement->line, lowering->numCases, lowering->selector->string, low, high);
+        }
+    }
+    for (i = 0; i < lowering->numCases; i++) lowerStatement(lowering->cases[i].body);
+    lowerStatement(lowering->defaultPart);
+}
+
+static void lowerStatement(Statement *statement) {
+    int numCases;
+
+    switch (statement->kind) {
+        case STATEMENT_COMPOUNDSTATEMENT:
+            lowerStatementList(statement->u.compoundStatement.statements);
+            break;
+        case STATEMENT_IFSTATEMENT:
+            numCases = countChain(statement);
+            if (numCases >= MIN_SWITCH_CASES) {
+                lowerChain(statement, numCases);
+                break;
+            }
+            lowerStatement(statement->u.ifStatement.thenPart);
+            lowerStatement(statement->u.ifStatement.elsePart);
+            break;
+        case STATEMENT_WHILESTATEMENT:
+            lowerStatement(statement->u.whileStatement.body);
+            break;
+        default:
+            break;
+    }
+}
+
+int lowerSwitches(Program *program, SymbolTable *globalTable, bool showReport) {
+    GlobalDeclarationList *declarationList;
+    GlobalDeclaration *declaration;
+    int lowered;
+
+    numLowered = 0;
+    /* the execution counters of an instrumented program are incremented in the branches of the if-statements */
+    if (numProfileCounters > 0) return 0;
+    reportSwitches = showReport;
+    for (declarationList = program; !declarationList->isEmpty; declarationList = declarationList->tail) {
+        declaration = declarationList->head;
+        if (declaration->kind != DECLARATION_PROCEDUREDECLARATION) continue;
+
+        localTable = lookup(globalTable, declaration->name)->u.procEntry.localTable;
+        if (showReport) printf("\nSwitch lowering for procedure '%s'\n", declaration->name->string);
+        lowered = numLowered;
+        lowerStatementList(declaration->u.procedureDeclaration.body);
+        if (showReport) printf("%d if-chains lowered\n", numLowered - lowered);
+    }
+    return numLowered;
+}
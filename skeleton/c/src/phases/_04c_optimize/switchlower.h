@@ -0,0 +1,42 @@
+/*
+ * switchlower.h -- lowering of if-chains to jump tables and decision trees
+ */
+
+
+#ifndef _SWITCHLOWER_H_
+#define _SWITCHLOWER_H_
+
+#include <stdbool.h>
+#include <absyn/absyn.h>
+#include <table/table.h>
+
+#define MIN_SWITCH_CASES 4              /* shorter chains are cheaper as sequential compares */
+#define MIN_JUMP_TABLE_DENSITY 50       /* percentage of the entries of a jump table which need a case */
+#define MAX_JUMP_TABLE_SIZE 512         /* entries of the largest jump table */
+
+/**
+ * This function finds chains of if-statements which compare one variable with distinct constants, like
+ * "if (c = 'a') s1 else if (c = 'b') s2 else if ... else s", and attaches a SwitchLowering to their first
+ * if-statement.
+ *
+ * A chain continues through the else-parts, also through a compound statement holding just the next
+ * if-statement, as long as each condition compares the same named variable with an integer literal for
+ * equality and the literal has not been seen before. A comparison for inequality, as left by the branch
+ * layout, continues through the then-part instead. Chains with fewer than MIN_SWITCH_CASES cases keep
+ * their compares.
+ *
+ * If at least MIN_JUMP_TABLE_DENSITY percent of the values between the lowest and the highest constant
+ * have a case and there are at most MAX_JUMP_TABLE_SIZE of them, the chain becomes a bounds-checked jump
+ * table, otherwise a balanced decision tree, which needs about log2(n) compares instead of n.
+ *
+ * Nothing is lowered in an instrumented program, whose execution counters belong to the if-statements.
+ * The pass has to run after the branch layout, which may exchange the branches of the if-statements.
+ *
+ * @param program The program whose if-chains are lowered.
+ * @param globalTable The symbol table for the current program.
+ * @param showReport Whether every lowered chain should be printed.
+ * @return The number of lowered chains.
+ */
+int lowerSwitches(Program *program, SymbolTable *globalTable, bool showReport);
+
+#endif /* _SWITCHLOWER_H_ */
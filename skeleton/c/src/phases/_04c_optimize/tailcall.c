@@ -0,0 +1,272 @@
+/*
+ * tailcall.c -- elimination of recursive tail calls
+ */
+
+#include <stdio.h>
+#include <util/errors.h>
+#include <util/memory.h>
+#include <absyn/absyn.h>
+#include <table/table.h>
+#include <types/types.h>
+#include "locals.h"
+#include "tailcall.h"
+
+static GlobalDeclaration *procedure;
+static SymbolTable *localTable;
+static Variable *flag;              /* set while the loop replacing the recursion has to run again */
+static Variable **temporaries;      /* one per parameter, created when needed */
+static int numParameters;
+static int numEliminated;
+static bool reportCalls;
+
+/*
+ * New variables
+ */
+
+static Variable *newTailcallVariable(char *suffix, TypeExpression *typeExpression, Type *type, int line) {
+    char buffer[200];
+
+    /* a dot can never appear in an identifier of the source program */
+    snprintf(buffer, sizeof(buffer), "%.90s.%.90s", procedure->name->string, suffix);
+    return newLocalVariable(procedure, localTable, newIdentifier(buffer), typeExpression, type, line);
+}
+
+static Variable *namedVariable(Identifier *name, int line) {
+    Variable *variable;
+
+    variable = newNamedVariable(line, name);
+    variable->dataType = lookup(localTable, name)->u.varEntry.type;
+    return variable;
+}
+
+static Expression *intLiteral(int value, int line) {
+    Expression *expression;
+
+    expression = newIntLiteral(line, value);
+    expression->dataType = intType;
+    return expression;
+}
+
+static Variable *getFlag(int line) {
+    TypeExpression *typeExpression;
+
+    if (flag == NULL) {
+        typeExpression = newNamedTypeExpression(line, newIdentifier("int"));
+        typeExpression->dataType = intType;
+        flag = newTailcallVariable("tailcall", typeExpression, intType, line);
+    }
+    return copyVariable(flag);
+}
+
+static Variable *getTemporary(int index, ParameterDeclaration *parameter, int line) {
+    char buffer[100];
+
+    if (temporaries[index] == NULL) {
+        snprintf(buffer, sizeof(buffer), "%.90s.tail", parameter->name->string);
+        temporaries[index] = newTailcallVariable(buffer, parameter->typeExpression,
+                                                 lookup(localTable, parameter->name)->u.varEntry.type, line);
+    }
+    return copyVariable(temporaries[index]);
+}
+
+/*
+ * Replacement of a call
+ */
+
+static bool isNamed(Expression *expression, Identifier *name) {
+    return expression->kind == EXPRESSION_VARIABLEEXPRESSION &&
+           expression->u.variableExpression.variable->kind == VARIABLE_NAMEDVARIABLE &&
+           expression->u.variableExpression.variable->u.namedVariable.name == name;
+}
+
+static bool readsExpression(Expression *expression, Identifier *name);
+
+static bool readsVariable(Variable *variable, Identifier *name) {
+    switch (variable->kind) {
+        case VARIABLE_NAMEDVARIABLE:
+            return variable->u.namedVariable.name == name;
+        case VARIABLE_ARRAYACCESS:
+            return readsVariable(variable->u.arrayAccess.array, name) ||
+                   readsExpression(variable->u.arrayAccess.index, name);
+        default:
+            error("unknown variable kind %d in readsVariable", variable->kind);
+            return false;
+    }
+}
+
+static bool readsExpression(Expression *expression, Identifier *name) {
+    switch (expression->kind) {
+        case EXPRESSION_INTLITERAL:
+            return false;
+        case EXPRESSION_VARIABLEEXPRESSION:
+            return readsVariable(expression->u.variableExpression.variable, name);
+        case EXPRESSION_BINARYEXPRESSION:
+            return readsExpression(expression->u.binaryExpression.leftOperand, name) ||
+                   readsExpression(expression->u.binaryExpression.rightOperand, name);
+        default:
+            error("unknown expression kind %d in readsExpression", expression->kind);
+            return false;
+    }
+}
+
+static void append(StatementList ***last, Statement *statement) {
+    **last = newStatementList(statement, emptyStatementList());
+    *last = &(**last)->tail;
+}
+
+/**
+ * Replaces a tail call by the assignment of the arguments and the setting of the flag.
+ */
+static void eliminateCall(Statement *call) {
+    ParameterList *parameters, *previous;
+    ExpressionList *arguments;
+    StatementList *saves, **lastSave, *assignments, **lastAssignment;
+    Expression *value;
+    bool *assigned, needsTemporary;
+    int line, k, j;
+
+    line = call->line;
+    parameters = procedure->u.procedureDeclaration.parameters;
+    for (arguments = call->u.callStatement.argumentList; !parameters->isEmpty;
+         parameters = parameters->tail, arguments = arguments->tail) {
+        if (parameters->head->isReference && !isNamed(arguments->head, parameters->head->name)) {
+            if (reportCalls) printf("call in line %d: not eliminated, reference argument '%s' changes\n",
+                                    line, parameters->head->name->string);
+            return;
+        }
+    }
+
+    assigned = allocate(numParameters * sizeof(bool));
+    saves = emptyStatementList();
+    lastSave = &saves;
+    assignments = emptyStatementList();
+    lastAssignment = &assignments;
+    parameters = procedure->u.procedureDeclaration.parameters;
+    arguments = call->u.callStatement.argumentList;
+    for (k = 0; k < numParameters; k++, parameters = parameters->tail, arguments = arguments->tail) {
+        assigned[k] = false;
+        if (parameters->head->isReference || isNamed(arguments->head, parameters->head->name)) continue;
+
+        /* the argument has to see the values the parameters had at the call */
+        needsTemporary = false;
+        for (j = 0, previous = procedure->u.procedureDeclaration.parameters; j < k; j++, previous = previous->tail) {
+            if (assigned[j] && readsExpression(arguments->head, previous->head->name)) needsTemporary = true;
+        }
+        value = copyExpression(arguments->head);
+        if (needsTemporary) {
+            append(&lastSave, newAssignStatement(line, getTemporary(k, parameters->head, line), value));
+            value = newVariableExpression(line, getTemporary(k, parameters->head, line));
+            value->dataType = value->u.variableExpression.variable->dataType;
+        }
+        append(&lastAssignment, newAssignStatement(line, namedVariable(parameters->head->name, line), value));
+        assigned[k] = true;
+    }
+    release(assigned);
+
+    append(&lastAssignment, newAssignStatement(line, getFlag(line), intLiteral(1, line)));
+    *lastSave = assignments;
+    *call = *newCompoundStatement(line, saves);
+    numEliminated++;
+    if (reportCalls) printf("call in line %d: eliminated\n", line);
+}
+
+/*
+ * Tail positions
+ */
+
+static bool hasNoEffect(Statement *statement) {
+    StatementList *statements;
+
+    if (statement->kind == STATEMENT_EMPTYSTATEMENT) return true;
+    if (statement->kind != STATEMENT_COMPOUNDSTATEMENT) return false;
+    for (statements = statement->u.compoundStatement.statements; !statements->isEmpty; statements = statements->tail) {
+        if (!hasNoEffect(statements->head)) return false;
+    }
+    return true;
+}
+
+static void eliminateInStatement(Statement *statement, bool isTail);
+
+static void eliminateInList(StatementList *statements, bool isTail) {
+    StatementList *rest;
+    bool restHasNoEffect;
+
+    for (; !statements->isEmpty; statements = statements->tail) {
+        restHasNoEffect = true;
+        for (rest = statements->tail; !rest->isEmpty; rest = rest->tail) {
+            if (!hasNoEffect(rest->head)) restHasNoEffect = false;
+        }
+        eliminateInStatement(statements->head, isTail && restHasNoEffect);
+    }
+}
+
+static void eliminateInStatement(Statement *statement, bool isTail) {
+    switch (statement->kind) {
+        case STATEMENT_COMPOUNDSTATEMENT:
+            eliminateInList(statement->u.compoundStatement.statements, isTail);
+            break;
+        case STATEMENT_IFSTATEMENT:
+            eliminateInStatement(statement->u.ifStatement.thenPart, isTail);
+            eliminateInStatement(statement->u.ifStatement.elsePart, isTail);
+            break;
+        case STATEMENT_WHILESTATEMENT:
+            /* the condition is evaluated again after the body */
+            eliminateInStatement(statement->u.whileStatement.body, false);
+            break;
+        case STATEMENT_CALLSTATEMENT:
+            if (isTail && statement->u.callStatement.procedureName == procedure->name) eliminateCall(statement);
+            break;
+        default:
+            break;
+    }
+}
+
+/**
+ * Wraps the body into "flag := 1; while (flag # 0) { flag := 0; body }".
+ */
+static void wrapBody(void) {
+    StatementList *body;
+    Expression *condition;
+    Statement *loop;
+    int line;
+
+    body = procedure->u.procedureDeclaration.body;
+    line = procedure->line;
+    body = newStatementList(newAssignStatement(line, getFlag(line), intLiteral(0, line)), body);
+    condition = newBinaryExpression(line, ABSYN_OP_NEQ, newVariableExpression(line, getFlag(line)), intLiteral(0, line));
+    condition->u.binaryExpression.leftOperand->dataType = intType;
+    condition->dataType = boolType;
+    loop = newWhileStatement(line, condition, newCompoundStatement(line, body));
+    procedure->u.procedureDeclaration.body =
+            newStatementList(newAssignStatement(line, getFlag(line), intLiteral(1, line)),
+                             newStatementList(loop, emptyStatementList()));
+}
+
+int eliminateTailCalls(Program *program, SymbolTable *globalTable, bool showReport) {
+    GlobalDeclarationList *declarationList;
+    ParameterList *parameters;
+    int eliminatedBefore, i;
+
+    numEliminated = 0;
+    reportCalls = showReport;
+    for (declarationList = program; !declarationList->isEmpty; declarationList = declarationList->tail) {
+        procedure = declarationList->head;
+        if (procedure->kind != DECLARATION_PROCEDUREDECLARATION) continue;
+
+        localTable = lookup(globalTable, procedure->name)->u.procEntry.localTable;
+        flag = NULL;
+        numParameters = 0;
+        for (parameters = procedure->u.procedureDeclaration.parameters; !parameters->isEmpty; parameters = parameters->tail) {
+            numParameters++;
+        }
+        temporaries = allocate((numParameters + 1) * sizeof(Variable *));
+        for (i = 0; i < numParameters; i++) temporaries[i] = NULL;
+
+        if (showReport) printf("\nTail call elimination for procedure '%s'\n", procedure->name->string);
+        eliminatedBefore = numEliminated;
+        eliminateInList(procedure->u.procedureDeclaration.body, true);
+        if (numEliminated > eliminatedBefore) wrapBody();
+        release(temporaries);
+    }
+    return numEliminated;
+}
@@ -0,0 +1,37 @@
+/*
+ * tailcall.h -- elimination of recursive tail calls
+ */
+
+
+#ifndef _TAILCALL_H_
+#define _TAILCALL_H_
+
+#include <absyn/absyn.h>
+#include <table/table.h>
+
+/**
+ * This function turns calls of a procedure to itself, which are the last statement executed by it, into a loop.
+ *
+ * A call is in tail position if it is the last statement of the procedure body, or the last one of
+ * a compound statement or a branch of an if-statement in tail position. Only empty statements may follow it.
+ * The body of a procedure with such calls is wrapped into a loop, which runs as long as a new flag variable
+ * is set, and every tail call is replaced by the assignment of its arguments to the parameters followed
+ * by setting the flag. The assignments behave like a parallel assignment: an argument that reads a parameter
+ * assigned before it is saved in a new temporary variable first.
+ *
+ * A reference parameter cannot be redirected to another variable, so a call is only replaced if it passes every
+ * reference parameter on to itself, like the k in "ackermann(i - 1, a, k)". The aliasing is the same then.
+ * Passing a local variable by reference would additionally let the next iteration see the variables of
+ * the previous one.
+ *
+ * The new variables get names which are no valid identifiers in SPL. The pass has to run after the semantic
+ * analysis.
+ *
+ * @param program The program whose tail calls are eliminated.
+ * @param globalTable The symbol table for the current program.
+ * @param showReport Whether every recursive tail call should be printed.
+ * @return The number of eliminated calls.
+ */
+int eliminateTailCalls(Program *program, SymbolTable *globalTable, bool showReport);
+
+#endif /* _TAILCALL_H_ */
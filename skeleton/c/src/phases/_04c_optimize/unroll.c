@@ -0,0 +1,446 @@
+/*
+ * unroll.c -- unrolling of counted loops
+ */
+
+#include <stdio.h>
+#include <limits.h>
+#include <util/errors.h>
+#include <absyn/absyn.h>
+#include <table/table.h>
+#include <types/types.h>
+#include "estimate.h"
+#include "unroll.h"
+#include "profile.h"
+
+/**
+ * The parameters of a loop like "i := start; while (i < limit) { ...; i := i + step; }".
+ */
+typedef struct {
+    Identifier *variable;
+    int start;
+    int step;
+    int iterations;
+    StatementList *body;        /* the statements of the body in front of the increment */
+    Statement *increment;
+} CountedLoop;
+
+static SymbolTable *procedures;
+static SymbolTable *localTable;
+static int unrollFactor;
+static int numUnrolled;
+static bool reportLoops;
+
+/*
+ * Counted loops
+ */
+
+static bool isNamed(Expression *expression, Identifier *name) {
+    return expression->kind == EXPRESSION_VARIABLEEXPRESSION &&
+           expression->u.variableExpression.variable->kind == VARIABLE_NAMEDVARIABLE &&
+           expression->u.variableExpression.variable->u.namedVariable.name == name;
+}
+
+static bool isAssigned(Statement *statement, Identifier *name);
+
+static bool isAssignedInList(StatementList *statements, Identifier *name) {
+    for (; !statements->isEmpty; statements = statements->tail) {
+        if (isAssigned(statements->head, name)) return true;
+    }
+    return false;
+}
+
+/**
+ * Checks whether a statement assigns a variable or passes it to a reference parameter.
+ */
+static bool isAssigned(Statement *statement, Identifier *name) {
+    ParamTypes *paramTypes;
+    ExpressionList *arguments;
+    Variable *target;
+
+    switch (statement->kind) {
+        case STATEMENT_COMPOUNDSTATEMENT:
+            return isAssignedInList(statement->u.compoundStatement.statements, name);
+        case STATEMENT_ASSIGNSTATEMENT:
+            target = statement->u.assignStatement.target;
+            return target->kind == VARIABLE_NAMEDVARIABLE && target->u.namedVariable.name == name;
+        case STATEMENT_IFSTATEMENT:
+            return isAssigned(statement->u.ifStatement.thenPart, name) ||
+                   isAssigned(statement->u.ifStatement.elsePart, name);
+        case STATEMENT_WHILESTATEMENT:
+            return isAssigned(statement->u.whileStatement.body, name);
+        case STATEMENT_CALLSTATEMENT:
+            paramTypes = lookup(procedures, statement->u.callStatement.procedureName)->u.procEntry.paramTypes;
+            arguments = statement->u.callStatement.argumentList;
+            for (; !arguments->isEmpty && !paramTypes->isEmpty; arguments = arguments->tail, paramTypes = paramTypes->next) {
+                if (paramTypes->isRef && isNamed(arguments->head, name)) return true;
+            }
+            return false;
+        default:
+            return false;
+    }
+}
+
+/**
+ * Computes the number of iterations of "i := start; while (i op limit) ... i := i + step".
+ * @return The number of iterations, or -1 if it is unknown or i would overflow.
+ */
+static long long countIterations(binary_operator operator, long long start, long long limit, long long step) {
+    long long iterations;
+
+    switch (operator) {
+        case ABSYN_OP_LST:
+            if (step <= 0) return -1;
+            iterations = start < limit ? (limit - start + step - 1) / step : 0;
+            break;
+        case ABSYN_OP_LSE:
+            if (step <= 0) return -1;
+            iterations = start <= limit ? (limit - start) / step + 1 : 0;
+            break;
+        case ABSYN_OP_GRT:
+            if (step >= 0) return -1;
+            iterations = start > limit ? (start - limit - step - 1) / -step : 0;
+            break;
+        case ABSYN_OP_GRE:
+            if (step >= 0) return -1;
+            iterations = start >= limit ? (start - limit) / -step + 1 : 0;
+            break;
+        case ABSYN_OP_NEQ:
+            if ((limit - start) % step != 0 || (limit - start) / step < 0) return -1;
+            iterations = (limit - start) / step;
+            break;
+        default:
+            return -1;
+    }
+    if (start + iterations * step < INT_MIN || start + iterations * step > INT_MAX) return -1;
+    return iterations;
+}
+
+static bool findCountedLoop(Statement *initialization, Statement *loop, CountedLoop *counted) {
+    StatementList *statements, **last;
+    Expression *condition, *increment;
+    Identifier *name;
+    Entry *entry;
+    long long iterations;
+    int step;
+
+    if (initialization->kind != STATEMENT_ASSIGNSTATEMENT ||
+        initialization->u.assignStatement.target->kind != VARIABLE_NAMEDVARIABLE ||
+        initialization->u.assignStatement.value->kind != EXPRESSION_INTLITERAL) return false;
+    name = initialization->u.assignStatement.target->u.namedVariable.name;
+    entry = lookup(localTable, name);
+    if (entry->u.varEntry.isRef || entry->u.varEntry.type != intType) return false;
+
+    condition = loop->u.whileStatement.condition;
+    if (condition->kind != EXPRESSION_BINARYEXPRESSION || !isNamed(condition->u.binaryExpression.leftOperand, name) ||
+        condition->u.binaryExpression.rightOperand->kind != EXPRESSION_INTLITERAL) return false;
+
+    if (loop->u.whileStatement.body->kind != STATEMENT_COMPOUNDSTATEMENT) return false;
+    statements = loop->u.whileStatement.body->u.compoundStatement.statements;
+    if (statements->isEmpty) return false;
+    while (!statements->tail->isEmpty) statements = statements->tail;
+    counted->increment = statements->head;
+    if (counted->increment->kind != STATEMENT_ASSIGNSTATEMENT ||
+        counted->increment->u.assignStatement.target->kind != VARIABLE_NAMEDVARIABLE ||
+        counted->increment->u.assignStatement.target->u.namedVariable.name != name) return false;
+    increment = counted->increment->u.assignStatement.value;
+    if (increment->kind != EXPRESSION_BINARYEXPRESSION || !isNamed(increment->u.binaryExpression.leftOperand, name) ||
+        increment->u.binaryExpression.rightOperand->kind != EXPRESSION_INTLITERAL) return false;
+    step = increment->u.binaryExpression.rightOperand->u.intLiteral.value;
+    if (increment->u.binaryExpression.operator == ABSYN_OP_SUB) {
+        if (step == INT_MIN) return false;
+        step = -step;
+    } else if (increment->u.binaryExpression.operator != ABSYN_OP_ADD) {
+        return false;
+    }
+    if (step == 0) return false;
+
+    /* the statements in front of the increment must leave i alone */
+    counted->body = emptyStatementList();
+    last = &counted->body;
+    for (statements = loop->u.whileStatement.body->u.compoundStatement.statements; statements->head != counted->increment;
+         statements = statements->tail) {
+        if (isAssigned(statements->head, name)) return false;
+        *last = newStatementList(statements->head, emptyStatementList());
+        last = &(*last)->tail;
+    }
+
+    iterations = countIterations(condition->u.binaryExpression.operator,
+                                 initialization->u.assignStatement.value->u.intLiteral.value,
+                                 condition->u.binaryExpression.rightOperand->u.intLiteral.value, step);
+    if (iterations < 0 || iterations > INT_MAX) return false;
+    counted->variable = name;
+    counted->start = initialization->u.assignStatement.value->u.intLiteral.value;
+    counted->step = step;
+    counted->iterations = (int) iterations;
+    return true;
+}
+
+/*
+ * Copies of the body
+ */
+
+static Expression *intLiteral(int value, int line) {
+    Expression *expression;
+
+    expression = newIntLiteral(line, value);
+    expression->dataType = intType;
+    return expression;
+}
+
+static Variable *namedVariable(Identifier *name, int line) {
+    Variable *variable;
+
+    variable = newNamedVariable(line, name);
+    variable->dataType = intType;
+    return variable;
+}
+
+/**
+ * Creates "i + offset", or just i if the offset is 0.
+ */
+static Expression *offsetVariable(Identifier *name, int offset, int line) {
+    Expression *variable, *sum;
+
+    variable = newVariableExpression(line, namedVariable(name, line));
+    variable->dataType = intType;
+    if (offset == 0) return variable;
+    sum = newBinaryExpression(line, ABSYN_OP_ADD, variable, intLiteral(offset, line));
+    sum->dataType = intType;
+    return sum;
+}
+
+static void replaceInStatement(Statement *statement, Identifier *name, Expression *replacement);
+
+static void replaceInExpression(Expression *expression, Identifier *name, Expression *replacement);
+
+static void replaceInVariable(Variable *variable, Identifier *name, Expression *replacement) {
+    switch (variable->kind) {
+        case VARIABLE_NAMEDVARIABLE:
+            break;
+        case VARIABLE_ARRAYACCESS:
+            replaceInVariable(variable->u.arrayAccess.array, name, replacement);
+            replaceInExpression(variable->u.arrayAccess.index, name, replacement);
+            break;
+        default:
+            error("unknown variable kind %d in replaceInVariable", variable->kind);
+    }
+}
+
+static void replaceInExpression(Expression *expression, Identifier *name, Expression *replacement) {
+    switch (expression->kind) {
+        case EXPRESSION_INTLITERAL:
+            break;
+        case EXPRESSION_VARIABLEEXPRESSION:
+            if (isNamed(expression, name)) {
+                *expression = *copyExpression(replacement);
+            } else {
+                replaceInVariable(expression->u.variableExpression.variable, name, replacement);
+            }
+            break;
+        case EXPRESSION_BINARYEXPRESSION:
+            replaceInExpression(expression->u.binaryExpression.leftOperand, name, replacement);
+            replaceInExpression(expression->u.binaryExpression.rightOperand, name, replacement);
+            break;
+        default:
+            error("unknown expression kind %d in replaceInExpression", expression->kind);
+    }
+}
+
+/**
+ * Replaces every read of a variable within a statement. The variable must not be assigned by it.
+ */
+static void replaceInStatement(Statement *statement, Identifier *name, Expression *replacement) {
+    StatementList *statements;
+    ExpressionList *arguments;
+
+    switch (statement->kind) {
+        case STATEMENT_EMPTYSTATEMENT:
+            break;
+        case STATEMENT_COMPOUNDSTATEMENT:
+            for (statements = statement->u.compoundStatement.statements; !statements->isEmpty;
+                 statements = statements->tail) {
+                replaceInStatement(statements->head, name, replacement);
+            }
+            break;
+        case STATEMENT_ASSIGNSTATEMENT:
+            replaceInVariable(statement->u.assignStatement.target, name, replacement);
+            replaceInExpression(statement->u.assignStatement.value, name, replacement);
+            break;
+        case STATEMENT_IFSTATEMENT:
+            replaceInExpression(statement->u.ifStatement.condition, name, replacement);
+            replaceInStatement(statement->u.ifStatement.thenPart, name, replacement);
+            replaceInStatement(statement->u.ifStatement.elsePart, name, replacement);
+            break;
+        case STATEMENT_WHILESTATEMENT:
+            replaceInExpression(statement->u.whileStatement.condition, name, replacement);
+            replaceInStatement(statement->u.whileStatement.body, name, replacement);
+            break;
+        case STATEMENT_CALLSTATEMENT:
+            for (arguments = statement->u.callStatement.argumentList; !arguments->isEmpty; arguments = arguments->tail) {
+                replaceInExpression(arguments->head, name, replacement);
+            }
+            break;
+        default:
+            error("unknown statement kind %d in replaceInStatement", statement->kind);
+    }
+}
+
+/**
+ * Appends a copy of the body to a list, with i replaced by the given expression.
+ */
+static StatementList **appendBody(StatementList **last, CountedLoop *counted, Expression *replacement, int line) {
+    Statement *copy;
+
+    copy = newCompoundStatement(line, copyStatementList(counted->body));
+    replaceInStatement(copy, counted->variable, replacement);
+    *last = newStatementList(copy, emptyStatementList());
+    return &(*last)->tail;
+}
+
+static void unrollCompletely(Statement *loop, CountedLoop *counted) {
+    StatementList *statements, **last;
+    int line, k;
+
+    line = loop->line;
+    statements = emptyStatementList();
+    last = &statements;
+    for (k = 0; k < counted->iterations; k++) {
+        last = appendBody(last, counted, intLiteral(counted->start + k * counted->step, line), line);
+    }
+    *last = newStatementList(newAssignStatement(line, namedVariable(counted->variable, line),
+                                                intLiteral(counted->start + counted->iterations * counted->step, line)),
+                             emptyStatementList());
+    *loop = *newCompoundStatement(line, statements);
+}
+
+static void unrollPartially(Statement *loop, CountedLoop *counted) {
+    StatementList *statements, **last;
+    Statement *remainder, *unrolled;
+    Expression *condition, *increment;
+    int line, limit, k;
+
+    line = loop->line;
+    statements = emptyStatementList();
+    last = &statements;
+    for (k = 0; k < unrollFactor; k++) {
+        last = appendBody(last, counted, offsetVariable(counted->variable, k * counted->step, line), line);
+    }
+    increment = offsetVariable(counted->variable, unrollFactor * counted->step, line);
+    *last = newStatementList(newAssignStatement(line, namedVariable(counted->variable, line), increment),
+                             emptyStatementList());
+
+    limit = counted->start + counted->iterations / unrollFactor * unrollFactor * counted->step;
+    condition = newBinaryExpression(line, counted->step > 0 ? ABSYN_OP_LST : ABSYN_OP_GRT,
+                                    offsetVariable(counted->variable, 0, line), intLiteral(limit, line));
+    condition->dataType = boolType;
+    unrolled = newWhileStatement(line, condition, newCompoundStatement(line, statements));
+
+    if (counted->iterations % unrollFactor == 0) {
+        *loop = *unrolled;
+        return;
+    }
+    remainder = newWhileStatement(line, loop->u.whileStatement.condition, loop->u.whileStatement.body);
+    remainder->profileCounter = loop->profileCounter;
+    *loop = *newCompoundStatement(line, newStatementList(unrolled, newStatementList(remainder, emptyStatementList())));
+}
+
+/*
+ * Loops
+ */
+
+/**
+ * Unrolls a counted loop if its copies are small enough, and prints the estimated effect.
+ */
+static void unrollLoop(Statement *loop, CountedLoop *counted) {
+    int body, overhead, iterations, copies, limit, remainder, sizeBefore, sizeAfter, executedBefore, executedAfter;
+
+    iterations = counted->iterations;
+    if (isColdProfileCounter(loop, 0)) {
+        if (reportLoops) printf("loop in line %d: not unrolled, never executed in the profile\n", loop->line);
+        return;
+    }
+    copies = iterations <= unrollFactor ? iterations : unrollFactor;
+    limit = isHotProfileCounter(loop, 0) ? 2 * MAX_UNROLLED_SIZE : MAX_UNROLLED_SIZE;
+    if (copies * statementListSize(counted->body) > limit) {
+        if (reportLoops) printf("loop in line %d: not unrolled, body too large\n", loop->line);
+        return;
+    }
+
+    /* the test, the increment and the jump back are executed in every iteration */
+    body = listInstructions(counted->body);
+    overhead = expressionInstructions(loop->u.whileStatement.condition) + 1 +
+               statementInstructions(counted->increment) + 1;
+    sizeBefore = body + overhead;
+    executedBefore = iterations * (body + overhead) + overhead;
+    if (iterations <= unrollFactor) {
+        sizeAfter = iterations * body + 2;
+        executedAfter = sizeAfter;
+        unrollCompletely(loop, counted);
+        if (reportLoops) printf("loop in line %d: unrolled completely, iterations = %d", loop->line, iterations);
+    } else {
+        remainder = iterations % unrollFactor;
+        sizeAfter = unrollFactor * body + overhead + (remainder > 0 ? sizeBefore : 0);
+        executedAfter = iterations / unrollFactor * (unrollFactor * body + overhead) + overhead +
+                        (remainder > 0 ? remainder * (body + overhead) + overhead : 0);
+        unrollPartially(loop, counted);
+        if (reportLoops) printf("loop in line %d: unrolled %d times, iterations = %d, remainder = %d",
+                                loop->line, unrollFactor, iterations, remainder);
+    }
+    if (reportLoops) printf(", code size = %d -> %d instructions, executed instructions = %d -> %d\n",
+                            sizeBefore, sizeAfter, executedBefore, executedAfter);
+    numUnrolled++;
+}
+
+static void unrollStatement(Statement *statement);
+
+static void unrollStatementList(StatementList *statements) {
+    Statement *previous;
+    CountedLoop counted;
+
+    for (previous = NULL; !statements->isEmpty; previous = statements->head, statements = statements->tail) {
+        unrollStatement(statements->head);
+        if (statements->head->kind != STATEMENT_WHILESTATEMENT) continue;
+        if (previous != NULL && findCountedLoop(previous, statements->head, &counted)) {
+            unrollLoop(statements->head, &counted);
+        } else if (reportLoops) {
+            printf("loop in line %d: not unrolled, no counted loop\n", statements->head->line);
+        }
+    }
+}
+
+static void unrollStatement(Statement *statement) {
+    switch (statement->kind) {
+        case STATEMENT_COMPOUNDSTATEMENT:
+            unrollStatementList(statement->u.compoundStatement.statements);
+            break;
+        case STATEMENT_IFSTATEMENT:
+            unrollStatement(statement->u.ifStatement.thenPart);
+            unrollStatement(statement->u.ifStatement.elsePart);
+            break;
+        case STATEMENT_WHILESTATEMENT:
+            unrollStatement(statement->u.whileStatement.body);
+            break;
+        default:
+            break;
+    }
+}
+
+int unrollLoops(Program *program, SymbolTable *globalTable, int factor, bool showReport) {
+    GlobalDeclarationList *declarationList;
+    GlobalDeclaration *declaration;
+
+    numUnrolled = 0;
+    if (factor < 2) return 0;
+    unrollFactor = factor;
+    reportLoops = showReport;
+    procedures = globalTable;
+    for (declarationList = program; !declarationList->isEmpty; declarationList = declarationList->tail) {
+        declaration = declarationList->head;
+        if (declaration->kind != DECLARATION_PROCEDUREDECLARATION) continue;
+
+        localTable = lookup(globalTable, declaration->name)->u.procEntry.localTable;
+        if (showReport) printf("\nLoop unrolling for procedure '%s'\n", declaration->name->string);
+        unrollStatementList(declaration->u.procedureDeclaration.body);
+    }
+    return numUnrolled;
+}
@@ -0,0 +1,43 @@
+/*
+ * unroll.h -- unrolling of counted loops
+ */
+
+
+#ifndef _UNROLL_H_
+#define _UNROLL_H_
+
+#include <absyn/absyn.h>
+#include <table/table.h>
+
+#define DEFAULT_UNROLL_FACTOR 4     /* used with -O2 */
+#define MAX_UNROLLED_SIZE 400       /* nodes of the abstract syntax tree all copies of a body may have */
+
+/**
+ * This function unrolls loops whose number of iterations is known at compile time.
+ *
+ * A counted loop looks like "i := a; while (i < b) { ...; i := i + c; }", where a, b and c are constants,
+ * the comparison is one of <, <=, >, >= or #, and i is a local variable or value parameter of type int.
+ * The increment must be the last statement of the body, and i must neither be assigned elsewhere in the body
+ * nor passed to a reference parameter.
+ *
+ * A loop with at most factor iterations is unrolled completely: it is replaced by one copy of the body per
+ * iteration, in which i is replaced by its value, followed by the assignment of the final value to i.
+ * A loop with more iterations is unrolled partially: a new loop in front of it executes factor copies of the body
+ * per iteration, using i, i + c, i + 2 * c and so on, and increments i by factor * c once. The original loop
+ * stays behind it as the remainder loop, unless the number of iterations is a multiple of the factor.
+ * All copies of a body together may not exceed MAX_UNROLLED_SIZE nodes. With a profile, the limit is doubled
+ * for hot loops, and loops whose body has never been executed are not unrolled.
+ *
+ * The constant indices of the copies are folded afterwards, so the bounds checks of accesses like a[0]
+ * can be removed. The pass has to run after the semantic analysis.
+ *
+ * @param program The program whose loops are unrolled.
+ * @param globalTable The symbol table for the current program.
+ * @param factor The largest number of copies of a body, values below 2 disable unrolling.
+ * @param showReport Whether every counted loop should be printed with the code size and the number
+ * of executed instructions before and after unrolling.
+ * @return The number of unrolled loops.
+ */
+int unrollLoops(Program *program, SymbolTable *globalTable, int factor, bool showReport);
+
+#endif /* _UNROLL_H_ */
@@ -0,0 +1,41 @@
+/*
+ * callconv.c -- calling convention passing arguments in registers
+ */
+
+#include <absyn/absyn.h>
+#include <table/table.h>
+#include <types/types.h>
+#include "varalloc.h"
+#include "callconv.h"
+
+int assignArgumentRegisters(Program *program, SymbolTable *globalTable) {
+    GlobalDeclarationList *declarationList;
+    ParamTypes *paramTypes;
+    int assigned, reg;
+
+    assigned = 0;
+    for (declarationList = program; !declarationList->isEmpty; declarationList = declarationList->tail) {
+        if (declarationList->head->kind != DECLARATION_PROCEDUREDECLARATION) continue;
+        paramTypes = lookup(globalTable, declarationList->head->name)->u.procEntry.paramTypes;
+        for (reg = FIRST_ARGUMENT_REGISTER; !paramTypes->isEmpty; paramTypes = paramTypes->next) {
+            if (reg > LAST_ARGUMENT_REGISTER) {
+                paramTypes->reg = 0;
+                continue;
+            }
+            paramTypes->reg = reg++;
+            assigned++;
+        }
+    }
+    return assigned;
+}
+
+int stackArgumentSize(ParamTypes *paramTypes) {
+    int size;
+
+    size = 0;
+    for (; !paramTypes->isEmpty; paramTypes = paramTypes->next) {
+        if (paramTypes->reg != 0) continue;
+        size += paramTypes->isRef ? REF_BYTE_SIZE : paramTypes->type->byteSize;
+    }
+    return size;
+}
@@ -0,0 +1,45 @@
+/*
+ * callconv.h -- calling convention passing arguments in registers
+ */
+
+
+#ifndef _CALLCONV_H_
+#define _CALLCONV_H_
+
+#include <absyn/absyn.h>
+#include <table/table.h>
+
+#define FIRST_ARGUMENT_REGISTER 4       /* the ECO32 argument registers $4..$7 */
+#define LAST_ARGUMENT_REGISTER  7
+
+/**
+ * This function lets the procedures of the program receive their first arguments in registers.
+ *
+ * The first LAST_ARGUMENT_REGISTER - FIRST_ARGUMENT_REGISTER + 1 arguments of every procedure declared in the
+ * program are passed in $4, $5, ... instead of the outgoing area of the caller, value arguments as their value
+ * and reference arguments as their address. The register is stored in the reg field of the ParamTypes,
+ * the remaining arguments keep their stack slot. The predefined procedures of the runtime library are not
+ * declared in the program, so their arguments are still passed on the stack.
+ *
+ * The argument registers are caller-saved and only hold variables whose lifetime contains no call, so
+ * the caller may load them after evaluating all arguments on the expression stack. In the callee, a parameter
+ * stays in its argument register unless it is passed as an argument for a reference parameter or live across
+ * a call, see keepArgumentsInRegisters and allocRegisters. Otherwise its reg field in the VariableEntry is 0
+ * and the prologue stores it to a stack slot in the localvar area.
+ * The pass has to run after the semantic analysis and before the register allocation.
+ *
+ * @param program The program whose calling convention is assigned.
+ * @param globalTable The symbol table for the current program.
+ * @return The number of parameters passed in a register.
+ */
+int assignArgumentRegisters(Program *program, SymbolTable *globalTable);
+
+/**
+ * Computes the size of the arguments of a procedure which are passed on the stack.
+ * The variable allocator uses it as the argument area of the procedure.
+ * @param paramTypes The parameters of the procedure.
+ * @return The size in bytes.
+ */
+int stackArgumentSize(ParamTypes *paramTypes);
+
+#endif /* _CALLCONV_H_ */
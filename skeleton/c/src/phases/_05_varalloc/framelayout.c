@@ -0,0 +1,89 @@
+/*
+ * framelayout.c -- classification and layout of stack frames
+ */
+
+#include <string.h>
+#include <limits.h>
+#include <util/errors.h>
+#include <absyn/absyn.h>
+#include <table/table.h>
+#include <phases/_06_codegen/instrument.h>
+#include "varalloc.h"
+#include "framelayout.h"
+
+#define LEAF_FRAME_INSTRUCTIONS 6       /* sub, stw $25, add $25 and ldw $25, add, jr in the reference compiler */
+#define SP_FRAME_INSTRUCTIONS   3       /* sub and add, jr */
+#define NO_FRAME_INSTRUCTIONS   1       /* jr */
+
+void classifyFrames(Program *program, SymbolTable *globalTable) {
+    GlobalDeclarationList *declarationList;
+    GlobalDeclaration *declaration;
+    Entry *procEntry;
+    bool isLeaf;
+
+    for (declarationList = program; !declarationList->isEmpty; declarationList = declarationList->tail) {
+        declaration = declarationList->head;
+        if (declaration->kind != DECLARATION_PROCEDUREDECLARATION) continue;
+        procEntry = lookup(globalTable, declaration->name);
+        if ((long long) procEntry->u.procEntry.localvarArea + procEntry->u.procEntry.outgoingArea +
+            2 * REF_BYTE_SIZE > INT_MAX) {
+            error("the stack frame of procedure '%s' is too large", declaration->name->string);
+        }
+        isLeaf = !containsCallInList(declaration->u.procedureDeclaration.body) &&
+                 !(numProfileCounters > 0 && strcmp(declaration->name->string, "main") == 0);
+        if (!isLeaf) {
+            procEntry->u.procEntry.frameKind = FRAME_FULL;
+        } else if (procEntry->u.procEntry.localvarArea == 0) {
+            procEntry->u.procEntry.frameKind = FRAME_NONE;
+        } else {
+            procEntry->u.procEntry.frameKind = FRAME_SP_RELATIVE;
+        }
+    }
+}
+
+int frameSize(Entry *procEntry) {
+    switch (procEntry->u.procEntry.frameKind) {
+        case FRAME_FULL:
+            /* outgoing area, return address, old frame pointer and localvar area */
+            return procEntry->u.procEntry.outgoingArea + 2 * REF_BYTE_SIZE + procEntry->u.procEntry.localvarArea;
+        case FRAME_SP_RELATIVE:
+            return procEntry->u.procEntry.localvarArea;
+        case FRAME_NONE:
+            return 0;
+        default:
+            error("unknown frame kind %d in frameSize", procEntry->u.procEntry.frameKind);
+            return 0;
+    }
+}
+
+int frameBaseRegister(Entry *procEntry) {
+    return procEntry->u.procEntry.frameKind == FRAME_FULL ? FRAME_POINTER_REGISTER : STACK_POINTER_REGISTER;
+}
+
+int frameOffset(Entry *procEntry, int offset) {
+    /* without a frame pointer, the frame starts frameSize bytes above the stack pointer */
+    return procEntry->u.procEntry.frameKind == FRAME_FULL ? offset : offset + frameSize(procEntry);
+}
+
+int savedRegisterOffset(Entry *procEntry, int reg) {
+    unsigned below;
+    int slot;
+
+    below = procEntry->u.procEntry.savedRegisters & ((1u << reg) - 1);
+    for (slot = 1; below != 0; below &= below - 1) slot++;
+    return -slot * REF_BYTE_SIZE;
+}
+
+int savedFrameInstructions(Entry *procEntry) {
+    switch (procEntry->u.procEntry.frameKind) {
+        case FRAME_FULL:
+            return 0;
+        case FRAME_SP_RELATIVE:
+            return LEAF_FRAME_INSTRUCTIONS - SP_FRAME_INSTRUCTIONS;
+        case FRAME_NONE:
+            return LEAF_FRAME_INSTRUCTIONS - NO_FRAME_INSTRUCTIONS;
+        default:
+            error("unknown frame kind %d in savedFrameInstructions", procEntry->u.procEntry.frameKind);
+            return 0;
+    }
+}
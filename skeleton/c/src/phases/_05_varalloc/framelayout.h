@@ -0,0 +1,74 @@
+/*
+ * framelayout.h -- classification and layout of stack frames
+ */
+
+
+#ifndef _FRAMELAYOUT_H_
+#define _FRAMELAYOUT_H_
+
+#include <absyn/absyn.h>
+#include <table/table.h>
+
+#define STACK_POINTER_REGISTER   29
+#define FRAME_POINTER_REGISTER   25
+#define RETURN_ADDRESS_REGISTER  31
+
+/**
+ * This function chooses the kind of stack frame of every procedure of the program.
+ *
+ * A procedure calling another one, a predefined one included, gets the full frame: the old frame pointer is saved,
+ * $25 is set to the start of the frame and the return address is saved, since the jal overwrites $31.
+ * A leaf procedure, i.e. one without any call, needs neither the return address nor a frame pointer.
+ * If its localvar area is empty, which requires that its variables are kept in registers, it gets no frame
+ * at all and reads its stack arguments relative to the unchanged stack pointer. Otherwise it only moves the
+ * stack pointer over its localvar area and addresses everything relative to $29.
+ * The main procedure of an instrumented program calls the routine printing the counters, so it is no leaf.
+ *
+ * The result is stored in the frameKind field of the ProcedureEntry. The function has to be called
+ * by the variable allocator after the sizes of all areas are known.
+ *
+ * @param program The program whose procedures are classified.
+ * @param globalTable The symbol table for the current program.
+ */
+void classifyFrames(Program *program, SymbolTable *globalTable);
+
+/**
+ * @param procEntry The ProcedureEntry of a classified procedure.
+ * @return The number of bytes the prologue subtracts from the stack pointer.
+ */
+int frameSize(Entry *procEntry);
+
+/**
+ * @param procEntry The ProcedureEntry of a classified procedure.
+ * @return The register the variables and arguments of the procedure are addressed with, $25 or $29.
+ */
+int frameBaseRegister(Entry *procEntry);
+
+/**
+ * Converts an offset relative to the frame pointer, as computed by the variable allocator,
+ * into one relative to the register returned by frameBaseRegister.
+ * @param procEntry The ProcedureEntry of a classified procedure.
+ * @param offset The offset of a parameter or local variable relative to the start of the frame.
+ * @return The offset relative to the base register.
+ */
+int frameOffset(Entry *procEntry, int offset);
+
+/**
+ * Computes where the prologue saves a callee-saved register used by the procedure.
+ * The saved registers occupy the first words of the localvar area, in ascending order of their numbers.
+ * @param procEntry The ProcedureEntry of a procedure.
+ * @param reg A register set in the savedRegisters field of the ProcedureEntry.
+ * @return The offset of the slot relative to the start of the frame.
+ */
+int savedRegisterOffset(Entry *procEntry, int reg);
+
+/**
+ * Counts the instructions of prologue and epilogue saved by the kind of frame, compared with the frame
+ * of the reference compiler, which sets up the frame pointer even for leaf procedures.
+ * The code saving and restoring callee-saved registers is not affected and not counted.
+ * @param procEntry The ProcedureEntry of a classified procedure.
+ * @return The number of instructions saved per call.
+ */
+int savedFrameInstructions(Entry *procEntry);
+
+#endif /* _FRAMELAYOUT_H_ */
@@ -0,0 +1,621 @@
+/*
+ * regalloc.c -- register allocation for scalar variables
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <util/errors.h>
+#include <util/memory.h>
+#include <absyn/absyn.h>
+#include <table/table.h>
+#include <types/types.h>
+#include <phases/_04c_optimize/profile.h>
+#include "regalloc.h"
+
+#define MAX_LOOP_WEIGHT 10000
+
+/**
+ * The live interval of a candidate variable.
+ * Positions are numbered in the order the statements appear in the procedure body.
+ */
+typedef struct {
+    Entry *entry;
+    int start;          /* -1 as long as the variable has not been seen */
+    int end;
+    int weight;         /* number of uses and definitions, weighted by the loop depth */
+    bool crossesCall;
+    bool excluded;      /* the variable is passed as a reference argument */
+    int argumentRegister;   /* the register a parameter arrives in, 0 if it is passed on the stack */
+} Interval;
+
+int lastExpressionRegister = LAST_CALLEE_SAVED_REGISTER;
+
+static SymbolTable *procedures;
+static SymbolTable *localTable;
+static Interval *intervals;
+static int numIntervals;
+static int *callPositions;
+static int numCalls;
+static int maxCalls;
+static long long procedureCalls;     /* calls of the current procedure in the profile, -1 without a profile */
+
+static int findInterval(Variable *variable) {
+    Entry *entry;
+    int i;
+
+    if (variable->kind != VARIABLE_NAMEDVARIABLE) return -1;
+    entry = lookup(localTable, variable->u.namedVariable.name);
+    for (i = 0; i < numIntervals; i++) {
+        if (intervals[i].entry == entry) return i;
+    }
+    return -1;
+}
+
+/*
+ * Sets of candidate variables, represented as one flag per interval.
+ */
+
+static bool *newSet(void) {
+    bool *set = allocate(numIntervals * sizeof(bool) + 1);
+
+    memset(set, 0, numIntervals * sizeof(bool) + 1);
+    return set;
+}
+
+static bool *copySet(bool *set) {
+    bool *copy = newSet();
+
+    memcpy(copy, set, numIntervals * sizeof(bool));
+    return copy;
+}
+
+static void unionSet(bool *target, bool *source) {
+    int i;
+
+    for (i = 0; i < numIntervals; i++) {
+        target[i] = target[i] || source[i];
+    }
+}
+
+static bool equalSets(bool *left, bool *right) {
+    return memcmp(left, right, numIntervals * sizeof(bool)) == 0;
+}
+
+/*
+ * Collecting the uses of variables
+ */
+
+static void addUsesOfExpression(Expression *expression, bool *set);
+
+static void addUsesOfVariable(Variable *variable, bool *set) {
+    int i;
+
+    switch (variable->kind) {
+        case VARIABLE_NAMEDVARIABLE:
+            i = findInterval(variable);
+            if (i >= 0) set[i] = true;
+            break;
+        case VARIABLE_ARRAYACCESS:
+            addUsesOfVariable(variable->u.arrayAccess.array, set);
+            addUsesOfExpression(variable->u.arrayAccess.index, set);
+            break;
+        default:
+            error("unknown variable kind %d in addUsesOfVariable", variable->kind);
+    }
+}
+
+static void addUsesOfExpression(Expression *expression, bool *set) {
+    switch (expression->kind) {
+        case EXPRESSION_INTLITERAL:
+            break;
+        case EXPRESSION_VARIABLEEXPRESSION:
+            addUsesOfVariable(expression->u.variableExpression.variable, set);
+            break;
+        case EXPRESSION_BINARYEXPRESSION:
+            addUsesOfExpression(expression->u.binaryExpression.leftOperand, set);
+            addUsesOfExpression(expression->u.binaryExpression.rightOperand, set);
+            break;
+        default:
+            error("unknown expression kind %d in addUsesOfExpression", expression->kind);
+    }
+}
+
+static void addUsesOfArguments(ExpressionList *arguments, bool *set) {
+    while (!arguments->isEmpty) {
+        addUsesOfExpression(arguments->head, set);
+        arguments = arguments->tail;
+    }
+}
+
+/**
+ * Adds the variables read by the target of an assignment, i.e. the variables in its index expressions,
+ * or a reference parameter, whose register holds the address the value is stored to.
+ */
+static void addUsesOfTarget(Variable *target, bool *set) {
+    int i;
+
+    if (target->kind == VARIABLE_ARRAYACCESS) {
+        addUsesOfVariable(target, set);
+        return;
+    }
+    i = findInterval(target);
+    if (i >= 0 && intervals[i].entry->u.varEntry.isRef) set[i] = true;
+}
+
+/*
+ * Exclusion of variables passed by reference
+ */
+
+static void excludeReferenceArguments(Statement *statement);
+
+static void excludeReferenceArgumentsOfList(StatementList *statements) {
+    while (!statements->isEmpty) {
+        excludeReferenceArguments(statements->head);
+        statements = statements->tail;
+    }
+}
+
+static void excludeReferenceArguments(Statement *statement) {
+    Entry *procEntry;
+    ParamTypes *paramTypes;
+    ExpressionList *arguments;
+    int i;
+
+    switch (statement->kind) {
+        case STATEMENT_COMPOUNDSTATEMENT:
+            excludeReferenceArgumentsOfList(statement->u.compoundStatement.statements);
+            break;
+        case STATEMENT_IFSTATEMENT:
+            excludeReferenceArguments(statement->u.ifStatement.thenPart);
+            excludeReferenceArguments(statement->u.ifStatement.elsePart);
+            break;
+        case STATEMENT_WHILESTATEMENT:
+            excludeReferenceArguments(statement->u.whileStatement.body);
+            break;
+        case STATEMENT_CALLSTATEMENT:
+            procEntry = lookup(procedures, statement->u.callStatement.procedureName);
+            paramTypes = procEntry->u.procEntry.paramTypes;
+            arguments = statement->u.callStatement.argumentList;
+            while (!arguments->isEmpty && !paramTypes->isEmpty) {
+                if (paramTypes->isRef && arguments->head->kind == EXPRESSION_VARIABLEEXPRESSION) {
+                    /* a reference parameter only passes on the address it holds */
+                    i = findInterval(arguments->head->u.variableExpression.variable);
+                    if (i >= 0 && !intervals[i].entry->u.varEntry.isRef) intervals[i].excluded = true;
+                }
+                arguments = arguments->tail;
+                paramTypes = paramTypes->next;
+            }
+            break;
+        default:
+            break;
+    }
+}
+
+/*
+ * Use counts
+ */
+
+static void countUses(Statement *statement, int loopWeight);
+
+static void addWeight(bool *set, int loopWeight) {
+    int i;
+
+    for (i = 0; i < numIntervals; i++) {
+        if (set[i]) intervals[i].weight += loopWeight;
+    }
+}
+
+static void countUsesOfList(StatementList *statements, int loopWeight) {
+    while (!statements->isEmpty) {
+        countUses(statements->head, loopWeight);
+        statements = statements->tail;
+    }
+}
+
+static void countUses(Statement *statement, int loopWeight) {
+    bool *set = newSet();
+
+    switch (statement->kind) {
+        case STATEMENT_EMPTYSTATEMENT:
+            break;
+        case STATEMENT_COMPOUNDSTATEMENT:
+            countUsesOfList(statement->u.compoundStatement.statements, loopWeight);
+            break;
+        case STATEMENT_ASSIGNSTATEMENT:
+            addUsesOfVariable(statement->u.assignStatement.target, set);
+            addUsesOfExpression(statement->u.assignStatement.value, set);
+            break;
+        case STATEMENT_IFSTATEMENT:
+            addUsesOfExpression(statement->u.ifStatement.condition, set);
+            countUses(statement->u.ifStatement.thenPart,
+                      profileFrequency(statement, PROFILE_THEN, procedureCalls, loopWeight));
+            countUses(statement->u.ifStatement.elsePart,
+                      profileFrequency(statement, PROFILE_ELSE, procedureCalls, loopWeight));
+            break;
+        case STATEMENT_WHILESTATEMENT:
+            if (loopWeight < MAX_LOOP_WEIGHT) loopWeight *= 10;
+            loopWeight = profileFrequency(statement, 0, procedureCalls, loopWeight);
+            addUsesOfExpression(statement->u.whileStatement.condition, set);
+            countUses(statement->u.whileStatement.body, loopWeight);
+            break;
+        case STATEMENT_CALLSTATEMENT:
+            addUsesOfArguments(statement->u.callStatement.argumentList, set);
+            break;
+        default:
+            error("unknown statement kind %d in countUses", statement->kind);
+    }
+    addWeight(set, loopWeight);
+    release(set);
+}
+
+/*
+ * Liveness analysis
+ */
+
+static int countPositions(Statement *statement);
+
+static int countPositionsOfList(StatementList *statements) {
+    int positions = 0;
+
+    while (!statements->isEmpty) {
+        positions += countPositions(statements->head);
+        statements = statements->tail;
+    }
+    return positions;
+}
+
+/**
+ * Returns the number of positions occupied by a statement.
+ * Conditions and simple statements occupy one position, while-statements an additional one for the jump back.
+ */
+static int countPositions(Statement *statement) {
+    switch (statement->kind) {
+        case STATEMENT_EMPTYSTATEMENT:
+            return 0;
+        case STATEMENT_COMPOUNDSTATEMENT:
+            return countPositionsOfList(statement->u.compoundStatement.statements);
+        case STATEMENT_ASSIGNSTATEMENT:
+        case STATEMENT_CALLSTATEMENT:
+            return 1;
+        case STATEMENT_IFSTATEMENT:
+            return 1 + countPositions(statement->u.ifStatement.thenPart) +
+                   countPositions(statement->u.ifStatement.elsePart);
+        case STATEMENT_WHILESTATEMENT:
+            return 2 + countPositions(statement->u.whileStatement.body);
+        default:
+            error("unknown statement kind %d in countPositions", statement->kind);
+            return 0;
+    }
+}
+
+/**
+ * Extends the intervals of all variables in the set, so they contain the given position.
+ */
+static void markLive(int position, bool *set) {
+    int i;
+
+    for (i = 0; i < numIntervals; i++) {
+        if (!set[i]) continue;
+        if (intervals[i].start < 0 || position < intervals[i].start) intervals[i].start = position;
+        if (position > intervals[i].end) intervals[i].end = position;
+    }
+}
+
+static void recordCall(int position) {
+    int i;
+
+    for (i = 0; i < numCalls; i++) {
+        if (callPositions[i] == position) return;
+    }
+    if (numCalls == maxCalls) {
+        int *newPositions;
+
+        maxCalls = maxCalls == 0 ? 16 : 2 * maxCalls;
+        newPositions = allocate(maxCalls * sizeof(int));
+        if (numCalls > 0) {
+            memcpy(newPositions, callPositions, numCalls * sizeof(int));
+            release(callPositions);
+        }
+        callPositions = newPositions;
+    }
+    callPositions[numCalls++] = position;
+}
+
+static bool *analyzeStatement(Statement *statement, int position, bool *liveOut);
+
+static bool *analyzeList(StatementList *statements, int position, bool *liveOut) {
+    bool *liveIn;
+
+    if (statements->isEmpty) return copySet(liveOut);
+    liveOut = analyzeList(statements->tail, position + countPositions(statements->head), liveOut);
+    liveIn = analyzeStatement(statements->head, position, liveOut);
+    release(liveOut);
+    return liveIn;
+}
+
+/**
+ * Computes the set of variables live before a statement, given the set of variables live after it.
+ * Along the way the intervals of all variables are extended to the positions where they are live.
+ */
+static bool *analyzeStatement(Statement *statement, int position, bool *liveOut) {
+    bool *liveIn, *thenIn, *elseIn, *bodyIn, *head;
+    int i;
+
+    switch (statement->kind) {
+        case STATEMENT_EMPTYSTATEMENT:
+            return copySet(liveOut);
+        case STATEMENT_COMPOUNDSTATEMENT:
+            return analyzeList(statement->u.compoundStatement.statements, position, liveOut);
+        case STATEMENT_ASSIGNSTATEMENT:
+            liveIn = copySet(liveOut);
+            i = findInterval(statement->u.assignStatement.target);
+            /* an assignment to a reference parameter does not change the address in its register */
+            if (i >= 0 && intervals[i].entry->u.varEntry.isRef) i = -1;
+            if (i >= 0) liveIn[i] = false;
+            addUsesOfTarget(statement->u.assignStatement.target, liveIn);
+            addUsesOfExpression(statement->u.assignStatement.value, liveIn);
+            markLive(position, liveIn);
+            markLive(position, liveOut);
+            if (i >= 0) {
+                /* a dead definition still needs its register at this position */
+                bool *def = newSet();
+                def[i] = true;
+                markLive(position, def);
+                release(def);
+            }
+            return liveIn;
+        case STATEMENT_CALLSTATEMENT:
+            liveIn = copySet(liveOut);
+            addUsesOfArguments(statement->u.callStatement.argumentList, liveIn);
+            markLive(position, liveIn);
+            recordCall(position);
+            return liveIn;
+        case STATEMENT_IFSTATEMENT:
+            thenIn = analyzeStatement(statement->u.ifStatement.thenPart, position + 1, liveOut);
+            elseIn = analyzeStatement(statement->u.ifStatement.elsePart,
+                                      position + 1 + countPositions(statement->u.ifStatement.thenPart),
+                                      liveOut);
+            liveIn = thenIn;
+            unionSet(liveIn, elseIn);
+            release(elseIn);
+            addUsesOfExpression(statement->u.ifStatement.condition, liveIn);
+            markLive(position, liveIn);
+            return liveIn;
+        case STATEMENT_WHILESTATEMENT:
+            /* iterate until the set of variables live at the loop head is stable */
+            head = copySet(liveOut);
+            addUsesOfExpression(statement->u.whileStatement.condition, head);
+            while (true) {
+                bodyIn = analyzeStatement(statement->u.whileStatement.body, position + 1, head);
+                unionSet(bodyIn, head);
+                if (equalSets(bodyIn, head)) {
+                    release(bodyIn);
+                    break;
+                }
+                release(head);
+                head = bodyIn;
+            }
+            markLive(position, head);
+            markLive(position + 1 + countPositions(statement->u.whileStatement.body), head);
+            return head;
+        default:
+            error("unknown statement kind %d in analyzeStatement", statement->kind);
+            return NULL;
+    }
+}
+
+/*
+ * Linear scan
+ */
+
+static int compareStarts(const void *left, const void *right) {
+    const Interval *l = *(const Interval **) left;
+    const Interval *r = *(const Interval **) right;
+
+    if (l->start != r->start) return l->start - r->start;
+    /* parameters claim the registers they arrive in before anything else starting at the entry */
+    if ((l->argumentRegister != 0) != (r->argumentRegister != 0)) return l->argumentRegister != 0 ? -1 : 1;
+    return r->weight - l->weight;
+}
+
+static bool isAllowed(Interval *interval, int reg) {
+    if (reg >= FIRST_CALLEE_SAVED_REGISTER && reg <= LAST_CALLEE_SAVED_REGISTER) {
+        /* saving and restoring costs two memory accesses per activation */
+        return interval->weight > 2;
+    }
+    /* moving a parameter between argument registers could overwrite another one not moved yet */
+    if (interval->argumentRegister != 0 && reg != interval->argumentRegister) return false;
+    return !interval->crossesCall;
+}
+
+static int findFreeRegister(Interval *interval, Interval **owners) {
+    int reg;
+
+    for (reg = FIRST_CALLER_SAVED_REGISTER; reg <= LAST_CALLER_SAVED_REGISTER; reg++) {
+        if (owners[reg] == NULL && isAllowed(interval, reg)) return reg;
+    }
+    for (reg = FIRST_CALLEE_SAVED_REGISTER; reg <= LAST_CALLEE_SAVED_REGISTER; reg++) {
+        if (owners[reg] == NULL && isAllowed(interval, reg)) return reg;
+    }
+    return 0;
+}
+
+/**
+ * Finds the register held by the active interval with the lowest weight, that could be given to the interval.
+ */
+static int findSpillCandidate(Interval *interval, Interval **owners) {
+    int reg, best;
+
+    best = 0;
+    for (reg = FIRST_CALLER_SAVED_REGISTER; reg <= LAST_CALLEE_SAVED_REGISTER; reg++) {
+        if (owners[reg] == NULL || !isAllowed(interval, reg)) continue;
+        if (best == 0 || owners[reg]->weight < owners[best]->weight) best = reg;
+    }
+    return best;
+}
+
+static int linearScan(Entry *procEntry) {
+    Interval **sorted;
+    Interval *owners[32];
+    int numSorted, allocated, i, reg;
+
+    sorted = allocate((numIntervals + 1) * sizeof(Interval *));
+    numSorted = 0;
+    for (i = 0; i < numIntervals; i++) {
+        if (!intervals[i].excluded && intervals[i].start >= 0) sorted[numSorted++] = &intervals[i];
+    }
+    qsort(sorted, numSorted, sizeof(Interval *), compareStarts);
+
+    /* a parameter which is never used can stay in its argument register without any cost */
+    for (i = 0; i < numIntervals; i++) {
+        if (intervals[i].start < 0) intervals[i].entry->u.varEntry.reg = intervals[i].argumentRegister;
+    }
+
+    memset(owners, 0, sizeof(owners));
+    allocated = 0;
+    for (i = 0; i < numSorted; i++) {
+        /* expire all intervals that ended before the current one starts */
+        for (reg = 0; reg < 32; reg++) {
+            if (owners[reg] != NULL && owners[reg]->end < sorted[i]->start) owners[reg] = NULL;
+        }
+
+        reg = findFreeRegister(sorted[i], owners);
+        if (reg == 0) {
+            reg = findSpillCandidate(sorted[i], owners);
+            if (reg == 0 || owners[reg]->weight >= sorted[i]->weight) continue;
+            owners[reg]->entry->u.varEntry.reg = 0;
+            allocated--;
+        }
+
+        owners[reg] = sorted[i];
+        sorted[i]->entry->u.varEntry.reg = reg;
+        allocated++;
+        if (reg >= FIRST_CALLEE_SAVED_REGISTER) procEntry->u.procEntry.savedRegisters |= 1u << reg;
+    }
+    release(sorted);
+    return allocated;
+}
+
+/**
+ * Adds a variable to the candidates. A reference parameter is only a candidate if its address arrives in
+ * an argument register, the register then holds the address.
+ */
+static void addCandidate(Identifier *name, int argumentRegister) {
+    Entry *entry = lookup(localTable, name);
+
+    if (entry->kind != ENTRY_KIND_VAR) return;
+    if (entry->u.varEntry.isRef ? argumentRegister == 0 : entry->u.varEntry.type != intType) return;
+    entry->u.varEntry.reg = 0;
+    intervals[numIntervals].entry = entry;
+    intervals[numIntervals].start = -1;
+    intervals[numIntervals].end = -1;
+    intervals[numIntervals].weight = 0;
+    intervals[numIntervals].crossesCall = false;
+    intervals[numIntervals].excluded = false;
+    intervals[numIntervals].argumentRegister = argumentRegister;
+    numIntervals++;
+}
+
+/**
+ * Keeps the parameters which arrive in an argument register, are not passed as a reference argument
+ * and are not live across a call in their argument register. All other candidates stay in memory.
+ */
+static int keepArguments(void) {
+    int kept, i;
+
+    kept = 0;
+    for (i = 0; i < numIntervals; i++) {
+        if (intervals[i].argumentRegister == 0 || intervals[i].excluded || intervals[i].crossesCall) continue;
+        intervals[i].entry->u.varEntry.reg = intervals[i].argumentRegister;
+        kept++;
+    }
+    return kept;
+}
+
+static int allocProcedureRegisters(GlobalDeclaration *procDec, bool argumentsOnly) {
+    Entry *procEntry;
+    ParamTypes *paramTypes;
+    ParameterList *parameters;
+    VariableDeclarationList *variables;
+    StatementList *body;
+    bool *liveOut, *liveIn;
+    int count, i, j;
+
+    procEntry = lookup(procedures, procDec->name);
+    localTable = procEntry->u.procEntry.localTable;
+    if (!argumentsOnly) procEntry->u.procEntry.savedRegisters = 0;
+    parameters = procDec->u.procedureDeclaration.parameters;
+    variables = procDec->u.procedureDeclaration.variables;
+    body = procDec->u.procedureDeclaration.body;
+
+    count = 0;
+    for (; !parameters->isEmpty; parameters = parameters->tail) count++;
+    for (; !variables->isEmpty; variables = variables->tail) count++;
+    intervals = allocate((count + 1) * sizeof(Interval));
+    numIntervals = 0;
+    paramTypes = procEntry->u.procEntry.paramTypes;
+    for (parameters = procDec->u.procedureDeclaration.parameters; !parameters->isEmpty; parameters = parameters->tail) {
+        addCandidate(parameters->head->name, paramTypes->reg);
+        paramTypes = paramTypes->next;
+    }
+    if (!argumentsOnly) {
+        for (variables = procDec->u.procedureDeclaration.variables; !variables->isEmpty; variables = variables->tail) {
+            addCandidate(variables->head->name, 0);
+        }
+    }
+
+    excludeReferenceArgumentsOfList(body);
+    procedureCalls = procedureProfileCount(procDec->name);
+    countUsesOfList(body, 1);
+
+    numCalls = 0;
+    liveOut = newSet();
+    liveIn = analyzeList(body, 0, liveOut);
+    release(liveOut);
+    release(liveIn);
+
+    for (i = 0; i < numIntervals; i++) {
+        for (j = 0; j < numCalls; j++) {
+            if (intervals[i].start <= callPositions[j] && callPositions[j] <= intervals[i].end) {
+                intervals[i].crossesCall = true;
+            }
+        }
+    }
+
+    count = argumentsOnly ? keepArguments() : linearScan(procEntry);
+    release(intervals);
+    return count;
+}
+
+int allocRegisters(Program *program, SymbolTable *globalTable) {
+    GlobalDeclarationList *declarationList;
+    int allocated;
+
+    procedures = globalTable;
+    lastExpressionRegister = LAST_TEMPORARY_REGISTER;
+    allocated = 0;
+    declarationList = program;
+    while (!declarationList->isEmpty) {
+        if (declarationList->head->kind == DECLARATION_PROCEDUREDECLARATION) {
+            allocated += allocProcedureRegisters(declarationList->head, false);
+        }
+        declarationList = declarationList->tail;
+    }
+    return allocated;
+}
+
+int keepArgumentsInRegisters(Program *program, SymbolTable *globalTable) {
+    GlobalDeclarationList *declarationList;
+    int kept;
+
+    procedures = globalTable;
+    kept = 0;
+    declarationList = program;
+    while (!declarationList->isEmpty) {
+        if (declarationList->head->kind == DECLARATION_PROCEDUREDECLARATION) {
+            kept += allocProcedureRegisters(declarationList->head, true);
+        }
+        declarationList = declarationList->tail;
+    }
+    return kept;
+}
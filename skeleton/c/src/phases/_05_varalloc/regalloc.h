@@ -0,0 +1,62 @@
+/*
+ * regalloc.h -- register allocation for scalar variables
+ */
+
+
+#ifndef _REGALLOC_H_
+#define _REGALLOC_H_
+
+#include <absyn/absyn.h>
+#include <table/table.h>
+
+#define FIRST_CALLER_SAVED_REGISTER 4     /* usable for variables whose lifetime contains no call */
+#define LAST_CALLER_SAVED_REGISTER  7
+#define FIRST_CALLEE_SAVED_REGISTER 16    /* have to be saved in the prologue of a procedure using them */
+#define LAST_CALLEE_SAVED_REGISTER  23
+#define FIRST_TEMPORARY_REGISTER    8     /* first register of the expression stack */
+#define LAST_TEMPORARY_REGISTER     15    /* the expression stack is limited to $8..$15 when registers are allocated */
+
+/**
+ * The highest register the expression stack may use.
+ * It is lowered to LAST_TEMPORARY_REGISTER by allocRegisters, since the registers above may hold variables then.
+ */
+extern int lastExpressionRegister;
+
+/**
+ * This function keeps scalar variables of every procedure in registers instead of their stack slots.
+ *
+ * Candidates are local variables and value parameters of type int, that are never passed as an argument
+ * for a reference parameter, and reference parameters arriving in an argument register, whose register
+ * then holds the address. A parameter arriving in an argument register is either kept there, moved to
+ * a callee-saved register or stored to a stack slot, it is never moved to another argument register.
+ * The allocator computes live intervals for them and assigns registers with
+ * a linear scan. Intervals that contain a call are only given callee-saved registers, all other intervals
+ * prefer the caller-saved registers, which do not need to be saved at all. If there are not enough registers,
+ * the variables with the lowest (loop depth weighted) number of uses are spilled, i.e. they stay in memory.
+ * If a profile has been read, the uses are weighted by how often they are executed per call of the procedure.
+ *
+ * The chosen register is stored in the reg field of the VariableEntry, the callee-saved registers
+ * a procedure uses are recorded in the savedRegisters field of its ProcedureEntry.
+ * The pass has to run after the semantic analysis and before the variable allocation.
+ *
+ * @param program The program for which the registers have to be allocated.
+ * @param globalTable The symbol table for the current program.
+ * @return The number of variables that have been placed in a register.
+ */
+int allocRegisters(Program *program, SymbolTable *globalTable);
+
+/**
+ * Keeps the parameters arriving in an argument register there if the register allocation does not run.
+ *
+ * The parameters are analyzed like the candidates of allocRegisters, but only a parameter which is neither
+ * passed as an argument for a reference parameter nor live across a call is given a register, its argument
+ * register. All other parameters arriving in a register are stored to a stack slot by the prologue.
+ * The pass has to run after the calling convention has been assigned by assignArgumentRegisters.
+ *
+ * @param program The program whose parameters are kept in registers.
+ * @param globalTable The symbol table for the current program.
+ * @return The number of parameters kept in their argument register.
+ */
+int keepArgumentsInRegisters(Program *program, SymbolTable *globalTable);
+
+#endif /* _REGALLOC_H_ */
@@ -0,0 +1,258 @@
+/*
+ * slotshare.c -- sharing of stack slots between local variables
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <util/errors.h>
+#include <util/memory.h>
+#include <absyn/absyn.h>
+#include <table/table.h>
+#include "slotshare.h"
+
+/**
+ * A local variable living in memory and the positions in the procedure body where it is live.
+ */
+typedef struct {
+    Entry *entry;
+    Identifier *name;
+    int size;
+    int index;          /* in the order of the declarations */
+    int start;          /* -1 if the variable does not occur */
+    int end;
+    bool inLoop;        /* occurs in the loop currently analyzed */
+    int slot;           /* the candidate whose slot is used, -1 as long as the variable is not placed */
+} SlotCandidate;
+
+static SymbolTable *localTable;
+static SlotCandidate *candidates;
+static int numCandidates;
+static int position;
+static int loopDepth;
+
+/*
+ * Lifetimes
+ */
+
+static void occurInExpression(Expression *expression);
+
+static void occurInVariable(Variable *variable) {
+    Entry *entry;
+    SlotCandidate *candidate;
+    int i;
+
+    switch (variable->kind) {
+        case VARIABLE_NAMEDVARIABLE:
+            entry = lookup(localTable, variable->u.namedVariable.name);
+            for (i = 0; i < numCandidates; i++) {
+                candidate = &candidates[i];
+                if (candidate->entry != entry) continue;
+                if (candidate->start < 0) candidate->start = position;
+                candidate->end = position;
+                if (loopDepth > 0) candidate->inLoop = true;
+            }
+            break;
+        case VARIABLE_ARRAYACCESS:
+            occurInVariable(variable->u.arrayAccess.array);
+            occurInExpression(variable->u.arrayAccess.index);
+            break;
+        default:
+            error("unknown variable kind %d in occurInVariable", variable->kind);
+    }
+}
+
+static void occurInExpression(Expression *expression) {
+    switch (expression->kind) {
+        case EXPRESSION_INTLITERAL:
+            break;
+        case EXPRESSION_VARIABLEEXPRESSION:
+            occurInVariable(expression->u.variableExpression.variable);
+            break;
+        case EXPRESSION_BINARYEXPRESSION:
+            occurInExpression(expression->u.binaryExpression.leftOperand);
+            occurInExpression(expression->u.binaryExpression.rightOperand);
+            break;
+        default:
+            error("unknown expression kind %d in occurInExpression", expression->kind);
+    }
+}
+
+static void occurInStatement(Statement *statement);
+
+static void occurInStatementList(StatementList *statements) {
+    for (; !statements->isEmpty; statements = statements->tail) occurInStatement(statements->head);
+}
+
+/**
+ * Extends the lifetime of every variable occurring in the outermost loop just analyzed to the whole loop.
+ */
+static void extendToLoop(int loopStart) {
+    int i;
+
+    for (i = 0; i < numCandidates; i++) {
+        if (!candidates[i].inLoop) continue;
+        if (candidates[i].start > loopStart) candidates[i].start = loopStart;
+        candidates[i].end = position;
+        candidates[i].inLoop = false;
+    }
+}
+
+static void occurInStatement(Statement *statement) {
+    ExpressionList *arguments;
+    int loopStart;
+
+    switch (statement->kind) {
+        case STATEMENT_EMPTYSTATEMENT:
+            break;
+        case STATEMENT_COMPOUNDSTATEMENT:
+            occurInStatementList(statement->u.compoundStatement.statements);
+            break;
+        case STATEMENT_ASSIGNSTATEMENT:
+            occurInVariable(statement->u.assignStatement.target);
+            occurInExpression(statement->u.assignStatement.value);
+            position++;
+            break;
+        case STATEMENT_IFSTATEMENT:
+            occurInExpression(statement->u.ifStatement.condition);
+            position++;
+            occurInStatement(statement->u.ifStatement.thenPart);
+            occurInStatement(statement->u.ifStatement.elsePart);
+            break;
+        case STATEMENT_WHILESTATEMENT:
+            loopStart = position;
+            loopDepth++;
+            occurInExpression(statement->u.whileStatement.condition);
+            position++;
+            occurInStatement(statement->u.whileStatement.body);
+            position++;
+            loopDepth--;
+            if (loopDepth == 0) extendToLoop(loopStart);
+            break;
+        case STATEMENT_CALLSTATEMENT:
+            for (arguments = statement->u.callStatement.argumentList; !arguments->isEmpty;
+                 arguments = arguments->tail) {
+                occurInExpression(arguments->head);
+            }
+            position++;
+            break;
+        default:
+            error("unknown statement kind %d in occurInStatement", statement->kind);
+    }
+}
+
+/*
+ * Placement
+ */
+
+static int compareSizes(const void *left, const void *right) {
+    const SlotCandidate *l = *(const SlotCandidate **) left;
+    const SlotCandidate *r = *(const SlotCandidate **) right;
+
+    if (l->size != r->size) return r->size - l->size;
+    return l->index - r->index;
+}
+
+static bool overlap(SlotCandidate *left, SlotCandidate *right) {
+    if (left->start < 0 || right->start < 0) return false;
+    return left->start <= right->end && right->start <= left->end;
+}
+
+/**
+ * Checks whether a variable could be added to the slot of a candidate, i.e. whether it does not interfere
+ * with any variable already placed in that slot.
+ */
+static bool fitsIntoSlot(SlotCandidate *candidate, int slot) {
+    int i;
+
+    for (i = 0; i < numCandidates; i++) {
+        if (candidates[i].slot == slot && overlap(candidate, &candidates[i])) return false;
+    }
+    return true;
+}
+
+static int placeVariables(SlotCandidate **sorted) {
+    SlotCandidate *candidate;
+    int shared, i, j;
+
+    shared = 0;
+    for (i = 0; i < numCandidates; i++) {
+        candidate = sorted[i];
+        for (j = 0; j < i; j++) {
+            if (sorted[j]->slot == sorted[j]->index && fitsIntoSlot(candidate, sorted[j]->index)) break;
+        }
+        if (j == i) {
+            candidate->slot = candidate->index;
+            continue;
+        }
+        candidate->slot = sorted[j]->index;
+        candidate->entry->u.varEntry.sharedSlot = sorted[j]->name;
+        shared++;
+    }
+    return shared;
+}
+
+static int shareProcedureSlots(GlobalDeclaration *procDec, SymbolTable *globalTable, bool showReport) {
+    VariableDeclarationList *variables;
+    SlotCandidate **sorted;
+    Entry *entry;
+    int shared, saved, count, i;
+
+    localTable = lookup(globalTable, procDec->name)->u.procEntry.localTable;
+    count = 0;
+    for (variables = procDec->u.procedureDeclaration.variables; !variables->isEmpty; variables = variables->tail) {
+        count++;
+    }
+    candidates = allocate((count + 1) * sizeof(SlotCandidate));
+    numCandidates = 0;
+    for (variables = procDec->u.procedureDeclaration.variables; !variables->isEmpty; variables = variables->tail) {
+        entry = lookup(localTable, variables->head->name);
+        if (entry->kind != ENTRY_KIND_VAR) continue;
+        entry->u.varEntry.sharedSlot = NULL;
+        if (entry->u.varEntry.reg != 0 || entry->u.varEntry.staticLabel != 0) continue;
+        candidates[numCandidates].entry = entry;
+        candidates[numCandidates].name = variables->head->name;
+        candidates[numCandidates].size = entry->u.varEntry.type->byteSize;
+        candidates[numCandidates].index = numCandidates;
+        candidates[numCandidates].start = -1;
+        candidates[numCandidates].end = -1;
+        candidates[numCandidates].inLoop = false;
+        candidates[numCandidates].slot = -1;
+        numCandidates++;
+    }
+
+    position = 0;
+    loopDepth = 0;
+    occurInStatementList(procDec->u.procedureDeclaration.body);
+
+    sorted = allocate((numCandidates + 1) * sizeof(SlotCandidate *));
+    for (i = 0; i < numCandidates; i++) sorted[i] = &candidates[i];
+    qsort(sorted, numCandidates, sizeof(SlotCandidate *), compareSizes);
+    shared = placeVariables(sorted);
+
+    if (showReport) {
+        printf("\nStack slot sharing for procedure '%s'\n", procDec->name->string);
+        saved = 0;
+        for (i = 0; i < numCandidates; i++) {
+            if (sorted[i]->slot == sorted[i]->index) continue;
+            printf("var '%s' shares the slot of '%s'\n", sorted[i]->name->string,
+                   sorted[i]->entry->u.varEntry.sharedSlot->string);
+            saved += sorted[i]->size;
+        }
+        printf("size of localvar area reduced by %d bytes\n", saved);
+    }
+    release(sorted);
+    release(candidates);
+    return shared;
+}
+
+int shareStackSlots(Program *program, SymbolTable *globalTable, bool showReport) {
+    GlobalDeclarationList *declarationList;
+    int shared;
+
+    shared = 0;
+    for (declarationList = program; !declarationList->isEmpty; declarationList = declarationList->tail) {
+        if (declarationList->head->kind != DECLARATION_PROCEDUREDECLARATION) continue;
+        shared += shareProcedureSlots(declarationList->head, globalTable, showReport);
+    }
+    return shared;
+}
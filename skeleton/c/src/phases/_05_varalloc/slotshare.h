@@ -0,0 +1,35 @@
+/*
+ * slotshare.h -- sharing of stack slots between local variables
+ */
+
+
+#ifndef _SLOTSHARE_H_
+#define _SLOTSHARE_H_
+
+#include <stdbool.h>
+#include <absyn/absyn.h>
+#include <table/table.h>
+
+/**
+ * This function lets local variables whose lifetimes never overlap share a stack slot.
+ *
+ * Only local variables which live in the stack frame take part, i.e. arrays and the scalar variables without
+ * a register, unless they are allocated statically.
+ * The lifetime of a variable reaches from its first to its last occurrence in the procedure body. If it occurs
+ * inside a loop, it covers the whole outermost loop around the occurrence, since a value may be carried
+ * from one iteration into the next. A variable which does not occur at all interferes with nothing.
+ * The variables are visited from the largest to the smallest, so the large arrays are placed first:
+ * every variable reuses the slot of the first variable placed before it whose lifetime does not overlap
+ * with any variable already sharing that slot, otherwise it gets a slot of its own.
+ *
+ * The variable whose slot is reused is stored in the sharedSlot field of the VariableEntry.
+ * The pass has to run after the register allocation and before the variable allocation.
+ *
+ * @param program The program whose stack slots are shared.
+ * @param globalTable The symbol table for the current program.
+ * @param showReport Whether the shared slots and the bytes saved should be printed for every procedure.
+ * @return The number of variables sharing the slot of another variable.
+ */
+int shareStackSlots(Program *program, SymbolTable *globalTable, bool showReport);
+
+#endif /* _SLOTSHARE_H_ */
@@ -0,0 +1,80 @@
+/*
+ * staticalloc.c -- static allocation of large local variables
+ */
+
+#include <stdio.h>
+#include <absyn/absyn.h>
+#include <table/table.h>
+#include <phases/_04c_optimize/callgraph.h>
+#include <phases/_06_codegen/codeprint.h>
+#include "staticalloc.h"
+
+static int numLabels = 0;
+
+static int allocProcedureVariables(CallGraphNode *node, int threshold, bool showReport) {
+    VariableDeclarationList *variables;
+    SymbolTable *localTable;
+    Entry *entry;
+    int allocated;
+
+    localTable = node->entry->u.procEntry.localTable;
+    if (showReport) printf("\nStatic allocation for procedure '%s'\n", node->declaration->name->string);
+    allocated = 0;
+    for (variables = node->declaration->u.procedureDeclaration.variables; !variables->isEmpty;
+         variables = variables->tail) {
+        entry = lookup(localTable, variables->head->name);
+        if (entry->kind != ENTRY_KIND_VAR || entry->u.varEntry.reg != 0) continue;
+        if (entry->u.varEntry.staticLabel != 0 || entry->u.varEntry.type->byteSize < threshold) continue;
+        if (node->isRecursive) {
+            if (showReport) {
+                printf("var '%s' (%d bytes): stays on the stack, the procedure is recursive\n",
+                       variables->head->name->string, entry->u.varEntry.type->byteSize);
+            }
+            continue;
+        }
+        entry->u.varEntry.staticLabel = ++numLabels;
+        allocated++;
+        if (showReport) {
+            printf("var '%s' (%d bytes): " STATIC_LABEL_FORMAT "\n",
+                   variables->head->name->string, entry->u.varEntry.type->byteSize, numLabels);
+        }
+    }
+    return allocated;
+}
+
+int allocStaticVariables(Program *program, SymbolTable *globalTable, int threshold, bool showReport) {
+    CallGraph *graph;
+    int allocated, i;
+
+    graph = buildCallGraph(program, globalTable);
+    allocated = 0;
+    for (i = 0; i < graph->numNodes; i++) {
+        allocated += allocProcedureVariables(&graph->nodes[i], threshold, showReport);
+    }
+    releaseCallGraph(graph);
+    return allocated;
+}
+
+void emitStaticVariables(FILE *out, Program *program, SymbolTable *globalTable) {
+    GlobalDeclarationList *declarationList;
+    VariableDeclarationList *variables;
+    SymbolTable *localTable;
+    Entry *entry;
+
+    if (numLabels == 0) return;
+    emit(out, "");
+    emit(out, "\t.bss");
+    for (declarationList = program; !declarationList->isEmpty; declarationList = declarationList->tail) {
+        if (declarationList->head->kind != DECLARATION_PROCEDUREDECLARATION) continue;
+        localTable = lookup(globalTable, declarationList->head->name)->u.procEntry.localTable;
+        variables = declarationList->head->u.procedureDeclaration.variables;
+        for (; !variables->isEmpty; variables = variables->tail) {
+            entry = lookup(localTable, variables->head->name);
+            if (entry->kind != ENTRY_KIND_VAR || entry->u.varEntry.staticLabel == 0) continue;
+            emit(out, "\t.align\t4");
+            emit(out, STATIC_LABEL_FORMAT ":\t\t\t; %s in %s", entry->u.varEntry.staticLabel,
+                 variables->head->name->string, declarationList->head->name->string);
+            emit(out, "\t.space\t%d", entry->u.varEntry.type->byteSize);
+        }
+    }
+}
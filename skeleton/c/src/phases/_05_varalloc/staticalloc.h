@@ -0,0 +1,45 @@
+/*
+ * staticalloc.h -- static allocation of large local variables
+ */
+
+
+#ifndef _STATICALLOC_H_
+#define _STATICALLOC_H_
+
+#include <stdio.h>
+#include <stdbool.h>
+#include <absyn/absyn.h>
+#include <table/table.h>
+
+#define DEFAULT_STATIC_THRESHOLD 1024   /* the smallest variable in bytes which is allocated statically */
+#define STATIC_LABEL_FORMAT "_static%d"
+
+/**
+ * This function moves large local variables of procedures, which are never active twice at the same time,
+ * from the stack into the bss segment.
+ *
+ * A procedure which is not recursive according to the call graph has at most one activation, so its local
+ * variables can live at a fixed address. Every local variable of such a procedure that lives in memory and has
+ * at least the given size gets a number, which is stored in the staticLabel field of its VariableEntry.
+ * The variable is addressed by the label STATIC_LABEL_FORMAT with this number, without the frame pointer.
+ * It needs no stack slot, which shrinks the frame and with it the adjustment of the stack pointer.
+ * Like the variables on the stack, the variables in the bss segment are not initialized.
+ * The pass has to run after the register allocation and before the stack slots are shared.
+ *
+ * @param program The program whose variables are allocated.
+ * @param globalTable The symbol table for the current program.
+ * @param threshold The smallest size in bytes of a variable which is allocated statically.
+ * @param showReport Whether the placement of every large variable should be printed.
+ * @return The number of variables allocated statically.
+ */
+int allocStaticVariables(Program *program, SymbolTable *globalTable, int threshold, bool showReport);
+
+/**
+ * Emits the bss segment holding the variables allocated statically, with the label and the size of each one.
+ * @param out The file pointer where the output has to be emitted to.
+ * @param program The program whose variables are emitted.
+ * @param globalTable The symbol table for the current program.
+ */
+void emitStaticVariables(FILE *out, Program *program, SymbolTable *globalTable);
+
+#endif /* _STATICALLOC_H_ */
@@ -5,9 +5,38 @@
 #include <absyn/absyn.h>
 #include <table/table.h>
 #include <stdio.h>
+#include <string.h>
 #include <util/errors.h>
 #include "types/types.h"
 #include "varalloc.h"
+#include "regalloc.h"
+#include "callconv.h"
+#include "framelayout.h"
+#include "staticalloc.h"
+#include "phases/_04c_optimize/profile.h"
+#include "phases/_06_codegen/sethiullman.h"
+#include "phases/_06_codegen/instrument.h"
+
+static int outgoingAreaSize(StatementList *statements, SymbolTable *globalTable, int size);
+
+/**
+ * Prints the kind of frame of a procedure and the instructions of prologue and epilogue it saves,
+ * per call and, if a profile has been read, in total.
+ */
+static void showFrame(Identifier *name, Entry *procEntry) {
+    static const char *kinds[] = {"full", "sp-relative", "none"};
+    long long calls;
+    int saved;
+
+    printf("frame = %s, size = %d", kinds[procEntry->u.procEntry.frameKind], frameSize(procEntry));
+    saved = savedFrameInstructions(procEntry);
+    if (saved > 0) {
+        printf(", saves %d instructions per call", saved);
+        calls = procedureProfileCount(name);
+        if (calls >= 0) printf(", %lld executed instructions in the profile", saved * calls);
+    }
+    printf("\n");
+}
 
 /**
  * Formats the variables of a procedure to a human readable format and prints it
@@ -17,10 +46,11 @@
 static void showProcedureVarAlloc(GlobalDeclaration *procDec, SymbolTable *globalTable) {
     SymbolTable *localTable;
     Entry *procEntry, *localEntry;
-    ParamTypes *paramTypes;
+    ParamTypes *paramTypes, *parameterTypes;
     ParameterList *parameterList;
     VariableDeclarationList *variableList;
     int argNum;
+    int reg;
 
     procEntry = lookup(globalTable, procDec->name);
     localTable = procEntry->u.procEntry.localTable;
@@ -29,7 +59,11 @@ static void showProcedureVarAlloc(GlobalDeclaration *procDec, SymbolTable *globa
     argNum = 1;
     paramTypes = procEntry->u.procEntry.paramTypes;
     while (!paramTypes->isEmpty) {
-        printf("arg %d: sp + %d\n", argNum, paramTypes->offset);
+        if (paramTypes->reg != 0) {
+            printf("arg %d: $%d\n", argNum, paramTypes->reg);
+        } else {
+            printf("arg %d: sp + %d\n", argNum, paramTypes->offset);
+        }
 
         paramTypes = paramTypes->next;
         argNum++;
@@ -38,21 +72,54 @@ static void showProcedureVarAlloc(GlobalDeclaration *procDec, SymbolTable *globa
 
 
     parameterList = procDec->u.procedureDeclaration.parameters;
+    parameterTypes = procEntry->u.procEntry.paramTypes;
     while (!parameterList->isEmpty) {
-        printf("param '%s': fp + %d\n",
-               parameterList->head->name->string,
-               lookup(localTable, parameterList->head->name)->u.varEntry.offset);
+        localEntry = lookup(localTable, parameterList->head->name);
+        if (parameterTypes->reg == 0) {
+            printf("param '%s': fp + %d",
+                   parameterList->head->name->string,
+                   localEntry->u.varEntry.offset);
+            if (localEntry->u.varEntry.reg != 0) {
+                printf(", held in $%d", localEntry->u.varEntry.reg);
+            }
+        } else if (localEntry->u.varEntry.reg != 0) {
+            printf("param '%s': $%d", parameterList->head->name->string, localEntry->u.varEntry.reg);
+            if (localEntry->u.varEntry.reg != parameterTypes->reg) {
+                printf(", arrives in $%d", parameterTypes->reg);
+            }
+        } else {
+            printf("param '%s': fp - %d, arrives in $%d",
+                   parameterList->head->name->string,
+                   -localEntry->u.varEntry.offset,
+                   parameterTypes->reg);
+        }
+        printf("\n");
 
         parameterList = parameterList->tail;
+        parameterTypes = parameterTypes->next;
     }
 
     variableList = procDec->u.procedureDeclaration.variables;
     while (!variableList->isEmpty) {
         localEntry = lookup(localTable, variableList->head->name);
         if (localEntry->kind == ENTRY_KIND_VAR) {
-            printf("var '%s': fp - %d\n",
-                   variableList->head->name->string,
-                   -localEntry->u.varEntry.offset);
+            if (localEntry->u.varEntry.reg != 0) {
+                printf("var '%s': $%d\n",
+                       variableList->head->name->string,
+                       localEntry->u.varEntry.reg);
+            } else if (localEntry->u.varEntry.staticLabel != 0) {
+                printf("var '%s': " STATIC_LABEL_FORMAT "\n",
+                       variableList->head->name->string,
+                       localEntry->u.varEntry.staticLabel);
+            } else {
+                printf("var '%s': fp - %d",
+                       variableList->head->name->string,
+                       -localEntry->u.varEntry.offset);
+                if (localEntry->u.varEntry.sharedSlot != NULL) {
+                    printf(", shares the slot of '%s'", localEntry->u.varEntry.sharedSlot->string);
+                }
+                printf("\n");
+            }
         }
 
         variableList = variableList->tail;
@@ -60,6 +127,14 @@ static void showProcedureVarAlloc(GlobalDeclaration *procDec, SymbolTable *globa
 
     printf("size of localvar area = %d\n", procEntry->u.procEntry.localvarArea);
     printf("size of outgoing area = %d\n", procEntry->u.procEntry.outgoingArea);
+    showFrame(procDec->name, procEntry);
+    if (procEntry->u.procEntry.savedRegisters != 0) {
+        printf("saved registers =");
+        for (reg = 0; reg < 32; reg++) {
+            if (procEntry->u.procEntry.savedRegisters & (1u << reg)) printf(" $%d", reg);
+        }
+        printf("\n");
+    }
 }
 
 /**
@@ -81,10 +156,170 @@ static void showVarAllocation(Program *program, SymbolTable *globalTable) {
     }
 }
 
+/**
+ * Enlarges the localvar area of every procedure by the spill area its expressions need,
+ * if they require more registers than the expression stack provides.
+ *
+ * @param program      The abstract syntax tree of the program
+ * @param globalTable  The symbol table containing all symbols of the spl program
+ */
+static void allocSpillAreas(Program *program, SymbolTable *globalTable) {
+    GlobalDeclarationList *declarationList;
+    Entry *procEntry;
+    int registers;
+
+    registers = lastExpressionRegister - FIRST_TEMPORARY_REGISTER + 1;
+    declarationList = program;
+    while (!declarationList->isEmpty) {
+        if (declarationList->head->kind == DECLARATION_PROCEDUREDECLARATION) {
+            procEntry = lookup(globalTable, declarationList->head->name);
+            procEntry->u.procEntry.localvarArea += spillAreaSize(declarationList->head, registers);
+        }
+
+        declarationList = declarationList->tail;
+    }
+}
+
+/**
+ * @return The number of bytes a variable of the given type occupies, an address for a reference.
+ */
+static int slotSize(Type *type, bool isRef) {
+    return isRef ? REF_BYTE_SIZE : type->byteSize;
+}
+
+/**
+ * Computes the offsets of the arguments passed on the stack, relative to the stack pointer of the caller,
+ * and the size of the argument area of every procedure declared in the program.
+ * The predefined procedures got theirs from the symbol table.
+ */
+static void allocArgumentAreas(Program *program, SymbolTable *globalTable) {
+    GlobalDeclarationList *declarationList;
+    ParamTypes *paramTypes;
+    Entry *procEntry;
+    int offset;
+
+    for (declarationList = program; !declarationList->isEmpty; declarationList = declarationList->tail) {
+        if (declarationList->head->kind != DECLARATION_PROCEDUREDECLARATION) continue;
+        procEntry = lookup(globalTable, declarationList->head->name);
+        offset = 0;
+        for (paramTypes = procEntry->u.procEntry.paramTypes; !paramTypes->isEmpty; paramTypes = paramTypes->next) {
+            if (paramTypes->reg != 0) continue;
+            paramTypes->offset = offset;
+            offset += slotSize(paramTypes->type, paramTypes->isRef);
+        }
+        procEntry->u.procEntry.argumentArea = stackArgumentSize(procEntry->u.procEntry.paramTypes);
+    }
+}
+
+/**
+ * Allocates the stack slots of the parameters and local variables of a procedure.
+ *
+ * The localvar area starts with the callee-saved registers, see savedRegisterOffset, followed by the parameters
+ * arriving in a register which the prologue stores, and the local variables in the order of their declaration.
+ * Variables kept in a register or allocated statically get no slot, a variable sharing the slot of another one
+ * gets its offset once all slots are allocated.
+ */
+static void allocLocalVariables(GlobalDeclaration *procDec, Entry *procEntry) {
+    SymbolTable *localTable;
+    ParameterList *parameterList;
+    ParamTypes *paramTypes;
+    VariableDeclarationList *variableList;
+    Entry *entry;
+    unsigned savedRegisters;
+    int offset;
+
+    localTable = procEntry->u.procEntry.localTable;
+    offset = 0;
+    for (savedRegisters = procEntry->u.procEntry.savedRegisters; savedRegisters != 0; savedRegisters &= savedRegisters - 1) {
+        offset -= REF_BYTE_SIZE;
+    }
+
+    parameterList = procDec->u.procedureDeclaration.parameters;
+    paramTypes = procEntry->u.procEntry.paramTypes;
+    for (; !parameterList->isEmpty; parameterList = parameterList->tail, paramTypes = paramTypes->next) {
+        entry = lookup(localTable, parameterList->head->name);
+        if (paramTypes->reg == 0) {
+            entry->u.varEntry.offset = paramTypes->offset;
+        } else if (entry->u.varEntry.reg == 0) {
+            offset -= REF_BYTE_SIZE;
+            entry->u.varEntry.offset = offset;
+        }
+    }
+
+    for (variableList = procDec->u.procedureDeclaration.variables; !variableList->isEmpty;
+         variableList = variableList->tail) {
+        entry = lookup(localTable, variableList->head->name);
+        if (entry->u.varEntry.reg != 0 || entry->u.varEntry.staticLabel != 0 ||
+            entry->u.varEntry.sharedSlot != NULL) {
+            continue;
+        }
+        offset -= slotSize(entry->u.varEntry.type, false);
+        entry->u.varEntry.offset = offset;
+    }
+    for (variableList = procDec->u.procedureDeclaration.variables; !variableList->isEmpty;
+         variableList = variableList->tail) {
+        entry = lookup(localTable, variableList->head->name);
+        if (entry->u.varEntry.sharedSlot == NULL) continue;
+        entry->u.varEntry.offset = lookup(localTable, entry->u.varEntry.sharedSlot)->u.varEntry.offset;
+    }
+    procEntry->u.procEntry.localvarArea = -offset;
+}
+
+static int statementOutgoingArea(Statement *statement, SymbolTable *globalTable, int size) {
+    Entry *calleeEntry;
+
+    switch (statement->kind) {
+        case STATEMENT_EMPTYSTATEMENT:
+        case STATEMENT_ASSIGNSTATEMENT:
+            return size;
+        case STATEMENT_COMPOUNDSTATEMENT:
+            return outgoingAreaSize(statement->u.compoundStatement.statements, globalTable, size);
+        case STATEMENT_IFSTATEMENT:
+            size = statementOutgoingArea(statement->u.ifStatement.thenPart, globalTable, size);
+            return statementOutgoingArea(statement->u.ifStatement.elsePart, globalTable, size);
+        case STATEMENT_WHILESTATEMENT:
+            return statementOutgoingArea(statement->u.whileStatement.body, globalTable, size);
+        case STATEMENT_CALLSTATEMENT:
+            calleeEntry = lookup(globalTable, statement->u.callStatement.procedureName);
+            return calleeEntry->u.procEntry.argumentArea > size ? calleeEntry->u.procEntry.argumentArea : size;
+        default:
+            error("unknown statement kind %d in statementOutgoingArea", statement->kind);
+            return size;
+    }
+}
+
+/**
+ * Computes the largest argument area of all procedures called in a list of statements.
+ * @param size The size computed so far, -1 as long as no call has been found.
+ */
+static int outgoingAreaSize(StatementList *statements, SymbolTable *globalTable, int size) {
+    for (; !statements->isEmpty; statements = statements->tail) {
+        size = statementOutgoingArea(statements->head, globalTable, size);
+    }
+    return size;
+}
+
 void allocVars(Program *program, SymbolTable *globalTable, bool showVarAlloc) {
-    //TODO (assignment 5): Allocate stack slots for all parameters and local variables
+    GlobalDeclarationList *declarationList;
+    GlobalDeclaration *procDec;
+    Entry *procEntry;
+
+    allocArgumentAreas(program, globalTable);
+    for (declarationList = program; !declarationList->isEmpty; declarationList = declarationList->tail) {
+        procDec = declarationList->head;
+        if (procDec->kind != DECLARATION_PROCEDUREDECLARATION) continue;
+        procEntry = lookup(globalTable, procDec->name);
+        allocLocalVariables(procDec, procEntry);
+        procEntry->u.procEntry.outgoingArea = outgoingAreaSize(procDec->u.procedureDeclaration.body, globalTable, -1);
+        /* the main procedure of an instrumented program calls the routine printing the counters */
+        if (numProfileCounters > 0 && strcmp(procDec->name->string, "main") == 0 &&
+            procEntry->u.procEntry.outgoingArea < 0) {
+            procEntry->u.procEntry.outgoingArea = 0;
+        }
+    }
 
-    notImplemented();
+    allocSpillAreas(program, globalTable);
+    classifyFrames(program, globalTable);
 
     if (showVarAlloc) showVarAllocation(program, globalTable);
 }
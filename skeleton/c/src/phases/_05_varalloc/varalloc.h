@@ -6,6 +6,8 @@
 #ifndef _VARALLOC_H_
 #define _VARALLOC_H_
 
+#include <absyn/absyn.h>
+#include <table/table.h>
 
 #define REF_BYTE_SIZE	4	/* size of an address in bytes */
 
@@ -16,6 +18,23 @@
  * Those values have to be stored in their corresponding fields in the ProcedureEntry, VariableEntry or
  * ParameterTypes structs.
  *
+ * If the register allocator ran before, local variables with a register (reg field of the VariableEntry)
+ * need no stack slot. Instead, the localvar area has to hold one word for every register set in the
+ * savedRegisters field of the ProcedureEntry.
+ *
+ * If the calling convention has been assigned by assignArgumentRegisters, arguments with a register (reg field
+ * of the ParamTypes) get no slot in the argument area, its size is the one returned by stackArgumentSize and
+ * the outgoing area of a caller shrinks accordingly. Such a parameter is held in the register of its
+ * VariableEntry, or, if that is 0, in a stack slot of the localvar area with a negative offset.
+ *
+ * A local variable allocated statically by allocStaticVariables, i.e. with a staticLabel, needs no stack slot either.
+ *
+ * If the stack slots have been shared by shareStackSlots, a local variable whose sharedSlot field is set gets
+ * no slot of its own, but the offset of the variable named there, which is never smaller.
+ *
+ * Finally, the kind of stack frame of every procedure is chosen by classifyFrames. All offsets stay relative
+ * to the start of the frame, frameOffset converts them for procedures addressed relative to the stack pointer.
+ *
  * @param program The program for which the variables have to be allocated.
  * @param globalTable The symbol table for the current program.
  * @param showVarAlloc A boolean value indicating, whether the progress of the allocation should be displayed to the user.
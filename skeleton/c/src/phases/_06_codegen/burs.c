@@ -0,0 +1,735 @@
+/*
+ * burs.c -- instruction selection by tree pattern matching
+ */
+
+#include "burs.h"
+
+#include <limits.h>
+#include <string.h>
+#include <util/errors.h>
+#include <util/memory.h>
+#include <absyn/absyn.h>
+#include <table/table.h>
+#include <types/types.h>
+#include <phases/_05_varalloc/regalloc.h>
+#include <phases/_05_varalloc/framelayout.h>
+#include <phases/_05_varalloc/staticalloc.h>
+#include "codeprint.h"
+#include "constarith.h"
+#include "sethiullman.h"
+
+#define INFINITE_COST (INT_MAX / 2)
+#define WORD_BYTE_SIZE 4
+#define INDEX_ERROR_LABEL "_indexError"
+
+/**
+ * The operators of the nodes of the trees the patterns are matched against.
+ */
+typedef enum {
+    BURS_CHAIN,         /* no node, marks the chain rules */
+    BURS_CNST,          /* an integer literal */
+    BURS_REGVAR,        /* a variable kept in a register */
+    BURS_FRAME,         /* the address of a variable in the stack frame */
+    BURS_STATIC,        /* the address of a statically allocated variable */
+    BURS_POINTER,       /* the address held by an induction pointer */
+    BURS_INDEX,         /* the address of an array element */
+    BURS_LOAD,          /* the value stored at an address */
+    BURS_ASGN,          /* the store of a value to an address */
+    BURS_ADD,
+    BURS_SUB,
+    BURS_MUL,
+    BURS_DIV,
+    BURS_EQ,
+    BURS_NE,
+    BURS_LT,
+    BURS_LE,
+    BURS_GT,
+    BURS_GE
+} burs_operator;
+
+typedef enum {
+    NT_NONE,
+    NT_reg,
+    NT_addr,
+    NT_con,
+    NT_con16,
+    NT_zero,
+    NT_cond,
+    NT_stmt,
+    NUM_NONTERMINALS
+} burs_nonterminal;
+
+/**
+ * The ways a rule is reduced, see reduce.
+ */
+typedef enum {
+    ACTION_IMMEDIATE,
+    ACTION_ZERO,
+    ACTION_REGISTER,
+    ACTION_FRAME,
+    ACTION_STATIC,
+    ACTION_POINTER,
+    ACTION_PASS,
+    ACTION_BASE,
+    ACTION_LOAD_CONSTANT,
+    ACTION_ADDRESS,
+    ACTION_LOAD,
+    ACTION_STORE,
+    ACTION_OFFSET,
+    ACTION_INDEX,
+    ACTION_RRR,
+    ACTION_RRI,
+    ACTION_CONSTANT_OPERATION,
+    ACTION_BRANCH
+} burs_action;
+
+typedef enum {
+#define RULE(name, ...) RULE_##name,
+#include "eco32.rules"
+#undef RULE
+    NUM_RULES
+} burs_rule_number;
+
+typedef struct {
+    const char *name;
+    burs_nonterminal nonterminal;
+    burs_operator operator;
+    burs_nonterminal left;
+    burs_nonterminal right;
+    burs_action action;
+    const char *opcode;
+} BursRule;
+
+static const BursRule rules[] = {
+#define RULE(name, nonterminal, operator, left, right, condition, ruleCost, action, opcode) \
+        {#name, NT_##nonterminal, BURS_##operator, NT_##left, NT_##right, ACTION_##action, opcode},
+#include "eco32.rules"
+#undef RULE
+};
+
+/**
+ * A node of the tree built from an expression, a variable or an assignment.
+ */
+typedef struct burs_node {
+    burs_operator op;
+    struct burs_node *kids[2];
+    int value;                          /* the constant, the register, the offset or the static label */
+    int reg;                            /* the register of an induction pointer */
+    binary_operator operator;           /* the operator of an arithmetic node */
+    int elementSize;                    /* the size of the elements of an indexed array */
+    int numElements;
+    bool checkIndex;
+    int cost[NUM_NONTERMINALS];         /* filled in by the labeller */
+    int rule[NUM_NONTERMINALS];         /* the cheapest rule deriving the nonterminal, or -1 */
+} BursNode;
+
+typedef enum {
+    OPERAND_REGISTER,
+    OPERAND_IMMEDIATE,
+    OPERAND_ADDRESS
+} operand_kind;
+
+/**
+ * The result of a reduced node.
+ */
+typedef struct {
+    operand_kind kind;
+    int reg;            /* the register, or the base register of an address */
+    int value;          /* the immediate value, or the offset of an address */
+    int label;          /* the static label of an address, 0 if it has none */
+    bool isOwned;       /* whether reg is a register of the expression stack which holds the result */
+} Operand;
+
+static FILE *outFile;
+static SymbolTable *localTable;
+static Entry *procEntry;
+static int variablesSize;
+static int numSpillSlots;
+static int spillDepth;
+static const char *branchLabel;
+static bool branchOnTrue;
+
+/*
+ * Trees
+ */
+
+static BursNode *newNode(burs_operator op, BursNode *left, BursNode *right) {
+    BursNode *node;
+
+    node = allocate(sizeof(BursNode));
+    node->op = op;
+    node->kids[0] = left;
+    node->kids[1] = right;
+    node->value = 0;
+    node->reg = 0;
+    node->operator = ABSYN_OP_ADD;
+    node->elementSize = 0;
+    node->numElements = 0;
+    node->checkIndex = false;
+    return node;
+}
+
+static BursNode *newLeaf(burs_operator op, int value) {
+    BursNode *node;
+
+    node = newNode(op, NULL, NULL);
+    node->value = value;
+    return node;
+}
+
+static void releaseTree(BursNode *node) {
+    if (node == NULL) return;
+    releaseTree(node->kids[0]);
+    releaseTree(node->kids[1]);
+    release(node);
+}
+
+static BursNode *valueTree(Expression *expression);
+
+static BursNode *addressTree(Variable *variable) {
+    Entry *entry;
+    BursNode *node;
+    Type *arrayType;
+
+    switch (variable->kind) {
+        case VARIABLE_NAMEDVARIABLE:
+            entry = lookup(localTable, variable->u.namedVariable.name);
+            if (entry->u.varEntry.staticLabel != 0) return newLeaf(BURS_STATIC, entry->u.varEntry.staticLabel);
+            if (entry->u.varEntry.reg != 0) {
+                if (!entry->u.varEntry.isRef) {
+                    error("variable '%s' is kept in a register and has no address", entry->name->string);
+                }
+                /* the register of a reference parameter holds the address */
+                return newLeaf(BURS_REGVAR, entry->u.varEntry.reg);
+            }
+            node = newLeaf(BURS_FRAME, entry->u.varEntry.offset);
+            return entry->u.varEntry.isRef ? newNode(BURS_LOAD, node, NULL) : node;
+        case VARIABLE_ARRAYACCESS:
+            if (variable->u.arrayAccess.pointer != NULL) {
+                /* loopreduce only reduces accesses without a check, an address relative to a pointer has none */
+                if (variable->u.arrayAccess.checkIndex) {
+                    error("array access in line %d has a pointer and a bounds check", variable->line);
+                }
+                node = newLeaf(BURS_POINTER, variable->u.arrayAccess.pointerOffset);
+                node->reg = variable->u.arrayAccess.pointer->reg;
+                return node;
+            }
+            arrayType = variable->u.arrayAccess.array->dataType;
+            node = newNode(BURS_INDEX, addressTree(variable->u.arrayAccess.array),
+                           valueTree(variable->u.arrayAccess.index));
+            node->elementSize = arrayType->u.arrayType.baseType->byteSize;
+            node->numElements = arrayType->u.arrayType.size;
+            node->checkIndex = variable->u.arrayAccess.checkIndex;
+            return node;
+        default:
+            error("unknown variable kind %d in addressTree", variable->kind);
+            return NULL;
+    }
+}
+
+static burs_operator binaryOperator(binary_operator operator) {
+    switch (operator) {
+        case ABSYN_OP_EQU:
+            return BURS_EQ;
+        case ABSYN_OP_NEQ:
+            return BURS_NE;
+        case ABSYN_OP_LST:
+            return BURS_LT;
+        case ABSYN_OP_LSE:
+            return BURS_LE;
+        case ABSYN_OP_GRT:
+            return BURS_GT;
+        case ABSYN_OP_GRE:
+            return BURS_GE;
+        case ABSYN_OP_ADD:
+            return BURS_ADD;
+        case ABSYN_OP_SUB:
+            return BURS_SUB;
+        case ABSYN_OP_MUL:
+            return BURS_MUL;
+        case ABSYN_OP_DIV:
+            return BURS_DIV;
+        default:
+            error("unknown operator %d in binaryOperator", operator);
+            return BURS_ADD;
+    }
+}
+
+static BursNode *valueTree(Expression *expression) {
+    Variable *variable;
+    Entry *entry;
+    BursNode *node;
+
+    switch (expression->kind) {
+        case EXPRESSION_INTLITERAL:
+            return newLeaf(BURS_CNST, expression->u.intLiteral.value);
+        case EXPRESSION_VARIABLEEXPRESSION:
+            variable = expression->u.variableExpression.variable;
+            if (variable->kind == VARIABLE_NAMEDVARIABLE) {
+                entry = lookup(localTable, variable->u.namedVariable.name);
+                if (entry->u.varEntry.reg != 0 && !entry->u.varEntry.isRef) {
+                    return newLeaf(BURS_REGVAR, entry->u.varEntry.reg);
+                }
+            }
+            return newNode(BURS_LOAD, addressTree(variable), NULL);
+        case EXPRESSION_BINARYEXPRESSION:
+            node = newNode(binaryOperator(expression->u.binaryExpression.operator),
+                           valueTree(expression->u.binaryExpression.leftOperand),
+                           valueTree(expression->u.binaryExpression.rightOperand));
+            node->operator = expression->u.binaryExpression.operator;
+            return node;
+        default:
+            error("unknown expression kind %d in valueTree", expression->kind);
+            return NULL;
+    }
+}
+
+/*
+ * Labelling
+ */
+
+static bool isSigned16(int value) {
+    return value >= -32768 && value <= 32767;
+}
+
+/**
+ * Checks whether the element of an array access with a constant index lies at a fixed offset,
+ * i.e. the index needs no check.
+ */
+static bool isFixedElement(BursNode *node) {
+    long long offset;
+
+    if (node->checkIndex || node->kids[1]->op != BURS_CNST) return false;
+    offset = (long long) node->kids[1]->value * node->elementSize;
+    return offset >= INT_MIN / 2 && offset <= INT_MAX / 2;
+}
+
+static int indexCost(BursNode *node) {
+    int cost;
+
+    cost = constantOperationCost(ABSYN_OP_MUL, node->elementSize) + instructionCost("add", 0);
+    if (node->checkIndex) cost += instructionCost("add", node->numElements) + instructionCost("bgeu", 0);
+    return cost;
+}
+
+static int operandCost(BursNode *node, int index, burs_nonterminal nonterminal) {
+    if (nonterminal == NT_NONE) return 0;
+    return node->kids[index]->cost[nonterminal];
+}
+
+/**
+ * Records a rule for a nonterminal of the node if it is cheaper than the one found before.
+ */
+static bool record(BursNode *node, burs_nonterminal nonterminal, int rule, int cost) {
+    if (cost >= node->cost[nonterminal]) return false;
+    node->cost[nonterminal] = cost;
+    node->rule[nonterminal] = rule;
+    return true;
+}
+
+/**
+ * Finds the cheapest rule for every nonterminal of every node of a tree, bottom-up.
+ */
+static void labelTree(BursNode *node) {
+    int i, operands;
+    bool changed;
+
+    for (i = 0; i < 2; i++) {
+        if (node->kids[i] != NULL) labelTree(node->kids[i]);
+    }
+    for (i = 0; i < NUM_NONTERMINALS; i++) {
+        node->cost[i] = INFINITE_COST;
+        node->rule[i] = -1;
+    }
+#define RULE(name, nonterminal, operator, left, right, condition, ruleCost, action, opcode) \
+    if (BURS_##operator != BURS_CHAIN && node->op == BURS_##operator && (condition)) { \
+        operands = operandCost(node, 0, NT_##left) + operandCost(node, 1, NT_##right); \
+        if (operands < INFINITE_COST) record(node, NT_##nonterminal, RULE_##name, operands + (ruleCost)); \
+    }
+#include "eco32.rules"
+#undef RULE
+    /* the chain rules are applied until no nonterminal gets cheaper */
+    do {
+        changed = false;
+#define RULE(name, nonterminal, operator, left, right, condition, ruleCost, action, opcode) \
+        if (BURS_##operator == BURS_CHAIN && node->cost[NT_##left] < INFINITE_COST && (condition)) { \
+            if (record(node, NT_##nonterminal, RULE_##name, node->cost[NT_##left] + (ruleCost))) changed = true; \
+        }
+#include "eco32.rules"
+#undef RULE
+    } while (changed);
+}
+
+/*
+ * Register need
+ */
+
+static int max(int a, int b) {
+    return a > b ? a : b;
+}
+
+static const BursRule *chosenRule(BursNode *node, burs_nonterminal nonterminal) {
+    if (node->rule[nonterminal] < 0) error("no instruction pattern covers the expression");
+    return &rules[node->rule[nonterminal]];
+}
+
+static int need(BursNode *node, burs_nonterminal nonterminal);
+
+/**
+ * The need of an operand of a rule, which is the node itself for a chain rule.
+ */
+static int operandNeed(BursNode *node, const BursRule *rule, int index) {
+    int operandNeed;
+
+    if (rule->operator == BURS_CHAIN) return need(node, rule->left);
+    operandNeed = need(node->kids[index], index == 0 ? rule->left : rule->right);
+    /* the bounds check compares the index with the size of the array in a second register */
+    if (rule->action == ACTION_INDEX && index == 1) return max(operandNeed, 2);
+    return operandNeed;
+}
+
+/**
+ * The need of two operands, if the more expensive one is evaluated first.
+ * Its result only occupies a register while the other one is evaluated if it needs registers at all.
+ */
+static int pairNeed(int first, int second) {
+    if (second > first) return pairNeed(second, first);
+    return max(first, second + (first > 0 ? 1 : 0));
+}
+
+/**
+ * Computes the number of registers of the expression stack the reduction of a node needs.
+ * A result which needs no register, like a constant or a variable kept in a register, is used in place.
+ */
+static int need(BursNode *node, burs_nonterminal nonterminal) {
+    const BursRule *rule;
+
+    rule = chosenRule(node, nonterminal);
+    switch (rule->action) {
+        case ACTION_IMMEDIATE:
+        case ACTION_ZERO:
+        case ACTION_REGISTER:
+        case ACTION_FRAME:
+        case ACTION_STATIC:
+        case ACTION_POINTER:
+            return 0;
+        case ACTION_PASS:
+        case ACTION_BASE:
+        case ACTION_OFFSET:
+            return operandNeed(node, rule, 0);
+        case ACTION_LOAD_CONSTANT:
+            return 1;
+        case ACTION_ADDRESS:
+        case ACTION_LOAD:
+            return max(1, operandNeed(node, rule, 0));
+        case ACTION_INDEX:
+        case ACTION_RRR:
+        case ACTION_RRI:
+        case ACTION_CONSTANT_OPERATION:
+            return max(1, pairNeed(operandNeed(node, rule, 0), operandNeed(node, rule, 1)));
+        case ACTION_STORE:
+        case ACTION_BRANCH:
+            return pairNeed(operandNeed(node, rule, 0), operandNeed(node, rule, 1));
+        default:
+            error("unknown action %d in need", rule->action);
+            return 0;
+    }
+}
+
+/*
+ * Reduction
+ */
+
+static Operand registerOperand(int reg, bool isOwned) {
+    Operand operand;
+
+    operand.kind = OPERAND_REGISTER;
+    operand.reg = reg;
+    operand.value = 0;
+    operand.label = 0;
+    operand.isOwned = isOwned;
+    return operand;
+}
+
+static Operand immediateOperand(int value) {
+    Operand operand;
+
+    operand = registerOperand(0, false);
+    operand.kind = OPERAND_IMMEDIATE;
+    operand.value = value;
+    return operand;
+}
+
+static Operand addressOperand(int reg, int offset, int label, bool isOwned) {
+    Operand operand;
+
+    operand = registerOperand(reg, isOwned);
+    operand.kind = OPERAND_ADDRESS;
+    operand.value = offset;
+    operand.label = label;
+    return operand;
+}
+
+/**
+ * Emits an instruction with an address as its last operand, like ldw, stw or the add computing it.
+ */
+static void emitAddressed(const char *opcode, int reg, Operand *address) {
+    if (address->label == 0) {
+        emitRRI(outFile, opcode, reg, address->reg, address->value);
+    } else if (address->value == 0) {
+        emitRRL(outFile, opcode, reg, address->reg, STATIC_LABEL_FORMAT, address->label);
+    } else {
+        emitRRL(outFile, opcode, reg, address->reg, STATIC_LABEL_FORMAT "%+d", address->label, address->value);
+    }
+}
+
+static void emitMove(int target, Operand *operand) {
+    if (operand->kind == OPERAND_IMMEDIATE) emitRRI(outFile, "add", target, 0, operand->value);
+    else if (operand->reg != target) emitRRR(outFile, "add", target, operand->reg, 0);
+}
+
+static int spillOffset(int slot) {
+    if (slot >= numSpillSlots) error("spill area of the procedure is too small");
+    return frameOffset(procEntry, -(variablesSize + WORD_BYTE_SIZE * (slot + 1)));
+}
+
+static const char *negatedBranch(const char *opcode) {
+    static const char *pairs[][2] = {
+            {"beq", "bne"}, {"blt", "bge"}, {"ble", "bgt"}
+    };
+    unsigned i;
+
+    for (i = 0; i < sizeof(pairs) / sizeof(pairs[0]); i++) {
+        if (strcmp(opcode, pairs[i][0]) == 0) return pairs[i][1];
+        if (strcmp(opcode, pairs[i][1]) == 0) return pairs[i][0];
+    }
+    error("opcode '%s' in negatedBranch is no conditional branch", opcode);
+    return opcode;
+}
+
+static Operand reduce(BursNode *node, burs_nonterminal nonterminal, int reg, int target);
+
+/**
+ * Checks the index of an array access against the size of the array and scales it to a byte offset
+ * in its register. An index in the register of a variable is checked in place and scaled into reg.
+ */
+static void prepareIndex(BursNode *node, Operand *index, int reg) {
+    int sizeReg, shift;
+
+    if (node->checkIndex) {
+        sizeReg = index->isOwned ? reg + 1 : reg;
+        if (sizeReg > lastExpressionRegister) error("expression too complicated");
+        emitRRI(outFile, "add", sizeReg, 0, node->numElements);
+        emitRRL(outFile, "bgeu", index->reg, sizeReg, INDEX_ERROR_LABEL);
+    }
+    if (!index->isOwned) {
+        for (shift = 0; shift < 31 && (1 << shift) < node->elementSize; shift++);
+        if ((1 << shift) == node->elementSize) {
+            emitRRI(outFile, "sll", reg, index->reg, shift);
+            *index = registerOperand(reg, true);
+            return;
+        }
+        emitMove(reg, index);
+    }
+    *index = registerOperand(reg, true);
+    emitConstantOperation(outFile, ABSYN_OP_MUL, reg, node->elementSize, lastExpressionRegister - reg);
+}
+
+/**
+ * Reduces an operand of a rule, which is the node itself for a chain rule.
+ */
+static Operand reduceOperand(BursNode *node, const BursRule *rule, int index, int reg) {
+    Operand operand;
+
+    if (rule->operator == BURS_CHAIN) return reduce(node, rule->left, reg, reg);
+    operand = reduce(node->kids[index], index == 0 ? rule->left : rule->right, reg, reg);
+    if (rule->action == ACTION_INDEX && index == 1) prepareIndex(node, &operand, reg);
+    return operand;
+}
+
+/**
+ * Reduces both operands of a rule, the one needing more registers first.
+ * If the second one does not fit into the remaining registers, the first result is spilled.
+ */
+static void reducePair(BursNode *node, const BursRule *rule, int reg, Operand *operands) {
+    int needs[2], first, second, offset;
+
+    needs[0] = operandNeed(node, rule, 0);
+    needs[1] = operandNeed(node, rule, 1);
+    first = needs[1] > needs[0] ? 1 : 0;
+    second = 1 - first;
+    operands[first] = reduceOperand(node, rule, first, reg);
+    if (!operands[first].isOwned) {
+        operands[second] = reduceOperand(node, rule, second, reg);
+        return;
+    }
+    if (reg + needs[second] <= lastExpressionRegister) {
+        operands[second] = reduceOperand(node, rule, second, reg + 1);
+        return;
+    }
+    offset = spillOffset(spillDepth);
+    commentRRI(outFile, "stw", operands[first].reg, frameBaseRegister(procEntry), offset, "spill");
+    spillDepth++;
+    operands[second] = reduceOperand(node, rule, second, reg);
+    spillDepth--;
+    operands[first].reg = operands[second].isOwned ? reg + 1 : reg;
+    if (operands[first].reg > lastExpressionRegister) error("expression too complicated");
+    commentRRI(outFile, "ldw", operands[first].reg, frameBaseRegister(procEntry), offset, "reload");
+}
+
+/**
+ * Emits the instructions of the rule chosen for a nonterminal of a node, after those of its operands.
+ * @param reg The lowest free register of the expression stack.
+ * @param target The register the last instruction writes a value to, usually reg.
+ */
+static Operand reduce(BursNode *node, burs_nonterminal nonterminal, int reg, int target) {
+    const BursRule *rule;
+    Operand operand, operands[2];
+    int constant;
+
+    rule = chosenRule(node, nonterminal);
+    switch (rule->action) {
+        case ACTION_IMMEDIATE:
+            return immediateOperand(node->value);
+        case ACTION_ZERO:
+            return registerOperand(0, false);
+        case ACTION_REGISTER:
+            return registerOperand(node->value, false);
+        case ACTION_FRAME:
+            return addressOperand(frameBaseRegister(procEntry), frameOffset(procEntry, node->value), 0, false);
+        case ACTION_STATIC:
+            return addressOperand(0, 0, node->value, false);
+        case ACTION_POINTER:
+            return addressOperand(node->reg, node->value, 0, false);
+        case ACTION_PASS:
+            return reduceOperand(node, rule, 0, reg);
+        case ACTION_BASE:
+            operand = reduceOperand(node, rule, 0, reg);
+            return addressOperand(operand.reg, 0, 0, operand.isOwned);
+        case ACTION_LOAD_CONSTANT:
+            operand = reduceOperand(node, rule, 0, reg);
+            emitRRI(outFile, rule->opcode, target, 0, operand.value);
+            return registerOperand(target, target == reg);
+        case ACTION_ADDRESS:
+            operand = reduceOperand(node, rule, 0, reg);
+            emitAddressed(rule->opcode, target, &operand);
+            return registerOperand(target, target == reg);
+        case ACTION_LOAD:
+            operand = reduceOperand(node, rule, 0, reg);
+            emitAddressed(rule->opcode, target, &operand);
+            return registerOperand(target, target == reg);
+        case ACTION_STORE:
+            reducePair(node, rule, reg, operands);
+            emitAddressed(rule->opcode, operands[1].reg, &operands[0]);
+            return registerOperand(0, false);
+        case ACTION_OFFSET:
+            operand = reduceOperand(node, rule, 0, reg);
+            operand.value += node->kids[1]->value * node->elementSize;
+            return operand;
+        case ACTION_INDEX:
+            reducePair(node, rule, reg, operands);
+            /* the index has been scaled in its register, which becomes the base of the element */
+            if (operands[0].reg == 0) {
+                return addressOperand(operands[1].reg, operands[0].value, operands[0].label, true);
+            }
+            emitRRR(outFile, "add", reg, operands[0].reg, operands[1].reg);
+            return addressOperand(reg, operands[0].value, operands[0].label, true);
+        case ACTION_RRR:
+            reducePair(node, rule, reg, operands);
+            emitRRR(outFile, rule->opcode, target, operands[0].reg, operands[1].reg);
+            return registerOperand(target, target == reg);
+        case ACTION_RRI:
+            reducePair(node, rule, reg, operands);
+            /* a constant left operand is only allowed for commutative operators */
+            if (operands[0].kind == OPERAND_IMMEDIATE) {
+                emitRRI(outFile, rule->opcode, target, operands[1].reg, operands[0].value);
+            } else {
+                emitRRI(outFile, rule->opcode, target, operands[0].reg, operands[1].value);
+            }
+            return registerOperand(target, target == reg);
+        case ACTION_CONSTANT_OPERATION:
+            reducePair(node, rule, reg, operands);
+            if (operands[0].kind == OPERAND_IMMEDIATE) {
+                constant = operands[0].value;
+                operand = operands[1];
+            } else {
+                constant = operands[1].value;
+                operand = operands[0];
+            }
+            emitMove(reg, &operand);
+            emitConstantOperation(outFile, node->operator, reg, constant, lastExpressionRegister - reg);
+            operand = registerOperand(reg, true);
+            if (target == reg) return operand;
+            emitMove(target, &operand);
+            return registerOperand(target, false);
+        case ACTION_BRANCH:
+            reducePair(node, rule, reg, operands);
+            emitRRL(outFile, branchOnTrue ? rule->opcode : negatedBranch(rule->opcode),
+                    operands[0].reg, operands[1].reg, "%s", branchLabel);
+            return registerOperand(0, false);
+        default:
+            error("unknown action %d in reduce", rule->action);
+            return registerOperand(0, false);
+    }
+}
+
+/**
+ * Labels a tree, reduces it for a nonterminal and releases it.
+ */
+static Operand selectTree(BursNode *tree, burs_nonterminal nonterminal, int reg, int target) {
+    Operand operand;
+
+    labelTree(tree);
+    operand = reduce(tree, nonterminal, reg, target);
+    releaseTree(tree);
+    return operand;
+}
+
+/*
+ * Interface
+ */
+
+void beginSelection(GlobalDeclaration *procDec, SymbolTable *globalTable) {
+    int registers, spillSize;
+
+    procEntry = lookup(globalTable, procDec->name);
+    localTable = procEntry->u.procEntry.localTable;
+    registers = lastExpressionRegister - FIRST_TEMPORARY_REGISTER + 1;
+    spillSize = spillAreaSize(procDec, registers);
+    variablesSize = procEntry->u.procEntry.localvarArea - spillSize;
+    numSpillSlots = spillSize / WORD_BYTE_SIZE;
+    spillDepth = 0;
+}
+
+int selectExpression(FILE *out, Expression *expression, int reg) {
+    outFile = out;
+    return selectTree(valueTree(expression), NT_reg, reg, reg).reg;
+}
+
+int selectAddress(FILE *out, Variable *variable, int reg) {
+    outFile = out;
+    return selectTree(addressTree(variable), NT_reg, reg, reg).reg;
+}
+
+void selectAssignment(FILE *out, Variable *target, Expression *value, int reg) {
+    Entry *entry;
+    Operand operand;
+
+    outFile = out;
+    if (target->kind == VARIABLE_NAMEDVARIABLE) {
+        entry = lookup(localTable, target->u.namedVariable.name);
+        if (entry->u.varEntry.reg != 0 && !entry->u.varEntry.isRef) {
+            operand = selectTree(valueTree(value), NT_reg, reg, entry->u.varEntry.reg);
+            emitMove(entry->u.varEntry.reg, &operand);
+            return;
+        }
+    }
+    selectTree(newNode(BURS_ASGN, addressTree(target), valueTree(value)), NT_stmt, reg, reg);
+}
+
+void selectCondition(FILE *out, Expression *condition, int reg, bool branchIfTrue, const char *label) {
+    outFile = out;
+    branchLabel = label;
+    branchOnTrue = branchIfTrue;
+    selectTree(valueTree(condition), NT_cond, reg, reg);
+}
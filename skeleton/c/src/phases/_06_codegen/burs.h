@@ -0,0 +1,72 @@
+/*
+ * burs.h -- instruction selection by tree pattern matching
+ */
+
+
+#ifndef _BURS_H_
+#define _BURS_H_
+
+#include <stdio.h>
+#include <stdbool.h>
+#include <absyn/absyn.h>
+#include <table/table.h>
+
+/**
+ * This function prepares the selection for the expressions of a procedure.
+ *
+ * The instruction selector covers the trees of expressions, variables and assignments with the patterns
+ * of eco32.rules at minimal cost, as a bottom-up rewrite system: every node is labelled with the cheapest
+ * rule deriving each nonterminal, then the tree is reduced from the root, emitting the instructions of the
+ * chosen rules. This uses the addressing forms of the ECO32, e.g. "ldw $8,$25,-8" instead of computing the
+ * address of a variable first, immediate operands of add, sub and the constant multiplications and divisions
+ * of emitConstantOperation, and $0 for the constant 0.
+ *
+ * The operand needing more registers is evaluated first, as described in sethiullman.h. If an operand needs
+ * more registers than the expression stack has left, the result of the other one is stored in the spill area.
+ *
+ * @param procDec The procedure declaration whose statements are translated next.
+ * @param globalTable The symbol table for the current program.
+ */
+void beginSelection(GlobalDeclaration *procDec, SymbolTable *globalTable);
+
+/**
+ * Emits the code of an expression.
+ * @param out The file pointer where the output has to be emitted to.
+ * @param expression The expression, which must not be a comparison.
+ * @param reg The lowest free register of the expression stack.
+ * @return The register holding the value. Besides reg, this may be $0 or the register of a variable,
+ *         which must not be changed.
+ */
+int selectExpression(FILE *out, Expression *expression, int reg);
+
+/**
+ * Emits the code computing the address of a variable, e.g. for an argument passed by reference.
+ * @param out The file pointer where the output has to be emitted to.
+ * @param variable The variable, which must not be kept in a register.
+ * @param reg The lowest free register of the expression stack.
+ * @return The register holding the address, which may be the register of a reference parameter.
+ */
+int selectAddress(FILE *out, Variable *variable, int reg);
+
+/**
+ * Emits the code of an assignment. A variable kept in a register receives the value directly from the
+ * last instruction computing it, all others are stored with their address folded into the store.
+ * @param out The file pointer where the output has to be emitted to.
+ * @param target The assigned variable.
+ * @param value The assigned expression.
+ * @param reg The lowest free register of the expression stack.
+ */
+void selectAssignment(FILE *out, Variable *target, Expression *value, int reg);
+
+/**
+ * Emits the code of a condition, which ends in a conditional branch.
+ * A comparison with 0 uses $0 instead of loading the constant.
+ * @param out The file pointer where the output has to be emitted to.
+ * @param condition A comparison.
+ * @param reg The lowest free register of the expression stack.
+ * @param branchIfTrue Whether the branch is taken if the condition holds, otherwise if it does not.
+ * @param label The target of the branch.
+ */
+void selectCondition(FILE *out, Expression *condition, int reg, bool branchIfTrue, const char *label);
+
+#endif /* _BURS_H_ */
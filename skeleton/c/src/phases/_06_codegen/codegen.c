@@ -10,9 +10,26 @@
 #include <table/table.h>
 #include <types/types.h>
 #include "codeprint.h"
+#include "peephole.h"
+#include "instrument.h"
+#include "burs.h"
+#include "prologue.h"
+#include "switchcode.h"
+#include <phases/_04c_optimize/profile.h>
+#include <phases/_05_varalloc/staticalloc.h>
+#include <phases/_05_varalloc/framelayout.h>
+#include <phases/_05_varalloc/regalloc.h>
+#include <phases/_05_varalloc/callconv.h>
 
-#define FIRST_REGISTER 8
-#define LAST_REGISTER 23
+#define NUM_ARGUMENT_REGISTERS (LAST_ARGUMENT_REGISTER - FIRST_ARGUMENT_REGISTER + 1)
+
+static FILE *out;
+static SymbolTable *procedures;
+static Entry *procEntry;
+static int numLabels;
+static InductionPointer *loopPointers;    /* the pointers of the innermost loop being emitted */
+
+static void genStatement(Statement *statement);
 
 /**
  * Emits needed import statements, to allow usage of the predefined functions and sets the correct settings
@@ -37,10 +54,284 @@ void assemblerProlog(FILE *out) {
     emit(out, "\t.align\t4");
 }
 
-void genCode(Program *program, SymbolTable *globalTable, FILE *out) {
-    assemblerProlog(out);
+static int newLabel(void) {
+    return numLabels++;
+}
+
+/**
+ * Emits a conditional branch to the label with the given number.
+ */
+static void genCondition(Expression *condition, bool branchIfTrue, int label) {
+    char name[LABEL_LENGTH];
+
+    snprintf(name, LABEL_LENGTH, "L%d", label);
+    selectCondition(out, condition, FIRST_TEMPORARY_REGISTER, branchIfTrue, name);
+}
+
+static void genStatementList(StatementList *statements) {
+    for (; !statements->isEmpty; statements = statements->tail) genStatement(statements->head);
+}
+
+/**
+ * Emits an assignment. If it increments the induction variable of the loop, its pointers are advanced as well.
+ */
+static void genAssignment(Statement *statement) {
+    InductionPointer *pointer;
+
+    selectAssignment(out, statement->u.assignStatement.target, statement->u.assignStatement.value,
+                     FIRST_TEMPORARY_REGISTER);
+    for (pointer = loopPointers; pointer != NULL; pointer = pointer->next) {
+        if (pointer->increment == statement) emitRRI(out, "add", pointer->reg, pointer->reg, pointer->step);
+    }
+}
+
+/**
+ * Evaluates the arguments of a call from left to right. Arguments passed on the stack are stored to the outgoing
+ * area at once, those passed in a register are kept on the expression stack and only loaded into the argument
+ * registers after all arguments have been evaluated, since the argument registers may be read by them.
+ */
+static void genCall(Statement *call) {
+    Entry *calleeEntry;
+    ParamTypes *paramTypes;
+    ExpressionList *arguments;
+    int sources[NUM_ARGUMENT_REGISTERS], targets[NUM_ARGUMENT_REGISTERS];
+    int numRegisterArguments, nextRegister, argumentIndex, reg, i;
+
+    calleeEntry = lookup(procedures, call->u.callStatement.procedureName);
+    paramTypes = calleeEntry->u.procEntry.paramTypes;
+    arguments = call->u.callStatement.argumentList;
+    numRegisterArguments = 0;
+    nextRegister = FIRST_TEMPORARY_REGISTER;
+    emitProfileIncrement(out, call, 0, FIRST_TEMPORARY_REGISTER);
+    for (argumentIndex = 0; !arguments->isEmpty; argumentIndex++) {
+        if (paramTypes->isRef) reg = selectAddress(out, arguments->head->u.variableExpression.variable, nextRegister);
+        else reg = selectExpression(out, arguments->head, nextRegister);
+        if (paramTypes->reg == 0) {
+            commentRRI(out, "stw", reg, STACK_POINTER_REGISTER, paramTypes->offset, "store arg #%d", argumentIndex);
+        } else {
+            if (reg >= FIRST_ARGUMENT_REGISTER && reg <= LAST_ARGUMENT_REGISTER) {
+                /* a variable in an argument register may be overwritten by a preceding argument */
+                emitRRI(out, "add", nextRegister, reg, 0);
+                reg = nextRegister;
+            }
+            if (reg == nextRegister) nextRegister++;
+            sources[numRegisterArguments] = reg;
+            targets[numRegisterArguments] = paramTypes->reg;
+            numRegisterArguments++;
+        }
+        arguments = arguments->tail;
+        paramTypes = paramTypes->next;
+    }
+    for (i = 0; i < numRegisterArguments; i++) {
+        commentRRI(out, "add", targets[i], sources[i], 0, "load arg #%d", i);
+    }
+    emitSS(out, "jal", profiledCallTarget(call->u.callStatement.procedureName));
+}
+
+static void genSwitchBody(Statement *body, void *data) {
+    (void) data;
+    genStatement(body);
+}
+
+/**
+ * Emits a chain of ifs lowered by the switch lowering. The selector is loaded once and the matching case is
+ * found through a jump table or a decision tree.
+ */
+static void genSwitch(Statement *statement) {
+    SwitchLowering *lowering;
+    Variable *selector;
+    Expression *selectorExpression;
+    char prefix[LABEL_LENGTH];
+    int reg;
+
+    lowering = statement->u.ifStatement.lowering;
+    selector = newNamedVariable(statement->line, lowering->selector);
+    selector->dataType = intType;
+    selectorExpression = newVariableExpression(statement->line, selector);
+    selectorExpression->dataType = intType;
+    reg = selectExpression(out, selectorExpression, FIRST_TEMPORARY_REGISTER);
+    snprintf(prefix, LABEL_LENGTH, "L%d", newLabel());
+    emitSwitch(out, lowering, prefix, reg, FIRST_TEMPORARY_REGISTER + 1, genSwitchBody, NULL);
+}
+
+/**
+ * Emits an if-statement. An empty else-part needs no code, unless its execution counter is incremented there.
+ * An instrumented build tests the conditions of a lowered chain one after another, so each if is counted.
+ */
+static void genIf(Statement *statement) {
+    int elseLabel, endLabel;
+
+    if (statement->u.ifStatement.lowering != NULL && numProfileCounters == 0) {
+        genSwitch(statement);
+        return;
+    }
+    elseLabel = newLabel();
+    genCondition(statement->u.ifStatement.condition, false, elseLabel);
+    emitProfileIncrement(out, statement, PROFILE_THEN, FIRST_TEMPORARY_REGISTER);
+    genStatement(statement->u.ifStatement.thenPart);
+    if (statement->u.ifStatement.elsePart->kind == STATEMENT_EMPTYSTATEMENT &&
+        (numProfileCounters == 0 || statement->profileCounter < 0)) {
+        emitLabel(out, "L%d", elseLabel);
+        return;
+    }
+    endLabel = newLabel();
+    emitJump(out, "L%d", endLabel);
+    emitLabel(out, "L%d", elseLabel);
+    emitProfileIncrement(out, statement, PROFILE_ELSE, FIRST_TEMPORARY_REGISTER);
+    genStatement(statement->u.ifStatement.elsePart);
+    emitLabel(out, "L%d", endLabel);
+}
+
+/**
+ * Computes the addresses held by the pointers of a loop. Since the pointers of loop-invariant addresses
+ * keep the bounds check, this happens after the loop has been entered.
+ */
+static void genPointers(InductionPointer *pointers) {
+    int reg;
+
+    for (; pointers != NULL; pointers = pointers->next) {
+        reg = selectAddress(out, pointers->access, FIRST_TEMPORARY_REGISTER);
+        commentRRI(out, "add", pointers->reg, reg, 0, "set up pointer");
+    }
+}
+
+/**
+ * Emits a while-statement. An inverted loop is tested in front of the loop and after the body, so an iteration
+ * only executes one branch. A loop with pointers is always emitted this way, the pointers are set up after the
+ * test in front of the loop.
+ */
+static void genWhile(Statement *statement) {
+    InductionPointer *outerPointers;
+    int testLabel, bodyLabel, endLabel;
+
+    outerPointers = loopPointers;
+    loopPointers = statement->u.whileStatement.pointers;
+    if (statement->u.whileStatement.isInverted || loopPointers != NULL) {
+        bodyLabel = newLabel();
+        endLabel = newLabel();
+        genCondition(statement->u.whileStatement.condition, false, endLabel);
+        genPointers(loopPointers);
+        emitLabel(out, "L%d", bodyLabel);
+        emitProfileIncrement(out, statement, 0, FIRST_TEMPORARY_REGISTER);
+        genStatement(statement->u.whileStatement.body);
+        genCondition(statement->u.whileStatement.condition, true, bodyLabel);
+        emitLabel(out, "L%d", endLabel);
+    } else {
+        testLabel = newLabel();
+        endLabel = newLabel();
+        emitLabel(out, "L%d", testLabel);
+        genCondition(statement->u.whileStatement.condition, false, endLabel);
+        emitProfileIncrement(out, statement, 0, FIRST_TEMPORARY_REGISTER);
+        genStatement(statement->u.whileStatement.body);
+        emitJump(out, "L%d", testLabel);
+        emitLabel(out, "L%d", endLabel);
+    }
+    loopPointers = outerPointers;
+}
+
+static void genStatement(Statement *statement) {
+    switch (statement->kind) {
+        case STATEMENT_EMPTYSTATEMENT:
+            break;
+        case STATEMENT_COMPOUNDSTATEMENT:
+            genStatementList(statement->u.compoundStatement.statements);
+            break;
+        case STATEMENT_ASSIGNSTATEMENT:
+            genAssignment(statement);
+            break;
+        case STATEMENT_IFSTATEMENT:
+            genIf(statement);
+            break;
+        case STATEMENT_WHILESTATEMENT:
+            genWhile(statement);
+            break;
+        case STATEMENT_CALLSTATEMENT:
+            genCall(statement);
+            break;
+        default:
+            error("unknown statement kind %d in genStatement", statement->kind);
+    }
+}
+
+/*
+ * Procedures
+ */
 
-    //TODO (assignment 6): generate eco32 assembler code for the spl program
+/**
+ * Saves or restores the callee-saved registers used by the procedure.
+ */
+static void genSavedRegisters(const char *opcode) {
+    int reg;
+
+    for (reg = FIRST_CALLEE_SAVED_REGISTER; reg <= LAST_CALLEE_SAVED_REGISTER; reg++) {
+        if ((procEntry->u.procEntry.savedRegisters & (1u << reg)) == 0) continue;
+        emitRRI(out, opcode, reg, frameBaseRegister(procEntry),
+                frameOffset(procEntry, savedRegisterOffset(procEntry, reg)));
+    }
+}
+
+/**
+ * Moves the parameters into the places chosen by the register allocator. The parameters arriving in a register
+ * are moved first, so none of them is overwritten by a parameter loaded from the stack.
+ */
+static void genParameters(GlobalDeclaration *procDec) {
+    ParameterList *parameters;
+    ParamTypes *paramTypes;
+    Entry *varEntry;
+    SymbolTable *localTable;
+
+    localTable = procEntry->u.procEntry.localTable;
+    paramTypes = procEntry->u.procEntry.paramTypes;
+    for (parameters = procDec->u.procedureDeclaration.parameters; !parameters->isEmpty; parameters = parameters->tail) {
+        varEntry = lookup(localTable, parameters->head->name);
+        if (paramTypes->reg != 0 && varEntry->u.varEntry.reg == 0) {
+            commentRRI(out, "stw", paramTypes->reg, frameBaseRegister(procEntry),
+                       frameOffset(procEntry, varEntry->u.varEntry.offset), "store %s", parameters->head->name->string);
+        } else if (paramTypes->reg != 0 && varEntry->u.varEntry.reg != paramTypes->reg) {
+            emitRRI(out, "add", varEntry->u.varEntry.reg, paramTypes->reg, 0);
+        }
+        paramTypes = paramTypes->next;
+    }
+    paramTypes = procEntry->u.procEntry.paramTypes;
+    for (parameters = procDec->u.procedureDeclaration.parameters; !parameters->isEmpty; parameters = parameters->tail) {
+        varEntry = lookup(localTable, parameters->head->name);
+        if (paramTypes->reg == 0 && varEntry->u.varEntry.reg != 0) {
+            commentRRI(out, "ldw", varEntry->u.varEntry.reg, frameBaseRegister(procEntry),
+                       frameOffset(procEntry, varEntry->u.varEntry.offset), "load %s", parameters->head->name->string);
+        }
+        paramTypes = paramTypes->next;
+    }
+}
+
+static void genProcedure(GlobalDeclaration *procDec) {
+    procEntry = lookup(procedures, procDec->name);
+    loopPointers = NULL;
+
+    emit(out, "");
+    emit(out, "\t.export\t%s", procDec->name->string);
+    emitLabel(out, "%s", procDec->name->string);
+    emitPrologue(out, procDec->name, procEntry);
+    genSavedRegisters("stw");
+    genParameters(procDec);
+    beginSelection(procDec, procedures);
+    genStatementList(procDec->u.procedureDeclaration.body);
+    genSavedRegisters("ldw");
+    emitEpilogue(out, procDec->name, procEntry);
+}
+
+void genCode(Program *program, SymbolTable *globalTable, FILE *outFile) {
+    GlobalDeclarationList *declarationList;
 
-    notImplemented();
+    out = outFile;
+    procedures = globalTable;
+    numLabels = 0;
+
+    assemblerProlog(out);
+    for (declarationList = program; !declarationList->isEmpty; declarationList = declarationList->tail) {
+        if (declarationList->head->kind == DECLARATION_PROCEDUREDECLARATION) genProcedure(declarationList->head);
+    }
+    emitProfileRuntime(out);
+    emitStaticVariables(out, program, globalTable);
+    /* the peephole optimizer may still hold the last instructions */
+    flushPeephole(out);
 }
@@ -14,6 +14,20 @@
  * This function is used to generate the assembly code for the compiled program.
  * This code is emitted via the functions provided by codeprint.h .
  *
+ * Expressions, assignments and conditions are translated by the instruction selector of burs.h, whose patterns
+ * are listed in eco32.rules. beginSelection has to be called before the statements of a procedure are emitted.
+ *
+ * An argument whose ParamTypes has a reg is loaded into that register after all arguments have been evaluated,
+ * instead of being stored to the outgoing area. The prologue first moves every parameter arriving in a register
+ * to the register of its VariableEntry, or stores it to its stack slot if that is 0, and only then loads
+ * the parameters passed on the stack which are held in a register.
+ *
+ * A local variable with a staticLabel is addressed by its label, see STATIC_LABEL_FORMAT, e.g. with
+ * "add $8,$0,_static1". The variables are emitted by emitStaticVariables.
+ *
+ * An if-statement with a lowering is emitted by emitSwitch, which is passed the selector in a register and
+ * a unique prefix for its labels. The if-statements of the chain below it are not emitted on their own.
+ *
  * @param program The program for which the assembly code has to be produced.
  * @param globalTable The symbol table for the current program.
  * @param outFile The file pointer where the output has to be emitted to.
@@ -5,10 +5,73 @@
 #include "codeprint.h"
 
 #include <stdarg.h>
+#include <string.h>
+#include <util/errors.h>
+#include "peephole.h"
+#include "immediate.h"
+
+void printInstruction(FILE *out, Instruction *instruction) {
+    const char *separator = "\t\t; ";
+
+    if (instruction->kind == INSTRUCTION_RRI && !fitsImmediate(instruction)) {
+        printLargeImmediate(out, instruction);
+        return;
+    }
+    noteHoistedBase(instruction);
+    switch (instruction->kind) {
+        case INSTRUCTION_RRI:
+            if (strcmp(instruction->opcode, "ldhi") == 0) {
+                /* the value is the high half, the assembler expects it in place and ignores the low half */
+                fprintf(out, "\tldhi\t$%d,0x%X", instruction->reg1, (unsigned) instruction->value << 16);
+                break;
+            }
+            fprintf(out, "\t%s\t$%d,$%d,%d", instruction->opcode, instruction->reg1, instruction->reg2,
+                    instruction->value);
+            break;
+        case INSTRUCTION_RRR:
+            fprintf(out, "\t%s\t$%d,$%d,$%d", instruction->opcode, instruction->reg1, instruction->reg2,
+                    instruction->reg3);
+            break;
+        case INSTRUCTION_RRL:
+            fprintf(out, "\t%s\t$%d,$%d,%s", instruction->opcode, instruction->reg1, instruction->reg2,
+                    instruction->label);
+            break;
+        case INSTRUCTION_R:
+            fprintf(out, "\t%s\t$%d", instruction->opcode, instruction->reg1);
+            separator = "\t\t\t; ";
+            break;
+        case INSTRUCTION_JUMP:
+            fprintf(out, "\tj\t%s", instruction->label);
+            break;
+        case INSTRUCTION_SS:
+            fprintf(out, "\t%s\t%s", instruction->opcode, instruction->label);
+            break;
+        case INSTRUCTION_LABEL:
+            fprintf(out, "%s:", instruction->label);
+            break;
+        default:
+            error("unknown instruction kind %d in printInstruction", instruction->kind);
+    }
+    if (instruction->comment[0] != '\0') fprintf(out, "%s%s", separator, instruction->comment);
+    fprintf(out, "\n");
+}
+
+static void newInstruction(Instruction *instruction, instruction_kind kind, const char *opcode) {
+    instruction->kind = kind;
+    snprintf(instruction->opcode, OPCODE_LENGTH, "%s", opcode);
+    instruction->reg1 = 0;
+    instruction->reg2 = 0;
+    instruction->reg3 = 0;
+    instruction->value = 0;
+    instruction->label[0] = '\0';
+    instruction->comment[0] = '\0';
+}
 
 void emit(FILE *out, const char *format, ...) {
     va_list ap;
 
+    flushPeephole(out);
+    noteHoistedBase(NULL);
     va_start(ap, format);
     vfprintf(out, format, ap);
     fprintf(out, "\n");
@@ -16,86 +79,118 @@ void emit(FILE *out, const char *format, ...) {
 }
 
 void emitImport(FILE *out, char *id) {
+    flushPeephole(out);
+    noteHoistedBase(NULL);
     fprintf(out, "\t.import\t%s\n", id);
 }
 
 void emitRRI(FILE *out, const char *opcode, int reg1, int reg2, int value) {
-    fprintf(out, "\t%s\t$%d,$%d,%d\n", opcode, reg1, reg2, value);
+    Instruction instruction;
+
+    newInstruction(&instruction, INSTRUCTION_RRI, opcode);
+    instruction.reg1 = reg1;
+    instruction.reg2 = reg2;
+    instruction.value = value;
+    emitInstruction(out, &instruction);
 }
 
 void commentRRI(FILE *out, const char *opcode, int reg1, int reg2, int value, const char *commentFormat, ...) {
+    Instruction instruction;
     va_list ap;
 
-    fprintf(out, "\t%s\t$%d,$%d,%d", opcode, reg1, reg2, value);
-
+    newInstruction(&instruction, INSTRUCTION_RRI, opcode);
+    instruction.reg1 = reg1;
+    instruction.reg2 = reg2;
+    instruction.value = value;
     va_start(ap, commentFormat);
-    fprintf(out, "\t\t; ");
-    vfprintf(out, commentFormat, ap);
-    fprintf(out, "\n");
+    vsnprintf(instruction.comment, COMMENT_LENGTH, commentFormat, ap);
     va_end(ap);
+    emitInstruction(out, &instruction);
 }
 
 void emitR(FILE *out, const char *opcode, int reg) {
-    fprintf(out, "\t%s\t$%d\n", opcode, reg);
+    Instruction instruction;
+
+    newInstruction(&instruction, INSTRUCTION_R, opcode);
+    instruction.reg1 = reg;
+    emitInstruction(out, &instruction);
 }
 
 void commentR(FILE *out, const char *opcode, int reg, const char *commentFormat, ...) {
+    Instruction instruction;
     va_list  ap;
 
-    fprintf(out, "\t%s\t$%d", opcode, reg);
-
+    newInstruction(&instruction, INSTRUCTION_R, opcode);
+    instruction.reg1 = reg;
     va_start(ap, commentFormat);
-    fprintf(out, "\t\t\t; ");
-    vfprintf(out, commentFormat, ap);
-    fprintf(out, "\n");
+    vsnprintf(instruction.comment, COMMENT_LENGTH, commentFormat, ap);
     va_end(ap);
+    emitInstruction(out, &instruction);
 }
 
 void emitRRR(FILE *out, const char *opcode, int reg1, int reg2, int reg3) {
-    fprintf(out, "\t%s\t$%d,$%d,$%d\n", opcode, reg1, reg2, reg3);
+    Instruction instruction;
+
+    newInstruction(&instruction, INSTRUCTION_RRR, opcode);
+    instruction.reg1 = reg1;
+    instruction.reg2 = reg2;
+    instruction.reg3 = reg3;
+    emitInstruction(out, &instruction);
 }
 
 void commentRRR(FILE *out, const char *opcode, int reg1, int reg2, int reg3, const char *commentFormat, ...) {
+    Instruction instruction;
     va_list ap;
 
-    fprintf(out, "\t%s\t$%d,$%d,$%d", opcode, reg1, reg2, reg3);
-
+    newInstruction(&instruction, INSTRUCTION_RRR, opcode);
+    instruction.reg1 = reg1;
+    instruction.reg2 = reg2;
+    instruction.reg3 = reg3;
     va_start(ap, commentFormat);
-    fprintf(out, "\t\t; ");
-    vfprintf(out, commentFormat, ap);
-    fprintf(out, "\n");
+    vsnprintf(instruction.comment, COMMENT_LENGTH, commentFormat, ap);
     va_end(ap);
+    emitInstruction(out, &instruction);
 }
 
 void emitRRL(FILE *out, const char *opcode, int reg1, int reg2, const char *labelFormat, ...) {
+    Instruction instruction;
     va_list ap;
     // print("\t%s\t$%d,$%d,%s\n", opcode, reg1, reg2, label)
+    newInstruction(&instruction, INSTRUCTION_RRL, opcode);
+    instruction.reg1 = reg1;
+    instruction.reg2 = reg2;
     va_start(ap, labelFormat);
-    fprintf(out, "\t%s\t$%d,$%d,", opcode, reg1, reg2);
-    vfprintf(out, labelFormat, ap);
-    fprintf(out, "\n");
+    vsnprintf(instruction.label, LABEL_LENGTH, labelFormat, ap);
     va_end(ap);
+    emitInstruction(out, &instruction);
 }
 
 void emitLabel(FILE *out, const char *labelFormat, ...) {
+    Instruction instruction;
     va_list ap;
     // print("%s:\n", label)
+    newInstruction(&instruction, INSTRUCTION_LABEL, "");
     va_start(ap, labelFormat);
-    vfprintf(out, labelFormat, ap);
-    fprintf(out, ":\n");
+    vsnprintf(instruction.label, LABEL_LENGTH, labelFormat, ap);
     va_end(ap);
+    emitInstruction(out, &instruction);
 }
 
 void emitJump(FILE *out, const char *labelFormat, ...) {
+    Instruction instruction;
     va_list ap;
     // print("\tj\t%s\n", label)
+    newInstruction(&instruction, INSTRUCTION_JUMP, "j");
     va_start(ap, labelFormat);
-    fprintf(out, "\tj\t");
-    vfprintf(out, labelFormat, ap);
-    fprintf(out, "\n");
+    vsnprintf(instruction.label, LABEL_LENGTH, labelFormat, ap);
     va_end(ap);
+    emitInstruction(out, &instruction);
 }
 
 void emitSS(FILE *out, const char *s1, const char *s2) {
-    fprintf(out, "\t%s\t%s\n", s1, s2);
+    Instruction instruction;
+
+    newInstruction(&instruction, INSTRUCTION_SS, s1);
+    snprintf(instruction.label, LABEL_LENGTH, "%s", s2);
+    emitInstruction(out, &instruction);
 }
@@ -7,6 +7,42 @@
 
 #include <stdio.h>
 
+#define OPCODE_LENGTH 8
+#define LABEL_LENGTH 256
+#define COMMENT_LENGTH 256
+
+typedef enum {
+    INSTRUCTION_RRI,    /* opcode reg1,reg2,value */
+    INSTRUCTION_RRR,    /* opcode reg1,reg2,reg3 */
+    INSTRUCTION_RRL,    /* opcode reg1,reg2,label */
+    INSTRUCTION_R,      /* opcode reg1 */
+    INSTRUCTION_JUMP,   /* j label */
+    INSTRUCTION_SS,     /* opcode label, e.g. a call */
+    INSTRUCTION_LABEL   /* label: */
+} instruction_kind;
+
+/**
+ * An instruction as it is passed from the code generator to the printing functions.
+ */
+typedef struct {
+    instruction_kind kind;
+    char opcode[OPCODE_LENGTH];
+    int reg1;
+    int reg2;
+    int reg3;
+    int value;
+    char label[LABEL_LENGTH];
+    char comment[COMMENT_LENGTH];   /* empty if the instruction has no comment */
+} Instruction;
+
+/**
+ * Prints an instruction in the syntax of the ECO32 assembler, without passing it through the peephole optimizer.
+ * An immediate value which does not fit into the instruction is loaded by the sequence of printLargeImmediate.
+ * @param out The file pointer where the output has to be emitted to.
+ * @param instruction The instruction to print.
+ */
+void printInstruction(FILE *out, Instruction *instruction);
+
 void emit(FILE *out, const char *format, ...);
 
 void emitImport(FILE *out, char *id);
@@ -0,0 +1,340 @@
+/*
+ * constarith.c -- multiplication and division by constants
+ */
+
+#include <string.h>
+#include <util/errors.h>
+#include <absyn/absyn.h>
+#include "codeprint.h"
+#include "constarith.h"
+
+#define MAX_SEQUENCE_LENGTH 40
+
+int mulCycles = 1;
+int divCycles = 1;
+
+/**
+ * Cycles needed by the ECO32 instructions used for constant operations and by the instruction selector,
+ * apart from the multiplication and the division, which take mulCycles and divCycles.
+ */
+static const struct {
+    char *opcode;
+    int cycles;
+} costTable[] = {
+    {"add",  1},
+    {"sub",  1},
+    {"and",  1},
+    {"sll",  1},
+    {"slr",  1},
+    {"sar",  1},
+    {"ldw",  1},
+    {"stw",  1},
+    {"beq",  1},
+    {"bne",  1},
+    {"blt",  1},
+    {"ble",  1},
+    {"bgt",  1},
+    {"bge",  1},
+    {"bgeu", 1},
+};
+
+/**
+ * One instruction of a sequence, either with three registers or with two registers and an immediate value.
+ */
+typedef struct {
+    char *opcode;
+    int target;
+    int source;
+    bool immediate;
+    int operand;
+} Step;
+
+typedef struct {
+    int length;
+    Step code[MAX_SEQUENCE_LENGTH];
+} Sequence;
+
+int instructionCost(const char *opcode, int immediate) {
+    int i, cycles;
+
+    cycles = 0;
+    if (strcmp(opcode, "mul") == 0 || strcmp(opcode, "mulu") == 0) cycles = mulCycles;
+    if (strcmp(opcode, "div") == 0) cycles = divCycles;
+    for (i = 0; i < (int) (sizeof(costTable) / sizeof(costTable[0])); i++) {
+        if (strcmp(costTable[i].opcode, opcode) == 0) cycles = costTable[i].cycles;
+    }
+    if (cycles == 0) error("unknown opcode '%s' in instructionCost", opcode);
+    /* larger values are loaded with ldhi and or into $1, see printLargeImmediate */
+    if (immediate < -32768 || immediate > 32767) cycles += 2;
+    return cycles;
+}
+
+static void append(Sequence *sequence, char *opcode, int target, int source, bool immediate, int operand) {
+    Step *instruction;
+
+    if (sequence->length == MAX_SEQUENCE_LENGTH) error("instruction sequence too long");
+    instruction = &sequence->code[sequence->length++];
+    instruction->opcode = opcode;
+    instruction->target = target;
+    instruction->source = source;
+    instruction->immediate = immediate;
+    instruction->operand = operand;
+}
+
+static void appendRRR(Sequence *sequence, char *opcode, int target, int source, int operand) {
+    append(sequence, opcode, target, source, false, operand);
+}
+
+static void appendRRI(Sequence *sequence, char *opcode, int target, int source, int operand) {
+    append(sequence, opcode, target, source, true, operand);
+}
+
+static int sequenceCost(Sequence *sequence) {
+    int i, cycles;
+
+    cycles = 0;
+    for (i = 0; i < sequence->length; i++) {
+        /* logical immediates are zero-extended, 0xFFFF still fits */
+        if (strcmp(sequence->code[i].opcode, "and") == 0) cycles += instructionCost("and", 0);
+        else cycles += instructionCost(sequence->code[i].opcode,
+                                       sequence->code[i].immediate ? sequence->code[i].operand : 0);
+    }
+    return cycles;
+}
+
+/**
+ * Returns the number of registers above reg the sequence writes to.
+ */
+static int sequenceTemporaries(Sequence *sequence, int reg) {
+    int i, temporaries;
+
+    temporaries = 0;
+    for (i = 0; i < sequence->length; i++) {
+        if (sequence->code[i].target - reg > temporaries) temporaries = sequence->code[i].target - reg;
+    }
+    return temporaries;
+}
+
+static void emitSequence(FILE *out, Sequence *sequence) {
+    Step *instruction;
+    int i;
+
+    for (i = 0; i < sequence->length; i++) {
+        instruction = &sequence->code[i];
+        if (instruction->immediate) {
+            emitRRI(out, instruction->opcode, instruction->target, instruction->source, instruction->operand);
+        } else {
+            emitRRR(out, instruction->opcode, instruction->target, instruction->source, instruction->operand);
+        }
+    }
+}
+
+/**
+ * Returns the magnitude of a constant, which is representable even for the smallest int.
+ */
+static unsigned magnitude(int constant) {
+    return constant < 0 ? -(unsigned) constant : (unsigned) constant;
+}
+
+static int powerOfTwo(unsigned value) {
+    int k;
+
+    if (value == 0 || (value & (value - 1)) != 0) return -1;
+    for (k = 0; (1u << k) != value; k++);
+    return k;
+}
+
+/*
+ * Multiplication
+ */
+
+/**
+ * Builds reg := reg * constant.
+ * The constant is written in the non-adjacent form, i.e. as a sum of powers of two with signs, where no two
+ * neighboring digits are non-zero. The digits are processed from the highest one with Horner's method,
+ * so every further digit costs one shift and one addition or subtraction of the original value in reg + 1.
+ */
+static void multiplySequence(Sequence *sequence, int reg, int constant) {
+    int digits[34];
+    unsigned long long value;
+    int position, previous, k;
+
+    sequence->length = 0;
+    if (constant == 0) {
+        appendRRI(sequence, "add", reg, 0, 0);
+        return;
+    }
+    k = powerOfTwo(magnitude(constant));
+    if (k >= 0) {
+        if (k > 0) appendRRI(sequence, "sll", reg, reg, k);
+    } else {
+        value = magnitude(constant);
+        for (position = 0; value != 0; position++) {
+            if (value & 1) {
+                digits[position] = (value & 3) == 3 ? -1 : 1;
+                value -= digits[position];
+            } else {
+                digits[position] = 0;
+            }
+            value >>= 1;
+        }
+
+        /* the highest digit of a positive number is always 1 */
+        previous = position - 1;
+        appendRRR(sequence, "add", reg + 1, reg, 0);
+        for (position = previous - 1; position >= 0; position--) {
+            if (digits[position] == 0) continue;
+            appendRRI(sequence, "sll", reg, reg, previous - position);
+            appendRRR(sequence, digits[position] > 0 ? "add" : "sub", reg, reg, reg + 1);
+            previous = position;
+        }
+        if (previous > 0) appendRRI(sequence, "sll", reg, reg, previous);
+    }
+    if (constant < 0) appendRRR(sequence, "sub", reg, 0, reg);
+}
+
+/*
+ * Division
+ */
+
+DivisionMagic divisionMagic(int divisor) {
+    const unsigned two31 = 0x80000000u;
+    unsigned absoluteDivisor, t, absoluteNc, q1, r1, q2, r2, delta;
+    DivisionMagic magic;
+    int p;
+
+    absoluteDivisor = magnitude(divisor);
+    t = two31 + ((unsigned) divisor >> 31);
+    absoluteNc = t - 1 - t % absoluteDivisor;
+    p = 31;
+    q1 = two31 / absoluteNc;
+    r1 = two31 - q1 * absoluteNc;
+    q2 = two31 / absoluteDivisor;
+    r2 = two31 - q2 * absoluteDivisor;
+    do {
+        p++;
+        q1 = 2 * q1;
+        r1 = 2 * r1;
+        if (r1 >= absoluteNc) {
+            q1++;
+            r1 -= absoluteNc;
+        }
+        q2 = 2 * q2;
+        r2 = 2 * r2;
+        if (r2 >= absoluteDivisor) {
+            q2++;
+            r2 -= absoluteDivisor;
+        }
+        delta = absoluteDivisor - r2;
+    } while (q1 < delta || (q1 == delta && r1 == 0));
+
+    magic.multiplier = (int) (q2 + 1);
+    if (divisor < 0) magic.multiplier = (int) -(q2 + 1);
+    magic.shift = p - 32;
+    return magic;
+}
+
+/**
+ * Builds reg := reg / 2^k for the divisor +/- 2^k.
+ * Adding 2^k - 1 to a negative dividend before the shift rounds the quotient toward zero.
+ */
+static void shiftDivisionSequence(Sequence *sequence, int reg, int divisor, int k) {
+    sequence->length = 0;
+    if (k > 1) {
+        appendRRI(sequence, "sar", reg + 1, reg, k - 1);
+        appendRRI(sequence, "slr", reg + 1, reg + 1, 32 - k);
+    } else {
+        appendRRI(sequence, "slr", reg + 1, reg, 31);
+    }
+    appendRRR(sequence, "add", reg, reg, reg + 1);
+    appendRRI(sequence, "sar", reg, reg, k);
+    if (divisor < 0) appendRRR(sequence, "sub", reg, 0, reg);
+}
+
+/**
+ * Builds reg := reg / divisor with the magic number of the divisor.
+ * The high word of the product is composed of the products of the 16 bit halves u1:u0 of the dividend
+ * and v1:v0 of the multiplier, where u1 and v1 are signed and u0 and v0 unsigned.
+ */
+static void magicDivisionSequence(Sequence *sequence, int reg, int divisor) {
+    DivisionMagic magic = divisionMagic(divisor);
+    int v0 = magic.multiplier & 0xFFFF;
+    int v1 = magic.multiplier >> 16;
+    int u0 = reg + 1, u1 = reg + 2, high = reg + 3, low = reg + 4;
+
+    sequence->length = 0;
+    appendRRI(sequence, "and", u0, reg, 0xFFFF);
+    appendRRI(sequence, "sar", u1, reg, 16);
+    appendRRI(sequence, "mul", high, u1, v1);         /* u1 * v1 */
+    appendRRI(sequence, "mul", u1, u1, v0);           /* u1 * v0 */
+    appendRRI(sequence, "mulu", low, u0, v0);         /* u0 * v0 */
+    appendRRI(sequence, "slr", low, low, 16);
+    appendRRR(sequence, "add", u1, u1, low);          /* middle part of u1 * v0 and the carry of u0 * v0 */
+    appendRRI(sequence, "and", low, u1, 0xFFFF);
+    appendRRI(sequence, "sar", u1, u1, 16);
+    appendRRR(sequence, "add", high, high, u1);
+    appendRRI(sequence, "mul", u0, u0, v1);           /* u0 * v1 */
+    appendRRR(sequence, "add", u0, u0, low);
+    appendRRI(sequence, "sar", u0, u0, 16);
+    appendRRR(sequence, "add", high, high, u0);       /* high word of dividend * multiplier */
+
+    if (divisor > 0 && magic.multiplier < 0) appendRRR(sequence, "add", high, high, reg);
+    if (divisor < 0 && magic.multiplier > 0) appendRRR(sequence, "sub", high, high, reg);
+    if (magic.shift > 0) appendRRI(sequence, "sar", high, high, magic.shift);
+    appendRRI(sequence, "slr", u0, high, 31);
+    appendRRR(sequence, "add", reg, high, u0);
+}
+
+/**
+ * Builds the cheapest replacement of reg := reg / divisor.
+ * @return false if the div instruction has to be used.
+ */
+static bool divisionSequence(Sequence *sequence, int reg, int divisor) {
+    int k;
+
+    sequence->length = 0;
+    /* the quotient of INT_MIN / -1 is defined by the processor */
+    if (divisor == 0 || divisor == -1) return false;
+    if (divisor == 1) return true;
+    k = powerOfTwo(magnitude(divisor));
+    if (k >= 0) shiftDivisionSequence(sequence, reg, divisor, k);
+    else magicDivisionSequence(sequence, reg, divisor);
+    return true;
+}
+
+/**
+ * Builds the cheapest sequence for "reg := reg * constant" or "reg := reg / constant".
+ * @return false if the mul or div instruction is cheaper or no sequence is possible.
+ */
+static bool buildConstantSequence(Sequence *sequence, binary_operator operator, int reg, int constant) {
+    switch (operator) {
+        case ABSYN_OP_MUL:
+            multiplySequence(sequence, reg, constant);
+            /* at the same cost, a shift is preferred to a multiplication */
+            return sequenceCost(sequence) <= instructionCost("mul", constant);
+        case ABSYN_OP_DIV:
+            return divisionSequence(sequence, reg, constant) &&
+                   sequenceCost(sequence) < instructionCost("div", constant);
+        default:
+            error("unknown operator %d in buildConstantSequence", operator);
+            return false;
+    }
+}
+
+int constantOperationCost(binary_operator operator, int constant) {
+    Sequence sequence;
+
+    if (buildConstantSequence(&sequence, operator, 0, constant)) return sequenceCost(&sequence);
+    return instructionCost(operator == ABSYN_OP_MUL ? "mul" : "div", constant);
+}
+
+void emitConstantOperation(FILE *out, binary_operator operator, int reg, int constant, int freeRegisters) {
+    Sequence sequence;
+
+    if (buildConstantSequence(&sequence, operator, reg, constant) &&
+        sequenceTemporaries(&sequence, reg) <= freeRegisters) {
+        emitSequence(out, &sequence);
+    } else {
+        emitRRI(out, operator == ABSYN_OP_MUL ? "mul" : "div", reg, reg, constant);
+    }
+}
@@ -0,0 +1,79 @@
+/*
+ * constarith.h -- multiplication and division by constants
+ */
+
+
+#ifndef _CONSTARITH_H_
+#define _CONSTARITH_H_
+
+#include <stdio.h>
+#include <absyn/absyn.h>
+
+/**
+ * The cycles of the mul and mulu instructions and of the div instruction in the cost table, set with
+ * --mul-cycles and --div-cycles. The simulator executes them in a single step like any other instruction,
+ * so by default only a multiplication by a power of two is replaced, by a shift. A sequential unit needs
+ * about one cycle per bit, a division by a magic number only pays off with a multiplier which is much
+ * faster than the divider.
+ */
+extern int mulCycles;
+extern int divCycles;
+
+/**
+ * The magic number for a signed division by a constant, as described in "Hacker's Delight", chapter 10.
+ * n / divisor is computed as the high word of n * multiplier, corrected by adding (or subtracting) n if the
+ * sign of the multiplier differs from the sign of the divisor, shifted right arithmetically by shift,
+ * plus one if the result is negative.
+ */
+typedef struct {
+    int multiplier;
+    int shift;
+} DivisionMagic;
+
+/**
+ * Computes the magic number for a signed division.
+ * @param divisor The divisor, which must not be -1, 0 or 1.
+ * @return The multiplier and the shift amount.
+ */
+DivisionMagic divisionMagic(int divisor);
+
+/**
+ * Computes the cost of an instruction according to the cost table of the ECO32.
+ * @param opcode The mnemonic of the instruction.
+ * @param immediate The immediate operand, or 0 if the instruction only has register operands.
+ * @return The estimated number of cycles, including the instructions the assembler inserts for an
+ * immediate value which does not fit into 16 bits.
+ */
+int instructionCost(const char *opcode, int immediate);
+
+/**
+ * Computes the cost of "reg := reg * constant" or "reg := reg / constant" as emitted by emitConstantOperation,
+ * assuming enough registers are free for the cheapest sequence.
+ * @param operator Either ABSYN_OP_MUL or ABSYN_OP_DIV.
+ * @param constant The right operand.
+ * @return The estimated number of cycles.
+ */
+int constantOperationCost(binary_operator operator, int constant);
+
+/**
+ * Emits the code for "reg := reg * constant" or "reg := reg / constant".
+ *
+ * A multiplication is replaced by a shift if the constant is a power of two, and otherwise by a sequence
+ * of shifts and additions following the signed digit representation of the constant.
+ * A division by a power of two is replaced by an arithmetic shift, which is corrected for negative
+ * dividends, so the quotient is still rounded toward zero. Other divisors use the magic number from
+ * divisionMagic with a high multiplication composed of 16 bit halves, since the ECO32 has no instruction
+ * for the upper word of a product.
+ * A sequence is only used if it is cheaper than the div instruction, or not more expensive than the mul
+ * instruction, according to the cost table and the registers it needs are available. Division by 0 and
+ * by -1 always uses the div instruction, so its behavior on the processor is preserved.
+ *
+ * @param out The file pointer where the output has to be emitted to.
+ * @param operator Either ABSYN_OP_MUL or ABSYN_OP_DIV.
+ * @param reg The register holding the left operand and receiving the result.
+ * @param constant The right operand.
+ * @param freeRegisters The number of registers above reg, which may be used for intermediate results.
+ */
+void emitConstantOperation(FILE *out, binary_operator operator, int reg, int constant, int freeRegisters);
+
+#endif /* _CONSTARITH_H_ */
@@ -0,0 +1,136 @@
+/*
+ * immediate.c -- instructions with immediate values which do not fit into 16 bits
+ */
+
+#include <string.h>
+#include "codeprint.h"
+#include "immediate.h"
+
+#define NO_BASE (-1)
+
+static int hoistedBase = NO_BASE;       /* the base register added to the high half in $1 */
+static int hoistedHigh;
+
+static bool isOpcodeIn(Instruction *instruction, const char **opcodes, int count) {
+    int i;
+
+    for (i = 0; i < count; i++) {
+        if (strcmp(instruction->opcode, opcodes[i]) == 0) return true;
+    }
+    return false;
+}
+
+static bool isMemoryAccess(Instruction *instruction) {
+    static const char *opcodes[] = {"ldw", "ldh", "ldhu", "ldb", "ldbu", "stw", "sth", "stb"};
+
+    return isOpcodeIn(instruction, opcodes, sizeof(opcodes) / sizeof(opcodes[0]));
+}
+
+static bool isStore(Instruction *instruction) {
+    static const char *opcodes[] = {"stw", "sth", "stb"};
+
+    return isOpcodeIn(instruction, opcodes, sizeof(opcodes) / sizeof(opcodes[0]));
+}
+
+bool fitsImmediate(Instruction *instruction) {
+    static const char *unsignedOpcodes[] = {"mulu", "divu", "remu", "and", "or", "xor", "xnor", "ldhi"};
+    static const char *shiftOpcodes[] = {"sll", "slr", "sar"};
+    int value;
+
+    value = instruction->value;
+    if (isOpcodeIn(instruction, unsignedOpcodes, sizeof(unsignedOpcodes) / sizeof(unsignedOpcodes[0]))) {
+        return value >= 0 && value <= 65535;
+    }
+    if (isOpcodeIn(instruction, shiftOpcodes, sizeof(shiftOpcodes) / sizeof(shiftOpcodes[0]))) {
+        return value >= 0 && value <= 31;
+    }
+    return value >= -32768 && value <= 32767;
+}
+
+void noteHoistedBase(Instruction *instruction) {
+    int written;
+
+    if (hoistedBase == NO_BASE) return;
+    /* the assembler may load the address of a label into $1 */
+    if (instruction == NULL || (instruction->kind != INSTRUCTION_RRI && instruction->kind != INSTRUCTION_RRR)) {
+        hoistedBase = NO_BASE;
+        return;
+    }
+    if (instruction->kind == INSTRUCTION_RRI && isStore(instruction)) return;
+    written = instruction->reg1;
+    if (written == ASSEMBLER_REGISTER || written == hoistedBase) hoistedBase = NO_BASE;
+}
+
+static void printPiece(FILE *out, instruction_kind kind, const char *opcode, int reg1, int reg2, int operand,
+                       const char *comment) {
+    Instruction piece;
+
+    memset(&piece, 0, sizeof(piece));
+    piece.kind = kind;
+    snprintf(piece.opcode, OPCODE_LENGTH, "%s", opcode);
+    piece.reg1 = reg1;
+    piece.reg2 = reg2;
+    if (kind == INSTRUCTION_RRR) {
+        piece.reg3 = operand;
+    } else {
+        piece.value = operand;
+    }
+    snprintf(piece.comment, COMMENT_LENGTH, "%s", comment);
+    printInstruction(out, &piece);
+}
+
+/**
+ * Loads a constant into a register with one or two instructions.
+ */
+static void printConstant(FILE *out, int reg, int value, const char *comment) {
+    unsigned bits;
+
+    bits = (unsigned) value;
+    if (value >= -32768 && value <= 32767) {
+        printPiece(out, INSTRUCTION_RRI, "add", reg, 0, value, comment);
+    } else if (bits <= 0xFFFF) {
+        printPiece(out, INSTRUCTION_RRI, "or", reg, 0, (int) bits, comment);
+    } else if ((bits & 0xFFFF) == 0) {
+        printPiece(out, INSTRUCTION_RRI, "ldhi", reg, 0, (int) (bits >> 16), comment);
+    } else {
+        printPiece(out, INSTRUCTION_RRI, "ldhi", reg, 0, (int) (bits >> 16), "");
+        printPiece(out, INSTRUCTION_RRI, "or", reg, reg, (int) (bits & 0xFFFF), comment);
+    }
+}
+
+/**
+ * Prints an instruction adding a large offset to $0, $25 or $29, with the high half of the offset
+ * and the base register in $1.
+ */
+static void printWithHoistedBase(FILE *out, Instruction *instruction) {
+    int low, high;
+
+    /* the low half is sign-extended by the instruction, the high half compensates for that */
+    low = (int) (short) (instruction->value & 0xFFFF);
+    high = (int) ((((unsigned) instruction->value - (unsigned) low) >> 16) & 0xFFFF);
+    if (hoistedBase != instruction->reg2 || hoistedHigh != high) {
+        printPiece(out, INSTRUCTION_RRI, "ldhi", ASSEMBLER_REGISTER, 0, high, "");
+        if (instruction->reg2 != 0) {
+            printPiece(out, INSTRUCTION_RRR, "add", ASSEMBLER_REGISTER, ASSEMBLER_REGISTER, instruction->reg2, "");
+        }
+        hoistedBase = instruction->reg2;
+        hoistedHigh = high;
+    }
+    printPiece(out, INSTRUCTION_RRI, instruction->opcode, instruction->reg1, ASSEMBLER_REGISTER, low,
+               instruction->comment);
+}
+
+void printLargeImmediate(FILE *out, Instruction *instruction) {
+    bool isBase;
+
+    isBase = instruction->reg2 == 0 || instruction->reg2 == 25 || instruction->reg2 == 29;
+    if (instruction->reg2 == 0 && (strcmp(instruction->opcode, "add") == 0 || strcmp(instruction->opcode, "or") == 0)) {
+        printConstant(out, instruction->reg1, instruction->value, instruction->comment);
+    } else if (isMemoryAccess(instruction) || (isBase && strcmp(instruction->opcode, "add") == 0)) {
+        printWithHoistedBase(out, instruction);
+    } else {
+        printConstant(out, ASSEMBLER_REGISTER, instruction->value, "");
+        printPiece(out, INSTRUCTION_RRR, instruction->opcode, instruction->reg1, instruction->reg2,
+                   ASSEMBLER_REGISTER, instruction->comment);
+    }
+}
@@ -0,0 +1,45 @@
+/*
+ * immediate.h -- instructions with immediate values which do not fit into 16 bits
+ */
+
+
+#ifndef _IMMEDIATE_H_
+#define _IMMEDIATE_H_
+
+#include <stdio.h>
+#include <stdbool.h>
+#include "codeprint.h"
+
+#define ASSEMBLER_REGISTER 1    /* $1 is reserved for the assembler and free between two instructions */
+
+/**
+ * Checks whether the immediate value of an instruction fits into its 16 bit field.
+ * Arithmetic operations, loads and stores sign-extend it, logical and unsigned operations and ldhi zero-extend it.
+ * @param instruction An instruction of kind INSTRUCTION_RRI.
+ * @return true if the instruction can be printed as it is.
+ */
+bool fitsImmediate(Instruction *instruction);
+
+/**
+ * Prints an instruction whose immediate value does not fit, as the cheapest sequence of instructions.
+ *
+ * A constant loaded by "add $r,$0,k" or "or $r,$0,k" becomes "ldhi $r,high" followed by "or $r,$r,low" if
+ * the low half is not 0. A load or store, and an address computed by add from $0, $25 or $29, gets its base
+ * from "ldhi $1,high; add $1,$1,$base" and keeps the low half, sign-extended, as its offset. This base is
+ * remembered: as long as neither $1 nor the base register are written and no label, jump or call is printed,
+ * further large offsets with the same high half only need the final instruction. All other operations load the
+ * value into $1 and use their form with three registers. Values fitting into 16 bits zero-extended are loaded
+ * by a single or.
+ *
+ * @param out The file pointer where the output has to be emitted to.
+ * @param instruction The instruction, for which fitsImmediate returned false.
+ */
+void printLargeImmediate(FILE *out, Instruction *instruction);
+
+/**
+ * Forgets the base held in $1 if the instruction could change it. printInstruction calls it for every instruction.
+ * @param instruction The instruction which is printed, or NULL for anything else printed, like a directive.
+ */
+void noteHoistedBase(Instruction *instruction);
+
+#endif /* _IMMEDIATE_H_ */
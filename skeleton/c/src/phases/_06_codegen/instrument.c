@@ -0,0 +1,89 @@
+/*
+ * instrument.c -- execution counters for an instrumented build
+ */
+
+#include "instrument.h"
+
+#include <string.h>
+#include <absyn/absyn.h>
+#include "codeprint.h"
+
+#define DUMP_FRAME_SIZE 16      /* outgoing argument, $17, $16 and the return register */
+#define PROFILE_LOOP_LABEL "_profileLoop"
+
+int numProfileCounters = 0;
+
+void emitProfileIncrement(FILE *out, Statement *statement, int offset, int reg) {
+    int address;
+
+    if (numProfileCounters == 0 || statement->profileCounter < 0) return;
+    address = 4 * (statement->profileCounter + offset);
+    emitRRL(out, "ldw", reg, 0, "%s+%d", PROFILE_DATA_LABEL, address);
+    emitRRI(out, "add", reg, reg, 1);
+    emitRRL(out, "stw", reg, 0, "%s+%d", PROFILE_DATA_LABEL, address);
+}
+
+const char *profiledCallTarget(Identifier *procedure) {
+    if (numProfileCounters > 0 && strcmp(procedure->string, "exit") == 0) return PROFILE_EXIT_LABEL;
+    return procedure->string;
+}
+
+void emitProfileDumpCall(FILE *out) {
+    if (numProfileCounters == 0) return;
+    emitSS(out, "jal", PROFILE_DUMP_LABEL);
+}
+
+/**
+ * Emits the call of a predefined procedure taking one argument.
+ */
+static void emitPrint(FILE *out, const char *procedure, int reg) {
+    commentRRI(out, "stw", reg, 29, 0, "store arg #0");
+    emitSS(out, "jal", procedure);
+}
+
+void emitProfileRuntime(FILE *out) {
+    const char *header = "#profile ";
+    int i;
+
+    if (numProfileCounters == 0) return;
+    emit(out, "");
+    emitLabel(out, PROFILE_DUMP_LABEL);
+    commentRRI(out, "sub", 29, 29, DUMP_FRAME_SIZE, "allocate frame");
+    commentRRI(out, "stw", 31, 29, 12, "save return register");
+    emitRRI(out, "stw", 16, 29, 8);
+    emitRRI(out, "stw", 17, 29, 4);
+    for (i = 0; header[i] != '\0'; i++) {
+        emitRRI(out, "add", 8, 0, header[i]);
+        emitPrint(out, "printc", 8);
+    }
+    emitRRI(out, "add", 8, 0, numProfileCounters);
+    emitPrint(out, "printi", 8);
+    emitRRI(out, "add", 8, 0, '\n');
+    emitPrint(out, "printc", 8);
+    /* $16 walks through the counters, $17 holds the end of the data area */
+    emitRRI(out, "add", 16, 0, 0);
+    emitRRI(out, "add", 17, 0, 4 * numProfileCounters);
+    emitLabel(out, "%s", PROFILE_LOOP_LABEL);
+    emitRRL(out, "ldw", 8, 16, "%s", PROFILE_DATA_LABEL);
+    emitPrint(out, "printi", 8);
+    emitRRI(out, "add", 8, 0, '\n');
+    emitPrint(out, "printc", 8);
+    emitRRI(out, "add", 16, 16, 4);
+    emitRRL(out, "bltu", 16, 17, "%s", PROFILE_LOOP_LABEL);
+    emitRRI(out, "ldw", 17, 29, 4);
+    emitRRI(out, "ldw", 16, 29, 8);
+    commentRRI(out, "ldw", 31, 29, 12, "restore return register");
+    commentRRI(out, "add", 29, 29, DUMP_FRAME_SIZE, "release frame");
+    commentR(out, "jr", 31, "return");
+
+    emit(out, "");
+    emitLabel(out, PROFILE_EXIT_LABEL);
+    emitSS(out, "jal", PROFILE_DUMP_LABEL);
+    emitJump(out, "exit");
+
+    emit(out, "");
+    emit(out, "\t.data");
+    emit(out, "\t.align\t4");
+    emit(out, "%s:", PROFILE_DATA_LABEL);
+    emit(out, "\t.space\t%d", 4 * numProfileCounters);
+}
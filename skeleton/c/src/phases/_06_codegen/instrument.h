@@ -0,0 +1,62 @@
+/*
+ * instrument.h -- execution counters for an instrumented build
+ */
+
+
+#ifndef _INSTRUMENT_H_
+#define _INSTRUMENT_H_
+
+#include <stdio.h>
+#include <absyn/absyn.h>
+
+#define PROFILE_DUMP_LABEL "_profileDump"
+#define PROFILE_EXIT_LABEL "_profileExit"
+#define PROFILE_DATA_LABEL "_profileCounters"
+
+/**
+ * The number of execution counters of the program, 0 unless it is compiled with --profile-generate.
+ */
+extern int numProfileCounters;
+
+/**
+ * Emits the increment of an execution counter, if the code is instrumented and the statement has a counter.
+ *
+ * The code generator calls it at the start of the then-part and of the else-part of an if-statement
+ * with PROFILE_THEN and PROFILE_ELSE, at the start of the body of a while-statement and in front of
+ * a call statement, each with the counters numbered by numberProfileCounters.
+ * The counter is loaded from the data area, incremented and stored back by three instructions.
+ *
+ * @param out The file pointer where the output has to be emitted to.
+ * @param statement An if-, while- or call statement.
+ * @param offset PROFILE_THEN or PROFILE_ELSE for an if-statement, otherwise 0.
+ * @param reg A register which is free at this point.
+ */
+void emitProfileIncrement(FILE *out, Statement *statement, int offset, int reg);
+
+/**
+ * Finds the label to jump to for a call.
+ * In an instrumented program, a call of exit has to print the counters first, so it calls PROFILE_EXIT_LABEL.
+ * @param procedure The name of the called procedure.
+ * @return The label of the procedure to call.
+ */
+const char *profiledCallTarget(Identifier *procedure);
+
+/**
+ * Emits the call printing the counters, if the code is instrumented.
+ * emitEpilogue calls it in the epilogue of main, before the return register is restored.
+ * @param out The file pointer where the output has to be emitted to.
+ */
+void emitProfileDumpCall(FILE *out);
+
+/**
+ * Emits the routines printing the counters and the data area holding them, if the code is instrumented.
+ *
+ * PROFILE_DUMP_LABEL prints the line "#profile n" and the n counters on a line each through printi and printc,
+ * so the output of the simulator can be passed to --profile-use without any changes to the simulator.
+ * PROFILE_EXIT_LABEL prints the counters and continues with exit. The counters follow in the data segment.
+ *
+ * @param out The file pointer where the output has to be emitted to.
+ */
+void emitProfileRuntime(FILE *out);
+
+#endif /* _INSTRUMENT_H_ */
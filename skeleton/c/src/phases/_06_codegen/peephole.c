@@ -0,0 +1,352 @@
+/*
+ * peephole.c -- peephole optimization of the emitted instructions
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <util/errors.h>
+#include "codeprint.h"
+#include "peephole.h"
+
+#define WINDOW_SIZE 8
+
+#define FIRST_REGISTER 8
+#define LAST_REGISTER 23
+
+/**
+ * A rewrite of the window. It tries to match at the given position and returns whether it changed the window.
+ */
+typedef struct {
+    const char *name;
+    bool (*apply)(int position);
+    int hits;
+} Rule;
+
+bool peepholeEnabled = false;
+
+static Instruction window[WINDOW_SIZE];
+static int windowLength = 0;
+static int numReceived = 0;
+static int numPrinted = 0;
+
+/*
+ * Instructions
+ */
+
+static bool isOpcode(Instruction *instruction, const char *opcode) {
+    return strcmp(instruction->opcode, opcode) == 0;
+}
+
+static bool isLoad(Instruction *instruction) {
+    return instruction->kind == INSTRUCTION_RRI &&
+           (isOpcode(instruction, "ldw") || isOpcode(instruction, "ldh") || isOpcode(instruction, "ldhu") ||
+            isOpcode(instruction, "ldb") || isOpcode(instruction, "ldbu"));
+}
+
+static bool isStore(Instruction *instruction) {
+    return instruction->kind == INSTRUCTION_RRI &&
+           (isOpcode(instruction, "stw") || isOpcode(instruction, "sth") || isOpcode(instruction, "stb"));
+}
+
+static bool isDivision(Instruction *instruction) {
+    return isOpcode(instruction, "div") || isOpcode(instruction, "divu") ||
+           isOpcode(instruction, "rem") || isOpcode(instruction, "remu");
+}
+
+/**
+ * Checks whether the instruction may transfer control, or is the target of a transfer.
+ */
+static bool isBarrier(Instruction *instruction) {
+    return instruction->kind != INSTRUCTION_RRI && instruction->kind != INSTRUCTION_RRR;
+}
+
+static bool readsRegister(Instruction *instruction, int reg) {
+    switch (instruction->kind) {
+        case INSTRUCTION_RRI:
+            if (isStore(instruction)) return instruction->reg1 == reg || instruction->reg2 == reg;
+            return instruction->reg2 == reg;
+        case INSTRUCTION_RRR:
+            return instruction->reg2 == reg || instruction->reg3 == reg;
+        case INSTRUCTION_RRL:
+            return instruction->reg1 == reg || instruction->reg2 == reg;
+        case INSTRUCTION_R:
+            return instruction->reg1 == reg;
+        default:
+            return false;
+    }
+}
+
+/**
+ * @return The register written by the instruction, or -1 if it writes none.
+ */
+static int writtenRegister(Instruction *instruction) {
+    if (instruction->kind == INSTRUCTION_RRR) return instruction->reg1;
+    if (instruction->kind == INSTRUCTION_RRI && !isStore(instruction)) return instruction->reg1;
+    return -1;
+}
+
+/**
+ * Checks whether the value of a register written at a position is overwritten before it is read again.
+ */
+static bool isDeadAfter(int position, int reg) {
+    int i;
+
+    for (i = position + 1; i < windowLength; i++) {
+        if (isBarrier(&window[i]) || readsRegister(&window[i], reg)) return false;
+        if (writtenRegister(&window[i]) == reg) return true;
+    }
+    return false;
+}
+
+static void removeInstruction(int position) {
+    int i;
+
+    for (i = position; i < windowLength - 1; i++) window[i] = window[i + 1];
+    windowLength--;
+}
+
+static bool isSignedImmediate(long value) {
+    return value >= -32768 && value <= 32767;
+}
+
+/**
+ * Checks whether an operation has a form with an immediate operand which can hold the value.
+ * The arithmetic operations sign-extend their 16 bit immediate, the logical and unsigned ones zero-extend it.
+ */
+static bool hasImmediateForm(Instruction *instruction, int value) {
+    static const char *signedOpcodes[] = {"add", "sub", "mul", "div", "rem"};
+    static const char *unsignedOpcodes[] = {"mulu", "divu", "remu", "and", "or", "xor", "xnor"};
+    static const char *shiftOpcodes[] = {"sll", "slr", "sar"};
+    unsigned i;
+
+    for (i = 0; i < sizeof(signedOpcodes) / sizeof(signedOpcodes[0]); i++) {
+        if (isOpcode(instruction, signedOpcodes[i])) return isSignedImmediate(value);
+    }
+    for (i = 0; i < sizeof(unsignedOpcodes) / sizeof(unsignedOpcodes[0]); i++) {
+        if (isOpcode(instruction, unsignedOpcodes[i])) return value >= 0 && value <= 65535;
+    }
+    for (i = 0; i < sizeof(shiftOpcodes) / sizeof(shiftOpcodes[0]); i++) {
+        if (isOpcode(instruction, shiftOpcodes[i])) return value >= 0 && value <= 31;
+    }
+    return false;
+}
+
+static bool isCommutative(Instruction *instruction) {
+    return isOpcode(instruction, "add") || isOpcode(instruction, "mul") || isOpcode(instruction, "mulu") ||
+           isOpcode(instruction, "and") || isOpcode(instruction, "or") || isOpcode(instruction, "xor") ||
+           isOpcode(instruction, "xnor");
+}
+
+/**
+ * @return The branch taken when the given one is not, or NULL if the opcode is no conditional branch.
+ */
+static const char *invertedBranch(Instruction *branch) {
+    static const char *pairs[][2] = {
+            {"beq", "bne"}, {"blt", "bge"}, {"ble", "bgt"}, {"bltu", "bgeu"}, {"bleu", "bgtu"}
+    };
+    unsigned i;
+
+    for (i = 0; i < sizeof(pairs) / sizeof(pairs[0]); i++) {
+        if (isOpcode(branch, pairs[i][0])) return pairs[i][1];
+        if (isOpcode(branch, pairs[i][1])) return pairs[i][0];
+    }
+    return NULL;
+}
+
+/*
+ * Rules
+ */
+
+/**
+ * "add $a,$b,k1; ldw $c,$a,k2" becomes "add $a,$b,k1; ldw $c,$b,k1+k2".
+ * The addition is removed by removeDeadDefinition if $a is not needed any more.
+ */
+static bool foldAddressOffset(int position) {
+    Instruction *add, *access;
+
+    if (position + 1 >= windowLength) return false;
+    add = &window[position];
+    access = &window[position + 1];
+    if (add->kind != INSTRUCTION_RRI || !isOpcode(add, "add") || add->reg1 == add->reg2) return false;
+    if (!isLoad(access) && !isStore(access)) return false;
+    if (access->reg2 != add->reg1) return false;
+    if (!isSignedImmediate((long) add->value + access->value)) return false;
+    access->reg2 = add->reg2;
+    access->value += add->value;
+    return true;
+}
+
+/**
+ * "add $t,$0,k; add $d,$s,$t" becomes "add $t,$0,k; add $d,$s,k".
+ */
+static bool foldConstantOperand(int position) {
+    Instruction *constant, *operation;
+    int other;
+
+    if (position + 1 >= windowLength) return false;
+    constant = &window[position];
+    operation = &window[position + 1];
+    if (constant->kind != INSTRUCTION_RRI || !isOpcode(constant, "add") || constant->reg2 != 0 ||
+        constant->reg1 == 0) return false;
+    if (operation->kind != INSTRUCTION_RRR || !hasImmediateForm(operation, constant->value)) return false;
+    if (operation->reg3 == constant->reg1 && operation->reg2 != constant->reg1) {
+        other = operation->reg2;
+    } else if (operation->reg2 == constant->reg1 && operation->reg3 != constant->reg1 && isCommutative(operation)) {
+        other = operation->reg3;
+    } else {
+        return false;
+    }
+    operation->kind = INSTRUCTION_RRI;
+    operation->reg2 = other;
+    operation->reg3 = 0;
+    operation->value = constant->value;
+    return true;
+}
+
+/**
+ * Removes "add $a,$a,0" and similar instructions which leave their register unchanged.
+ */
+static bool removeUselessInstruction(int position) {
+    Instruction *instruction;
+
+    instruction = &window[position];
+    if (instruction->kind == INSTRUCTION_RRI) {
+        if (instruction->reg1 != instruction->reg2 || instruction->value != 0) return false;
+        if (!isOpcode(instruction, "add") && !isOpcode(instruction, "sub") && !isOpcode(instruction, "or") &&
+            !isOpcode(instruction, "xor") && !isOpcode(instruction, "sll") && !isOpcode(instruction, "slr") &&
+            !isOpcode(instruction, "sar")) return false;
+    } else if (instruction->kind == INSTRUCTION_RRR) {
+        if (instruction->reg1 != instruction->reg2 || instruction->reg3 != 0) return false;
+        if (!isOpcode(instruction, "add") && !isOpcode(instruction, "sub") && !isOpcode(instruction, "or")) return false;
+    } else {
+        return false;
+    }
+    removeInstruction(position);
+    return true;
+}
+
+static bool removeDeadDefinition(int position) {
+    Instruction *instruction;
+    int reg;
+
+    instruction = &window[position];
+    reg = writtenRegister(instruction);
+    if (reg < FIRST_REGISTER || reg > LAST_REGISTER || isDivision(instruction)) return false;
+    if (!isDeadAfter(position, reg)) return false;
+    removeInstruction(position);
+    return true;
+}
+
+static bool removeJumpToNextLabel(int position) {
+    int i;
+
+    if (window[position].kind != INSTRUCTION_JUMP) return false;
+    for (i = position + 1; i < windowLength && window[i].kind == INSTRUCTION_LABEL; i++) {
+        if (strcmp(window[i].label, window[position].label) == 0) {
+            removeInstruction(position);
+            return true;
+        }
+    }
+    return false;
+}
+
+static bool removeUnreachableInstruction(int position) {
+    Instruction *jump;
+
+    if (position + 1 >= windowLength || window[position + 1].kind == INSTRUCTION_LABEL) return false;
+    jump = &window[position];
+    if (jump->kind != INSTRUCTION_JUMP && !(jump->kind == INSTRUCTION_R && isOpcode(jump, "jr"))) return false;
+    removeInstruction(position + 1);
+    return true;
+}
+
+/**
+ * "beq $a,$b,L1; j L2; L1:" becomes "bne $a,$b,L2; L1:".
+ */
+static bool invertBranchOverJump(int position) {
+    Instruction *branch, *jump, *label;
+    const char *inverted;
+
+    if (position + 2 >= windowLength) return false;
+    branch = &window[position];
+    jump = &window[position + 1];
+    label = &window[position + 2];
+    if (branch->kind != INSTRUCTION_RRL || jump->kind != INSTRUCTION_JUMP || label->kind != INSTRUCTION_LABEL) {
+        return false;
+    }
+    if (strcmp(branch->label, label->label) != 0) return false;
+    inverted = invertedBranch(branch);
+    if (inverted == NULL) return false;
+    snprintf(branch->opcode, OPCODE_LENGTH, "%s", inverted);
+    memcpy(branch->label, jump->label, LABEL_LENGTH);
+    removeInstruction(position + 1);
+    return true;
+}
+
+static Rule rules[] = {
+        {"fold address offset",     foldAddressOffset,            0},
+        {"fold constant operand",   foldConstantOperand,          0},
+        {"useless instruction",     removeUselessInstruction,     0},
+        {"dead definition",         removeDeadDefinition,         0},
+        {"jump to next label",      removeJumpToNextLabel,        0},
+        {"unreachable instruction", removeUnreachableInstruction, 0},
+        {"branch over jump",        invertBranchOverJump,         0},
+};
+
+/**
+ * Applies the rules to the whole window until none of them matches any more.
+ */
+static void applyRules(void) {
+    bool changed;
+    unsigned rule;
+    int position;
+
+    do {
+        changed = false;
+        for (rule = 0; rule < sizeof(rules) / sizeof(rules[0]) && !changed; rule++) {
+            for (position = 0; position < windowLength && !changed; position++) {
+                if (rules[rule].apply(position)) {
+                    rules[rule].hits++;
+                    changed = true;
+                }
+            }
+        }
+    } while (changed);
+}
+
+static void printOldest(FILE *out) {
+    printInstruction(out, &window[0]);
+    if (window[0].kind != INSTRUCTION_LABEL) numPrinted++;
+    removeInstruction(0);
+}
+
+void emitInstruction(FILE *out, Instruction *instruction) {
+    if (!peepholeEnabled) {
+        printInstruction(out, instruction);
+        return;
+    }
+    if (instruction->kind != INSTRUCTION_LABEL) numReceived++;
+    window[windowLength++] = *instruction;
+    applyRules();
+    while (windowLength >= WINDOW_SIZE) printOldest(out);
+}
+
+void flushPeephole(FILE *out) {
+    applyRules();
+    while (windowLength > 0) printOldest(out);
+}
+
+void showPeepholeStats(void) {
+    unsigned rule;
+
+    printf("\nPeephole optimization\n");
+    for (rule = 0; rule < sizeof(rules) / sizeof(rules[0]); rule++) {
+        printf("rule '%s': hits = %d\n", rules[rule].name, rules[rule].hits);
+    }
+    printf("instructions generated = %d, emitted = %d, removed = %d\n",
+           numReceived, numPrinted, numReceived - numPrinted);
+}
+
+int countPeepholeRemovals(void) {
+    return numReceived - numPrinted;
+}
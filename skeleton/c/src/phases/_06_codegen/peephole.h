@@ -0,0 +1,59 @@
+/*
+ * peephole.h -- peephole optimization of the emitted instructions
+ */
+
+
+#ifndef _PEEPHOLE_H_
+#define _PEEPHOLE_H_
+
+#include <stdio.h>
+#include <stdbool.h>
+#include "codeprint.h"
+
+/**
+ * Whether the instructions pass through the peephole optimizer, set by the pass manager.
+ */
+extern bool peepholeEnabled;
+
+/**
+ * Passes an instruction from the code generator on to the output.
+ *
+ * If the optimizer is enabled, the instruction is put into a window of the most recent instructions
+ * and a table of rules is applied to the window until none matches any more. The oldest instruction
+ * is printed when the window is full. The rules are:
+ *   - an address computed by "add $a,$b,k1" and used by the following load or store "ldw $c,$a,k2"
+ *     is replaced by "ldw $c,$b,k1+k2",
+ *   - a constant loaded by "add $t,$0,k" and used by the following register operation is turned into
+ *     an immediate operand, e.g. "add $9,$9,k",
+ *   - instructions without effect like "add $a,$a,0" are removed,
+ *   - an instruction writing a register which is overwritten before it is read again is removed,
+ *     unless it is a division, which may trap,
+ *   - a jump to a label directly following it is removed,
+ *   - instructions following an unconditional jump up to the next label are removed,
+ *   - a conditional branch over a jump, "beq $a,$b,L1; j L2; L1:", becomes "bne $a,$b,L2; L1:".
+ * A register is only known to be dead if it is overwritten within the window, before any label, branch,
+ * jump or call. Only the registers of the expression stack and of register variables are considered.
+ *
+ * @param out The file pointer where the output has to be emitted to.
+ * @param instruction The instruction to emit. It is copied, so it may be reused by the caller.
+ */
+void emitInstruction(FILE *out, Instruction *instruction);
+
+/**
+ * Prints the instructions still held in the window. This happens automatically before anything else than
+ * an instruction is printed, and must be done by the code generator when it is done.
+ * @param out The file pointer where the output has to be emitted to.
+ */
+void flushPeephole(FILE *out);
+
+/**
+ * Prints how often every rule has been applied, and the number of instructions saved.
+ */
+void showPeepholeStats(void);
+
+/**
+ * @return The number of instructions removed by the rules so far.
+ */
+int countPeepholeRemovals(void);
+
+#endif /* _PEEPHOLE_H_ */
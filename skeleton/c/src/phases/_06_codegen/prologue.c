@@ -0,0 +1,77 @@
+/*
+ * prologue.c -- prologue and epilogue of procedures
+ */
+
+#include <string.h>
+#include <util/errors.h>
+#include <table/table.h>
+#include <phases/_05_varalloc/varalloc.h>
+#include <phases/_05_varalloc/framelayout.h>
+#include "codeprint.h"
+#include "instrument.h"
+#include "prologue.h"
+
+/**
+ * @return The offset of the saved old frame pointer relative to the stack pointer.
+ */
+static int oldFramePointerOffset(Entry *procEntry) {
+    return procEntry->u.procEntry.outgoingArea + REF_BYTE_SIZE;
+}
+
+/**
+ * @return The offset of the saved return address relative to the frame pointer.
+ */
+static int returnAddressOffset(Entry *procEntry) {
+    return -(procEntry->u.procEntry.localvarArea + 2 * REF_BYTE_SIZE);
+}
+
+void emitPrologue(FILE *out, Identifier *name, Entry *procEntry) {
+    int size;
+
+    size = frameSize(procEntry);
+    switch (procEntry->u.procEntry.frameKind) {
+        case FRAME_FULL:
+            commentRRI(out, "sub", STACK_POINTER_REGISTER, STACK_POINTER_REGISTER, size,
+                       "allocate frame of %s", name->string);
+            commentRRI(out, "stw", FRAME_POINTER_REGISTER, STACK_POINTER_REGISTER, oldFramePointerOffset(procEntry),
+                       "save old frame pointer");
+            commentRRI(out, "add", FRAME_POINTER_REGISTER, STACK_POINTER_REGISTER, size, "set up frame pointer");
+            commentRRI(out, "stw", RETURN_ADDRESS_REGISTER, FRAME_POINTER_REGISTER, returnAddressOffset(procEntry),
+                       "save return register");
+            break;
+        case FRAME_SP_RELATIVE:
+            commentRRI(out, "sub", STACK_POINTER_REGISTER, STACK_POINTER_REGISTER, size,
+                       "allocate frame of %s", name->string);
+            break;
+        case FRAME_NONE:
+            break;
+        default:
+            error("unknown frame kind %d in emitPrologue", procEntry->u.procEntry.frameKind);
+    }
+}
+
+void emitEpilogue(FILE *out, Identifier *name, Entry *procEntry) {
+    int size;
+
+    size = frameSize(procEntry);
+    switch (procEntry->u.procEntry.frameKind) {
+        case FRAME_FULL:
+            if (strcmp(name->string, "main") == 0) emitProfileDumpCall(out);
+            commentRRI(out, "ldw", RETURN_ADDRESS_REGISTER, FRAME_POINTER_REGISTER, returnAddressOffset(procEntry),
+                       "restore return register");
+            commentRRI(out, "ldw", FRAME_POINTER_REGISTER, STACK_POINTER_REGISTER, oldFramePointerOffset(procEntry),
+                       "restore old frame pointer");
+            commentRRI(out, "add", STACK_POINTER_REGISTER, STACK_POINTER_REGISTER, size,
+                       "release frame of %s", name->string);
+            break;
+        case FRAME_SP_RELATIVE:
+            commentRRI(out, "add", STACK_POINTER_REGISTER, STACK_POINTER_REGISTER, size,
+                       "release frame of %s", name->string);
+            break;
+        case FRAME_NONE:
+            break;
+        default:
+            error("unknown frame kind %d in emitEpilogue", procEntry->u.procEntry.frameKind);
+    }
+    commentR(out, "jr", RETURN_ADDRESS_REGISTER, "return");
+}
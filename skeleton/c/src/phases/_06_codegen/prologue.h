@@ -0,0 +1,36 @@
+/*
+ * prologue.h -- prologue and epilogue of procedures
+ */
+
+
+#ifndef _PROLOGUE_H_
+#define _PROLOGUE_H_
+
+#include <stdio.h>
+#include <table/table.h>
+
+/**
+ * Emits the code setting up the stack frame of a procedure, as classified by classifyFrames.
+ *
+ * A full frame saves the old frame pointer above the outgoing area and the return address below the localvar area,
+ * a frame relative to the stack pointer only allocates the localvar area, and a procedure without frame
+ * needs no prologue at all. The code generator saves the callee-saved registers afterwards.
+ *
+ * @param out The file pointer where the output has to be emitted to.
+ * @param name The name of the procedure.
+ * @param procEntry The ProcedureEntry of the procedure.
+ */
+void emitPrologue(FILE *out, Identifier *name, Entry *procEntry);
+
+/**
+ * Emits the code releasing the stack frame of a procedure and returning to the caller.
+ * The code generator restores the callee-saved registers before. In an instrumented program,
+ * the epilogue of main prints the counters first.
+ *
+ * @param out The file pointer where the output has to be emitted to.
+ * @param name The name of the procedure.
+ * @param procEntry The ProcedureEntry of the procedure.
+ */
+void emitEpilogue(FILE *out, Identifier *name, Entry *procEntry);
+
+#endif /* _PROLOGUE_H_ */
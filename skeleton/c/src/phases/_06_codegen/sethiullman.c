@@ -0,0 +1,205 @@
+/*
+ * sethiullman.c -- register need of expressions and spilling
+ */
+
+#include <stddef.h>
+#include <util/errors.h>
+#include <absyn/absyn.h>
+#include "sethiullman.h"
+
+#define WORD_BYTE_SIZE 4
+
+/**
+ * One of the two operands of a node, which is either an expression or the address of a variable.
+ */
+typedef struct {
+    Expression *expression;
+    Variable *variable;
+    int minimumNeed;
+} Operand;
+
+static int operandNeed(Operand operand);
+static int operandSpillSlots(Operand operand, int registers);
+
+static Operand expressionOperand(Expression *expression, int minimumNeed) {
+    Operand operand;
+
+    operand.expression = expression;
+    operand.variable = NULL;
+    operand.minimumNeed = minimumNeed;
+    return operand;
+}
+
+static Operand variableOperand(Variable *variable) {
+    Operand operand;
+
+    operand.expression = NULL;
+    operand.variable = variable;
+    operand.minimumNeed = 1;
+    return operand;
+}
+
+static int max(int a, int b) {
+    return a > b ? a : b;
+}
+
+/**
+ * The need of a node with two operands: one more register than the operands if both need the same number,
+ * otherwise the need of the more expensive operand, which is evaluated first.
+ */
+static int pairNeed(Operand first, Operand second) {
+    int firstNeed = operandNeed(first);
+    int secondNeed = operandNeed(second);
+
+    return firstNeed == secondNeed ? firstNeed + 1 : max(firstNeed, secondNeed);
+}
+
+static int pairSpillSlots(Operand left, Operand right, int registers) {
+    Operand first, second;
+
+    if (pairNeed(left, right) <= registers) return 0;
+
+    if (operandNeed(right) > operandNeed(left)) {
+        first = right;
+        second = left;
+    } else {
+        first = left;
+        second = right;
+    }
+    if (operandNeed(second) >= registers) {
+        /* the result of the first operand is kept in the spill area while the second one is evaluated */
+        return max(operandSpillSlots(first, registers), 1 + operandSpillSlots(second, registers));
+    }
+    return max(operandSpillSlots(first, registers), operandSpillSlots(second, registers - 1));
+}
+
+static Operand arrayOperand(Variable *arrayAccess) {
+    return variableOperand(arrayAccess->u.arrayAccess.array);
+}
+
+static Operand indexOperand(Variable *arrayAccess) {
+    /* the bounds check needs a second register for the size of the array */
+    return expressionOperand(arrayAccess->u.arrayAccess.index, 2);
+}
+
+int variableRegisterNeed(Variable *variable) {
+    switch (variable->kind) {
+        case VARIABLE_NAMEDVARIABLE:
+            return 1;
+        case VARIABLE_ARRAYACCESS:
+            return pairNeed(arrayOperand(variable), indexOperand(variable));
+        default:
+            error("unknown variable kind %d in variableRegisterNeed", variable->kind);
+            return 0;
+    }
+}
+
+int expressionRegisterNeed(Expression *expression) {
+    switch (expression->kind) {
+        case EXPRESSION_INTLITERAL:
+            return 1;
+        case EXPRESSION_VARIABLEEXPRESSION:
+            return variableRegisterNeed(expression->u.variableExpression.variable);
+        case EXPRESSION_BINARYEXPRESSION:
+            return pairNeed(expressionOperand(expression->u.binaryExpression.leftOperand, 1),
+                            expressionOperand(expression->u.binaryExpression.rightOperand, 1));
+        default:
+            error("unknown expression kind %d in expressionRegisterNeed", expression->kind);
+            return 0;
+    }
+}
+
+bool evaluateRightOperandFirst(Expression *binaryExpression) {
+    return expressionRegisterNeed(binaryExpression->u.binaryExpression.rightOperand) >
+           expressionRegisterNeed(binaryExpression->u.binaryExpression.leftOperand);
+}
+
+static int variableSpillSlots(Variable *variable, int registers) {
+    switch (variable->kind) {
+        case VARIABLE_NAMEDVARIABLE:
+            return 0;
+        case VARIABLE_ARRAYACCESS:
+            return pairSpillSlots(arrayOperand(variable), indexOperand(variable), registers);
+        default:
+            error("unknown variable kind %d in variableSpillSlots", variable->kind);
+            return 0;
+    }
+}
+
+int expressionSpillSlots(Expression *expression, int registers) {
+    switch (expression->kind) {
+        case EXPRESSION_INTLITERAL:
+            return 0;
+        case EXPRESSION_VARIABLEEXPRESSION:
+            return variableSpillSlots(expression->u.variableExpression.variable, registers);
+        case EXPRESSION_BINARYEXPRESSION:
+            return pairSpillSlots(expressionOperand(expression->u.binaryExpression.leftOperand, 1),
+                                  expressionOperand(expression->u.binaryExpression.rightOperand, 1),
+                                  registers);
+        default:
+            error("unknown expression kind %d in expressionSpillSlots", expression->kind);
+            return 0;
+    }
+}
+
+static int operandNeed(Operand operand) {
+    if (operand.variable != NULL) return max(variableRegisterNeed(operand.variable), operand.minimumNeed);
+    return max(expressionRegisterNeed(operand.expression), operand.minimumNeed);
+}
+
+static int operandSpillSlots(Operand operand, int registers) {
+    if (operand.variable != NULL) return variableSpillSlots(operand.variable, registers);
+    return expressionSpillSlots(operand.expression, registers);
+}
+
+static int statementSpillSlots(Statement *statement, int registers);
+
+static int statementListSpillSlots(StatementList *statements, int registers) {
+    int slots = 0;
+
+    while (!statements->isEmpty) {
+        slots = max(slots, statementSpillSlots(statements->head, registers));
+        statements = statements->tail;
+    }
+    return slots;
+}
+
+static int statementSpillSlots(Statement *statement, int registers) {
+    ExpressionList *arguments;
+    int slots;
+
+    switch (statement->kind) {
+        case STATEMENT_EMPTYSTATEMENT:
+            return 0;
+        case STATEMENT_COMPOUNDSTATEMENT:
+            return statementListSpillSlots(statement->u.compoundStatement.statements, registers);
+        case STATEMENT_ASSIGNSTATEMENT:
+            /* the address of the target is held while the value is computed */
+            return pairSpillSlots(variableOperand(statement->u.assignStatement.target),
+                                  expressionOperand(statement->u.assignStatement.value, 1),
+                                  registers);
+        case STATEMENT_IFSTATEMENT:
+            slots = expressionSpillSlots(statement->u.ifStatement.condition, registers);
+            slots = max(slots, statementSpillSlots(statement->u.ifStatement.thenPart, registers));
+            return max(slots, statementSpillSlots(statement->u.ifStatement.elsePart, registers));
+        case STATEMENT_WHILESTATEMENT:
+            slots = expressionSpillSlots(statement->u.whileStatement.condition, registers);
+            return max(slots, statementSpillSlots(statement->u.whileStatement.body, registers));
+        case STATEMENT_CALLSTATEMENT:
+            /* every argument is stored in the outgoing area right after it has been evaluated */
+            slots = 0;
+            arguments = statement->u.callStatement.argumentList;
+            while (!arguments->isEmpty) {
+                slots = max(slots, expressionSpillSlots(arguments->head, registers));
+                arguments = arguments->tail;
+            }
+            return slots;
+        default:
+            error("unknown statement kind %d in statementSpillSlots", statement->kind);
+            return 0;
+    }
+}
+
+int spillAreaSize(GlobalDeclaration *procDec, int registers) {
+    return WORD_BYTE_SIZE * statementListSpillSlots(procDec->u.procedureDeclaration.body, registers);
+}
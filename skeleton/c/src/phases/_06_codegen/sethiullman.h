@@ -0,0 +1,58 @@
+/*
+ * sethiullman.h -- register need of expressions and spilling
+ */
+
+
+#ifndef _SETHIULLMAN_H_
+#define _SETHIULLMAN_H_
+
+#include <absyn/absyn.h>
+
+/**
+ * Computes the Sethi-Ullman number of an expression, i.e. the number of registers needed to evaluate it
+ * without spilling, if the operand with the higher need is always evaluated first.
+ * @param expression The expression to be evaluated.
+ * @return The minimal number of registers needed.
+ */
+int expressionRegisterNeed(Expression *expression);
+
+/**
+ * Computes the number of registers needed to compute the address of a variable.
+ * An array access needs at least two registers for the index, since the bounds check compares it with
+ * the size of the array held in a second register.
+ * @param variable The variable whose address is computed.
+ * @return The minimal number of registers needed.
+ */
+int variableRegisterNeed(Variable *variable);
+
+/**
+ * Decides the evaluation order of the operands of a binary expression.
+ * The operand needing more registers has to be evaluated first, so its result occupies a register
+ * only while the cheaper operand is evaluated.
+ * @param binaryExpression A binary expression.
+ * @return true if the right operand has to be evaluated before the left one.
+ */
+bool evaluateRightOperandFirst(Expression *binaryExpression);
+
+/**
+ * Computes how many words of the spill area the evaluation of an expression needs.
+ * Spilling is only necessary if both operands of a node need all available registers. Then the result
+ * of the operand evaluated first is stored in the spill area and reloaded after the second one is done.
+ * @param expression The expression to be evaluated.
+ * @param registers The number of registers available for the expression stack.
+ * @return The number of spill slots needed at the same time.
+ */
+int expressionSpillSlots(Expression *expression, int registers);
+
+/**
+ * Computes the size of the spill area of a procedure in bytes.
+ * This is the maximum number of spill slots needed by any statement of the procedure body.
+ * The variable allocator adds this size to the localvar area; slot i (counted from 0) is located
+ * directly below the local variables, at fp - (size of the local variables + 4 * (i + 1)).
+ * @param procDec The procedure declaration.
+ * @param registers The number of registers available for the expression stack.
+ * @return The size of the spill area in bytes.
+ */
+int spillAreaSize(GlobalDeclaration *procDec, int registers);
+
+#endif /* _SETHIULLMAN_H_ */
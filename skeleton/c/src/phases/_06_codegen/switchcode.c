@@ -0,0 +1,91 @@
+/*
+ * switchcode.c -- code for lowered if-chains
+ */
+
+#include "switchcode.h"
+
+#include <stdbool.h>
+#include <absyn/absyn.h>
+#include <util/errors.h>
+#include "codeprint.h"
+
+/**
+ * Emits the dispatch through a jump table.
+ */
+static void emitJumpTable(FILE *out, SwitchLowering *lowering, const char *prefix, int selectorReg, int tempReg) {
+    int low, high, value, i;
+
+    low = lowering->cases[0].value;
+    high = lowering->cases[lowering->numCases - 1].value;
+    commentRRI(out, "sub", tempReg, selectorReg, low, "switch on cases %d to %d", low, high);
+    emitRRI(out, "add", tempReg + 1, 0, high - low + 1);
+    emitRRL(out, "bgeu", tempReg, tempReg + 1, "%s_default", prefix);
+    emitRRI(out, "sll", tempReg, tempReg, 2);
+    emitRRL(out, "ldw", tempReg, tempReg, "%s_table", prefix);
+    emitR(out, "jr", tempReg);
+    emitLabel(out, "%s_table", prefix);
+    i = 0;
+    for (value = low; value <= high; value++) {
+        if (lowering->cases[i].value == value) {
+            emit(out, "\t.word\t%s_case%d", prefix, i);
+            i++;
+        } else {
+            emit(out, "\t.word\t%s_default", prefix);
+        }
+    }
+}
+
+/**
+ * Emits the compares of a decision tree for the cases from first to last - 1.
+ * If isFirstLoaded, tempReg already holds the value of the first case.
+ */
+static void emitDecisionTree(FILE *out, SwitchLowering *lowering, const char *prefix, int selectorReg, int tempReg,
+                             int first, int last, bool isFirstLoaded) {
+    int middle, i;
+
+    if (last - first <= LINEAR_SWITCH_CASES) {
+        for (i = first; i < last; i++) {
+            if (lowering->cases[i].value == 0) {
+                emitRRL(out, "beq", selectorReg, 0, "%s_case%d", prefix, i);
+            } else if (i == first && isFirstLoaded) {
+                emitRRL(out, "beq", selectorReg, tempReg, "%s_case%d", prefix, i);
+            } else {
+                emitRRI(out, "add", tempReg, 0, lowering->cases[i].value);
+                emitRRL(out, "beq", selectorReg, tempReg, "%s_case%d", prefix, i);
+            }
+        }
+        emitJump(out, "%s_default", prefix);
+        return;
+    }
+    middle = (first + last) / 2;
+    emitRRI(out, "add", tempReg, 0, lowering->cases[middle].value);
+    emitRRL(out, "blt", selectorReg, tempReg, "%s_below%d", prefix, middle);
+    /* the upper half starts with the middle case, whose value is still loaded */
+    emitDecisionTree(out, lowering, prefix, selectorReg, tempReg, middle, last, true);
+    emitLabel(out, "%s_below%d", prefix, middle);
+    emitDecisionTree(out, lowering, prefix, selectorReg, tempReg, first, middle, false);
+}
+
+void emitSwitch(FILE *out, SwitchLowering *lowering, const char *prefix, int selectorReg, int tempReg,
+                void (*genBody)(Statement *body, void *data), void *data) {
+    int i;
+
+    switch (lowering->kind) {
+        case SWITCH_JUMP_TABLE:
+            emitJumpTable(out, lowering, prefix, selectorReg, tempReg);
+            break;
+        case SWITCH_DECISION_TREE:
+            emitDecisionTree(out, lowering, prefix, selectorReg, tempReg, 0, lowering->numCases, false);
+            break;
+        default:
+            error("unknown switch kind %d in emitSwitch", lowering->kind);
+    }
+    for (i = 0; i < lowering->numCases; i++) {
+        emitLabel(out, "%s_case%d", prefix, i);
+        genBody(lowering->cases[i].body, data);
+        emitJump(out, "%s_end", prefix);
+    }
+    emitLabel(out, "%s_default", prefix);
+    genBody(lowering->defaultPart, data);
+    emitLabel(out, "%s_end", prefix);
+}
@@ -0,0 +1,38 @@
+/*
+ * switchcode.h -- code for lowered if-chains
+ */
+
+
+#ifndef _SWITCHCODE_H_
+#define _SWITCHCODE_H_
+
+#include <stdio.h>
+#include <absyn/absyn.h>
+
+#define LINEAR_SWITCH_CASES 3   /* a decision tree compares this many cases one after another */
+
+/**
+ * This function emits the code of an if-statement with a SwitchLowering, in place of its compares.
+ *
+ * A jump table subtracts the lowest value from the selector, branches to the default part if the result is
+ * not below the number of entries as an unsigned number, which also catches values below the lowest one,
+ * and jumps through the entry loaded from the table. The table follows the jump in the code segment and
+ * holds the label of a case for every value, the default part for the values without a case.
+ * A decision tree branches on the middle case to one of the halves, until at most LINEAR_SWITCH_CASES cases
+ * remain, which are compared one after another.
+ *
+ * The bodies of the cases follow, each with a jump to the end, and the default part. All labels are made of
+ * the prefix and a suffix, e.g. "L12_case3", "L12_table" or "L12_end", so the prefix has to be unique.
+ *
+ * @param out The file pointer where the output has to be emitted to.
+ * @param lowering The lowering of the if-statement.
+ * @param prefix The prefix of the labels.
+ * @param selectorReg The register holding the value of the selector.
+ * @param tempReg A free register, tempReg + 1 has to be free as well.
+ * @param genBody Called to emit the code of each case and of the default part.
+ * @param data Passed on to genBody.
+ */
+void emitSwitch(FILE *out, SwitchLowering *lowering, const char *prefix, int selectorReg, int tempReg,
+                void (*genBody)(Statement *body, void *data), void *data);
+
+#endif /* _SWITCHCODE_H_ */
@@ -0,0 +1,474 @@
+/*
+ * x86codegen.c -- x86-64 code generator
+ */
+
+#include "x86codegen.h"
+
+#include <stdio.h>
+#include <stdbool.h>
+#include <string.h>
+#include <util/errors.h>
+#include <absyn/absyn.h>
+#include <table/table.h>
+#include <types/types.h>
+#include <phases/_05_varalloc/staticalloc.h>
+#include <phases/_06_codegen/codeprint.h>
+#include <phases/_06_codegen/sethiullman.h>
+
+#define NUM_REGISTERS 12
+#define NUM_ARGUMENT_REGISTERS 5
+#define SAVED_FRAME_SIZE 16     /* return address and old frame pointer, between the frame and the arguments */
+#define OPERAND_LENGTH 64
+
+/* the stack of registers for expressions, %rax and %rdx are needed by the division */
+static const char *registers64[NUM_REGISTERS] = {
+        "r8", "r9", "r10", "r11", "rsi", "rdi", "rcx", "rbx", "r12", "r13", "r14", "r15"
+};
+static const char *registers32[NUM_REGISTERS] = {
+        "r8d", "r9d", "r10d", "r11d", "esi", "edi", "ecx", "ebx", "r12d", "r13d", "r14d", "r15d"
+};
+
+/* the registers of the System V convention for the predefined procedures */
+static const char *arguments64[NUM_ARGUMENT_REGISTERS] = {"rdi", "rsi", "rdx", "rcx", "r8"};
+static const char *arguments32[NUM_ARGUMENT_REGISTERS] = {"edi", "esi", "edx", "ecx", "r8d"};
+
+static FILE *out;
+static SymbolTable *procedures;
+static SymbolTable *localTable;
+static int numLabels;
+static bool isIndexChecked;
+
+static int newLabel(void) {
+    return ++numLabels;
+}
+
+static void checkRegister(int reg) {
+    if (reg >= NUM_REGISTERS) registerOverflow();
+}
+
+static int roundUp16(int size) {
+    return (size + 15) & ~15;
+}
+
+/**
+ * @return The offset of a parameter or local variable relative to %rbp.
+ */
+static int x86Offset(Entry *entry) {
+    int offset;
+
+    offset = entry->u.varEntry.offset;
+    /* the parameters lie above the frame, the local variables below its start */
+    return offset >= 0 ? SAVED_FRAME_SIZE + X86_64_SLOT_SCALE * offset : offset;
+}
+
+/*
+ * Variables and expressions
+ */
+
+static void genExpression(Expression *expression, int reg);
+
+/**
+ * Emits the check of the index of an array access in the register indexReg and adds it, multiplied by the size
+ * of the elements, to the address of the array in base, leaving the address of the element in reg.
+ */
+static void genIndexedAddress(Variable *arrayAccess, const char *base, int indexReg, int reg) {
+    int size, elementSize;
+
+    size = arrayAccess->u.arrayAccess.array->dataType->u.arrayType.size;
+    elementSize = arrayAccess->u.arrayAccess.array->dataType->u.arrayType.baseType->byteSize;
+    if (arrayAccess->u.arrayAccess.checkIndex) {
+        /* a negative index is a large unsigned number */
+        emit(out, "\tcmpl\t$%d,%%%s", size, registers32[indexReg]);
+        emit(out, "\tjae\t.Lindex_error");
+        isIndexChecked = true;
+    } else {
+        emit(out, "\tmovslq\t%%%s,%%%s", registers32[indexReg], registers64[indexReg]);
+    }
+    if (elementSize == 1 || elementSize == 2 || elementSize == 4 || elementSize == 8) {
+        emit(out, "\tleaq\t(%%%s,%%%s,%d),%%%s", base, registers64[indexReg], elementSize, registers64[reg]);
+    } else {
+        emit(out, "\timulq\t$%d,%%%s,%%%s", elementSize, registers64[indexReg], registers64[indexReg]);
+        emit(out, "\tleaq\t(%%%s,%%%s),%%%s", base, registers64[indexReg], registers64[reg]);
+    }
+}
+
+/**
+ * Emits the code leaving the address of a variable in a register.
+ */
+static void genAddress(Variable *variable, int reg) {
+    Entry *entry;
+    Variable *array;
+    Expression *index;
+    int size, elementSize, value;
+
+    checkRegister(reg);
+    switch (variable->kind) {
+        case VARIABLE_NAMEDVARIABLE:
+            entry = lookup(localTable, variable->u.namedVariable.name);
+            if (entry->u.varEntry.staticLabel != 0) {
+                emit(out, "\tleaq\t" STATIC_LABEL_FORMAT "(%%rip),%%%s", entry->u.varEntry.staticLabel,
+                     registers64[reg]);
+            } else if (entry->u.varEntry.isRef) {
+                emit(out, "\tmovq\t%d(%%rbp),%%%s", x86Offset(entry), registers64[reg]);
+            } else {
+                emit(out, "\tleaq\t%d(%%rbp),%%%s", x86Offset(entry), registers64[reg]);
+            }
+            break;
+        case VARIABLE_ARRAYACCESS:
+            array = variable->u.arrayAccess.array;
+            index = variable->u.arrayAccess.index;
+            size = array->dataType->u.arrayType.size;
+            elementSize = array->dataType->u.arrayType.baseType->byteSize;
+            genAddress(array, reg);
+            if (index->kind == EXPRESSION_INTLITERAL && index->u.intLiteral.value >= 0 &&
+                index->u.intLiteral.value < size) {
+                value = index->u.intLiteral.value;
+                if (value != 0) emit(out, "\taddq\t$%d,%%%s", value * elementSize, registers64[reg]);
+                break;
+            }
+            if (expressionRegisterNeed(index) < NUM_REGISTERS - reg) {
+                genExpression(index, reg + 1);
+                genIndexedAddress(variable, registers64[reg], reg + 1, reg);
+            } else {
+                /* the address waits on the stack while the index takes all registers */
+                emit(out, "\tpushq\t%%%s", registers64[reg]);
+                genExpression(index, reg);
+                emit(out, "\tpopq\t%%rax");
+                genIndexedAddress(variable, "rax", reg, reg);
+            }
+            break;
+        default:
+            error("unknown variable kind %d in genAddress", variable->kind);
+    }
+}
+
+/**
+ * Formats the memory operand of a variable holding an int. A local variable or value parameter is addressed
+ * directly, otherwise the address is computed into the register.
+ */
+static void memoryOperand(Variable *variable, int reg, char *operand) {
+    Entry *entry;
+
+    if (variable->kind == VARIABLE_NAMEDVARIABLE) {
+        entry = lookup(localTable, variable->u.namedVariable.name);
+        if (entry->u.varEntry.staticLabel != 0) {
+            snprintf(operand, OPERAND_LENGTH, STATIC_LABEL_FORMAT "(%%rip)", entry->u.varEntry.staticLabel);
+            return;
+        }
+        if (!entry->u.varEntry.isRef) {
+            snprintf(operand, OPERAND_LENGTH, "%d(%%rbp)", x86Offset(entry));
+            return;
+        }
+    }
+    genAddress(variable, reg);
+    snprintf(operand, OPERAND_LENGTH, "(%%%s)", registers64[reg]);
+}
+
+/**
+ * Evaluates both operands of a binary expression from the register reg upwards and formats the operands of the
+ * instruction combining them. The operand needing more registers is evaluated first. If the registers do not
+ * suffice for both, the left operand is kept on the stack while the right one is evaluated and ends up in %eax.
+ * @param allowImmediate Whether a literal right operand may be used as an immediate.
+ */
+static void genOperands(Expression *binaryExpression, int reg, bool allowImmediate, char *left, char *right) {
+    Expression *leftOperand, *rightOperand;
+    int leftNeed, rightNeed, available;
+
+    leftOperand = binaryExpression->u.binaryExpression.leftOperand;
+    rightOperand = binaryExpression->u.binaryExpression.rightOperand;
+    leftNeed = expressionRegisterNeed(leftOperand);
+    rightNeed = expressionRegisterNeed(rightOperand);
+    available = NUM_REGISTERS - reg;
+    if (allowImmediate && rightOperand->kind == EXPRESSION_INTLITERAL) {
+        genExpression(leftOperand, reg);
+        snprintf(left, OPERAND_LENGTH, "%%%s", registers32[reg]);
+        snprintf(right, OPERAND_LENGTH, "$%d", rightOperand->u.intLiteral.value);
+    } else if (!evaluateRightOperandFirst(binaryExpression) && rightNeed < available) {
+        genExpression(leftOperand, reg);
+        genExpression(rightOperand, reg + 1);
+        snprintf(left, OPERAND_LENGTH, "%%%s", registers32[reg]);
+        snprintf(right, OPERAND_LENGTH, "%%%s", registers32[reg + 1]);
+    } else if (evaluateRightOperandFirst(binaryExpression) && leftNeed < available) {
+        genExpression(rightOperand, reg);
+        genExpression(leftOperand, reg + 1);
+        snprintf(left, OPERAND_LENGTH, "%%%s", registers32[reg + 1]);
+        snprintf(right, OPERAND_LENGTH, "%%%s", registers32[reg]);
+    } else {
+        genExpression(leftOperand, reg);
+        emit(out, "\tpushq\t%%%s", registers64[reg]);
+        genExpression(rightOperand, reg);
+        emit(out, "\tpopq\t%%rax");
+        snprintf(left, OPERAND_LENGTH, "%%eax");
+        snprintf(right, OPERAND_LENGTH, "%%%s", registers32[reg]);
+    }
+}
+
+/**
+ * Emits the division of left by right into the register reg with %eax and %edx.
+ * The smallest int divided by -1 is negated instead, since idivl traps on the overflow.
+ */
+static void genDivision(int reg, const char *left, const char *right, bool mayBeMinusOne) {
+    int divide, end;
+
+    divide = newLabel();
+    end = newLabel();
+    if (mayBeMinusOne) {
+        emit(out, "\tcmpl\t$-1,%s", right);
+        emit(out, "\tjne\t.L%d", divide);
+        emit(out, "\tmovl\t%s,%%eax", left);
+        emit(out, "\tnegl\t%%eax");
+        emit(out, "\tjmp\t.L%d", end);
+    }
+    emit(out, ".L%d:", divide);
+    if (strcmp(left, "%eax") != 0) emit(out, "\tmovl\t%s,%%eax", left);
+    emit(out, "\tcltd");
+    emit(out, "\tidivl\t%s", right);
+    emit(out, ".L%d:", end);
+    emit(out, "\tmovl\t%%eax,%%%s", registers32[reg]);
+}
+
+static void genArithmetic(Expression *expression, int reg) {
+    static const char *opcodes[] = {"addl", "subl", "imull"};
+    char left[OPERAND_LENGTH], right[OPERAND_LENGTH], result[OPERAND_LENGTH];
+    Expression *rightOperand;
+    binary_operator operator;
+
+    operator = expression->u.binaryExpression.operator;
+    rightOperand = expression->u.binaryExpression.rightOperand;
+    snprintf(result, OPERAND_LENGTH, "%%%s", registers32[reg]);
+    switch (operator) {
+        case ABSYN_OP_ADD:
+        case ABSYN_OP_SUB:
+        case ABSYN_OP_MUL:
+            genOperands(expression, reg, true, left, right);
+            if (operator != ABSYN_OP_SUB && strcmp(right, result) == 0) {
+                /* the operation commutes, so the result can be computed into reg directly */
+                emit(out, "\t%s\t%s,%s", opcodes[operator - ABSYN_OP_ADD], left, right);
+                break;
+            }
+            emit(out, "\t%s\t%s,%s", opcodes[operator - ABSYN_OP_ADD], right, left);
+            if (strcmp(left, result) != 0) emit(out, "\tmovl\t%s,%s", left, result);
+            break;
+        case ABSYN_OP_DIV:
+            if (rightOperand->kind == EXPRESSION_INTLITERAL && rightOperand->u.intLiteral.value == -1) {
+                genExpression(expression->u.binaryExpression.leftOperand, reg);
+                emit(out, "\tnegl\t%s", result);
+                break;
+            }
+            genOperands(expression, reg, false, left, right);
+            genDivision(reg, left, right, rightOperand->kind != EXPRESSION_INTLITERAL);
+            break;
+        default:
+            error("unknown arithmetic operator %d in genArithmetic", operator);
+    }
+}
+
+static void genExpression(Expression *expression, int reg) {
+    char operand[OPERAND_LENGTH];
+
+    checkRegister(reg);
+    switch (expression->kind) {
+        case EXPRESSION_INTLITERAL:
+            emit(out, "\tmovl\t$%d,%%%s", expression->u.intLiteral.value, registers32[reg]);
+            break;
+        case EXPRESSION_VARIABLEEXPRESSION:
+            memoryOperand(expression->u.variableExpression.variable, reg, operand);
+            emit(out, "\tmovl\t%s,%%%s", operand, registers32[reg]);
+            break;
+        case EXPRESSION_BINARYEXPRESSION:
+            genArithmetic(expression, reg);
+            break;
+        default:
+            error("unknown expression kind %d in genExpression", expression->kind);
+    }
+}
+
+/**
+ * Emits a comparison followed by a conditional jump.
+ * @param jumpIfTrue Whether the jump is taken if the condition holds, otherwise if it does not.
+ */
+static void genCondition(Expression *condition, int label, bool jumpIfTrue) {
+    static const char *jumps[] = {"je", "jne", "jl", "jle", "jg", "jge"};
+    static const char *negatedJumps[] = {"jne", "je", "jge", "jg", "jle", "jl"};
+    char left[OPERAND_LENGTH], right[OPERAND_LENGTH];
+    binary_operator operator;
+
+    if (condition->kind != EXPRESSION_BINARYEXPRESSION) {
+        error("unknown condition kind %d in genCondition", condition->kind);
+    }
+    operator = condition->u.binaryExpression.operator;
+    if (operator > ABSYN_OP_GRE) error("unknown comparison operator %d in genCondition", operator);
+    genOperands(condition, 0, true, left, right);
+    emit(out, "\tcmpl\t%s,%s", right, left);
+    emit(out, "\t%s\t.L%d", jumpIfTrue ? jumps[operator] : negatedJumps[operator], label);
+}
+
+/*
+ * Statements
+ */
+
+static void genStatement(Statement *statement);
+
+static void genStatementList(StatementList *statements) {
+    for (; !statements->isEmpty; statements = statements->tail) genStatement(statements->head);
+}
+
+static void genCall(Statement *call) {
+    Entry *entry;
+    ParamTypes *paramTypes;
+    ExpressionList *arguments;
+    int slot, i;
+
+    entry = lookup(procedures, call->u.callStatement.procedureName);
+    paramTypes = entry->u.procEntry.paramTypes;
+    arguments = call->u.callStatement.argumentList;
+    for (; !arguments->isEmpty; arguments = arguments->tail, paramTypes = paramTypes->next) {
+        slot = X86_64_SLOT_SCALE * paramTypes->offset;
+        if (paramTypes->isRef) {
+            genAddress(arguments->head->u.variableExpression.variable, 0);
+            emit(out, "\tmovq\t%%%s,%d(%%rsp)", registers64[0], slot);
+        } else {
+            genExpression(arguments->head, 0);
+            emit(out, "\tmovl\t%%%s,%d(%%rsp)", registers32[0], slot);
+        }
+    }
+    /* a predefined procedure has no local table and takes its arguments in registers */
+    if (entry->u.procEntry.localTable == NULL) {
+        paramTypes = entry->u.procEntry.paramTypes;
+        for (i = 0; !paramTypes->isEmpty; i++, paramTypes = paramTypes->next) {
+            if (i == NUM_ARGUMENT_REGISTERS) error("too many arguments for predefined procedure");
+            slot = X86_64_SLOT_SCALE * paramTypes->offset;
+            if (paramTypes->isRef) emit(out, "\tmovq\t%d(%%rsp),%%%s", slot, arguments64[i]);
+            else emit(out, "\tmovl\t%d(%%rsp),%%%s", slot, arguments32[i]);
+        }
+    }
+    emit(out, "\tcall\t%s", call->u.callStatement.procedureName->string);
+}
+
+static void genStatement(Statement *statement) {
+    char operand[OPERAND_LENGTH];
+    int elseLabel, endLabel, bodyLabel, testLabel;
+
+    switch (statement->kind) {
+        case STATEMENT_EMPTYSTATEMENT:
+            break;
+        case STATEMENT_COMPOUNDSTATEMENT:
+            genStatementList(statement->u.compoundStatement.statements);
+            break;
+        case STATEMENT_ASSIGNSTATEMENT:
+            genExpression(statement->u.assignStatement.value, 0);
+            memoryOperand(statement->u.assignStatement.target, 1, operand);
+            emit(out, "\tmovl\t%%%s,%s", registers32[0], operand);
+            break;
+        case STATEMENT_IFSTATEMENT:
+            elseLabel = newLabel();
+            genCondition(statement->u.ifStatement.condition, elseLabel, false);
+            genStatement(statement->u.ifStatement.thenPart);
+            if (statement->u.ifStatement.elsePart->kind == STATEMENT_EMPTYSTATEMENT) {
+                emit(out, ".L%d:", elseLabel);
+                break;
+            }
+            endLabel = newLabel();
+            emit(out, "\tjmp\t.L%d", endLabel);
+            emit(out, ".L%d:", elseLabel);
+            genStatement(statement->u.ifStatement.elsePart);
+            emit(out, ".L%d:", endLabel);
+            break;
+        case STATEMENT_WHILESTATEMENT:
+            bodyLabel = newLabel();
+            testLabel = newLabel();
+            /* the condition is always tested after the body, as the loop inversion does on the ECO32 */
+            emit(out, "\tjmp\t.L%d", testLabel);
+            emit(out, ".L%d:", bodyLabel);
+            genStatement(statement->u.whileStatement.body);
+            emit(out, ".L%d:", testLabel);
+            genCondition(statement->u.whileStatement.condition, bodyLabel, true);
+            break;
+        case STATEMENT_CALLSTATEMENT:
+            genCall(statement);
+            break;
+        default:
+            error("unknown statement kind %d in genStatement", statement->kind);
+    }
+}
+
+/*
+ * Procedures
+ */
+
+static void genProcedure(GlobalDeclaration *procDec) {
+    Entry *procEntry;
+    int outgoingArea, size;
+
+    procEntry = lookup(procedures, procDec->name);
+    localTable = procEntry->u.procEntry.localTable;
+    outgoingArea = procEntry->u.procEntry.outgoingArea > 0 ? procEntry->u.procEntry.outgoingArea : 0;
+    size = roundUp16(procEntry->u.procEntry.localvarArea) + roundUp16(X86_64_SLOT_SCALE * outgoingArea);
+
+    emit(out, "");
+    emit(out, "\t.globl\t%s", procDec->name->string);
+    emit(out, "\t.type\t%s,@function", procDec->name->string);
+    emit(out, "%s:", procDec->name->string);
+    emit(out, "\tpushq\t%%rbp");
+    emit(out, "\tmovq\t%%rsp,%%rbp");
+    if (size > 0) emit(out, "\tsubq\t$%d,%%rsp", size);
+    genStatementList(procDec->u.procedureDeclaration.body);
+    emit(out, "\tleave");
+    emit(out, "\tret");
+    emit(out, "\t.size\t%s,.-%s", procDec->name->string, procDec->name->string);
+}
+
+/**
+ * Emits the variables with a staticLabel in the bss segment.
+ */
+static void genStaticVariables(Program *program) {
+    GlobalDeclarationList *declarationList;
+    VariableDeclarationList *variables;
+    SymbolTable *table;
+    Entry *entry;
+    bool isBssStarted;
+
+    isBssStarted = false;
+    for (declarationList = program; !declarationList->isEmpty; declarationList = declarationList->tail) {
+        if (declarationList->head->kind != DECLARATION_PROCEDUREDECLARATION) continue;
+        table = lookup(procedures, declarationList->head->name)->u.procEntry.localTable;
+        variables = declarationList->head->u.procedureDeclaration.variables;
+        for (; !variables->isEmpty; variables = variables->tail) {
+            entry = lookup(table, variables->head->name);
+            if (entry->kind != ENTRY_KIND_VAR || entry->u.varEntry.staticLabel == 0) continue;
+            if (!isBssStarted) {
+                emit(out, "");
+                emit(out, "\t.bss");
+                isBssStarted = true;
+            }
+            emit(out, "\t.balign\t4");
+            emit(out, STATIC_LABEL_FORMAT ":\t\t\t# %s in %s", entry->u.varEntry.staticLabel,
+                 variables->head->name->string, declarationList->head->name->string);
+            emit(out, "\t.zero\t%d", entry->u.varEntry.type->byteSize);
+        }
+    }
+}
+
+void genCodeX86(Program *program, SymbolTable *globalTable, FILE *outFile) {
+    GlobalDeclarationList *declarationList;
+
+    out = outFile;
+    procedures = globalTable;
+    numLabels = 0;
+    isIndexChecked = false;
+
+    emit(out, "\t.text");
+    for (declarationList = program; !declarationList->isEmpty; declarationList = declarationList->tail) {
+        if (declarationList->head->kind == DECLARATION_PROCEDUREDECLARATION) genProcedure(declarationList->head);
+    }
+    if (isIndexChecked) {
+        /* the stack may hold operands saved during the evaluation of an expression */
+        emit(out, "");
+        emit(out, ".Lindex_error:");
+        emit(out, "\tandq\t$-16,%%rsp");
+        emit(out, "\tcall\t_indexError");
+    }
+    genStaticVariables(program);
+    emit(out, "");
+    emit(out, "\t.section\t.note.GNU-stack,\"\",@progbits");
+}
@@ -0,0 +1,54 @@
+/*
+ * x86codegen.h -- x86-64 code generator
+ */
+
+
+#ifndef _X86CODEGEN_H_
+#define _X86CODEGEN_H_
+
+#include <stdio.h>
+#include <absyn/absyn.h>
+#include <table/table.h>
+
+#define X86_64_SLOT_SCALE 2     /* an argument slot of 4 bytes in the ECO32 layout takes 8 bytes */
+
+/* passes producing information only the ECO32 code generator understands, removed from the pipeline */
+#define X86_64_UNSUPPORTED_PASSES "callconv,regalloc,loopreduce,licm,switch,peephole"
+
+/**
+ * This function generates assembly code for x86-64 Linux in the AT&T syntax of the GNU assembler, as
+ * an alternative to genCode. The output is linked with ld against the runtime in runtime/x86_64, which
+ * implements the predefined procedures and calls the procedure main of the program.
+ *
+ * The frames keep the layout computed by the variable allocator for the ECO32, adapted to 8 byte addresses:
+ * a procedure saves %rbp, points it to the start of the frame and reserves the localvar area, rounded up
+ * to 16 bytes, and the outgoing area below it. Local variables keep their negative offsets to %rbp.
+ * Since every argument of SPL is an int or the address of a variable, every slot of the argument area takes
+ * X86_64_SLOT_SCALE times its ECO32 size, so an argument is stored at X86_64_SLOT_SCALE times its offset
+ * above %rsp by the caller and found 16 bytes higher relative to %rbp by the callee, above the return
+ * address and the saved frame pointer. The stack stays aligned to 16 bytes at every call.
+ *
+ * The predefined procedures are called with the System V convention of the runtime: the arguments are stored
+ * to the outgoing area like for any procedure and loaded into %edi, %esi, %edx, %ecx and %r8d, or the 64 bit
+ * registers for a reference, right before the call.
+ *
+ * Expressions are evaluated with 32 bit arithmetic in a stack of registers, so they wrap around like on the
+ * ECO32. The operand needing more registers is evaluated first, see sethiullman.h, and an operand is pushed
+ * to the stack if the registers do not suffice. No value lives across a call, so no register has to be saved. Array indices are checked with an
+ * unsigned compare against the size of the array, unless the optimizer cleared checkIndex, and a failing
+ * check calls _indexError of the runtime. A division of the smallest int by -1 yields the smallest int,
+ * as on the ECO32, instead of trapping.
+ *
+ * A local variable with a staticLabel is addressed relative to %rip by its label, see STATIC_LABEL_FORMAT,
+ * and emitted in the bss segment. The register allocation, the calling convention, loop strength reduction,
+ * code motion, the switch lowering and the peephole optimizer work on ECO32 code, so X86_64_UNSUPPORTED_PASSES
+ * have to be removed from the pipeline. Every loop tests its condition after the body anyway, the other passes
+ * only transform the tree or the frame layout and are supported.
+ *
+ * @param program The program for which the assembly code has to be produced.
+ * @param globalTable The symbol table for the current program.
+ * @param outFile The file pointer where the output has to be emitted to.
+ */
+void genCodeX86(Program *program, SymbolTable *globalTable, FILE *outFile);
+
+#endif /* _X86CODEGEN_H_ */
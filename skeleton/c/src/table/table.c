@@ -30,6 +30,9 @@ Entry *newVarEntry(Identifier *name, Type *type, bool isRef) {
     Entry *entry = newEntry(name, ENTRY_KIND_VAR);
     entry->u.varEntry.type = type;
     entry->u.varEntry.isRef = isRef;
+    entry->u.varEntry.reg = 0;
+    entry->u.varEntry.sharedSlot = NULL;
+    entry->u.varEntry.staticLabel = 0;
     return entry;
 }
 
@@ -38,6 +41,8 @@ Entry *newProcEntry(Identifier *name, ParamTypes *paramTypes, SymbolTable *local
     Entry *entry = newEntry(name, ENTRY_KIND_PROC);
     entry->u.procEntry.paramTypes = paramTypes;
     entry->u.procEntry.localTable = localTable;
+    entry->u.procEntry.savedRegisters = 0;
+    entry->u.procEntry.frameKind = FRAME_FULL;
     return entry;
 }
 
@@ -46,6 +51,8 @@ Entry *newPredefinedProcEntry(Identifier *name, ParamTypes *paramTypes, int argu
     entry->u.procEntry.paramTypes = paramTypes;
     entry->u.procEntry.argumentArea = argumentAreaSize;
     entry->u.procEntry.localTable = NULL;
+    entry->u.procEntry.savedRegisters = 0;
+    entry->u.procEntry.frameKind = FRAME_FULL;
     return entry;
 }
 
@@ -296,6 +303,7 @@ ParamTypes *newPredefinedParamTypes(Type *type, bool isRef, int offset, ParamTyp
     paramTypes->type = type;
     paramTypes->isRef = isRef;
     paramTypes->offset = offset;
+    paramTypes->reg = 0;
     paramTypes->next = next;
     return paramTypes;
 }
@@ -18,6 +18,15 @@ typedef enum {
     ENTRY_KIND_PROC,
 } entry_kind;
 
+/**
+ * The kinds of stack frames of a procedure, chosen by the variable allocator.
+ */
+typedef enum {
+    FRAME_FULL,             /* frame pointer $25 and, for a procedure calling others, the saved return address */
+    FRAME_SP_RELATIVE,      /* leaf procedure with locals, addressed relative to the stack pointer */
+    FRAME_NONE,             /* leaf procedure without locals, no instructions besides the return */
+} frame_kind;
+
 /**
  * Represents a table entry for a declaration in SPL.
  *
@@ -44,6 +53,9 @@ typedef struct {
             Type *type;
             bool isRef;
             int offset;        /* filled in by variable allocator */
+            int reg;           /* filled in by register allocator, 0 if the variable lives in memory */
+            Identifier *sharedSlot; /* filled in by slot sharing, the variable whose stack slot is reused */
+            int staticLabel;   /* filled in by static allocation, 0 if the variable lives on the stack */
         } varEntry;
         struct {
             ParamTypes *paramTypes;
@@ -51,6 +63,8 @@ typedef struct {
             int argumentArea;        /* filled in by variable allocator */
             int localvarArea;        /* filled in by variable allocator */
             int outgoingArea;        /* filled in by variable allocator */
+            unsigned savedRegisters; /* filled in by register allocator, bit n is set if $n must be saved */
+            frame_kind frameKind;    /* filled in by variable allocator */
         } procEntry;
     } u;
 } Entry;
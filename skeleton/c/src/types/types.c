@@ -4,6 +4,7 @@
 
 #include <stdio.h>
 #include <string.h>
+#include <limits.h>
 #include <stdbool.h>
 #include <util/memory.h>
 #include <util/errors.h>
@@ -27,6 +28,10 @@ Type *newArrayType(int size, Type *baseType) {
     type->kind = TYPE_KIND_ARRAY;
     type->u.arrayType.size = size;
     type->u.arrayType.baseType = baseType;
+    /* the ECO32 cannot address more than 2 GiB with a signed offset */
+    if (baseType->byteSize > 0 && size > INT_MAX / baseType->byteSize) {
+        error("array type with %d elements of %d bytes is too large", size, baseType->byteSize);
+    }
     type->byteSize = size * baseType->byteSize;
     return type;
 }
@@ -52,6 +52,7 @@ typedef struct paramtypes {
     Type *type;
     bool isRef;
     int offset;        /* filled in by variable allocator */
+    int reg;           /* filled in by the calling convention, 0 if the argument is passed on the stack */
     struct paramtypes *next;
 } ParamTypes;
 
@@ -66,6 +67,7 @@ Type *newPrimitiveType(char *printName, int byteSize);
 /**
  * Creates a new array type representing the type of an array in SPL.
  * This automatically calculates the size in byte required to hold a value of this type.
+ * It is an error if the size does not fit into an int.
  * @param size The amount of elements an array of this type can hold.
  * @param baseType The type of the arrays elements.
  * @return A reference to the newly created array type.
@@ -0,0 +1,245 @@
+/*
+ * constarith.c -- test of the multiplication and division by constants
+ *
+ * Emits the sequence for every divisor from 2 to 65536 and its negation, for the powers of two and their
+ * neighbors and for the extreme values, runs the emitted instructions on the critical dividends and compares
+ * the results with the division of C. The multiplication sequences are checked in the same way.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <absyn/absyn.h>
+#include <phases/_06_codegen/constarith.h>
+#include <phases/_06_codegen/peephole.h>
+
+#define NUM_REGISTERS 32
+#define MAX_INSTRUCTIONS 64
+#define MAX_DIVIDENDS 64
+#define OPERAND_REGISTER 8
+#define FREE_REGISTERS 8
+#define FAST_CYCLES 1           /* a multiplier in a single cycle, so the division by a magic number pays off */
+#define SLOW_CYCLES 35          /* a sequential unit, so the sequences are used */
+
+typedef struct {
+    char opcode[8];
+    int target;
+    int source;
+    bool immediate;
+    int operand;
+} TestInstruction;
+
+typedef struct {
+    int length;
+    bool usesInstruction;       /* the mul or div instruction is emitted instead of a sequence */
+    TestInstruction code[MAX_INSTRUCTIONS];
+} TestProgram;
+
+static char *buffer;
+static int numChecks;
+static int numFailures;
+
+/**
+ * Emits reg := reg op constant and reads the emitted instructions back.
+ */
+static void translate(TestProgram *program, binary_operator operator, int constant) {
+    FILE *out;
+    size_t size;
+    char *line, opcode[8];
+    TestInstruction *instruction;
+    unsigned value;
+
+    out = open_memstream(&buffer, &size);
+    emitConstantOperation(out, operator, OPERAND_REGISTER, constant, FREE_REGISTERS);
+    flushPeephole(out);
+    fclose(out);
+
+    program->length = 0;
+    program->usesInstruction = false;
+    for (line = strtok(buffer, "\n"); line != NULL; line = strtok(NULL, "\n")) {
+        if (program->length == MAX_INSTRUCTIONS) {
+            fprintf(stderr, "sequence too long for %d\n", constant);
+            exit(1);
+        }
+        instruction = &program->code[program->length++];
+        if (sscanf(line, " ldhi $%d,0x%X", &instruction->target, &value) == 2) {
+            strcpy(instruction->opcode, "ldhi");
+            instruction->source = 0;
+            instruction->immediate = true;
+            instruction->operand = (int) value;
+        } else if (sscanf(line, " %7s $%d,$%d,$%d", opcode, &instruction->target, &instruction->source,
+                          &instruction->operand) == 4) {
+            strcpy(instruction->opcode, opcode);
+            instruction->immediate = false;
+        } else if (sscanf(line, " %7s $%d,$%d,%d", opcode, &instruction->target, &instruction->source,
+                          &instruction->operand) == 4) {
+            strcpy(instruction->opcode, opcode);
+            instruction->immediate = true;
+        } else {
+            fprintf(stderr, "cannot read '%s' emitted for %d\n", line, constant);
+            exit(1);
+        }
+        if (strcmp(instruction->opcode, operator == ABSYN_OP_MUL ? "mul" : "div") == 0 &&
+            instruction->source == OPERAND_REGISTER && instruction->immediate &&
+            instruction->operand == constant) {
+            program->usesInstruction = true;
+        }
+    }
+    free(buffer);
+}
+
+/**
+ * Executes the instructions like the ECO32 and returns the result in the operand register.
+ */
+static int run(TestProgram *program, int dividend) {
+    unsigned registers[NUM_REGISTERS];
+    unsigned a, b, result;
+    TestInstruction *instruction;
+    int i;
+
+    memset(registers, 0, sizeof(registers));
+    registers[OPERAND_REGISTER] = (unsigned) dividend;
+    for (i = 0; i < program->length; i++) {
+        instruction = &program->code[i];
+        a = registers[instruction->source];
+        b = instruction->immediate ? (unsigned) instruction->operand : registers[instruction->operand];
+        if (strcmp(instruction->opcode, "add") == 0) result = a + b;
+        else if (strcmp(instruction->opcode, "sub") == 0) result = a - b;
+        else if (strcmp(instruction->opcode, "and") == 0) result = a & b;
+        else if (strcmp(instruction->opcode, "or") == 0) result = a | b;
+        else if (strcmp(instruction->opcode, "ldhi") == 0) result = b & 0xFFFF0000u;
+        else if (strcmp(instruction->opcode, "sll") == 0) result = a << (b & 31);
+        else if (strcmp(instruction->opcode, "slr") == 0) result = a >> (b & 31);
+        else if (strcmp(instruction->opcode, "sar") == 0) result = (unsigned) ((int) a >> (b & 31));
+        else if (strcmp(instruction->opcode, "mul") == 0) result = (unsigned) ((long long) (int) a * (int) b);
+        else if (strcmp(instruction->opcode, "mulu") == 0) result = a * b;
+        else if (strcmp(instruction->opcode, "div") == 0) result = (unsigned) ((int) a / (int) b);
+        else {
+            fprintf(stderr, "unknown opcode '%s'\n", instruction->opcode);
+            exit(1);
+        }
+        if (instruction->target != 0) registers[instruction->target] = result;
+    }
+    return (int) registers[OPERAND_REGISTER];
+}
+
+static void check(const char *operation, int constant, int operand, int result, int expected) {
+    numChecks++;
+    if (result == expected) return;
+    numFailures++;
+    if (numFailures <= 20) {
+        fprintf(stderr, "%d %s %d: got %d, expected %d\n", operand, operation, constant, result, expected);
+    }
+}
+
+/**
+ * Collects the dividends where a wrong magic number or shift shows first: the extreme values, the multiples
+ * of the divisor next to them and to zero, each with its neighbors.
+ */
+static int criticalDividends(int divisor, int *dividends) {
+    long long d, multiple, candidates[MAX_DIVIDENDS];
+    int count, numCandidates, i, j;
+
+    d = divisor < 0 ? -(long long) divisor : divisor;
+    numCandidates = 0;
+    candidates[numCandidates++] = INT_MIN;
+    candidates[numCandidates++] = INT_MAX;
+    for (i = -2; i <= 2; i++) candidates[numCandidates++] = i;
+    multiple = INT_MAX / d * d;
+    for (i = -1; i <= 1; i++) {
+        candidates[numCandidates++] = multiple + i;
+        candidates[numCandidates++] = -multiple + i;
+        candidates[numCandidates++] = d + i;
+        candidates[numCandidates++] = -d + i;
+        candidates[numCandidates++] = 2 * d + i;
+        candidates[numCandidates++] = -2 * d + i;
+        candidates[numCandidates++] = (multiple - d) + i;
+        candidates[numCandidates++] = -(multiple - d) + i;
+    }
+    candidates[numCandidates++] = INT_MIN + 1;
+    candidates[numCandidates++] = INT_MAX - 1;
+    count = 0;
+    for (i = 0; i < numCandidates; i++) {
+        if (candidates[i] < INT_MIN || candidates[i] > INT_MAX) continue;
+        for (j = 0; j < count && dividends[j] != candidates[i]; j++);
+        if (j == count) dividends[count++] = (int) candidates[i];
+    }
+    return count;
+}
+
+static void testDivisor(int divisor, bool sweep) {
+    TestProgram program;
+    int dividends[MAX_DIVIDENDS];
+    int count, i, n;
+    unsigned state;
+
+    translate(&program, ABSYN_OP_DIV, divisor);
+    if (program.usesInstruction) {
+        fprintf(stderr, "no sequence emitted for the divisor %d\n", divisor);
+        numFailures++;
+        return;
+    }
+    count = criticalDividends(divisor, dividends);
+    for (i = 0; i < count; i++) check("/", divisor, dividends[i], run(&program, dividends[i]), dividends[i] / divisor);
+    /* a few pseudo random dividends of all magnitudes */
+    state = (unsigned) divisor;
+    for (i = 0; i < 16; i++) {
+        state = state * 1103515245u + 12345u;
+        n = (int) state >> (i % 31);
+        check("/", divisor, n, run(&program, n), n / divisor);
+    }
+    if (!sweep) return;
+    for (n = -200000; n <= 200000; n++) check("/", divisor, n, run(&program, n), n / divisor);
+}
+
+static void testMultiplier(int multiplier) {
+    static const int factors[] = {INT_MIN, INT_MIN + 1, -65536, -65535, -3, -1, 0, 1, 3, 65535, 65536, INT_MAX};
+    TestProgram program;
+    int i;
+
+    translate(&program, ABSYN_OP_MUL, multiplier);
+    for (i = 0; i < (int) (sizeof(factors) / sizeof(factors[0])); i++) {
+        check("*", multiplier, factors[i], run(&program, factors[i]),
+              (int) ((unsigned) factors[i] * (unsigned) multiplier));
+    }
+}
+
+int main(void) {
+    static const int sweepDivisors[] = {2, 3, 5, 6, 7, 10, 641, 65535, -3, -7, -10};
+    int divisor, k, i;
+
+    mulCycles = FAST_CYCLES;
+    divCycles = SLOW_CYCLES;
+    for (divisor = 2; divisor <= 65536; divisor++) {
+        testDivisor(divisor, false);
+        testDivisor(-divisor, false);
+    }
+    for (k = 16; k < 31; k++) {
+        testDivisor(1 << k, false);
+        testDivisor(-(1 << k), false);
+        testDivisor((1 << k) + 1, false);
+        testDivisor(-(1 << k) - 1, false);
+        testDivisor((1 << k) - 1, false);
+        testDivisor(-(1 << k) + 1, false);
+    }
+    testDivisor(INT_MAX, false);
+    testDivisor(-INT_MAX, false);
+    testDivisor(INT_MIN, false);
+    for (i = 0; i < (int) (sizeof(sweepDivisors) / sizeof(sweepDivisors[0])); i++) {
+        testDivisor(sweepDivisors[i], true);
+    }
+
+    mulCycles = SLOW_CYCLES;
+    for (i = -65536; i <= 65536; i++) testMultiplier(i);
+    for (k = 16; k < 31; k++) {
+        testMultiplier((1 << k) + 1);
+        testMultiplier(-(1 << k) - 1);
+        testMultiplier((1 << k) - 1);
+    }
+    testMultiplier(INT_MAX);
+    testMultiplier(INT_MIN);
+
+    printf("%d checks, %d failures\n", numChecks, numFailures);
+    return numFailures == 0 ? 0 : 1;
+}
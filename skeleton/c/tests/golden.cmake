@@ -0,0 +1,21 @@
+# golden.cmake -- runs the compiler on one input and compares its output with the expected one
+#
+# Variables: SPL (the compiler), OPTIONS (list of options), INPUT (the SPL program),
+# EXPECTED (the expected standard output), OUTPUT (optional, a file written by the compiler which is
+# compared instead of the standard output)
+
+if (DEFINED OUTPUT)
+    execute_process(COMMAND ${SPL} ${OPTIONS} ${INPUT} ${OUTPUT}
+            RESULT_VARIABLE status ERROR_VARIABLE errors)
+    file(READ ${OUTPUT} actual)
+else ()
+    execute_process(COMMAND ${SPL} ${OPTIONS} ${INPUT}
+            RESULT_VARIABLE status OUTPUT_VARIABLE actual ERROR_VARIABLE errors)
+endif ()
+if (NOT status EQUAL 0)
+    message(FATAL_ERROR "${SPL} ${OPTIONS} ${INPUT} failed with status ${status}:\n${errors}")
+endif ()
+file(READ ${EXPECTED} expected)
+if (NOT actual STREQUAL expected)
+    message(FATAL_ERROR "output of ${SPL} ${OPTIONS} ${INPUT} differs from ${EXPECTED}:\n${actual}")
+endif ()
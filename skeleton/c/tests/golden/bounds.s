@@ -0,0 +1,110 @@
+	.import	printi
+	.import	printc
+	.import	readi
+	.import	readc
+	.import	exit
+	.import	time
+	.import	clearAll
+	.import	setPixel
+	.import	drawLine
+	.import	drawCircle
+	.import	_indexError
+
+	.code
+	.align	4
+
+	.export	clear
+clear:
+	sub	$29,$29,4		; allocate frame of clear
+	stw	$0,$29,0
+L0:
+	ldw	$8,$29,0
+	add	$9,$0,10
+	bge	$8,$9,L1
+	ldw	$8,$29,0
+	sll	$8,$8,2
+	ldw	$9,$29,4
+	add	$8,$9,$8
+	stw	$0,$8,0
+	ldw	$8,$29,0
+	add	$8,$8,1
+	stw	$8,$29,0
+	j	L0
+L1:
+	add	$29,$29,4		; release frame of clear
+	jr	$31			; return
+
+	.export	fill
+fill:
+	sub	$29,$29,4		; allocate frame of fill
+	stw	$0,$29,0
+	ldw	$8,$29,8
+	add	$9,$0,10
+	bgt	$8,$9,L2
+L3:
+	ldw	$8,$29,0
+	ldw	$9,$29,8
+	bge	$8,$9,L4
+	ldw	$8,$29,0
+	sll	$8,$8,2
+	ldw	$9,$29,4
+	add	$8,$9,$8
+	ldw	$9,$29,0
+	stw	$9,$8,0
+	ldw	$8,$29,0
+	add	$8,$8,1
+	stw	$8,$29,0
+	j	L3
+L4:
+	j	L5
+L2:
+L6:
+	ldw	$8,$29,0
+	ldw	$9,$29,8
+	bge	$8,$9,L7
+	ldw	$8,$29,0
+	add	$9,$0,10
+	bgeu	$8,$9,_indexError
+	sll	$8,$8,2
+	ldw	$9,$29,4
+	add	$8,$9,$8
+	ldw	$9,$29,0
+	stw	$9,$8,0
+	ldw	$8,$29,0
+	add	$8,$8,1
+	stw	$8,$29,0
+	j	L6
+L7:
+L5:
+	add	$29,$29,4		; release frame of fill
+	jr	$31			; return
+
+	.export	main
+main:
+	sub	$29,$29,60		; allocate frame of main
+	stw	$25,$29,12		; save old frame pointer
+	add	$25,$29,60		; set up frame pointer
+	stw	$31,$25,-52		; save return register
+	add	$8,$25,-40
+	stw	$8,$29,0		; store arg #0
+	jal	clear
+	add	$8,$25,-44
+	stw	$8,$29,0		; store arg #0
+	jal	readi
+	add	$8,$25,-40
+	stw	$8,$29,0		; store arg #0
+	ldw	$8,$25,-44
+	stw	$8,$29,4		; store arg #1
+	jal	fill
+	ldw	$8,$25,-44
+	add	$9,$0,10
+	bgeu	$8,$9,_indexError
+	sll	$8,$8,2
+	add	$8,$25,$8
+	ldw	$8,$8,-40
+	stw	$8,$29,0		; store arg #0
+	jal	printi
+	ldw	$31,$25,-52		; restore return register
+	ldw	$25,$29,12		; restore old frame pointer
+	add	$29,$29,60		; release frame of main
+	jr	$31			; return
@@ -0,0 +1,109 @@
+	.import	printi
+	.import	printc
+	.import	readi
+	.import	readc
+	.import	exit
+	.import	time
+	.import	clearAll
+	.import	setPixel
+	.import	drawLine
+	.import	drawCircle
+	.import	_indexError
+
+	.code
+	.align	4
+
+	.export	add
+add:
+	add	$8,$4,$5
+	stw	$8,$6,0
+	jr	$31			; return
+
+	.export	swap
+swap:
+	sub	$29,$29,8		; allocate frame of swap
+	add	$8,$0,2
+	bgeu	$0,$8,_indexError
+	sll	$8,$0,2
+	add	$8,$29,$8
+	add	$9,$0,1
+	add	$10,$0,2
+	bgeu	$9,$10,_indexError
+	sll	$9,$9,2
+	add	$9,$4,$9
+	ldw	$9,$9,0
+	stw	$9,$8,0
+	add	$8,$0,1
+	add	$9,$0,2
+	bgeu	$8,$9,_indexError
+	sll	$8,$8,2
+	add	$8,$29,$8
+	add	$9,$0,2
+	bgeu	$0,$9,_indexError
+	sll	$9,$0,2
+	add	$9,$4,$9
+	ldw	$9,$9,0
+	stw	$9,$8,0
+	add	$8,$0,2
+	bgeu	$0,$8,_indexError
+	sll	$8,$0,2
+	add	$8,$4,$8
+	add	$9,$0,2
+	bgeu	$0,$9,_indexError
+	sll	$9,$0,2
+	add	$9,$29,$9
+	ldw	$9,$9,0
+	stw	$9,$8,0
+	add	$8,$0,1
+	add	$9,$0,2
+	bgeu	$8,$9,_indexError
+	sll	$8,$8,2
+	add	$8,$4,$8
+	add	$9,$0,1
+	add	$10,$0,2
+	bgeu	$9,$10,_indexError
+	sll	$9,$9,2
+	add	$9,$29,$9
+	ldw	$9,$9,0
+	stw	$9,$8,0
+	add	$29,$29,8		; release frame of swap
+	jr	$31			; return
+
+	.export	main
+main:
+	sub	$29,$29,20		; allocate frame of main
+	stw	$25,$29,8		; save old frame pointer
+	add	$25,$29,20		; set up frame pointer
+	stw	$31,$29,4		; save return register
+	add	$8,$0,1
+	add	$9,$0,2
+	add	$10,$0,2
+	bgeu	$0,$10,_indexError
+	sll	$10,$0,2
+	add	$10,$25,$10
+	add	$10,$10,-8
+	add	$4,$8,0		; load arg #0
+	add	$5,$9,0		; load arg #1
+	add	$6,$10,0		; load arg #2
+	jal	add
+	add	$8,$0,1
+	add	$9,$0,2
+	bgeu	$8,$9,_indexError
+	sll	$8,$8,2
+	add	$8,$25,$8
+	add	$9,$0,4
+	stw	$9,$8,-8
+	add	$8,$25,-8
+	add	$4,$8,0		; load arg #0
+	jal	swap
+	add	$8,$0,2
+	bgeu	$0,$8,_indexError
+	sll	$8,$0,2
+	add	$8,$25,$8
+	ldw	$8,$8,-8
+	stw	$8,$29,0		; store arg #0
+	jal	printi
+	ldw	$31,$25,-16		; restore return register
+	ldw	$25,$29,8		; restore old frame pointer
+	add	$29,$29,20		; release frame of main
+	jr	$31			; return
@@ -0,0 +1,39 @@
+	.import	printi
+	.import	printc
+	.import	readi
+	.import	readc
+	.import	exit
+	.import	time
+	.import	clearAll
+	.import	setPixel
+	.import	drawLine
+	.import	drawCircle
+	.import	_indexError
+
+	.code
+	.align	4
+
+	.export	main
+main:
+	sub	$29,$29,16		; allocate frame of main
+	stw	$25,$29,8		; save old frame pointer
+	add	$25,$29,16		; set up frame pointer
+	stw	$31,$29,4		; save return register
+	stw	$16,$25,-4
+	add	$4,$0,$0
+	add	$16,$0,$0
+	add	$8,$0,10
+	bge	$4,$8,L1
+L0:
+	add	$16,$16,$4
+	add	$4,$4,1
+	add	$8,$0,10
+	blt	$4,$8,L0
+L1:
+	stw	$16,$29,0		; store arg #0
+	jal	printi
+	ldw	$16,$25,-4
+	ldw	$31,$25,-12		; restore return register
+	ldw	$25,$29,8		; restore old frame pointer
+	add	$29,$29,16		; release frame of main
+	jr	$31			; return
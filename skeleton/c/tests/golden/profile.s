@@ -0,0 +1,125 @@
+	.import	printi
+	.import	printc
+	.import	readi
+	.import	readc
+	.import	exit
+	.import	time
+	.import	clearAll
+	.import	setPixel
+	.import	drawLine
+	.import	drawCircle
+	.import	_indexError
+
+	.code
+	.align	4
+
+	.export	main
+main:
+	sub	$29,$29,16		; allocate frame of main
+	stw	$25,$29,8		; save old frame pointer
+	add	$25,$29,16		; set up frame pointer
+	stw	$31,$25,-12		; save return register
+	stw	$0,$25,-4
+L0:
+	ldw	$8,$25,-4
+	add	$9,$0,3
+	bge	$8,$9,L1
+	ldw	$8,$0,_profileCounters+0
+	add	$8,$8,1
+	stw	$8,$0,_profileCounters+0
+	ldw	$8,$25,-4
+	add	$9,$0,1
+	bne	$8,$9,L2
+	ldw	$8,$0,_profileCounters+4
+	add	$8,$8,1
+	stw	$8,$0,_profileCounters+4
+	ldw	$8,$0,_profileCounters+12
+	add	$8,$8,1
+	stw	$8,$0,_profileCounters+12
+	ldw	$8,$25,-4
+	stw	$8,$29,0		; store arg #0
+	jal	printi
+	j	L3
+L2:
+	ldw	$8,$0,_profileCounters+8
+	add	$8,$8,1
+	stw	$8,$0,_profileCounters+8
+L3:
+	ldw	$8,$25,-4
+	add	$8,$8,1
+	stw	$8,$25,-4
+	j	L0
+L1:
+	ldw	$8,$0,_profileCounters+16
+	add	$8,$8,1
+	stw	$8,$0,_profileCounters+16
+	jal	_profileExit
+	jal	_profileDump
+	ldw	$31,$25,-12		; restore return register
+	ldw	$25,$29,8		; restore old frame pointer
+	add	$29,$29,16		; release frame of main
+	jr	$31			; return
+
+_profileDump:
+	sub	$29,$29,16		; allocate frame
+	stw	$31,$29,12		; save return register
+	stw	$16,$29,8
+	stw	$17,$29,4
+	add	$8,$0,35
+	stw	$8,$29,0		; store arg #0
+	jal	printc
+	add	$8,$0,112
+	stw	$8,$29,0		; store arg #0
+	jal	printc
+	add	$8,$0,114
+	stw	$8,$29,0		; store arg #0
+	jal	printc
+	add	$8,$0,111
+	stw	$8,$29,0		; store arg #0
+	jal	printc
+	add	$8,$0,102
+	stw	$8,$29,0		; store arg #0
+	jal	printc
+	add	$8,$0,105
+	stw	$8,$29,0		; store arg #0
+	jal	printc
+	add	$8,$0,108
+	stw	$8,$29,0		; store arg #0
+	jal	printc
+	add	$8,$0,101
+	stw	$8,$29,0		; store arg #0
+	jal	printc
+	add	$8,$0,32
+	stw	$8,$29,0		; store arg #0
+	jal	printc
+	add	$8,$0,5
+	stw	$8,$29,0		; store arg #0
+	jal	printi
+	add	$8,$0,10
+	stw	$8,$29,0		; store arg #0
+	jal	printc
+	add	$16,$0,0
+	add	$17,$0,20
+_profileLoop:
+	ldw	$8,$16,_profileCounters
+	stw	$8,$29,0		; store arg #0
+	jal	printi
+	add	$8,$0,10
+	stw	$8,$29,0		; store arg #0
+	jal	printc
+	add	$16,$16,4
+	bltu	$16,$17,_profileLoop
+	ldw	$17,$29,4
+	ldw	$16,$29,8
+	ldw	$31,$29,12		; restore return register
+	add	$29,$29,16		; release frame
+	jr	$31			; return
+
+_profileExit:
+	jal	_profileDump
+	j	exit
+
+	.data
+	.align	4
+_profileCounters:
+	.space	20
@@ -0,0 +1,65 @@
+	.import	printi
+	.import	printc
+	.import	readi
+	.import	readc
+	.import	exit
+	.import	time
+	.import	clearAll
+	.import	setPixel
+	.import	drawLine
+	.import	drawCircle
+	.import	_indexError
+
+	.code
+	.align	4
+
+	.export	main
+main:
+	sub	$29,$29,56		; allocate frame of main
+	stw	$25,$29,8		; save old frame pointer
+	add	$25,$29,56		; set up frame pointer
+	stw	$31,$25,-52		; save return register
+	stw	$0,$25,-44
+	ldw	$8,$25,-44
+	add	$9,$0,10
+	bge	$8,$9,L1
+	ldw	$8,$25,-44
+	sll	$8,$8,2
+	add	$8,$25,$8
+	add	$8,$8,-40
+	add	$12,$8,0		; set up pointer
+L0:
+	ldw	$8,$25,-44
+	stw	$8,$12,0
+	ldw	$8,$25,-44
+	add	$8,$8,1
+	stw	$8,$25,-44
+	add	$12,$12,4
+	ldw	$8,$25,-44
+	add	$9,$0,10
+	blt	$8,$9,L0
+L1:
+	stw	$0,$25,-44
+L2:
+	ldw	$8,$25,-44
+	add	$9,$0,12
+	bge	$8,$9,L3
+	ldw	$8,$25,-44
+	add	$9,$0,10
+	bgeu	$8,$9,_indexError
+	sll	$8,$8,2
+	add	$8,$25,$8
+	ldw	$9,$25,-44
+	stw	$9,$8,-40
+	ldw	$8,$25,-44
+	add	$8,$8,1
+	stw	$8,$25,-44
+	j	L2
+L3:
+	ldw	$8,$25,-4
+	stw	$8,$29,0		; store arg #0
+	jal	printi
+	ldw	$31,$25,-52		; restore return register
+	ldw	$25,$29,8		; restore old frame pointer
+	add	$29,$29,56		; release frame of main
+	jr	$31			; return
@@ -0,0 +1,92 @@
+	.import	printi
+	.import	printc
+	.import	readi
+	.import	readc
+	.import	exit
+	.import	time
+	.import	clearAll
+	.import	setPixel
+	.import	drawLine
+	.import	drawCircle
+	.import	_indexError
+
+	.code
+	.align	4
+
+	.export	scale
+scale:
+	sub	$29,$29,4		; allocate frame of scale
+	stw	$0,$29,0
+L0:
+	ldw	$8,$29,0
+	add	$9,$0,8
+	bge	$8,$9,L1
+	ldw	$8,$29,0
+	add	$9,$0,8
+	bgeu	$8,$9,_indexError
+	sll	$8,$8,2
+	ldw	$9,$29,4
+	add	$8,$9,$8
+	ldw	$9,$29,0
+	add	$10,$0,8
+	bgeu	$9,$10,_indexError
+	sll	$9,$9,2
+	ldw	$10,$29,4
+	add	$9,$10,$9
+	ldw	$9,$9,0
+	ldw	$10,$29,8
+	mul	$9,$9,$10
+	add	$9,$9,1
+	stw	$9,$8,0
+	ldw	$8,$29,0
+	add	$8,$8,1
+	stw	$8,$29,0
+	j	L0
+L1:
+	add	$29,$29,4		; release frame of scale
+	jr	$31			; return
+
+	.export	main
+main:
+	sub	$29,$29,52		; allocate frame of main
+	stw	$25,$29,12		; save old frame pointer
+	add	$25,$29,52		; set up frame pointer
+	stw	$31,$25,-44		; save return register
+	add	$8,$0,3
+	stw	$8,$25,-36
+	add	$8,$0,2
+	add	$9,$0,8
+	bgeu	$8,$9,_indexError
+	sll	$8,$8,2
+	add	$8,$25,$8
+	ldw	$9,$25,-36
+	ldhi	$10,0x10000
+	or	$10,$10,34464
+	sub	$9,$9,$10
+	stw	$9,$8,-32
+	add	$8,$25,-32
+	stw	$8,$29,0		; store arg #0
+	ldw	$8,$25,-36
+	stw	$8,$29,4		; store arg #1
+	jal	scale
+	add	$8,$0,2
+	add	$9,$0,8
+	bgeu	$8,$9,_indexError
+	sll	$8,$8,2
+	add	$8,$25,$8
+	ldw	$8,$8,-32
+	beq	$8,$0,L2
+	add	$8,$0,2
+	add	$9,$0,8
+	bgeu	$8,$9,_indexError
+	sll	$8,$8,2
+	add	$8,$25,$8
+	ldw	$8,$8,-32
+	div	$8,$8,4
+	stw	$8,$29,0		; store arg #0
+	jal	printi
+L2:
+	ldw	$31,$25,-44		; restore return register
+	ldw	$25,$29,12		; restore old frame pointer
+	add	$29,$29,52		; release frame of main
+	jr	$31			; return
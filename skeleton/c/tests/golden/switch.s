@@ -0,0 +1,106 @@
+	.import	printi
+	.import	printc
+	.import	readi
+	.import	readc
+	.import	exit
+	.import	time
+	.import	clearAll
+	.import	setPixel
+	.import	drawLine
+	.import	drawCircle
+	.import	_indexError
+
+	.code
+	.align	4
+
+	.export	main
+main:
+	sub	$29,$29,16		; allocate frame of main
+	stw	$25,$29,8		; save old frame pointer
+	add	$25,$29,16		; set up frame pointer
+	stw	$31,$29,4		; save return register
+	add	$8,$25,-4
+	stw	$8,$29,0		; store arg #0
+	jal	readi
+	ldw	$8,$25,-4
+	sub	$9,$8,1		; switch on cases 1 to 4
+	add	$10,$0,4
+	bgeu	$9,$10,L0_default
+	sll	$9,$9,2
+	ldw	$9,$9,L0_table
+	jr	$9
+L0_table:
+	.word	L0_case0
+	.word	L0_case1
+	.word	L0_case2
+	.word	L0_case3
+L0_case0:
+	add	$8,$0,10
+	stw	$8,$29,0		; store arg #0
+	jal	printi
+	j	L0_end
+L0_case1:
+	add	$8,$0,20
+	stw	$8,$29,0		; store arg #0
+	jal	printi
+	j	L0_end
+L0_case2:
+	add	$8,$0,30
+	stw	$8,$29,0		; store arg #0
+	jal	printi
+	j	L0_end
+L0_case3:
+	add	$8,$0,40
+	stw	$8,$29,0		; store arg #0
+	jal	printi
+	j	L0_end
+L0_default:
+	stw	$0,$29,0		; store arg #0
+	jal	printi
+L0_end:
+	ldw	$8,$25,-4
+	add	$9,$0,1000
+	blt	$8,$9,L1_below2
+	beq	$8,$9,L1_case2
+	add	$9,$0,10000
+	beq	$8,$9,L1_case3
+	ldhi	$9,0x10000
+	or	$9,$9,34464
+	beq	$8,$9,L1_case4
+	j	L1_default
+L1_below2:
+	add	$9,$0,1
+	beq	$8,$9,L1_case0
+	add	$9,$0,100
+	beq	$8,$9,L1_case1
+	j	L1_default
+L1_case0:
+	add	$8,$0,1
+	stw	$8,$29,0		; store arg #0
+	jal	printi
+	j	L1_end
+L1_case1:
+	add	$8,$0,2
+	stw	$8,$29,0		; store arg #0
+	jal	printi
+	j	L1_end
+L1_case2:
+	add	$8,$0,3
+	stw	$8,$29,0		; store arg #0
+	jal	printi
+	j	L1_end
+L1_case3:
+	add	$8,$0,4
+	stw	$8,$29,0		; store arg #0
+	jal	printi
+	j	L1_end
+L1_case4:
+	add	$8,$0,5
+	stw	$8,$29,0		; store arg #0
+	jal	printi
+L1_default:
+L1_end:
+	ldw	$31,$25,-12		; restore return register
+	ldw	$25,$29,8		; restore old frame pointer
+	add	$29,$29,16		; release frame of main
+	jr	$31			; return
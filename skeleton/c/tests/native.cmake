@@ -0,0 +1,32 @@
+# native.cmake -- compiles one program for x86-64, runs it and compares its output with the expected one
+#
+# Variables: SPL (the compiler), OPTIONS (list of options), AS and LD (the GNU assembler and linker),
+# RUNTIME (the runtime library), INPUT (the SPL program), STDIN (the standard input of the program),
+# EXPECTED (the expected standard output), PROGRAM (the executable to build), STACK (optional, the limit
+# of the stack size in kilobytes or unlimited)
+
+execute_process(COMMAND ${SPL} --target=x86_64 ${OPTIONS} ${INPUT} ${PROGRAM}.s
+        RESULT_VARIABLE status ERROR_VARIABLE errors)
+if (NOT status EQUAL 0)
+    message(FATAL_ERROR "${SPL} --target=x86_64 ${OPTIONS} ${INPUT} failed with status ${status}:\n${errors}")
+endif ()
+execute_process(COMMAND ${AS} -o ${PROGRAM}.o ${PROGRAM}.s
+        RESULT_VARIABLE status ERROR_VARIABLE errors)
+if (status EQUAL 0)
+    execute_process(COMMAND ${LD} -o ${PROGRAM} ${PROGRAM}.o ${RUNTIME}
+            RESULT_VARIABLE status ERROR_VARIABLE errors)
+endif ()
+if (NOT status EQUAL 0)
+    message(FATAL_ERROR "assembling or linking ${PROGRAM} failed with status ${status}:\n${errors}")
+endif ()
+# the status is not checked, since an index error ends the program with status 1
+if (STACK)
+    execute_process(COMMAND sh -c "ulimit -s ${STACK} && exec \"$0\"" ${PROGRAM}
+            INPUT_FILE ${STDIN} OUTPUT_VARIABLE actual TIMEOUT 60)
+else ()
+    execute_process(COMMAND ${PROGRAM} INPUT_FILE ${STDIN} OUTPUT_VARIABLE actual TIMEOUT 60)
+endif ()
+file(READ ${EXPECTED} expected)
+if (NOT actual STREQUAL expected)
+    message(FATAL_ERROR "output of ${PROGRAM} differs from ${EXPECTED}:\n${actual}")
+endif ()